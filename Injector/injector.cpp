@@ -1,9 +1,17 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+
 #include <windows.h>
 #include <tlhelp32.h>
 
+#include "remotereader.h"
+
+#include "../Susano/telemetry.h"
+#include "../Susano/gamestructs.h"
+
 /////////////////////////////////////////////////
 // Macros
 /////////////////////////////////////////////////
@@ -17,6 +25,19 @@
 #define ALIGN_PAGE_DOWN(VALUE) (((UINT64)VALUE) & ~((PAGE_SIZE) - 1))
 #define ALIGN_PAGE_UP(VALUE) ((((UINT64)VALUE) + ((PAGE_SIZE) - 1)) & ~((PAGE_SIZE) - 1))
 
+#define MONITOR_FIELD_COUNT (256)
+#define MONITOR_FIELD_SIZE (16)
+#define MONITOR_INTERVAL (16)
+
+#define TELEMETRY_REPORT_FRAMES (60)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+// Structures the monitor can read by name, declared once in the game structure schema shared with the dll
+static GAME_STRUCT_DESCRIPTION sGameStructs[] = { PLAYER_OBJECT::Describe(), CAMERA_BLOCK::Describe() };
+
 /////////////////////////////////////////////////
 // Function Definition
 /////////////////////////////////////////////////
@@ -34,6 +55,10 @@ VOID VaWriteIntoMemory(HANDLE Process, UINT64 Base, UINT64 Size, PVOID Buffer);
 VOID VaInjectModuleIntoProcess(HANDLE Process, LPCSTR FilePath);
 VOID VaEjectModuleFromProcess(HANDLE Process, HMODULE Module);
 
+VOID VaMonitorProcess(HANDLE Process, UINT64 ModuleBase, UINT32 FieldCount, CHAR** Fields);
+VOID VaPrintGameStruct(const GAME_STRUCT_DESCRIPTION* Struct, const BYTE* Bytes);
+VOID VaConsumeTelemetry(HANDLE Process);
+
 /////////////////////////////////////////////////
 // Function Implementation
 /////////////////////////////////////////////////
@@ -180,6 +205,234 @@ VOID VaEjectModuleFromProcess(HANDLE Process, HMODULE Module)
 	CloseHandle(thread);
 }
 
+VOID VaMonitorProcess(HANDLE Process, UINT64 ModuleBase, UINT32 FieldCount, CHAR** Fields)
+{
+	static REMOTE_READ reads[MONITOR_FIELD_COUNT] = { 0 };
+	static BYTE values[MONITOR_FIELD_COUNT][GAME_STRUCT_MAXIMUM_SIZE] = { 0 };
+	static const GAME_STRUCT_DESCRIPTION* structs[MONITOR_FIELD_COUNT] = { 0 };
+
+	FieldCount = min(FieldCount, MONITOR_FIELD_COUNT);
+
+	// Fields are given as module relative hex offsets with an optional byte count, 0x1234:8,
+	// or as a declared structure at a module relative offset, CAMERA_BLOCK@0x1234, which is read as one span
+	for (UINT32 i = 0; i < FieldCount; i++)
+	{
+		CHAR* at = strchr(Fields[i], '@');
+		CHAR* end = NULL;
+
+		structs[i] = NULL;
+
+		if (at)
+		{
+			for (UINT32 j = 0; j < ARRAY_LENGTH(sGameStructs); j++)
+			{
+				if (_strnicmp(sGameStructs[j].Name, Fields[i], at - Fields[i]) == 0)
+				{
+					structs[i] = &sGameStructs[j];
+				}
+			}
+		}
+
+		if (structs[i])
+		{
+			reads[i].Address = ModuleBase + strtoull(at + 1, NULL, 16) + structs[i]->Begin;
+			reads[i].Size = structs[i]->Size;
+		}
+		else
+		{
+			reads[i].Address = ModuleBase + strtoull(Fields[i], &end, 16);
+			reads[i].Size = (*end == ':') ? min((UINT32)strtoul(end + 1, NULL, 10), MONITOR_FIELD_SIZE) : 4;
+		}
+
+		reads[i].Buffer = values[i];
+	}
+
+	VaCreateRemoteReader(Process, REMOTE_READER_DEFAULT_LIFETIME);
+
+	// The wait doubles as the refresh timer and ends the loop once the game exits
+	while (WaitForSingleObject(Process, MONITOR_INTERVAL) == WAIT_TIMEOUT)
+	{
+		UINT32 validCount = VaReadRemoteBatch(reads, FieldCount);
+
+		REMOTE_READER_STATISTICS statistics = { 0 };
+
+		VaGetRemoteReaderStatistics(&statistics);
+
+		printf("\r%u/%u valid, %.1f calls per batch |", validCount, FieldCount, (DOUBLE)statistics.SyscallCount / statistics.BatchCount);
+
+		for (UINT32 i = 0; i < FieldCount; i++)
+		{
+			printf(" ");
+
+			if (structs[i] && reads[i].Valid)
+			{
+				VaPrintGameStruct(structs[i], values[i]);
+
+				continue;
+			}
+
+			for (UINT32 j = reads[i].Size; j > 0; j--)
+			{
+				printf(reads[i].Valid ? "%02X" : "??", values[i][j - 1]);
+			}
+		}
+
+		fflush(stdout);
+	}
+
+	printf("\n");
+
+	VaDestroyRemoteReader();
+}
+VOID VaPrintGameStruct(const GAME_STRUCT_DESCRIPTION* Struct, const BYTE* Bytes)
+{
+	printf("%s {", Struct->Name);
+
+	for (UINT32 i = 0; i < Struct->FieldCount; i++)
+	{
+		const GAME_FIELD_DESCRIPTION* field = &Struct->Fields[i];
+
+		const BYTE* value = Bytes + (field->Offset - Struct->Begin);
+
+		UINT64 bits = 0;
+
+		memcpy(&bits, value, field->Size);
+
+		switch (field->Type)
+		{
+			case GAME_FIELD_TYPE_I32:
+			{
+				printf(" %s %d", field->Name, (INT32)bits);
+
+				break;
+			}
+			case GAME_FIELD_TYPE_F32:
+			{
+				FLOAT number;
+
+				memcpy(&number, &bits, sizeof(number));
+
+				printf(" %s %.3f", field->Name, number);
+
+				break;
+			}
+			case GAME_FIELD_TYPE_F64:
+			{
+				DOUBLE number;
+
+				memcpy(&number, &bits, sizeof(number));
+
+				printf(" %s %.3f", field->Name, number);
+
+				break;
+			}
+			default:
+			{
+				printf(" %s %llu", field->Name, bits);
+
+				break;
+			}
+		}
+	}
+
+	printf(" }");
+}
+VOID VaConsumeTelemetry(HANDLE Process)
+{
+	HANDLE mapping = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, TELEMETRY_MAPPING_NAME);
+
+	if (!mapping)
+	{
+		PRINT_LAST_ERROR();
+
+		return;
+	}
+
+	TELEMETRY_RING* ring = (TELEMETRY_RING*)MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, sizeof(TELEMETRY_RING));
+
+	if (!ring || (ring->Magic != TELEMETRY_MAGIC) || (ring->Version != TELEMETRY_VERSION) || (ring->FrameSize != sizeof(TELEMETRY_FRAME)))
+	{
+		printf("Telemetry layout does not match this build\n");
+
+		if (ring)
+		{
+			UnmapViewOfFile(ring);
+		}
+
+		CloseHandle(mapping);
+
+		return;
+	}
+
+	UINT64 frameCount = 0;
+	UINT64 durationSum = 0;
+	UINT64 durationMaximum = 0;
+
+	UINT64 zoneSums[TELEMETRY_ZONE_COUNT] = { 0 };
+
+	// The wait doubles as the poll timer and ends the loop once the game exits
+	while (WaitForSingleObject(Process, MONITOR_INTERVAL) == WAIT_TIMEOUT)
+	{
+		LONG64 readIndex = ring->ReadIndex;
+		LONG64 writeIndex = ReadAcquire64(&ring->WriteIndex);
+
+		const TELEMETRY_FRAME* frame = NULL;
+
+		// Frames are looked at in place, their slots only go back to the game once the read index moves past them
+		for (; readIndex < writeIndex; readIndex++)
+		{
+			frame = &ring->Frames[readIndex & (TELEMETRY_FRAME_COUNT - 1)];
+
+			frameCount += 1;
+			durationSum += frame->Duration;
+			durationMaximum = max(durationMaximum, frame->Duration);
+
+			for (UINT32 i = 0; i < TELEMETRY_ZONE_COUNT; i++)
+			{
+				zoneSums[i] += frame->ZoneTimes[i];
+			}
+
+			if (frameCount < TELEMETRY_REPORT_FRAMES)
+			{
+				continue;
+			}
+
+			UINT32 slowestZone = 0;
+
+			for (UINT32 i = 1; i < TELEMETRY_ZONE_COUNT; i++)
+			{
+				slowestZone = (zoneSums[i] > zoneSums[slowestZone]) ? i : slowestZone;
+			}
+
+			// The game clears the count before it rewrites any name
+			UINT32 zoneCount = ring->ZoneCount;
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			printf("Frame %llu: %.3f ms mean, %.3f ms max, slowest %s, %llu dropped", frame->FrameIndex, durationSum / (frameCount * 1000000.0), durationMaximum / 1000000.0, (slowestZone < zoneCount) ? ring->ZoneNames[slowestZone] : "?", ring->DroppedCount);
+
+			if (frame->PlayerValid)
+			{
+				printf(", player %.2f %.2f %.2f", frame->PlayerX, frame->PlayerY, frame->PlayerZ);
+			}
+
+			printf("\n");
+
+			frameCount = 0;
+			durationSum = 0;
+			durationMaximum = 0;
+
+			memset(zoneSums, 0, sizeof(zoneSums));
+		}
+
+		WriteRelease64(&ring->ReadIndex, readIndex);
+	}
+
+	UnmapViewOfFile(ring);
+
+	CloseHandle(mapping);
+}
+
 /////////////////////////////////////////////////
 // Entry Point
 /////////////////////////////////////////////////
@@ -207,6 +460,27 @@ INT main(INT Argc, CHAR** Argv, CHAR** ENVP)
 
 		CloseHandle(process);
 	}
+	else if (strcmp("Monitor", Argv[1]) == 0)
+	{
+		UINT32 processId = VaFindProcessId(Argv[2]);
+
+		HANDLE process = OpenProcess(PROCESS_VM_READ | PROCESS_QUERY_INFORMATION | SYNCHRONIZE, FALSE, processId);
+		UINT64 moduleBase = VaFindModuleBase(processId, Argv[3]);
+
+		VaMonitorProcess(process, moduleBase, (Argc > 4) ? (Argc - 4) : 0, Argv + 4);
+
+		CloseHandle(process);
+	}
+	else if (strcmp("Telemetry", Argv[1]) == 0)
+	{
+		UINT32 processId = VaFindProcessId(Argv[2]);
+
+		HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, processId);
+
+		VaConsumeTelemetry(process);
+
+		CloseHandle(process);
+	}
 
 	return 0;
 }
\ No newline at end of file
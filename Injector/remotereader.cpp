@@ -0,0 +1,339 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "remotereader.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define REMOTE_PAGE_SIZE (0x1000)
+#define REMOTE_PAGE_SHIFT (12)
+
+#define REMOTE_PAGE_COUNT (512)
+#define REMOTE_PAGE_INDEX_COUNT (REMOTE_PAGE_COUNT * 2)
+
+// Upper bound of one ReadProcessMemory call, longer runs of missing pages are split
+#define REMOTE_SPAN_PAGES (32)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+struct REMOTE_PAGE
+{
+	UINT64 Page;
+	BOOL Readable;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static HANDLE sProcess = NULL;
+
+static UINT32 sLifetime = REMOTE_READER_DEFAULT_LIFETIME;
+
+// Slots are handed out in order, so a run of missing pages lands in consecutive slots and is read with a single call
+static REMOTE_PAGE sPages[REMOTE_PAGE_COUNT] = { 0 };
+static UINT32 sPageCount = 0;
+
+static PBYTE sPageData = NULL;
+
+// Open addressing over page numbers, an entry is the slot plus one and zero marks an empty bucket
+static UINT16 sPageIndex[REMOTE_PAGE_INDEX_COUNT] = { 0 };
+
+static UINT64 sFetchTime = 0;
+
+// Scratch for the pages a batch misses, sorted before they are coalesced
+static UINT64 sMissingPages[REMOTE_PAGE_COUNT] = { 0 };
+
+static REMOTE_READER_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static UINT32 VaHashRemotePage(UINT64 Page);
+static INT32 VaFindRemotePage(UINT64 Page);
+
+static UINT32 VaCollectMissingPages(const REMOTE_READ* Reads, UINT32 Count);
+
+static VOID VaFetchRemotePages(UINT32 MissingCount);
+static VOID VaFetchRemoteSpan(UINT64 Page, UINT32 PageCount);
+
+static BOOL VaCopyRemoteRead(REMOTE_READ* Read);
+
+static int VaCompareRemotePages(const VOID* Left, const VOID* Right);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateRemoteReader(HANDLE Process, UINT32 Lifetime)
+{
+	sProcess = Process;
+	sLifetime = Lifetime;
+
+	sPageData = (PBYTE)VirtualAlloc(NULL, REMOTE_PAGE_COUNT * REMOTE_PAGE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	VaInvalidateRemoteReader();
+}
+VOID VaDestroyRemoteReader(VOID)
+{
+	VirtualFree(sPageData, 0, MEM_RELEASE);
+
+	sPageData = NULL;
+	sProcess = NULL;
+}
+
+UINT32 VaReadRemoteBatch(REMOTE_READ* Reads, UINT32 Count)
+{
+	UINT64 time = GetTickCount64();
+
+	// The game keeps running between batches, old pages are dropped as a whole instead of being tracked one by one
+	if ((time - sFetchTime) > sLifetime)
+	{
+		VaInvalidateRemoteReader();
+
+		sFetchTime = time;
+	}
+
+	UINT32 missingCount = VaCollectMissingPages(Reads, Count);
+
+	// A full cache starts over for this batch, whatever still does not fit is read field by field further down
+	if ((sPageCount + missingCount) > REMOTE_PAGE_COUNT)
+	{
+		VaInvalidateRemoteReader();
+
+		sFetchTime = time;
+
+		missingCount = VaCollectMissingPages(Reads, Count);
+	}
+
+	VaFetchRemotePages(missingCount);
+
+	UINT32 validCount = 0;
+
+	for (UINT32 i = 0; i < Count; i++)
+	{
+		REMOTE_READ* read = &Reads[i];
+
+		read->Valid = VaCopyRemoteRead(read);
+
+		if (!read->Valid)
+		{
+			sStatistics.FailedCount += 1;
+		}
+
+		validCount += read->Valid;
+	}
+
+	sStatistics.BatchCount += 1;
+	sStatistics.ReadCount += Count;
+
+	return validCount;
+}
+
+VOID VaInvalidateRemoteReader(VOID)
+{
+	memset(sPageIndex, 0, sizeof(sPageIndex));
+
+	sPageCount = 0;
+
+	sStatistics.FlushCount += 1;
+}
+
+VOID VaGetRemoteReaderStatistics(REMOTE_READER_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+}
+
+static UINT32 VaHashRemotePage(UINT64 Page)
+{
+	return (UINT32)((Page * 0x9E3779B97F4A7C15ULL) >> 32) % REMOTE_PAGE_INDEX_COUNT;
+}
+static INT32 VaFindRemotePage(UINT64 Page)
+{
+	UINT32 bucket = VaHashRemotePage(Page);
+
+	while (sPageIndex[bucket])
+	{
+		UINT32 slot = sPageIndex[bucket] - 1;
+
+		if (sPages[slot].Page == Page)
+		{
+			return (INT32)slot;
+		}
+
+		bucket = (bucket + 1) % REMOTE_PAGE_INDEX_COUNT;
+	}
+
+	return -1;
+}
+
+static UINT32 VaCollectMissingPages(const REMOTE_READ* Reads, UINT32 Count)
+{
+	UINT32 missingCount = 0;
+
+	for (UINT32 i = 0; i < Count; i++)
+	{
+		const REMOTE_READ* read = &Reads[i];
+
+		if (!read->Size)
+		{
+			continue;
+		}
+
+		UINT64 firstPage = read->Address >> REMOTE_PAGE_SHIFT;
+		UINT64 lastPage = (read->Address + read->Size - 1) >> REMOTE_PAGE_SHIFT;
+
+		for (UINT64 page = firstPage; page <= lastPage; page++)
+		{
+			if (VaFindRemotePage(page) >= 0)
+			{
+				sStatistics.PageHitCount += 1;
+
+				continue;
+			}
+
+			if (missingCount < REMOTE_PAGE_COUNT)
+			{
+				sMissingPages[missingCount] = page;
+
+				missingCount += 1;
+			}
+		}
+	}
+
+	if (missingCount == 0)
+	{
+		return 0;
+	}
+
+	qsort(sMissingPages, missingCount, sizeof(UINT64), VaCompareRemotePages);
+
+	// Neighbouring fields share pages, every page is fetched once no matter how many reads touch it
+	UINT32 uniqueCount = 1;
+
+	for (UINT32 i = 1; i < missingCount; i++)
+	{
+		if (sMissingPages[i] != sMissingPages[uniqueCount - 1])
+		{
+			sMissingPages[uniqueCount] = sMissingPages[i];
+
+			uniqueCount += 1;
+		}
+	}
+
+	return uniqueCount;
+}
+
+static VOID VaFetchRemotePages(UINT32 MissingCount)
+{
+	UINT32 i = 0;
+
+	while ((i < MissingCount) && (sPageCount < REMOTE_PAGE_COUNT))
+	{
+		UINT32 spanLength = 1;
+
+		while (((i + spanLength) < MissingCount) && (spanLength < REMOTE_SPAN_PAGES) && ((sPageCount + spanLength) < REMOTE_PAGE_COUNT) && (sMissingPages[i + spanLength] == (sMissingPages[i] + spanLength)))
+		{
+			spanLength += 1;
+		}
+
+		VaFetchRemoteSpan(sMissingPages[i], spanLength);
+
+		sStatistics.PageMissCount += spanLength;
+
+		i += spanLength;
+	}
+}
+static VOID VaFetchRemoteSpan(UINT64 Page, UINT32 PageCount)
+{
+	UINT32 firstSlot = sPageCount;
+
+	PBYTE destination = sPageData + ((UINT64)firstSlot * REMOTE_PAGE_SIZE);
+
+	sStatistics.SpanCount += 1;
+	sStatistics.SyscallCount += 1;
+
+	// Reading needs no protection changes, only no access and guard pages fail and those are never worth reading
+	BOOL spanRead = ReadProcessMemory(sProcess, (PVOID)(Page << REMOTE_PAGE_SHIFT), destination, (SIZE_T)PageCount * REMOTE_PAGE_SIZE, NULL);
+
+	for (UINT32 i = 0; i < PageCount; i++)
+	{
+		REMOTE_PAGE* page = &sPages[firstSlot + i];
+
+		page->Page = Page + i;
+		page->Readable = spanRead;
+
+		// One bad page fails the whole span, the others are retried alone so they still count as readable
+		if (!spanRead)
+		{
+			sStatistics.SyscallCount += 1;
+
+			page->Readable = ReadProcessMemory(sProcess, (PVOID)(page->Page << REMOTE_PAGE_SHIFT), destination + ((UINT64)i * REMOTE_PAGE_SIZE), REMOTE_PAGE_SIZE, NULL);
+		}
+
+		UINT32 bucket = VaHashRemotePage(page->Page);
+
+		while (sPageIndex[bucket])
+		{
+			bucket = (bucket + 1) % REMOTE_PAGE_INDEX_COUNT;
+		}
+
+		sPageIndex[bucket] = (UINT16)(firstSlot + i + 1);
+	}
+
+	sPageCount += PageCount;
+}
+
+static BOOL VaCopyRemoteRead(REMOTE_READ* Read)
+{
+	if (!Read->Size)
+	{
+		return TRUE;
+	}
+
+	PBYTE buffer = (PBYTE)Read->Buffer;
+
+	UINT64 address = Read->Address;
+	UINT64 end = Read->Address + Read->Size;
+
+	while (address < end)
+	{
+		INT32 slot = VaFindRemotePage(address >> REMOTE_PAGE_SHIFT);
+
+		// Only happens when one batch touches more pages than the cache holds
+		if (slot < 0)
+		{
+			sStatistics.SyscallCount += 1;
+
+			return ReadProcessMemory(sProcess, (PVOID)Read->Address, Read->Buffer, Read->Size, NULL);
+		}
+
+		if (!sPages[slot].Readable)
+		{
+			return FALSE;
+		}
+
+		UINT64 pageOffset = address & (REMOTE_PAGE_SIZE - 1);
+		UINT64 length = min(REMOTE_PAGE_SIZE - pageOffset, end - address);
+
+		memcpy(buffer, sPageData + ((UINT64)slot * REMOTE_PAGE_SIZE) + pageOffset, length);
+
+		buffer += length;
+		address += length;
+	}
+
+	return TRUE;
+}
+
+static int VaCompareRemotePages(const VOID* Left, const VOID* Right)
+{
+	UINT64 left = *(const UINT64*)Left;
+	UINT64 right = *(const UINT64*)Right;
+
+	return (left > right) - (left < right);
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <windows.h>
+
+#define REMOTE_READER_DEFAULT_LIFETIME (8)
+
+// One field to fetch, Valid is only set when every page it touches could be read
+struct REMOTE_READ
+{
+	UINT64 Address;
+	UINT32 Size;
+	PVOID Buffer;
+	BOOL Valid;
+};
+
+struct REMOTE_READER_STATISTICS
+{
+	UINT64 BatchCount;
+	UINT64 ReadCount;
+	UINT64 FailedCount;
+	UINT64 PageHitCount;
+	UINT64 PageMissCount;
+	UINT64 SpanCount;
+	UINT64 SyscallCount;
+	UINT64 FlushCount;
+};
+
+// Pages fetched for one batch are reused by the following ones until they are older than the lifetime in milliseconds
+VOID VaCreateRemoteReader(HANDLE Process, UINT32 Lifetime);
+VOID VaDestroyRemoteReader(VOID);
+
+// Coalesces the pages behind all reads into as few spans as possible and returns how many reads came back valid
+UINT32 VaReadRemoteBatch(REMOTE_READ* Reads, UINT32 Count);
+
+VOID VaInvalidateRemoteReader(VOID);
+
+VOID VaGetRemoteReaderStatistics(REMOTE_READER_STATISTICS* Statistics);
\ No newline at end of file
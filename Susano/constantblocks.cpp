@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <d3d11.h>
+
+#include "susano.h"
+#include "constantblocks.h"
+#include "logger.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define CONSTANT_BLOCK_COUNT (16)
+
+#define ALIGN_UP_16(VALUE) (((VALUE) + 15) & ~15)
+
+#define HR_CHECK(EXPRESSION) \
+	{ \
+		HRESULT result = (EXPRESSION); \
+		if (result != S_OK) \
+		{ \
+			VA_LOG("%s 0x%08X", #EXPRESSION, result); \
+		} \
+	}
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// The shadow copy is what the next commit uploads, the buffer holds the contents of UploadedVersion
+struct CONSTANT_BLOCK_DATA
+{
+	ID3D11Buffer* Buffer;
+	BYTE* Shadow;
+	UINT32 Size;
+	UINT32 BufferSize;
+	UINT32 Version;
+	UINT32 UploadedVersion;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static CONSTANT_BLOCK_DATA sBlocks[CONSTANT_BLOCK_COUNT] = { 0 };
+
+static UINT32 sBlockCount = 0;
+
+static CONSTANT_BLOCK_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateConstantBlocks(VOID)
+{
+	sBlockCount = 0;
+
+	memset(&sStatistics, 0, sizeof(sStatistics));
+}
+VOID VaDestroyConstantBlocks(VOID)
+{
+	for (UINT32 i = 0; i < sBlockCount; i++)
+	{
+		sBlocks[i].Buffer->Release();
+
+		free(sBlocks[i].Shadow);
+	}
+
+	memset(sBlocks, 0, sizeof(sBlocks));
+
+	sBlockCount = 0;
+}
+
+CONSTANT_BLOCK VaCreateConstantBlock(UINT32 Size)
+{
+	if (sBlockCount == CONSTANT_BLOCK_COUNT)
+	{
+		return INVALID_CONSTANT_BLOCK;
+	}
+
+	CONSTANT_BLOCK_DATA* block = &sBlocks[sBlockCount];
+
+	block->Size = Size;
+	block->BufferSize = ALIGN_UP_16(Size);
+	block->Shadow = (BYTE*)calloc(1, block->BufferSize);
+
+	// Version zero is never uploaded, the first write is what makes the block valid
+	block->Version = 0;
+	block->UploadedVersion = 0;
+
+	D3D11_BUFFER_DESC bufferDescription = { 0 };
+	bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDescription.ByteWidth = block->BufferSize;
+	bufferDescription.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, NULL, &block->Buffer));
+
+	sBlockCount += 1;
+
+	sStatistics.BlockCount = sBlockCount;
+
+	return (CONSTANT_BLOCK)(sBlockCount - 1);
+}
+
+VOID VaWriteConstantBlock(CONSTANT_BLOCK Block, const VOID* Data)
+{
+	CONSTANT_BLOCK_DATA* block = &sBlocks[Block];
+
+	sStatistics.WriteCount += 1;
+
+	// Writing identical contents keeps the version, so nothing is uploaded for it
+	if ((block->Version != 0) && (memcmp(block->Shadow, Data, block->Size) == 0))
+	{
+		return;
+	}
+
+	memcpy(block->Shadow, Data, block->Size);
+
+	block->Version += 1;
+}
+UINT32 VaGetConstantBlockVersion(CONSTANT_BLOCK Block)
+{
+	return sBlocks[Block].Version;
+}
+
+ID3D11Buffer* VaCommitConstantBlock(CONSTANT_BLOCK Block)
+{
+	CONSTANT_BLOCK_DATA* block = &sBlocks[Block];
+
+	if (block->UploadedVersion == block->Version)
+	{
+		sStatistics.SkippedUploadCount += 1;
+
+		return block->Buffer;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 };
+
+	HR_CHECK(gDeviceContext->Map(block->Buffer, NULL, D3D11_MAP_WRITE_DISCARD, NULL, &mappedSubResource));
+
+	memcpy(mappedSubResource.pData, block->Shadow, block->BufferSize);
+
+	gDeviceContext->Unmap(block->Buffer, NULL);
+
+	block->UploadedVersion = block->Version;
+
+	sStatistics.UploadCount += 1;
+
+	return block->Buffer;
+}
+
+VOID VaResetConstantBlockStatistics(VOID)
+{
+	sStatistics.WriteCount = 0;
+	sStatistics.UploadCount = 0;
+	sStatistics.SkippedUploadCount = 0;
+}
+VOID VaGetConstantBlockStatistics(CONSTANT_BLOCK_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+}
\ No newline at end of file
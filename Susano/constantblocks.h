@@ -0,0 +1,30 @@
+#pragma once
+
+#include <windows.h>
+
+#include <d3d11.h>
+
+#define INVALID_CONSTANT_BLOCK (-1)
+
+typedef INT32 CONSTANT_BLOCK;
+
+struct CONSTANT_BLOCK_STATISTICS
+{
+	UINT32 BlockCount;
+	UINT32 WriteCount;
+	UINT32 UploadCount;
+	UINT32 SkippedUploadCount;
+};
+
+VOID VaCreateConstantBlocks(VOID);
+VOID VaDestroyConstantBlocks(VOID);
+
+CONSTANT_BLOCK VaCreateConstantBlock(UINT32 Size);
+
+VOID VaWriteConstantBlock(CONSTANT_BLOCK Block, const VOID* Data);
+UINT32 VaGetConstantBlockVersion(CONSTANT_BLOCK Block);
+
+ID3D11Buffer* VaCommitConstantBlock(CONSTANT_BLOCK Block);
+
+VOID VaResetConstantBlockStatistics(VOID);
+VOID VaGetConstantBlockStatistics(CONSTANT_BLOCK_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include <string.h>
+
+#include "control.h"
+#include "logger.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define CONTROL_QUEUE_SIZE (64)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+struct CONTROL_TASK_DATA
+{
+	CONTROL_TASK Task;
+	UINT32 Interval;
+	UINT64 NextRun;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+// Everything below is guarded by the lock, the condition variable is the only thing the loop ever blocks on
+static CRITICAL_SECTION sLock = { 0 };
+static CONDITION_VARIABLE sWake = CONDITION_VARIABLE_INIT;
+
+static CONTROL_COMMAND sQueue[CONTROL_QUEUE_SIZE] = { CONTROL_COMMAND_ENABLE_HOOKS };
+
+static UINT32 sQueueHead = 0;
+static UINT32 sQueueCount = 0;
+
+static BOOL sExitRequested = FALSE;
+
+static CONTROL_HANDLER sHandlers[CONTROL_COMMAND_COUNT] = { 0 };
+
+static CONTROL_TASK_DATA sTasks[CONTROL_TASK_COUNT] = { 0 };
+
+static UINT32 sTaskCount = 0;
+
+static CONTROL_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static DWORD VaGetControlTimeout(UINT64 Now);
+
+static VOID VaRunDueTasks(UINT64 Now);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateControl(VOID)
+{
+	InitializeCriticalSection(&sLock);
+	InitializeConditionVariable(&sWake);
+
+	memset(sHandlers, 0, sizeof(sHandlers));
+	memset(sTasks, 0, sizeof(sTasks));
+	memset(&sStatistics, 0, sizeof(sStatistics));
+
+	sQueueHead = 0;
+	sQueueCount = 0;
+	sTaskCount = 0;
+	sExitRequested = FALSE;
+}
+VOID VaDestroyControl(VOID)
+{
+	DeleteCriticalSection(&sLock);
+}
+
+VOID VaSetControlHandler(CONTROL_COMMAND Command, CONTROL_HANDLER Handler)
+{
+	EnterCriticalSection(&sLock);
+
+	sHandlers[Command] = Handler;
+
+	LeaveCriticalSection(&sLock);
+}
+BOOL VaRegisterControlTask(CONTROL_TASK Task, UINT32 Interval)
+{
+	BOOL registered = FALSE;
+
+	EnterCriticalSection(&sLock);
+
+	if (sTaskCount < CONTROL_TASK_COUNT)
+	{
+		CONTROL_TASK_DATA* task = &sTasks[sTaskCount];
+
+		task->Task = Task;
+		task->Interval = Interval;
+		task->NextRun = GetTickCount64() + Interval;
+
+		sTaskCount += 1;
+
+		registered = TRUE;
+	}
+
+	LeaveCriticalSection(&sLock);
+
+	// The loop may already be sleeping towards a later deadline
+	WakeConditionVariable(&sWake);
+
+	return registered;
+}
+
+BOOL VaPostControlCommand(CONTROL_COMMAND Command)
+{
+	BOOL posted = FALSE;
+
+	EnterCriticalSection(&sLock);
+
+	if (sQueueCount < CONTROL_QUEUE_SIZE)
+	{
+		sQueue[(sQueueHead + sQueueCount) % CONTROL_QUEUE_SIZE] = Command;
+
+		sQueueCount += 1;
+
+		posted = TRUE;
+	}
+	else
+	{
+		sStatistics.DroppedCommandCount += 1;
+	}
+
+	LeaveCriticalSection(&sLock);
+
+	if (posted)
+	{
+		WakeConditionVariable(&sWake);
+	}
+
+	return posted;
+}
+VOID VaRequestControlExit(VOID)
+{
+	EnterCriticalSection(&sLock);
+
+	sExitRequested = TRUE;
+
+	LeaveCriticalSection(&sLock);
+
+	WakeConditionVariable(&sWake);
+}
+
+VOID VaRunControlLoop(VOID)
+{
+	EnterCriticalSection(&sLock);
+
+	while (!sExitRequested)
+	{
+		UINT64 now = GetTickCount64();
+
+		if (sQueueCount > 0)
+		{
+			CONTROL_COMMAND command = sQueue[sQueueHead];
+			CONTROL_HANDLER handler = sHandlers[command];
+
+			sQueueHead = (sQueueHead + 1) % CONTROL_QUEUE_SIZE;
+			sQueueCount -= 1;
+
+			sStatistics.CommandCount += 1;
+
+			// Handlers run unlocked so they are free to post further commands
+			LeaveCriticalSection(&sLock);
+
+			if (handler)
+			{
+				handler();
+			}
+			else
+			{
+				VA_LOG("Control command %u has no handler", command);
+			}
+
+			EnterCriticalSection(&sLock);
+
+			continue;
+		}
+
+		VaRunDueTasks(now);
+
+		// Nothing queued and no task due, the thread sleeps until a post, an exit request or the next deadline
+		if (!sExitRequested && (sQueueCount == 0))
+		{
+			SleepConditionVariableCS(&sWake, &sLock, VaGetControlTimeout(GetTickCount64()));
+
+			sStatistics.WakeCount += 1;
+		}
+	}
+
+	LeaveCriticalSection(&sLock);
+
+	// Tasks get a last run so whatever they drain is not lost on exit
+	for (UINT32 i = 0; i < sTaskCount; i++)
+	{
+		sTasks[i].Task();
+	}
+}
+
+VOID VaGetControlStatistics(CONTROL_STATISTICS* Statistics)
+{
+	EnterCriticalSection(&sLock);
+
+	*Statistics = sStatistics;
+
+	LeaveCriticalSection(&sLock);
+}
+
+static DWORD VaGetControlTimeout(UINT64 Now)
+{
+	DWORD timeout = INFINITE;
+
+	for (UINT32 i = 0; i < sTaskCount; i++)
+	{
+		UINT64 nextRun = sTasks[i].NextRun;
+
+		DWORD remaining = (nextRun > Now) ? (DWORD)(nextRun - Now) : 0;
+
+		if (remaining < timeout)
+		{
+			timeout = remaining;
+		}
+	}
+
+	return timeout;
+}
+
+static VOID VaRunDueTasks(UINT64 Now)
+{
+	for (UINT32 i = 0; i < sTaskCount; i++)
+	{
+		CONTROL_TASK_DATA* task = &sTasks[i];
+
+		if (task->NextRun > Now)
+		{
+			continue;
+		}
+
+		task->NextRun = Now + task->Interval;
+
+		CONTROL_TASK function = task->Task;
+
+		LeaveCriticalSection(&sLock);
+
+		function();
+
+		EnterCriticalSection(&sLock);
+
+		sStatistics.TaskRunCount += 1;
+	}
+}
\ No newline at end of file
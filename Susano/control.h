@@ -0,0 +1,37 @@
+#pragma once
+
+#include <windows.h>
+
+#define CONTROL_TASK_COUNT (16)
+
+enum CONTROL_COMMAND
+{
+	CONTROL_COMMAND_ENABLE_HOOKS,
+	CONTROL_COMMAND_DISABLE_HOOKS,
+	CONTROL_COMMAND_RELOAD_CONFIG,
+	CONTROL_COMMAND_COUNT,
+};
+
+typedef VOID(*CONTROL_HANDLER)(VOID);
+typedef VOID(*CONTROL_TASK)(VOID);
+
+struct CONTROL_STATISTICS
+{
+	UINT64 CommandCount;
+	UINT64 DroppedCommandCount;
+	UINT64 TaskRunCount;
+	UINT64 WakeCount;
+};
+
+VOID VaCreateControl(VOID);
+VOID VaDestroyControl(VOID);
+
+VOID VaSetControlHandler(CONTROL_COMMAND Command, CONTROL_HANDLER Handler);
+BOOL VaRegisterControlTask(CONTROL_TASK Task, UINT32 Interval);
+
+BOOL VaPostControlCommand(CONTROL_COMMAND Command);
+VOID VaRequestControlExit(VOID);
+
+VOID VaRunControlLoop(VOID);
+
+VOID VaGetControlStatistics(CONTROL_STATISTICS* Statistics);
\ No newline at end of file
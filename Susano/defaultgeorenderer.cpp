@@ -7,6 +7,9 @@
 
 #include "susano.h"
 #include "linebatchrenderer.h"
+#include "defaultgeorenderer.h"
+#include "pipelinecache.h"
+#include "logger.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "d3dcompiler.lib")
@@ -15,57 +18,51 @@
 // Macros
 /////////////////////////////////////////////////
 
-#define PRINT_LAST_ERROR() printf("0x%08X\n", GetLastError())
+#define PRINT_LAST_ERROR() VA_LOG("0x%08X", GetLastError())
 
 #define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
 
+#define MESH_COUNT (256)
+#define MESH_DRAW_CAPACITY (64)
+
 #define HR_CHECK(EXPRESSION) \
 	{ \
 		HRESULT result = (EXPRESSION); \
 		if (result != S_OK) \
 		{ \
-			printf("%s 0x%08X\n", #EXPRESSION, result); \
+			VA_LOG("%s 0x%08X", #EXPRESSION, result); \
 		} \
 	}
 
-#define COPY_INTO_CONSTANT_BUFFER(BUFFER, VALUE, SIZE) \
-	{ \
-		D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 }; \
-		HR_CHECK(gDeviceContext->Map((BUFFER), NULL, D3D11_MAP_WRITE_DISCARD, NULL, &mappedSubResource)); \
-		memcpy(mappedSubResource.pData, (VALUE), (SIZE)); \
-		gDeviceContext->Unmap((BUFFER), NULL); \
-	}
-
-
 /////////////////////////////////////////////////
 // Type Definition
 /////////////////////////////////////////////////
 
-struct VERTEX
+struct MESH_DATA
 {
-	XMFLOAT3 Position;
-	XMFLOAT4 Color;
+	ID3D11Buffer* VertexBuffer;
+	ID3D11Buffer* IndexBuffer;
+	UINT32 IndexCount;
+	BOOL Allocated;
+};
+
+struct MESH_DRAW
+{
+	MESH Mesh;
+	XMFLOAT4X4 Transform;
 };
 
 /////////////////////////////////////////////////
 // Local Variables
 /////////////////////////////////////////////////
 
-static ID3DBlob* sVertexShaderBlob = NULL;
-static ID3DBlob* sPixelShaderBlob = NULL;
-
-static ID3D11VertexShader* sVertexShader = NULL;
-static ID3D11PixelShader* sPixelShader = NULL;
-static ID3D11InputLayout* sInputLayout = NULL;
-static ID3D11Buffer* sVertexBuffer = NULL;
-static ID3D11Buffer* sIndexBuffer = NULL;
+static PIPELINE sPipeline = INVALID_PIPELINE;
+static CONSTANT_BLOCK sModelViewProjectionBlock = INVALID_CONSTANT_BLOCK;
 
 static CHAR sVertexShaderSource[] = R"hlsl(
-	cbuffer ModelViewProjection : register(b0)
+	cbuffer ModelViewProjection : register(b1)
 	{
-		matrix model;
-		matrix view;
-		matrix projection;
+		matrix modelViewProjection;
 	};
 
 	struct VS_INPUT
@@ -86,9 +83,7 @@ static CHAR sVertexShaderSource[] = R"hlsl(
 
 		float4 position = float4(input.position, 1.0f);
 
-		position = mul(position, model);
-		position = mul(position, view);
-		position = mul(position, projection);
+		position = mul(position, modelViewProjection);
 
 		output.position = position;
 		output.color = input.color;
@@ -113,19 +108,19 @@ static CHAR sPixelShaderSource[] = R"hlsl(
 static D3D11_INPUT_ELEMENT_DESC sInputLayoutSource[] =
 {
 	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 };
 
 static VERTEX sVertices[] =
 {
-	{ XMFLOAT3{ -1.0f, -1.0f, -1.0f }, XMFLOAT4{ 1.0f, 0.0f, 0.0f, 1.0f } },
-	{ XMFLOAT3{  1.0f, -1.0f, -1.0f }, XMFLOAT4{ 1.0f, 0.0f, 0.0f, 1.0f } },
-	{ XMFLOAT3{  1.0f,  1.0f, -1.0f }, XMFLOAT4{ 1.0f, 0.0f, 0.0f, 1.0f } },
-	{ XMFLOAT3{ -1.0f,  1.0f, -1.0f }, XMFLOAT4{ 1.0f, 0.0f, 0.0f, 1.0f } },
-	{ XMFLOAT3{ -1.0f, -1.0f,  1.0f }, XMFLOAT4{ 1.0f, 0.0f, 0.0f, 1.0f } },
-	{ XMFLOAT3{  1.0f, -1.0f,  1.0f }, XMFLOAT4{ 1.0f, 0.0f, 0.0f, 1.0f } },
-	{ XMFLOAT3{  1.0f,  1.0f,  1.0f }, XMFLOAT4{ 1.0f, 0.0f, 0.0f, 1.0f } },
-	{ XMFLOAT3{ -1.0f,  1.0f,  1.0f }, XMFLOAT4{ 1.0f, 0.0f, 0.0f, 1.0f } },
+	{ XMFLOAT3{ -1.0f, -1.0f, -1.0f }, 0xFF0000FF },
+	{ XMFLOAT3{  1.0f, -1.0f, -1.0f }, 0xFF0000FF },
+	{ XMFLOAT3{  1.0f,  1.0f, -1.0f }, 0xFF0000FF },
+	{ XMFLOAT3{ -1.0f,  1.0f, -1.0f }, 0xFF0000FF },
+	{ XMFLOAT3{ -1.0f, -1.0f,  1.0f }, 0xFF0000FF },
+	{ XMFLOAT3{  1.0f, -1.0f,  1.0f }, 0xFF0000FF },
+	{ XMFLOAT3{  1.0f,  1.0f,  1.0f }, 0xFF0000FF },
+	{ XMFLOAT3{ -1.0f,  1.0f,  1.0f }, 0xFF0000FF },
 };
 
 static UINT16 sIndices[] =
@@ -138,14 +133,24 @@ static UINT16 sIndices[] =
 	4, 5, 1, 4, 1, 0,
 };
 
+static MESH_DATA sMeshes[MESH_COUNT] = { 0 };
+
+static MESH sCubeMesh = INVALID_MESH;
+
+static MESH_DRAW* sDraws = NULL;
+static UINT32 sDrawCount = 0;
+static UINT32 sDrawCapacity = 0;
+
+static DEFAULT_GEO_STATISTICS sStatistics = { 0 };
+
 /////////////////////////////////////////////////
 // Function Definition
 /////////////////////////////////////////////////
 
-static VOID VaCreateShaders(VOID);
-static VOID VaCreateVertexBuffers(VOID);
-static VOID VaCreateIndexBuffers(VOID);
-static VOID VaCreateInputLayouts(VOID);
+static VOID VaCreatePipelines(VOID);
+static VOID VaCreateConstantBuffers(VOID);
+
+static VOID VaReleaseMesh(MESH_DATA* Mesh);
 
 /////////////////////////////////////////////////
 // Function Implementation
@@ -153,74 +158,178 @@ static VOID VaCreateInputLayouts(VOID);
 
 VOID VaCreateDefaultGeoRenderer(VOID)
 {
-	VaCreateShaders();
-	VaCreateVertexBuffers();
-	VaCreateIndexBuffers();
-	VaCreateInputLayouts();
+	VaCreatePipelines();
+	VaCreateConstantBuffers();
+
+	sCubeMesh = VaRegisterMesh(sVertices, ARRAY_LENGTH(sVertices), sIndices, ARRAY_LENGTH(sIndices));
 }
 VOID VaDestroyDefaultGeoRenderer(VOID)
 {
-	sVertexShaderBlob->Release();
-	sPixelShaderBlob->Release();
-
-	sVertexShader->Release();
-	sPixelShader->Release();
-	sInputLayout->Release();
-	sVertexBuffer->Release();
-	sIndexBuffer->Release();
+	for (MESH i = 0; i < MESH_COUNT; i++)
+	{
+		VaReleaseMesh(&sMeshes[i]);
+	}
+
+	free(sDraws);
+
+	sDraws = NULL;
+	sDrawCount = 0;
+	sDrawCapacity = 0;
+
+	sCubeMesh = INVALID_MESH;
+
+	memset(&sStatistics, 0, sizeof(sStatistics));
 }
 
-VOID VaRenderDefaultGeo(VOID)
+MESH VaRegisterMesh(const VERTEX* Vertices, UINT32 VertexCount, const UINT16* Indices, UINT32 IndexCount)
 {
-	//gModelViewProjection.Model // TODO
+	for (MESH i = 0; i < MESH_COUNT; i++)
+	{
+		MESH_DATA* mesh = &sMeshes[i];
 
-	COPY_INTO_CONSTANT_BUFFER(sVertexBuffer, sVertices, sizeof(VERTEX) * ARRAY_LENGTH(sVertices));
-	COPY_INTO_CONSTANT_BUFFER(sIndexBuffer, sIndices, sizeof(UINT16) * ARRAY_LENGTH(sIndices));
-	COPY_INTO_CONSTANT_BUFFER(gModelViewProjectionBuffer, &gModelViewProjection, sizeof(MODEL_VIEW_PROJECTION));
+		if (mesh->Allocated)
+		{
+			continue;
+		}
 
-	UINT32 stride = sizeof(VERTEX);
-	UINT32 offset = 0;
+		// Meshes are uploaded exactly once, drawing them later only binds the buffers
+		D3D11_BUFFER_DESC bufferDescription = { 0 };
+		bufferDescription.Usage = D3D11_USAGE_IMMUTABLE;
+		bufferDescription.ByteWidth = sizeof(VERTEX) * VertexCount;
+		bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA subResourceData = { 0 };
+		subResourceData.pSysMem = Vertices;
+
+		HR_CHECK(gDevice->CreateBuffer(&bufferDescription, &subResourceData, &mesh->VertexBuffer));
+
+		bufferDescription.ByteWidth = sizeof(UINT16) * IndexCount;
+		bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+		subResourceData.pSysMem = Indices;
+
+		HR_CHECK(gDevice->CreateBuffer(&bufferDescription, &subResourceData, &mesh->IndexBuffer));
 
-	gDeviceContext->IASetInputLayout(sInputLayout);
-	gDeviceContext->VSSetShader(sVertexShader, NULL, 0);
-	gDeviceContext->VSSetConstantBuffers(0, 1, &gModelViewProjectionBuffer);
-	gDeviceContext->PSSetShader(sPixelShader, NULL, 0);
-	gDeviceContext->IASetVertexBuffers(0, 1, &sVertexBuffer, &stride, &offset);
-	gDeviceContext->IASetIndexBuffer(sIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-	gDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		mesh->IndexCount = IndexCount;
+		mesh->Allocated = TRUE;
 
-	gDeviceContext->DrawIndexed(ARRAY_LENGTH(sIndices), 0, 0);
+		sStatistics.MeshCount += 1;
+
+		return i;
+	}
+
+	return INVALID_MESH;
 }
+VOID VaUnregisterMesh(MESH Mesh)
+{
+	if ((Mesh >= 0) && (Mesh < MESH_COUNT) && sMeshes[Mesh].Allocated)
+	{
+		VaReleaseMesh(&sMeshes[Mesh]);
 
-static VOID VaCreateShaders(VOID)
+		sStatistics.MeshCount -= 1;
+	}
+}
+
+VOID VaDrawMesh(MESH Mesh, XMMATRIX Transform)
 {
-	HR_CHECK(D3DCompile(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), NULL, NULL, NULL, "VS", "vs_4_0", 0, 0, &sVertexShaderBlob, NULL));
-	HR_CHECK(D3DCompile(sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), NULL, NULL, NULL, "PS", "ps_4_0", 0, 0, &sPixelShaderBlob, NULL));
+	if ((Mesh < 0) || (Mesh >= MESH_COUNT) || !sMeshes[Mesh].Allocated)
+	{
+		return;
+	}
+
+	if (sDrawCount == sDrawCapacity)
+	{
+		sDrawCapacity = max(sDrawCapacity * 2, MESH_DRAW_CAPACITY);
+		sDraws = (MESH_DRAW*)realloc(sDraws, sizeof(MESH_DRAW) * sDrawCapacity);
+	}
+
+	MESH_DRAW* draw = &sDraws[sDrawCount];
 
-	HR_CHECK(gDevice->CreateVertexShader(sVertexShaderBlob->GetBufferPointer(), sVertexShaderBlob->GetBufferSize(), NULL, &sVertexShader));
-	HR_CHECK(gDevice->CreatePixelShader(sPixelShaderBlob->GetBufferPointer(), sPixelShaderBlob->GetBufferSize(), NULL, &sPixelShader));
+	draw->Mesh = Mesh;
+
+	XMStoreFloat4x4(&draw->Transform, Transform);
+
+	sDrawCount += 1;
 }
-static VOID VaCreateVertexBuffers(VOID)
+
+VOID VaRenderDefaultGeo(VOID)
 {
-	D3D11_BUFFER_DESC bufferDescription = { 0 };
-	bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
-	bufferDescription.ByteWidth = sizeof(VERTEX) * ARRAY_LENGTH(sVertices);
-	bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	// The cube keeps following the shared model matrix, which is already stored transposed
+	if (sCubeMesh != INVALID_MESH)
+	{
+		VaDrawMesh(sCubeMesh, XMMatrixTranspose(gModelViewProjection.Model));
+	}
+
+	sStatistics.DrawCount = 0;
+	sStatistics.IndexCount = 0;
+
+	XMMATRIX viewProjection = XMMatrixTranspose(gModelViewProjection.ViewProjection);
+
+	UINT32 stride = sizeof(VERTEX);
+	UINT32 offset = 0;
+
+	VaBindPipeline(sPipeline);
+
+	for (UINT32 i = 0; i < sDrawCount; i++)
+	{
+		MESH_DRAW* draw = &sDraws[i];
+		MESH_DATA* mesh = &sMeshes[draw->Mesh];
+
+		// A mesh unregistered after its draw was submitted is silently dropped
+		if (!mesh->Allocated)
+		{
+			continue;
+		}
 
-	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, NULL, &sVertexBuffer));
+		VaBindVertexBuffers(1, &mesh->VertexBuffer, &stride, &offset);
+		VaBindIndexBuffer(mesh->IndexBuffer, 0);
+
+		// Each draw gets its full transform folded on the cpu, the shader does a single multiply per vertex
+		XMFLOAT4X4 modelViewProjection;
+
+		XMStoreFloat4x4(&modelViewProjection, XMMatrixTranspose(XMMatrixMultiply(XMLoadFloat4x4(&draw->Transform), viewProjection)));
+
+		VaWriteConstantBlock(sModelViewProjectionBlock, &modelViewProjection);
+
+		ID3D11Buffer* modelViewProjectionBuffer = VaCommitConstantBlock(sModelViewProjectionBlock);
+
+		VaBindConstantBuffers(1, 1, &modelViewProjectionBuffer);
+
+		gDeviceContext->DrawIndexed(mesh->IndexCount, 0, 0);
+
+		sStatistics.DrawCount += 1;
+		sStatistics.IndexCount += mesh->IndexCount;
+	}
+
+	sDrawCount = 0;
 }
-static VOID VaCreateIndexBuffers(VOID)
+
+VOID VaGetDefaultGeoStatistics(DEFAULT_GEO_STATISTICS* Statistics)
 {
-	D3D11_BUFFER_DESC bufferDescription = { 0 };
-	bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
-	bufferDescription.ByteWidth = sizeof(UINT16) * ARRAY_LENGTH(sIndices);
-	bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	*Statistics = sStatistics;
+}
 
-	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, NULL, &sIndexBuffer));
+static VOID VaCreatePipelines(VOID)
+{
+	sPipeline = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
-static VOID VaCreateInputLayouts(VOID)
+static VOID VaCreateConstantBuffers(VOID)
+{
+	sModelViewProjectionBlock = VaCreateConstantBlock(sizeof(XMFLOAT4X4));
+}
+
+static VOID VaReleaseMesh(MESH_DATA* Mesh)
 {
-	HR_CHECK(gDevice->CreateInputLayout(sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), sVertexShaderBlob->GetBufferPointer(), sVertexShaderBlob->GetBufferSize(), &sInputLayout));
+	if (!Mesh->Allocated)
+	{
+		return;
+	}
+
+	Mesh->VertexBuffer->Release();
+	Mesh->IndexBuffer->Release();
+
+	Mesh->VertexBuffer = NULL;
+	Mesh->IndexBuffer = NULL;
+	Mesh->IndexCount = 0;
+	Mesh->Allocated = FALSE;
 }
\ No newline at end of file
@@ -4,9 +4,29 @@
 
 #include <directxmath.h>
 
+#include "susano.h"
+
 using namespace DirectX;
 
+#define INVALID_MESH (-1)
+
+typedef INT32 MESH;
+
+struct DEFAULT_GEO_STATISTICS
+{
+	UINT32 MeshCount;
+	UINT32 DrawCount;
+	UINT64 IndexCount;
+};
+
 VOID VaCreateDefaultGeoRenderer(VOID);
 VOID VaDestroyDefaultGeoRenderer(VOID);
 
-VOID VaRenderDefaultGeo(VOID);
\ No newline at end of file
+MESH VaRegisterMesh(const VERTEX* Vertices, UINT32 VertexCount, const UINT16* Indices, UINT32 IndexCount);
+VOID VaUnregisterMesh(MESH Mesh);
+
+VOID VaDrawMesh(MESH Mesh, XMMATRIX Transform);
+
+VOID VaRenderDefaultGeo(VOID);
+
+VOID VaGetDefaultGeoStatistics(DEFAULT_GEO_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include <string.h>
+
+#include <atomic>
+
+#include "profiler.h"
+#include "offsets.h"
+#include "safememory.h"
+#include "gamestructs.h"
+#include "gamestate.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define GAME_STATE_MINIMUM_RATE (1)
+#define GAME_STATE_MAXIMUM_RATE (1000)
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION (0x00000002)
+#endif
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+// Odd while the sampler is writing, readers retry until they saw the same even value before and after their copy
+static volatile LONG64 sSequence = 0;
+
+static GAME_STATE sState = { 0 };
+
+// Field handles are only valid for the schema generation they were looked up in
+static UINT32 sFieldGeneration = 0;
+
+static OFFSET_FIELD sWindowWidthField = INVALID_OFFSET_FIELD;
+static OFFSET_FIELD sWindowHeightField = INVALID_OFFSET_FIELD;
+static OFFSET_FIELD sPlayerObjectField = INVALID_OFFSET_FIELD;
+static OFFSET_FIELD sCameraBlockField = INVALID_OFFSET_FIELD;
+
+static volatile LONG sRate = GAME_STATE_DEFAULT_RATE;
+
+// The sampler signals the done event right before it returns, destroy runs under the loader lock and must never wait on the thread itself
+static HANDLE sSamplerStopEvent = NULL;
+static HANDLE sSamplerDoneEvent = NULL;
+static HANDLE sSamplerTimer = NULL;
+
+static volatile LONG64 sSampleCount = 0;
+static volatile LONG64 sReadCount = 0;
+static volatile LONG64 sRetryCount = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static INT32 WINAPI VaSamplerThread(PVOID UserParam);
+
+static VOID VaFindGameStateFields(VOID);
+
+static VOID VaSampleGameState(GAME_STATE* State);
+static VOID VaPublishGameState(const GAME_STATE* State);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateGameStateSampler(VOID)
+{
+	sFieldGeneration = 0;
+
+	sSequence = 0;
+	sSampleCount = 0;
+	sReadCount = 0;
+	sRetryCount = 0;
+
+	// The default timer only ticks every 15.6 ms, the high resolution one keeps rates above 64 Hz honest
+	sSamplerTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+	if (!sSamplerTimer)
+	{
+		sSamplerTimer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+	}
+
+	sSamplerStopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	sSamplerDoneEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	CloseHandle(CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)VaSamplerThread, NULL, 0, NULL));
+}
+VOID VaDestroyGameStateSampler(VOID)
+{
+	SetEvent(sSamplerStopEvent);
+
+	WaitForSingleObject(sSamplerDoneEvent, INFINITE);
+
+	CloseHandle(sSamplerStopEvent);
+	CloseHandle(sSamplerDoneEvent);
+	CloseHandle(sSamplerTimer);
+
+	sSamplerStopEvent = NULL;
+	sSamplerDoneEvent = NULL;
+	sSamplerTimer = NULL;
+}
+
+VOID VaSetGameStateSampleRate(UINT32 Rate)
+{
+	sRate = (LONG)min(max(Rate, GAME_STATE_MINIMUM_RATE), GAME_STATE_MAXIMUM_RATE);
+}
+
+BOOL VaReadGameState(GAME_STATE* State)
+{
+	InterlockedIncrement64(&sReadCount);
+
+	while (TRUE)
+	{
+		LONG64 before = ReadAcquire64(&sSequence);
+
+		if (before == 0)
+		{
+			return FALSE;
+		}
+
+		if (before & 1)
+		{
+			YieldProcessor();
+
+			continue;
+		}
+
+		memcpy(State, (const VOID*)&sState, sizeof(GAME_STATE));
+
+		// The copy has to be complete before the sequence is looked at again
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (ReadNoFence64(&sSequence) == before)
+		{
+			return TRUE;
+		}
+
+		InterlockedIncrement64(&sRetryCount);
+	}
+}
+
+VOID VaGetGameStateStatistics(GAME_STATE_STATISTICS* Statistics)
+{
+	Statistics->Rate = sRate;
+	Statistics->SampleCount = sSampleCount;
+	Statistics->ReadCount = sReadCount;
+	Statistics->RetryCount = sRetryCount;
+}
+
+static INT32 WINAPI VaSamplerThread(PVOID UserParam)
+{
+	HANDLE handles[] = { sSamplerStopEvent, sSamplerTimer };
+
+	GAME_STATE state = { 0 };
+
+	while (TRUE)
+	{
+		// Relative due times are negative and counted in 100 ns units
+		LARGE_INTEGER dueTime = { 0 };
+		dueTime.QuadPart = -(10000000LL / sRate);
+
+		SetWaitableTimer(sSamplerTimer, &dueTime, 0, NULL, NULL, FALSE);
+
+		if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != (WAIT_OBJECT_0 + 1))
+		{
+			break;
+		}
+
+		VaSampleGameState(&state);
+		VaPublishGameState(&state);
+	}
+
+	SetEvent(sSamplerDoneEvent);
+
+	return 0;
+}
+
+static VOID VaFindGameStateFields(VOID)
+{
+	sWindowWidthField = VaFindOffsetField("window_width");
+	sWindowHeightField = VaFindOffsetField("window_height");
+	sPlayerObjectField = VaFindOffsetField("player_object");
+	sCameraBlockField = VaFindOffsetField("camera_block");
+}
+
+static VOID VaSampleGameState(GAME_STATE* State)
+{
+	State->SampleIndex += 1;
+	State->SampleTime = VaQueryProfilerTime();
+
+	VaResolveOffsets();
+
+	VaAcquireOffsets();
+
+	UINT32 generation = VaGetOffsetGeneration();
+
+	if (generation != sFieldGeneration)
+	{
+		VaFindGameStateFields();
+
+		sFieldGeneration = generation;
+	}
+
+	VaReadOffsetField(sWindowWidthField, &State->WindowWidth, sizeof(State->WindowWidth));
+	VaReadOffsetField(sWindowHeightField, &State->WindowHeight, sizeof(State->WindowHeight));
+
+	GAME_STRUCT_VIEW<PLAYER_OBJECT> player;
+	GAME_STRUCT_VIEW<CAMERA_BLOCK> camera;
+
+	// Every structure is fetched with one copy, the player object only exists while a level is loaded
+	State->PlayerValid = VaReadGameStruct(VaSafeRead, VaGetOffsetFieldAddress(sPlayerObjectField), &player);
+
+	BOOL cameraValid = VaReadGameStruct(VaSafeRead, VaGetOffsetFieldAddress(sCameraBlockField), &camera);
+
+	VaReleaseOffsets();
+
+	if (State->PlayerValid)
+	{
+		State->PlayerX = player.Get<PLAYER_OBJECT::PositionX>();
+		State->PlayerY = player.Get<PLAYER_OBJECT::PositionY>();
+		State->PlayerZ = player.Get<PLAYER_OBJECT::PositionZ>();
+	}
+
+	if (cameraValid)
+	{
+		State->CameraPitch = camera.Get<CAMERA_BLOCK::Pitch>();
+		State->CameraYaw = camera.Get<CAMERA_BLOCK::Yaw>();
+		State->CameraDistance = camera.Get<CAMERA_BLOCK::Distance>();
+		State->CameraHeight = camera.Get<CAMERA_BLOCK::Height>();
+		State->Fov = camera.Get<CAMERA_BLOCK::Fov>();
+	}
+}
+static VOID VaPublishGameState(const GAME_STATE* State)
+{
+	LONG64 sequence = sSequence;
+
+	WriteNoFence64(&sSequence, sequence + 1);
+
+	// Readers must never see the new contents together with the old even sequence
+	std::atomic_thread_fence(std::memory_order_release);
+
+	memcpy((VOID*)&sState, State, sizeof(GAME_STATE));
+
+	WriteRelease64(&sSequence, sequence + 2);
+
+	InterlockedIncrement64(&sSampleCount);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <windows.h>
+
+#define GAME_STATE_DEFAULT_RATE (120)
+
+// One consistent sample of everything the overlays read from the game
+struct GAME_STATE
+{
+	UINT64 SampleIndex;
+	UINT64 SampleTime;
+	UINT32 WindowWidth;
+	UINT32 WindowHeight;
+	BOOL PlayerValid;
+	FLOAT PlayerX;
+	FLOAT PlayerY;
+	FLOAT PlayerZ;
+	FLOAT CameraPitch;
+	FLOAT CameraYaw;
+	FLOAT CameraDistance;
+	FLOAT CameraHeight;
+	FLOAT Fov;
+};
+
+struct GAME_STATE_STATISTICS
+{
+	UINT32 Rate;
+	UINT64 SampleCount;
+	UINT64 ReadCount;
+	UINT64 RetryCount;
+};
+
+VOID VaCreateGameStateSampler(VOID);
+VOID VaDestroyGameStateSampler(VOID);
+
+VOID VaSetGameStateSampleRate(UINT32 Rate);
+
+BOOL VaReadGameState(GAME_STATE* State);
+
+VOID VaGetGameStateStatistics(GAME_STATE_STATISTICS* Statistics);
\ No newline at end of file
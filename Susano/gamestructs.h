@@ -0,0 +1,165 @@
+#pragma once
+
+#include <string.h>
+
+#include <windows.h>
+
+#include <type_traits>
+
+// Game structures are declared once as a field list, FIELD(NAME, OFFSET, TYPE), and expanded into typed field tags,
+// a descriptor table for tools and the extent of the single contiguous copy that reads every field of the object
+#define DECLARE_GAME_STRUCT(NAME, FIELDS) \
+	static constexpr GAME_FIELD_DESCRIPTION NAME##_FIELDS[] = { FIELDS(GAME_STRUCT_DESCRIBE_FIELD) }; \
+	static_assert(VaAreGameFieldsDisjoint(NAME##_FIELDS, ARRAYSIZE(NAME##_FIELDS)), #NAME " has overlapping fields"); \
+	struct NAME \
+	{ \
+		typedef NAME Owner; \
+		FIELDS(GAME_STRUCT_DECLARE_FIELD) \
+		static constexpr UINT32 FieldCount = ARRAYSIZE(NAME##_FIELDS); \
+		static constexpr UINT32 Begin = VaGetGameStructBegin(NAME##_FIELDS, ARRAYSIZE(NAME##_FIELDS)); \
+		static constexpr UINT32 End = VaGetGameStructEnd(NAME##_FIELDS, ARRAYSIZE(NAME##_FIELDS)); \
+		static constexpr UINT32 Size = End - Begin; \
+		static GAME_STRUCT_DESCRIPTION Describe(VOID) { return { #NAME, NAME##_FIELDS, FieldCount, Begin, Size }; } \
+	}; \
+	static_assert(NAME::Size <= GAME_STRUCT_MAXIMUM_SIZE, #NAME " is too large for a single read")
+
+#define GAME_STRUCT_DECLARE_FIELD(NAME, OFFSET, TYPE) typedef GAME_FIELD<Owner, TYPE, OFFSET> NAME;
+#define GAME_STRUCT_DESCRIBE_FIELD(NAME, OFFSET, TYPE) { #NAME, OFFSET, sizeof(TYPE), GAME_FIELD_TRAITS<TYPE>::Type },
+
+#define GAME_STRUCT_MAXIMUM_SIZE (0x1000)
+
+enum GAME_FIELD_TYPE
+{
+	GAME_FIELD_TYPE_U8,
+	GAME_FIELD_TYPE_U16,
+	GAME_FIELD_TYPE_U32,
+	GAME_FIELD_TYPE_U64,
+	GAME_FIELD_TYPE_I32,
+	GAME_FIELD_TYPE_F32,
+	GAME_FIELD_TYPE_F64,
+};
+
+template<typename TYPE> struct GAME_FIELD_TRAITS;
+
+template<> struct GAME_FIELD_TRAITS<UINT8> { static constexpr GAME_FIELD_TYPE Type = GAME_FIELD_TYPE_U8; };
+template<> struct GAME_FIELD_TRAITS<UINT16> { static constexpr GAME_FIELD_TYPE Type = GAME_FIELD_TYPE_U16; };
+template<> struct GAME_FIELD_TRAITS<UINT32> { static constexpr GAME_FIELD_TYPE Type = GAME_FIELD_TYPE_U32; };
+template<> struct GAME_FIELD_TRAITS<UINT64> { static constexpr GAME_FIELD_TYPE Type = GAME_FIELD_TYPE_U64; };
+template<> struct GAME_FIELD_TRAITS<INT32> { static constexpr GAME_FIELD_TYPE Type = GAME_FIELD_TYPE_I32; };
+template<> struct GAME_FIELD_TRAITS<FLOAT> { static constexpr GAME_FIELD_TYPE Type = GAME_FIELD_TYPE_F32; };
+template<> struct GAME_FIELD_TRAITS<DOUBLE> { static constexpr GAME_FIELD_TYPE Type = GAME_FIELD_TYPE_F64; };
+
+struct GAME_FIELD_DESCRIPTION
+{
+	LPCSTR Name;
+	UINT32 Offset;
+	UINT32 Size;
+	GAME_FIELD_TYPE Type;
+};
+
+struct GAME_STRUCT_DESCRIPTION
+{
+	LPCSTR Name;
+	const GAME_FIELD_DESCRIPTION* Fields;
+	UINT32 FieldCount;
+	UINT32 Begin;
+	UINT32 Size;
+};
+
+// Typed tag of one field, it carries everything an accessor needs so reading it compiles down to a single load
+template<typename OWNER, typename TYPE, UINT32 OFFSET>
+struct GAME_FIELD
+{
+	typedef OWNER Owner;
+	typedef TYPE Type;
+
+	static constexpr UINT32 Offset = OFFSET;
+	static constexpr UINT32 End = OFFSET + sizeof(TYPE);
+};
+
+constexpr UINT32 VaGetGameStructBegin(const GAME_FIELD_DESCRIPTION* Fields, UINT32 FieldCount)
+{
+	UINT32 begin = 0xFFFFFFFF;
+
+	for (UINT32 i = 0; i < FieldCount; i++)
+	{
+		begin = (Fields[i].Offset < begin) ? Fields[i].Offset : begin;
+	}
+
+	return begin;
+}
+constexpr UINT32 VaGetGameStructEnd(const GAME_FIELD_DESCRIPTION* Fields, UINT32 FieldCount)
+{
+	UINT32 end = 0;
+
+	for (UINT32 i = 0; i < FieldCount; i++)
+	{
+		end = ((Fields[i].Offset + Fields[i].Size) > end) ? (Fields[i].Offset + Fields[i].Size) : end;
+	}
+
+	return end;
+}
+
+constexpr BOOL VaAreGameFieldsDisjoint(const GAME_FIELD_DESCRIPTION* Fields, UINT32 FieldCount)
+{
+	for (UINT32 i = 0; i < FieldCount; i++)
+	{
+		for (UINT32 j = i + 1; j < FieldCount; j++)
+		{
+			if ((Fields[i].Offset < (Fields[j].Offset + Fields[j].Size)) && (Fields[j].Offset < (Fields[i].Offset + Fields[i].Size)))
+			{
+				return FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+// Destination of a read plan, Bytes mirrors the object from its first to the end of its last declared field
+template<typename STRUCT>
+struct GAME_STRUCT_VIEW
+{
+	BYTE Bytes[STRUCT::Size];
+
+	template<typename FIELD>
+	typename FIELD::Type Get(VOID) const
+	{
+		static_assert(std::is_same<typename FIELD::Owner, STRUCT>::value, "Field is not part of this structure");
+
+		typename FIELD::Type value;
+
+		memcpy(&value, Bytes + (FIELD::Offset - STRUCT::Begin), sizeof(value));
+
+		return value;
+	}
+};
+
+// In process the copy goes through VaSafeRead, out of process the view becomes one entry of a remote batch
+template<typename STRUCT, typename READ_PROC>
+BOOL VaReadGameStruct(READ_PROC ReadProc, UINT64 Address, GAME_STRUCT_VIEW<STRUCT>* View)
+{
+	return Address && ReadProc(Address + STRUCT::Begin, View->Bytes, STRUCT::Size);
+}
+
+/////////////////////////////////////////////////
+// Game Structures
+/////////////////////////////////////////////////
+
+#define PLAYER_OBJECT_FIELDS(FIELD) \
+	FIELD(PositionX, 0x80, FLOAT) \
+	FIELD(PositionY, 0x84, FLOAT) \
+	FIELD(PositionZ, 0x88, FLOAT)
+
+#define CAMERA_BLOCK_FIELDS(FIELD) \
+	FIELD(Pitch, 0x00, FLOAT) \
+	FIELD(Yaw, 0x04, FLOAT) \
+	FIELD(Fov, 0x20, FLOAT) \
+	FIELD(Distance, 0x4C, FLOAT) \
+	FIELD(Height, 0x50, FLOAT)
+
+DECLARE_GAME_STRUCT(PLAYER_OBJECT, PLAYER_OBJECT_FIELDS);
+DECLARE_GAME_STRUCT(CAMERA_BLOCK, CAMERA_BLOCK_FIELDS);
+
+static_assert((PLAYER_OBJECT::Begin == 0x80) && (PLAYER_OBJECT::Size == 0xC), "Player object plan changed");
+static_assert((CAMERA_BLOCK::Begin == 0x00) && (CAMERA_BLOCK::Size == 0x54), "Camera block plan changed");
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include <string.h>
+
+#include "hash.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+	#define HASH_SSE2
+	#include <emmintrin.h>
+#endif
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define HASH_LANE_COUNT (8)
+#define HASH_STRIPE_SIZE (HASH_LANE_COUNT * sizeof(UINT64))
+#define HASH_STRIPES_PER_BLOCK (16)
+#define HASH_BLOCK_SIZE (HASH_STRIPE_SIZE * HASH_STRIPES_PER_BLOCK)
+
+#define HASH_PRIME32_1 (0x9E3779B1U)
+#define HASH_PRIME32_2 (0x85EBCA77U)
+#define HASH_PRIME32_3 (0xC2B2AE3DU)
+
+#define HASH_PRIME64_1 (0x9E3779B185EBCA87ULL)
+#define HASH_PRIME64_2 (0xC2B2AE3D27D4EB4FULL)
+#define HASH_PRIME64_3 (0x165667B19E3779F9ULL)
+#define HASH_PRIME64_4 (0x85EBCA77C2B2AE63ULL)
+#define HASH_PRIME64_5 (0x27D4EB2F165667C5ULL)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+// Hexadecimal digits of pi, one key per accumulator lane
+static const UINT64 sSecret[HASH_LANE_COUNT] =
+{
+	0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL,
+	0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+	0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL,
+	0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL,
+};
+
+static const UINT64 sAccumulatorSeed[HASH_LANE_COUNT] =
+{
+	HASH_PRIME32_3, HASH_PRIME64_1, HASH_PRIME64_2, HASH_PRIME64_3,
+	HASH_PRIME64_4, HASH_PRIME32_2, HASH_PRIME64_5, HASH_PRIME32_1,
+};
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaAccumulateStripe(UINT64* Accumulators, const BYTE* Stripe);
+static VOID VaScrambleAccumulators(UINT64* Accumulators);
+
+static UINT64 VaMultiplyFold(UINT64 A, UINT64 B);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+UINT64 VaHashMemory(const VOID* Data, SIZE_T Size)
+{
+	const BYTE* bytes = (const BYTE*)Data;
+
+	__declspec(align(16)) UINT64 accumulators[HASH_LANE_COUNT];
+
+	memcpy(accumulators, sAccumulatorSeed, sizeof(accumulators));
+
+	if (Size < HASH_STRIPE_SIZE)
+	{
+		// Short inputs are zero padded into a single stripe, the length mixed in below keeps padded inputs apart
+		BYTE stripe[HASH_STRIPE_SIZE] = { 0 };
+
+		memcpy(stripe, bytes, Size);
+
+		VaAccumulateStripe(accumulators, stripe);
+	}
+	else
+	{
+		SIZE_T stripeCount = Size / HASH_STRIPE_SIZE;
+
+		for (SIZE_T i = 0; i < stripeCount; i++)
+		{
+			VaAccumulateStripe(accumulators, bytes + i * HASH_STRIPE_SIZE);
+
+			if ((i % HASH_STRIPES_PER_BLOCK) == (HASH_STRIPES_PER_BLOCK - 1))
+			{
+				VaScrambleAccumulators(accumulators);
+			}
+		}
+
+		// The remainder is covered by one more stripe ending exactly at the last byte
+		if ((Size % HASH_STRIPE_SIZE) != 0)
+		{
+			VaAccumulateStripe(accumulators, bytes + Size - HASH_STRIPE_SIZE);
+		}
+	}
+
+	UINT64 hash = (UINT64)Size * HASH_PRIME64_1;
+
+	for (UINT32 i = 0; i < HASH_LANE_COUNT; i += 2)
+	{
+		hash += VaMultiplyFold(accumulators[i] ^ sSecret[(i + 3) % HASH_LANE_COUNT], accumulators[i + 1] ^ sSecret[(i + 4) % HASH_LANE_COUNT]);
+	}
+
+	hash ^= hash >> 37;
+	hash *= HASH_PRIME64_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+static VOID VaAccumulateStripe(UINT64* Accumulators, const BYTE* Stripe)
+{
+#ifdef HASH_SSE2
+	// Two lanes per register, the 32x32 multiply and the swapped add are exactly the scalar path below
+	for (UINT32 i = 0; i < HASH_LANE_COUNT; i += 2)
+	{
+		__m128i accumulator = _mm_load_si128((const __m128i*)(Accumulators + i));
+		__m128i data = _mm_loadu_si128((const __m128i*)(Stripe + i * sizeof(UINT64)));
+		__m128i key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)(sSecret + i)));
+
+		__m128i product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+		__m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+
+		accumulator = _mm_add_epi64(accumulator, _mm_add_epi64(product, swapped));
+
+		_mm_store_si128((__m128i*)(Accumulators + i), accumulator);
+	}
+#else
+	for (UINT32 i = 0; i < HASH_LANE_COUNT; i++)
+	{
+		UINT64 data;
+		UINT64 swapped;
+
+		memcpy(&data, Stripe + i * sizeof(UINT64), sizeof(UINT64));
+		memcpy(&swapped, Stripe + (i ^ 1) * sizeof(UINT64), sizeof(UINT64));
+
+		UINT64 key = data ^ sSecret[i];
+
+		Accumulators[i] += (UINT64)(UINT32)key * (UINT64)(UINT32)(key >> 32) + swapped;
+	}
+#endif
+}
+static VOID VaScrambleAccumulators(UINT64* Accumulators)
+{
+#ifdef HASH_SSE2
+	// SSE2 has no 64 bit multiply, the product with a 32 bit prime is assembled from both halves
+	__m128i prime = _mm_set1_epi32((INT32)HASH_PRIME32_1);
+
+	for (UINT32 i = 0; i < HASH_LANE_COUNT; i += 2)
+	{
+		__m128i accumulator = _mm_load_si128((const __m128i*)(Accumulators + i));
+
+		accumulator = _mm_xor_si128(accumulator, _mm_srli_epi64(accumulator, 47));
+		accumulator = _mm_xor_si128(accumulator, _mm_loadu_si128((const __m128i*)(sSecret + i)));
+
+		__m128i productLow = _mm_mul_epu32(accumulator, prime);
+		__m128i productHigh = _mm_mul_epu32(_mm_shuffle_epi32(accumulator, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+
+		accumulator = _mm_add_epi64(productLow, _mm_slli_epi64(productHigh, 32));
+
+		_mm_store_si128((__m128i*)(Accumulators + i), accumulator);
+	}
+#else
+	for (UINT32 i = 0; i < HASH_LANE_COUNT; i++)
+	{
+		UINT64 accumulator = Accumulators[i];
+
+		accumulator ^= accumulator >> 47;
+		accumulator ^= sSecret[i];
+		accumulator *= HASH_PRIME32_1;
+
+		Accumulators[i] = accumulator;
+	}
+#endif
+}
+
+static UINT64 VaMultiplyFold(UINT64 A, UINT64 B)
+{
+	// Full 128 bit product from 32 bit halves, the high and low words are folded together
+	UINT64 aLow = (UINT32)A;
+	UINT64 aHigh = A >> 32;
+	UINT64 bLow = (UINT32)B;
+	UINT64 bHigh = B >> 32;
+
+	UINT64 lowLow = aLow * bLow;
+	UINT64 highLow = aHigh * bLow;
+	UINT64 lowHigh = aLow * bHigh;
+	UINT64 highHigh = aHigh * bHigh;
+
+	UINT64 cross = (lowLow >> 32) + (UINT32)highLow + lowHigh;
+
+	UINT64 low = (cross << 32) | (UINT32)lowLow;
+	UINT64 high = (highLow >> 32) + (cross >> 32) + highHigh;
+
+	return low ^ high;
+}
\ No newline at end of file
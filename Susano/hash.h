@@ -0,0 +1,5 @@
+#pragma once
+
+#include <windows.h>
+
+UINT64 VaHashMemory(const VOID* Data, SIZE_T Size);
\ No newline at end of file
@@ -7,6 +7,10 @@
 
 #include "susano.h"
 #include "linebatchrenderer.h"
+#include "uploadring.h"
+#include "pipelinecache.h"
+#include "logger.h"
+#include "hash.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "d3dcompiler.lib")
@@ -15,59 +19,131 @@
 // Macros
 /////////////////////////////////////////////////
 
-#define PRINT_LAST_ERROR() printf("0x%08X\n", GetLastError())
+#define PRINT_LAST_ERROR() VA_LOG("0x%08X", GetLastError())
 
 #define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
 
 #define VERTEX_BUFFER_SIZE (65535)
 #define INDEX_BUFFER_SIZE (VERTEX_BUFFER_SIZE * 2)
 
+#define ALIGN_UP_4(VALUE) (((VALUE) + 3) & ~3)
+
+#define LINE_PRIMITIVE_CAPACITY (ALIGN_UP_4(VERTEX_BUFFER_SIZE / 2))
+#define BOX_PRIMITIVE_CAPACITY (ALIGN_UP_4(VERTEX_BUFFER_SIZE / 8))
+
+#define LINE_LAYER_COUNT (32)
+
+#define LINE_PRODUCER_IDLE (-1)
+#define LINE_PRODUCER_TRIMMING (-2)
+#define LINE_PRODUCER_RETIRED (-3)
+
+#define LINE_PRODUCER_TRIM_EPOCHS (120)
+
 #define HR_CHECK(EXPRESSION) \
 	{ \
 		HRESULT result = (EXPRESSION); \
 		if (result != S_OK) \
 		{ \
-			printf("%s 0x%08X\n", #EXPRESSION, result); \
+			VA_LOG("%s 0x%08X", #EXPRESSION, result); \
 		} \
 	}
 
-#define COPY_INTO_CONSTANT_BUFFER(BUFFER, VALUE, SIZE) \
-	{ \
-		D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 }; \
-		HR_CHECK(gDeviceContext->Map((BUFFER), NULL, D3D11_MAP_WRITE_DISCARD, NULL, &mappedSubResource)); \
-		memcpy(mappedSubResource.pData, (VALUE), (SIZE)); \
-		gDeviceContext->Unmap((BUFFER), NULL); \
-	}
-
 /////////////////////////////////////////////////
 // Type Definition
 /////////////////////////////////////////////////
 
-struct VERTEX
+static_assert(sizeof(VERTEX) == sizeof(XMFLOAT4), "A vertex must fill exactly one vector register");
+
+struct LINE_BATCH_PRIMITIVE
+{
+	UINT16 VertexCount;
+	UINT16 IndexCount;
+};
+
+// Primitives never straddle two chunks, so every index stays below VERTEX_BUFFER_SIZE and fits into 16 bits
+// The bounds are stored as six arrays (min xyz, max xyz) of PrimitiveCapacity floats each, so four boxes are culled per vector
+struct LINE_BATCH_CHUNK
+{
+	VERTEX* Vertices;
+	UINT16* Indices;
+	FLOAT* Bounds;
+	LINE_BATCH_PRIMITIVE* Primitives;
+	UINT32 VertexOffset;
+	UINT32 IndexOffset;
+	UINT32 PrimitiveCount;
+	UINT32 PrimitiveCapacity;
+	LINE_BATCH_CHUNK* Next;
+};
+
+struct FRUSTUM_PLANE
+{
+	XMVECTOR X;
+	XMVECTOR Y;
+	XMVECTOR Z;
+	XMVECTOR W;
+	BOOL PositiveX;
+	BOOL PositiveY;
+	BOOL PositiveZ;
+};
+
+// Non-indexed chains carry no index storage and are submitted with Draw
+struct LINE_BATCH_CHAIN
+{
+	LINE_BATCH_CHUNK* First;
+	LINE_BATCH_CHUNK* Current;
+	BOOL Indexed;
+};
+
+// Every recording thread owns one producer, the two halves alternate between frames so the render thread never reads the half being written
+struct LINE_PRODUCER
+{
+	LINE_BATCH_CHAIN LineChains[2];
+	LINE_BATCH_CHAIN IndexedChains[2];
+	volatile LONG Epoch;
+	volatile LONG LastEpoch;
+	LINE_PRODUCER* Next;
+};
+
+// The producer of a thread is handed back to the render thread when the thread exits, a slot of an older renderer generation is never touched again
+struct LINE_PRODUCER_SLOT
 {
-	XMFLOAT3 Position;
-	XMFLOAT4 Color;
+	LINE_PRODUCER* Producer;
+	LONG Generation;
+	~LINE_PRODUCER_SLOT();
+};
+
+// Indexed chunks keep their 16-bit indices and are drawn with a base vertex into the shared immutable buffers
+struct LINE_LAYER_RANGE
+{
+	UINT32 StartIndex;
+	UINT32 IndexCount;
+	UINT32 BaseVertex;
+};
+
+struct LINE_LAYER_DATA
+{
+	BOOL Allocated;
+	BOOL Recorded;
+	UINT32 InputSize;
+	UINT64 InputHash;
+	ID3D11Buffer* VertexBuffer;
+	ID3D11Buffer* IndexBuffer;
+	UINT32 VertexCount;
+	UINT32 NonIndexedVertexCount;
+	UINT32 RangeCount;
+	LINE_LAYER_RANGE* Ranges;
 };
 
 /////////////////////////////////////////////////
 // Local Variables
 /////////////////////////////////////////////////
 
-static ID3DBlob* sVertexShaderBlob = NULL;
-static ID3DBlob* sPixelShaderBlob = NULL;
-
-static ID3D11VertexShader* sVertexShader = NULL;
-static ID3D11PixelShader* sPixelShader = NULL;
-static ID3D11InputLayout* sInputLayout = NULL;
-static ID3D11Buffer* sVertexBuffer = NULL;
-static ID3D11Buffer* sIndexBuffer = NULL;
+static PIPELINE sPipeline = INVALID_PIPELINE;
 
 static CHAR sVertexShaderSource[] = R"hlsl(
-	cbuffer ModelViewProjection : register(b0)
+	cbuffer ViewProjection : register(b0)
 	{
-		matrix model;
-		matrix view;
-		matrix projection;
+		matrix viewProjection;
 	};
 
 	struct VS_INPUT
@@ -88,8 +164,7 @@ static CHAR sVertexShaderSource[] = R"hlsl(
 
 		float4 position = float4(input.position, 1.0f);
 
-		position = mul(position, view);
-		position = mul(position, projection);
+		position = mul(position, viewProjection);
 
 		output.position = position;
 		output.color = input.color;
@@ -114,23 +189,88 @@ static CHAR sPixelShaderSource[] = R"hlsl(
 static D3D11_INPUT_ELEMENT_DESC sInputLayoutSource[] =
 {
 	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 };
 
-static VERTEX* sVertices = NULL;
-static UINT16* sIndices = NULL;
+static LINE_PRODUCER* volatile sProducers = NULL;
+
+static volatile LONG sEpoch = 0;
+static volatile LONG sGeneration = 0;
+
+static thread_local LINE_PRODUCER_SLOT tProducer = { NULL, 0 };
+
+static LINE_BATCH_CHAIN sLayerLineChain = { NULL, NULL, FALSE };
+static LINE_BATCH_CHAIN sLayerIndexedChain = { NULL, NULL, TRUE };
+
+static thread_local LINE_BATCH_CHAIN* tLayerLineChain = NULL;
+static thread_local LINE_BATCH_CHAIN* tLayerIndexedChain = NULL;
+
+static LINE_LAYER_DATA sLayers[LINE_LAYER_COUNT] = { 0 };
 
-static UINT16 sVertexOffset = 0;
-static UINT16 sIndexOffset = 0;
+static LINE_LAYER sRecordingLayer = INVALID_LINE_LAYER;
+static LINE_LAYER sSubmittedLayers[LINE_LAYER_COUNT] = { 0 };
+static UINT32 sSubmittedLayerCount = 0;
+
+static LINE_BATCH_STATISTICS sStatistics = { 0 };
+
+static volatile LONG sChunkCount = 0;
+static volatile LONG64 sAllocatedBytes = 0;
+
+static FRUSTUM_PLANE sFrustumPlanes[6];
+
+static BYTE* sVisibility = NULL;
+
+static VERTEX* sStagingVertices = NULL;
+static UINT16* sStagingIndices = NULL;
+
+static const XMVECTORU32 sBoxCornerSelect[8] =
+{
+	{ { { XM_SELECT_0, XM_SELECT_0, XM_SELECT_0, XM_SELECT_0 } } },
+	{ { { XM_SELECT_1, XM_SELECT_0, XM_SELECT_0, XM_SELECT_0 } } },
+	{ { { XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0 } } },
+	{ { { XM_SELECT_1, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0 } } },
+	{ { { XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0 } } },
+	{ { { XM_SELECT_1, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0 } } },
+	{ { { XM_SELECT_0, XM_SELECT_1, XM_SELECT_1, XM_SELECT_0 } } },
+	{ { { XM_SELECT_1, XM_SELECT_1, XM_SELECT_1, XM_SELECT_0 } } },
+};
+
+static const UINT16 sBoxIndices[24] =
+{
+	0, 1, 0, 2, 2, 3,
+	3, 1, 4, 5, 4, 6,
+	6, 7, 7, 5, 0, 4,
+	1, 5, 2, 6, 3, 7,
+};
 
 /////////////////////////////////////////////////
 // Function Definition
 /////////////////////////////////////////////////
 
-static VOID VaCreateShaders(VOID);
-static VOID VaCreateVertexBuffers(VOID);
-static VOID VaCreateIndexBuffers(VOID);
-static VOID VaCreateInputLayouts(VOID);
+static VOID VaCreatePipelines(VOID);
+
+static LINE_BATCH_CHUNK* VaCreateChunk(BOOL Indexed);
+static LINE_BATCH_CHUNK* VaAcquireChunk(LINE_BATCH_CHAIN* Chain, UINT32 VertexCount, UINT32 IndexCount, UINT32 PrimitiveCount);
+static VOID XM_CALLCONV VaPushPrimitive(LINE_BATCH_CHUNK* Chunk, UINT32 VertexCount, UINT32 IndexCount, FXMVECTOR Min, FXMVECTOR Max);
+
+static VOID VaUpdateFrustumPlanes(VOID);
+static VOID VaCullChunk(LINE_BATCH_CHUNK* Chunk);
+
+static VOID VaFlushChain(LINE_BATCH_CHAIN* Chain);
+static VOID VaDestroyChain(LINE_BATCH_CHAIN* Chain);
+
+static LINE_PRODUCER* VaRegisterProducer(VOID);
+static VOID VaUnlinkProducer(LINE_PRODUCER* Previous, LINE_PRODUCER* Producer);
+static VOID VaDestroyProducer(LINE_PRODUCER* Producer);
+
+static LINE_BATCH_CHAIN* VaBeginRecording(BOOL Indexed);
+static VOID VaEndRecording(VOID);
+
+static VOID VaUploadLayer(LINE_LAYER_DATA* Layer);
+static VOID VaReleaseLayer(LINE_LAYER_DATA* Layer);
+
+static VOID XM_CALLCONV VaStoreVertex(VERTEX* Vertex, FXMVECTOR Position, FXMVECTOR Color);
+static VOID XM_CALLCONV VaStoreGridLine(LINE_BATCH_CHUNK* Chunk, FXMVECTOR Offset, const XMVECTOR* Starts, FXMVECTOR Color);
 
 /////////////////////////////////////////////////
 // Function Implementation
@@ -138,182 +278,928 @@ static VOID VaCreateInputLayouts(VOID);
 
 VOID VaCreateLineBatchRenderer(VOID)
 {
-	VaCreateShaders();
-	VaCreateVertexBuffers();
-	VaCreateIndexBuffers();
-	VaCreateInputLayouts();
+	VaCreatePipelines();
+
+	sVisibility = (BYTE*)malloc(LINE_PRIMITIVE_CAPACITY);
 
-	sVertices = (VERTEX*)malloc(sizeof(VERTEX) * VERTEX_BUFFER_SIZE);
-	sIndices = (UINT16*)malloc(sizeof(UINT16) * INDEX_BUFFER_SIZE);
+	sStagingVertices = (VERTEX*)malloc(sizeof(VERTEX) * VERTEX_BUFFER_SIZE);
+	sStagingIndices = (UINT16*)malloc(sizeof(UINT16) * INDEX_BUFFER_SIZE);
 }
 VOID VaDestroyLineBatchRenderer(VOID)
 {
-	sVertexShaderBlob->Release();
-	sPixelShaderBlob->Release();
+	for (UINT32 i = 0; i < LINE_LAYER_COUNT; i++)
+	{
+		VaReleaseLayer(&sLayers[i]);
+
+		sLayers[i].Allocated = FALSE;
+	}
+
+	sSubmittedLayerCount = 0;
+
+	// Threads still holding a producer of this generation register a new one the next time they record
+	InterlockedIncrement(&sGeneration);
+
+	LINE_PRODUCER* producer = sProducers;
+
+	while (producer)
+	{
+		LINE_PRODUCER* next = producer->Next;
+
+		VaDestroyProducer(producer);
+
+		producer = next;
+	}
+
+	sProducers = NULL;
+
+	VaDestroyChain(&sLayerLineChain);
+	VaDestroyChain(&sLayerIndexedChain);
+
+	memset(&sStatistics, 0, sizeof(sStatistics));
+
+	free(sVisibility);
+	free(sStagingVertices);
+	free(sStagingIndices);
 
-	sVertexShader->Release();
-	sPixelShader->Release();
-	sInputLayout->Release();
-	sVertexBuffer->Release();
-	sIndexBuffer->Release();
+	sVisibility = NULL;
+	sStagingVertices = NULL;
+	sStagingIndices = NULL;
+
+	sChunkCount = 0;
+	sAllocatedBytes = 0;
 }
 
 VOID VaDrawLine(XMFLOAT3 A, XMFLOAT3 B, XMFLOAT4 C)
 {
-	sVertices[sVertexOffset + 0].Position = A;
-	sVertices[sVertexOffset + 1].Position = B;
+	XMVECTOR color = XMVectorReplicateInt(VaPackColor(C));
+
+	XMVECTOR a = XMLoadFloat3(&A);
+	XMVECTOR b = XMLoadFloat3(&B);
+
+	LINE_BATCH_CHUNK* chunk = VaAcquireChunk(VaBeginRecording(FALSE), 2, 0, 1);
 
-	sVertices[sVertexOffset + 0].Color = C;
-	sVertices[sVertexOffset + 1].Color = C;
+	VERTEX* vertices = chunk->Vertices + chunk->VertexOffset;
 
-	sIndices[sIndexOffset + 0] = sVertexOffset + 0;
-	sIndices[sIndexOffset + 1] = sVertexOffset + 1;
+	VaStoreVertex(vertices + 0, a, color);
+	VaStoreVertex(vertices + 1, b, color);
 
-	sVertexOffset += 2;
-	sIndexOffset += 2;
+	VaPushPrimitive(chunk, 2, 0, XMVectorMin(a, b), XMVectorMax(a, b));
+
+	VaEndRecording();
 }
 VOID VaDrawBox(XMFLOAT3 P, XMFLOAT3 S, XMFLOAT4 C)
 {
-	XMFLOAT3 hs(S.x / 2.0f, S.y / 2.0f, S.z / 2.0f);
-
-	sVertices[sVertexOffset + 0].Position = XMFLOAT3(P.x - hs.x, P.y - hs.y, P.z - hs.z);
-	sVertices[sVertexOffset + 1].Position = XMFLOAT3(P.x + hs.x, P.y - hs.y, P.z - hs.z);
-	sVertices[sVertexOffset + 2].Position = XMFLOAT3(P.x - hs.x, P.y + hs.y, P.z - hs.z);
-	sVertices[sVertexOffset + 3].Position = XMFLOAT3(P.x + hs.x, P.y + hs.y, P.z - hs.z);
-
-	sVertices[sVertexOffset + 4].Position = XMFLOAT3(P.x - hs.x, P.y - hs.y, P.z + hs.z);
-	sVertices[sVertexOffset + 5].Position = XMFLOAT3(P.x + hs.x, P.y - hs.y, P.z + hs.z);
-	sVertices[sVertexOffset + 6].Position = XMFLOAT3(P.x - hs.x, P.y + hs.y, P.z + hs.z);
-	sVertices[sVertexOffset + 7].Position = XMFLOAT3(P.x + hs.x, P.y + hs.y, P.z + hs.z);
-
-	sVertices[sVertexOffset + 0].Color = C;
-	sVertices[sVertexOffset + 1].Color = C;
-	sVertices[sVertexOffset + 2].Color = C;
-	sVertices[sVertexOffset + 3].Color = C;
-
-	sVertices[sVertexOffset + 4].Color = C;
-	sVertices[sVertexOffset + 5].Color = C;
-	sVertices[sVertexOffset + 6].Color = C;
-	sVertices[sVertexOffset + 7].Color = C;
-
-	sIndices[sIndexOffset + 0] = sVertexOffset + 0;
-	sIndices[sIndexOffset + 1] = sVertexOffset + 1;
-	sIndices[sIndexOffset + 2] = sVertexOffset + 0;
-	sIndices[sIndexOffset + 3] = sVertexOffset + 2;
-	sIndices[sIndexOffset + 4] = sVertexOffset + 2;
-	sIndices[sIndexOffset + 5] = sVertexOffset + 3;
-
-	sIndices[sIndexOffset + 6] = sVertexOffset + 3;
-	sIndices[sIndexOffset + 7] = sVertexOffset + 1;
-	sIndices[sIndexOffset + 8] = sVertexOffset + 4;
-	sIndices[sIndexOffset + 9] = sVertexOffset + 5;
-	sIndices[sIndexOffset + 10] = sVertexOffset + 4;
-	sIndices[sIndexOffset + 11] = sVertexOffset + 6;
-
-	sIndices[sIndexOffset + 12] = sVertexOffset + 6;
-	sIndices[sIndexOffset + 13] = sVertexOffset + 7;
-	sIndices[sIndexOffset + 14] = sVertexOffset + 7;
-	sIndices[sIndexOffset + 15] = sVertexOffset + 5;
-	sIndices[sIndexOffset + 16] = sVertexOffset + 0;
-	sIndices[sIndexOffset + 17] = sVertexOffset + 4;
-
-	sIndices[sIndexOffset + 18] = sVertexOffset + 1;
-	sIndices[sIndexOffset + 19] = sVertexOffset + 5;
-	sIndices[sIndexOffset + 20] = sVertexOffset + 2;
-	sIndices[sIndexOffset + 21] = sVertexOffset + 6;
-	sIndices[sIndexOffset + 22] = sVertexOffset + 3;
-	sIndices[sIndexOffset + 23] = sVertexOffset + 7;
-
-	sVertexOffset += 8;
-	sIndexOffset += 24;
+	XMVECTOR color = XMVectorReplicateInt(VaPackColor(C));
+
+	XMVECTOR p = XMLoadFloat3(&P);
+	XMVECTOR hs = XMVectorScale(XMLoadFloat3(&S), 0.5f);
+
+	XMVECTOR min = XMVectorSubtract(p, hs);
+	XMVECTOR max = XMVectorAdd(p, hs);
+
+	LINE_BATCH_CHUNK* chunk = VaAcquireChunk(VaBeginRecording(TRUE), 8, 24, 1);
+
+	VERTEX* vertices = chunk->Vertices + chunk->VertexOffset;
+	UINT16* indices = chunk->Indices + chunk->IndexOffset;
+	UINT16 vertexOffset = (UINT16)chunk->VertexOffset;
+
+	// Each corner picks its components from either the minimum or the maximum, one 16 byte store per vertex
+	for (UINT32 i = 0; i < 8; i++)
+	{
+		VaStoreVertex(vertices + i, XMVectorSelect(min, max, sBoxCornerSelect[i]), color);
+	}
+
+	for (UINT32 i = 0; i < 24; i++)
+	{
+		indices[i] = vertexOffset + sBoxIndices[i];
+	}
+
+	VaPushPrimitive(chunk, 8, 24, min, max);
+
+	VaEndRecording();
 }
 VOID VaDrawGrid(XMFLOAT3 P, FLOAT S, UINT32 N, XMFLOAT4 C)
 {
-	UINT32 indexOffset = 0;
+	XMVECTOR color = XMVectorReplicateInt(VaPackColor(C));
 
 	FLOAT ss = S / N;
 	FLOAT hs = S / 2.0F;
 
-	for (UINT32 i = 0; i <= N; i++)
+	XMVECTOR p = XMLoadFloat3(&P);
+
+	XMVECTOR starts[4] =
 	{
-		FLOAT go = ((FLOAT)i) * ss - hs;
+		XMVectorAdd(p, XMVectorSet(0.0f, 0.0f, -hs, 0.0f)),
+		XMVectorAdd(p, XMVectorSet(0.0f, 0.0f, hs, 0.0f)),
+		XMVectorAdd(p, XMVectorSet(-hs, 0.0f, 0.0f, 0.0f)),
+		XMVectorAdd(p, XMVectorSet(hs, 0.0f, 0.0f, 0.0f)),
+	};
 
-		sVertices[sVertexOffset + indexOffset + 0].Position = XMFLOAT3(P.x + go, P.y, P.z - hs);
-		sVertices[sVertexOffset + indexOffset + 1].Position = XMFLOAT3(P.x + go, P.y, P.z + hs);
-		sVertices[sVertexOffset + indexOffset + 2].Position = XMFLOAT3(P.x - hs, P.y, P.z + go);
-		sVertices[sVertexOffset + indexOffset + 3].Position = XMFLOAT3(P.x + hs, P.y, P.z + go);
+	LINE_BATCH_CHAIN* chain = VaBeginRecording(FALSE);
 
-		sVertices[sVertexOffset + indexOffset + 0].Color = C;
-		sVertices[sVertexOffset + indexOffset + 1].Color = C;
-		sVertices[sVertexOffset + indexOffset + 2].Color = C;
-		sVertices[sVertexOffset + indexOffset + 3].Color = C;
+	UINT32 i = 0;
 
-		sIndices[sIndexOffset + indexOffset + 0] = sVertexOffset + indexOffset + 0;
-		sIndices[sIndexOffset + indexOffset + 1] = sVertexOffset + indexOffset + 1;
-		sIndices[sIndexOffset + indexOffset + 2] = sVertexOffset + indexOffset + 2;
-		sIndices[sIndexOffset + indexOffset + 3] = sVertexOffset + indexOffset + 3;
+	// Four grid lines per iteration, the offsets of all four are computed in one go
+	for (; (i + 4) <= (N + 1); i += 4)
+	{
+		LINE_BATCH_CHUNK* chunk = VaAcquireChunk(chain, 16, 0, 8);
+
+		XMVECTOR go = XMVectorMultiplyAdd(XMVectorSet((FLOAT)(i + 0), (FLOAT)(i + 1), (FLOAT)(i + 2), (FLOAT)(i + 3)), XMVectorReplicate(ss), XMVectorReplicate(-hs));
 
-		indexOffset += 4;
+		VaStoreGridLine(chunk, XMVectorSplatX(go), starts, color);
+		VaStoreGridLine(chunk, XMVectorSplatY(go), starts, color);
+		VaStoreGridLine(chunk, XMVectorSplatZ(go), starts, color);
+		VaStoreGridLine(chunk, XMVectorSplatW(go), starts, color);
 	}
 
-	sVertexOffset += indexOffset;
-	sIndexOffset += indexOffset;
+	for (; i <= N; i++)
+	{
+		LINE_BATCH_CHUNK* chunk = VaAcquireChunk(chain, 4, 0, 2);
+
+		VaStoreGridLine(chunk, XMVectorReplicate(((FLOAT)i) * ss - hs), starts, color);
+	}
+
+	VaEndRecording();
 }
 
 VOID VaRenderLineBatch(VOID)
 {
-	//gModelViewProjection.Model // TODO
-
-	COPY_INTO_CONSTANT_BUFFER(sVertexBuffer, sVertices, sizeof(VERTEX) * sVertexOffset);
-	COPY_INTO_CONSTANT_BUFFER(sIndexBuffer, sIndices, sizeof(UINT16) * sIndexOffset);
-	COPY_INTO_CONSTANT_BUFFER(gModelViewProjectionBuffer, &gModelViewProjection, sizeof(MODEL_VIEW_PROJECTION));
+	ID3D11Buffer* viewProjectionBuffer = VaCommitConstantBlock(gViewProjectionBlock);
 
 	UINT32 stride = sizeof(VERTEX);
 	UINT32 offset = 0;
 
-	gDeviceContext->IASetInputLayout(sInputLayout);
-	gDeviceContext->VSSetShader(sVertexShader, NULL, 0);
-	gDeviceContext->VSSetConstantBuffers(0, 1, &gModelViewProjectionBuffer);
-	gDeviceContext->PSSetShader(sPixelShader, NULL, 0);
-	gDeviceContext->IASetVertexBuffers(0, 1, &sVertexBuffer, &stride, &offset);
-	gDeviceContext->IASetIndexBuffer(sIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-	gDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+	VaBindPipeline(sPipeline);
+	VaBindConstantBuffers(0, 1, &viewProjectionBuffer);
+
+	sStatistics.DrawCount = 0;
+	sStatistics.VertexCount = 0;
+	sStatistics.IndexCount = 0;
+	sStatistics.NonIndexedBytes = 0;
+	sStatistics.IndexedBytes = 0;
+	sStatistics.LayerDrawCount = 0;
+	sStatistics.LayerVertexCount = 0;
+
+	// Retained layers live in immutable buffers and are redrawn without any upload
+	for (UINT32 i = 0; i < sSubmittedLayerCount; i++)
+	{
+		LINE_LAYER_DATA* layer = &sLayers[sSubmittedLayers[i]];
+
+		if (layer->VertexCount == 0)
+		{
+			continue;
+		}
+
+		VaBindVertexBuffers(1, &layer->VertexBuffer, &stride, &offset);
+
+		if (layer->NonIndexedVertexCount > 0)
+		{
+			gDeviceContext->Draw(layer->NonIndexedVertexCount, 0);
+
+			sStatistics.LayerDrawCount += 1;
+		}
+
+		if (layer->RangeCount > 0)
+		{
+			VaBindIndexBuffer(layer->IndexBuffer, 0);
+
+			for (UINT32 j = 0; j < layer->RangeCount; j++)
+			{
+				gDeviceContext->DrawIndexed(layer->Ranges[j].IndexCount, layer->Ranges[j].StartIndex, layer->Ranges[j].BaseVertex);
+			}
+
+			sStatistics.LayerDrawCount += layer->RangeCount;
+		}
+
+		sStatistics.LayerVertexCount += layer->VertexCount;
+	}
+
+	sSubmittedLayerCount = 0;
+
+	sStatistics.ProducerCount = 0;
+	sStatistics.DeferredProducerCount = 0;
+	sStatistics.RetiredProducerCount = 0;
+	sStatistics.TrimmedProducerCount = 0;
+	sStatistics.KeptPrimitiveCount = 0;
+	sStatistics.CulledPrimitiveCount = 0;
+
+	VaUpdateFrustumPlanes();
+
+	// Flip the epoch first, producers starting a primitive from now on record into the other half
+	LONG epoch = sEpoch;
+
+	InterlockedIncrement(&sEpoch);
+
+	LINE_PRODUCER* previous = NULL;
+	LINE_PRODUCER* producer = sProducers;
+
+	while (producer)
+	{
+		LINE_PRODUCER* next = producer->Next;
+
+		LONG active = producer->Epoch;
+
+		// The owner of a retired producer has exited, whatever it recorded into either half is drawn now and the producer is released
+		if (active == LINE_PRODUCER_RETIRED)
+		{
+			VaFlushChain(&producer->LineChains[0]);
+			VaFlushChain(&producer->LineChains[1]);
+			VaFlushChain(&producer->IndexedChains[0]);
+			VaFlushChain(&producer->IndexedChains[1]);
+
+			VaUnlinkProducer(previous, producer);
+			VaDestroyProducer(producer);
+
+			sStatistics.RetiredProducerCount += 1;
+
+			producer = next;
+
+			continue;
+		}
+
+		sStatistics.ProducerCount += 1;
+
+		// A producer still inside a primitive of this half is left alone, its records are flushed the next time this half comes around
+		if ((active != LINE_PRODUCER_IDLE) && ((active & 1) == (epoch & 1)))
+		{
+			sStatistics.DeferredProducerCount += 1;
+
+			previous = producer;
+			producer = next;
+
+			continue;
+		}
+
+		VaFlushChain(&producer->LineChains[epoch & 1]);
+		VaFlushChain(&producer->IndexedChains[epoch & 1]);
+
+		// The chunks of a producer idle for many frames are released, the owner is locked out while they are and allocates again on its next record
+		if (producer->LineChains[0].First || producer->LineChains[1].First || producer->IndexedChains[0].First || producer->IndexedChains[1].First)
+		{
+			if (((epoch - producer->LastEpoch) >= LINE_PRODUCER_TRIM_EPOCHS) && (InterlockedCompareExchange(&producer->Epoch, LINE_PRODUCER_TRIMMING, LINE_PRODUCER_IDLE) == LINE_PRODUCER_IDLE))
+			{
+				VaFlushChain(&producer->LineChains[(epoch + 1) & 1]);
+				VaFlushChain(&producer->IndexedChains[(epoch + 1) & 1]);
+
+				VaDestroyChain(&producer->LineChains[0]);
+				VaDestroyChain(&producer->LineChains[1]);
+				VaDestroyChain(&producer->IndexedChains[0]);
+				VaDestroyChain(&producer->IndexedChains[1]);
+
+				InterlockedExchange(&producer->Epoch, LINE_PRODUCER_IDLE);
+
+				sStatistics.TrimmedProducerCount += 1;
+			}
+		}
+
+		previous = producer;
+		producer = next;
+	}
+}
+
+LINE_LAYER VaCreateLineLayer(VOID)
+{
+	for (LINE_LAYER i = 0; i < LINE_LAYER_COUNT; i++)
+	{
+		if (!sLayers[i].Allocated)
+		{
+			memset(&sLayers[i], 0, sizeof(LINE_LAYER_DATA));
+
+			sLayers[i].Allocated = TRUE;
+
+			return i;
+		}
+	}
+
+	return INVALID_LINE_LAYER;
+}
+VOID VaDestroyLineLayer(LINE_LAYER Layer)
+{
+	VaReleaseLayer(&sLayers[Layer]);
+
+	sLayers[Layer].Allocated = FALSE;
+}
+
+BOOL VaBeginLineLayer(LINE_LAYER Layer, PVOID Inputs, UINT32 InputSize)
+{
+	LINE_LAYER_DATA* layer = &sLayers[Layer];
+
+	// Inputs of any size are hashed whole, a change anywhere in them has to rebuild the layer
+	UINT64 inputHash = VaHashMemory(Inputs, InputSize);
+
+	// A layer is only rebuilt when it was invalidated or the inputs it was recorded from have changed
+	if (layer->Recorded && (layer->InputSize == InputSize) && (layer->InputHash == inputHash))
+	{
+		return FALSE;
+	}
+
+	layer->InputSize = InputSize;
+	layer->InputHash = inputHash;
+
+	sRecordingLayer = Layer;
+
+	tLayerLineChain = &sLayerLineChain;
+	tLayerIndexedChain = &sLayerIndexedChain;
+
+	return TRUE;
+}
+VOID VaEndLineLayer(VOID)
+{
+	LINE_LAYER_DATA* layer = &sLayers[sRecordingLayer];
+
+	VaReleaseLayer(layer);
+	VaUploadLayer(layer);
+
+	layer->Recorded = TRUE;
+
+	sRecordingLayer = INVALID_LINE_LAYER;
+
+	tLayerLineChain = NULL;
+	tLayerIndexedChain = NULL;
+}
+VOID VaInvalidateLineLayer(LINE_LAYER Layer)
+{
+	sLayers[Layer].Recorded = FALSE;
+}
+VOID VaDrawLineLayer(LINE_LAYER Layer)
+{
+	if (sSubmittedLayerCount < LINE_LAYER_COUNT)
+	{
+		sSubmittedLayers[sSubmittedLayerCount] = Layer;
+
+		sSubmittedLayerCount += 1;
+	}
+}
+
+VOID VaGetLineBatchStatistics(LINE_BATCH_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+
+	Statistics->ChunkCount = sChunkCount;
+	Statistics->AllocatedBytes = sAllocatedBytes;
+}
+
+static VOID VaCreatePipelines(VOID)
+{
+	sPipeline = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+}
+
+static LINE_BATCH_CHUNK* VaCreateChunk(BOOL Indexed)
+{
+	LINE_BATCH_CHUNK* chunk = (LINE_BATCH_CHUNK*)calloc(1, sizeof(LINE_BATCH_CHUNK));
+
+	chunk->PrimitiveCapacity = Indexed ? BOX_PRIMITIVE_CAPACITY : LINE_PRIMITIVE_CAPACITY;
+
+	chunk->Vertices = (VERTEX*)malloc(sizeof(VERTEX) * VERTEX_BUFFER_SIZE);
+	chunk->Bounds = (FLOAT*)_aligned_malloc(sizeof(FLOAT) * 6 * chunk->PrimitiveCapacity, 16);
+	chunk->Primitives = (LINE_BATCH_PRIMITIVE*)malloc(sizeof(LINE_BATCH_PRIMITIVE) * chunk->PrimitiveCapacity);
+
+	InterlockedIncrement(&sChunkCount);
+	InterlockedExchangeAdd64(&sAllocatedBytes, sizeof(LINE_BATCH_CHUNK) + sizeof(VERTEX) * VERTEX_BUFFER_SIZE + (sizeof(FLOAT) * 6 + sizeof(LINE_BATCH_PRIMITIVE)) * chunk->PrimitiveCapacity);
+
+	if (Indexed)
+	{
+		chunk->Indices = (UINT16*)malloc(sizeof(UINT16) * INDEX_BUFFER_SIZE);
+
+		InterlockedExchangeAdd64(&sAllocatedBytes, sizeof(UINT16) * INDEX_BUFFER_SIZE);
+	}
+
+	return chunk;
+}
+static LINE_BATCH_CHUNK* VaAcquireChunk(LINE_BATCH_CHAIN* Chain, UINT32 VertexCount, UINT32 IndexCount, UINT32 PrimitiveCount)
+{
+	LINE_BATCH_CHUNK* chunk = Chain->Current;
+
+	if (!chunk)
+	{
+		chunk = VaCreateChunk(Chain->Indexed);
+
+		Chain->First = chunk;
+		Chain->Current = chunk;
+	}
+
+	if (((chunk->VertexOffset + VertexCount) > VERTEX_BUFFER_SIZE) || ((chunk->IndexOffset + IndexCount) > INDEX_BUFFER_SIZE) || ((chunk->PrimitiveCount + PrimitiveCount) > chunk->PrimitiveCapacity))
+	{
+		// Chunks are kept alive across frames, the chain only grows up to the high-water mark of a single frame
+		if (!chunk->Next)
+		{
+			chunk->Next = VaCreateChunk(Chain->Indexed);
+		}
+
+		chunk = chunk->Next;
+
+		Chain->Current = chunk;
+	}
+
+	return chunk;
+}
+static VOID XM_CALLCONV VaPushPrimitive(LINE_BATCH_CHUNK* Chunk, UINT32 VertexCount, UINT32 IndexCount, FXMVECTOR Min, FXMVECTOR Max)
+{
+	UINT32 primitive = Chunk->PrimitiveCount;
+	UINT32 capacity = Chunk->PrimitiveCapacity;
+
+	XMFLOAT3 min;
+	XMFLOAT3 max;
 
-	gDeviceContext->DrawIndexed(sIndexOffset, 0, 0);
+	XMStoreFloat3(&min, Min);
+	XMStoreFloat3(&max, Max);
 
-	sVertexOffset = 0;
-	sIndexOffset = 0;
+	Chunk->Bounds[capacity * 0 + primitive] = min.x;
+	Chunk->Bounds[capacity * 1 + primitive] = min.y;
+	Chunk->Bounds[capacity * 2 + primitive] = min.z;
+	Chunk->Bounds[capacity * 3 + primitive] = max.x;
+	Chunk->Bounds[capacity * 4 + primitive] = max.y;
+	Chunk->Bounds[capacity * 5 + primitive] = max.z;
+
+	Chunk->Primitives[primitive].VertexCount = (UINT16)VertexCount;
+	Chunk->Primitives[primitive].IndexCount = (UINT16)IndexCount;
+
+	Chunk->VertexOffset += VertexCount;
+	Chunk->IndexOffset += IndexCount;
+	Chunk->PrimitiveCount += 1;
 }
 
-static VOID VaCreateShaders(VOID)
+static VOID VaUpdateFrustumPlanes(VOID)
 {
-	HR_CHECK(D3DCompile(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), NULL, NULL, NULL, "VS", "vs_4_0", 0, 0, &sVertexShaderBlob, NULL));
-	HR_CHECK(D3DCompile(sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), NULL, NULL, NULL, "PS", "ps_4_0", 0, 0, &sPixelShaderBlob, NULL));
+	// The matrix is stored transposed for the shader, so its rows are the columns of the actual view * projection
+	XMMATRIX columns = gModelViewProjection.ViewProjection;
+
+	XMVECTOR planes[6] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),
+		XMVectorSubtract(columns.r[3], columns.r[0]),
+		XMVectorAdd(columns.r[3], columns.r[1]),
+		XMVectorSubtract(columns.r[3], columns.r[1]),
+		columns.r[2],
+		XMVectorSubtract(columns.r[3], columns.r[2]),
+	};
+
+	for (UINT32 i = 0; i < 6; i++)
+	{
+		XMFLOAT4 plane;
+
+		XMStoreFloat4(&plane, planes[i]);
+
+		sFrustumPlanes[i].X = XMVectorReplicate(plane.x);
+		sFrustumPlanes[i].Y = XMVectorReplicate(plane.y);
+		sFrustumPlanes[i].Z = XMVectorReplicate(plane.z);
+		sFrustumPlanes[i].W = XMVectorReplicate(plane.w);
 
-	HR_CHECK(gDevice->CreateVertexShader(sVertexShaderBlob->GetBufferPointer(), sVertexShaderBlob->GetBufferSize(), NULL, &sVertexShader));
-	HR_CHECK(gDevice->CreatePixelShader(sPixelShaderBlob->GetBufferPointer(), sPixelShaderBlob->GetBufferSize(), NULL, &sPixelShader));
+		sFrustumPlanes[i].PositiveX = plane.x >= 0.0f;
+		sFrustumPlanes[i].PositiveY = plane.y >= 0.0f;
+		sFrustumPlanes[i].PositiveZ = plane.z >= 0.0f;
+	}
 }
-static VOID VaCreateVertexBuffers(VOID)
+static VOID VaCullChunk(LINE_BATCH_CHUNK* Chunk)
 {
-	D3D11_BUFFER_DESC bufferDescription = { 0 };
-	bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
-	bufferDescription.ByteWidth = sizeof(VERTEX) * VERTEX_BUFFER_SIZE;
-	bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	UINT32 capacity = Chunk->PrimitiveCapacity;
+
+	const FLOAT* minX = Chunk->Bounds + capacity * 0;
+	const FLOAT* minY = Chunk->Bounds + capacity * 1;
+	const FLOAT* minZ = Chunk->Bounds + capacity * 2;
+	const FLOAT* maxX = Chunk->Bounds + capacity * 3;
+	const FLOAT* maxY = Chunk->Bounds + capacity * 4;
+	const FLOAT* maxZ = Chunk->Bounds + capacity * 5;
+
+	// Four boxes per iteration, a box is outside once its corner furthest along the plane normal is behind any plane
+	for (UINT32 i = 0; i < Chunk->PrimitiveCount; i += 4)
+	{
+		XMVECTOR outside = XMVectorFalseInt();
+
+		for (UINT32 j = 0; j < 6; j++)
+		{
+			FRUSTUM_PLANE* plane = &sFrustumPlanes[j];
+
+			XMVECTOR x = XMLoadFloat4A((const XMFLOAT4A*)((plane->PositiveX ? maxX : minX) + i));
+			XMVECTOR y = XMLoadFloat4A((const XMFLOAT4A*)((plane->PositiveY ? maxY : minY) + i));
+			XMVECTOR z = XMLoadFloat4A((const XMFLOAT4A*)((plane->PositiveZ ? maxZ : minZ) + i));
 
-	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, NULL, &sVertexBuffer));
+			XMVECTOR distance = XMVectorMultiplyAdd(x, plane->X, XMVectorMultiplyAdd(y, plane->Y, XMVectorMultiplyAdd(z, plane->Z, plane->W)));
+
+			outside = XMVectorOrInt(outside, XMVectorLess(distance, XMVectorZero()));
+		}
+
+		XMUINT4 mask;
+
+		XMStoreUInt4(&mask, outside);
+
+		sVisibility[i + 0] = mask.x == 0;
+		sVisibility[i + 1] = mask.y == 0;
+		sVisibility[i + 2] = mask.z == 0;
+		sVisibility[i + 3] = mask.w == 0;
+	}
 }
-static VOID VaCreateIndexBuffers(VOID)
+
+static VOID VaFlushChain(LINE_BATCH_CHAIN* Chain)
 {
-	D3D11_BUFFER_DESC bufferDescription = { 0 };
-	bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
-	bufferDescription.ByteWidth = sizeof(UINT16) * INDEX_BUFFER_SIZE;
-	bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	// Every chunk is uploaded into the shared ring, a chunk identical to a recent upload is drawn again from its old region
+	for (LINE_BATCH_CHUNK* chunk = Chain->First; chunk; chunk = chunk->Next)
+	{
+		if (chunk->PrimitiveCount > 0)
+		{
+			VaCullChunk(chunk);
+
+			VERTEX* vertices = sStagingVertices;
+			UINT16* indices = sStagingIndices;
+
+			UINT32 sourceVertex = 0;
+			UINT32 sourceIndex = 0;
+			UINT32 vertexCount = 0;
+			UINT32 indexCount = 0;
+			UINT32 keptCount = 0;
+
+			// Only visible primitives are compacted into the staging region, consecutive ones are copied as a single run
+			for (UINT32 i = 0; i < chunk->PrimitiveCount;)
+			{
+				if (!sVisibility[i])
+				{
+					sourceVertex += chunk->Primitives[i].VertexCount;
+					sourceIndex += chunk->Primitives[i].IndexCount;
+
+					i++;
+
+					continue;
+				}
+
+				UINT32 runVertex = sourceVertex;
+				UINT32 runIndex = sourceIndex;
+
+				for (; (i < chunk->PrimitiveCount) && sVisibility[i]; i++)
+				{
+					sourceVertex += chunk->Primitives[i].VertexCount;
+					sourceIndex += chunk->Primitives[i].IndexCount;
+
+					keptCount += 1;
+				}
+
+				memcpy(vertices + vertexCount, chunk->Vertices + runVertex, sizeof(VERTEX) * (sourceVertex - runVertex));
+
+				if (Chain->Indexed)
+				{
+					UINT16 rebase = (UINT16)(vertexCount - runVertex);
 
-	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, NULL, &sIndexBuffer));
+					for (UINT32 j = runIndex; j < sourceIndex; j++)
+					{
+						indices[indexCount + (j - runIndex)] = chunk->Indices[j] + rebase;
+					}
+
+					indexCount += sourceIndex - runIndex;
+				}
+
+				vertexCount += sourceVertex - runVertex;
+			}
+
+			if (vertexCount > 0)
+			{
+				UPLOAD_REGION vertexRegion = { 0 };
+
+				UINT32 stride = sizeof(VERTEX);
+
+				VaUploadCached(vertices, sizeof(VERTEX) * vertexCount, sizeof(VERTEX), &vertexRegion);
+				VaBindVertexBuffers(1, &vertexRegion.Buffer, &stride, &vertexRegion.Offset);
+
+				if (Chain->Indexed)
+				{
+					UPLOAD_REGION indexRegion = { 0 };
+
+					VaUploadCached(indices, sizeof(UINT16) * indexCount, sizeof(UINT16), &indexRegion);
+					VaBindIndexBuffer(indexRegion.Buffer, indexRegion.Offset);
+				}
+
+				UINT64 vertexBytes = sizeof(VERTEX) * vertexCount;
+
+				if (Chain->Indexed)
+				{
+					gDeviceContext->DrawIndexed(indexCount, 0, 0);
+
+					sStatistics.IndexCount += indexCount;
+					sStatistics.IndexedBytes += vertexBytes + sizeof(UINT16) * indexCount;
+				}
+				else
+				{
+					gDeviceContext->Draw(vertexCount, 0);
+
+					sStatistics.NonIndexedBytes += vertexBytes;
+				}
+
+				sStatistics.DrawCount += 1;
+				sStatistics.VertexCount += vertexCount;
+			}
+
+			sStatistics.KeptPrimitiveCount += keptCount;
+			sStatistics.CulledPrimitiveCount += chunk->PrimitiveCount - keptCount;
+		}
+
+		chunk->VertexOffset = 0;
+		chunk->IndexOffset = 0;
+		chunk->PrimitiveCount = 0;
+
+		if (chunk == Chain->Current)
+		{
+			break;
+		}
+	}
+
+	Chain->Current = Chain->First;
+}
+static VOID VaDestroyChain(LINE_BATCH_CHAIN* Chain)
+{
+	LINE_BATCH_CHUNK* chunk = Chain->First;
+
+	while (chunk)
+	{
+		LINE_BATCH_CHUNK* next = chunk->Next;
+
+		InterlockedDecrement(&sChunkCount);
+		InterlockedExchangeAdd64(&sAllocatedBytes, -(LONG64)(sizeof(LINE_BATCH_CHUNK) + sizeof(VERTEX) * VERTEX_BUFFER_SIZE + (sizeof(FLOAT) * 6 + sizeof(LINE_BATCH_PRIMITIVE)) * chunk->PrimitiveCapacity));
+
+		if (chunk->Indices)
+		{
+			InterlockedExchangeAdd64(&sAllocatedBytes, -(LONG64)(sizeof(UINT16) * INDEX_BUFFER_SIZE));
+		}
+
+		free(chunk->Vertices);
+		free(chunk->Indices);
+		free(chunk->Primitives);
+
+		_aligned_free(chunk->Bounds);
+
+		free(chunk);
+
+		chunk = next;
+	}
+
+	Chain->First = NULL;
+	Chain->Current = NULL;
 }
-static VOID VaCreateInputLayouts(VOID)
+
+static VOID VaUploadLayer(LINE_LAYER_DATA* Layer)
 {
-	HR_CHECK(gDevice->CreateInputLayout(sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), sVertexShaderBlob->GetBufferPointer(), sVertexShaderBlob->GetBufferSize(), &sInputLayout));
+	UINT32 vertexCount = 0;
+	UINT32 indexCount = 0;
+	UINT32 rangeCount = 0;
+
+	for (LINE_BATCH_CHUNK* chunk = sLayerLineChain.First; chunk; chunk = (chunk == sLayerLineChain.Current) ? NULL : chunk->Next)
+	{
+		vertexCount += chunk->VertexOffset;
+	}
+
+	Layer->NonIndexedVertexCount = vertexCount;
+
+	for (LINE_BATCH_CHUNK* chunk = sLayerIndexedChain.First; chunk; chunk = (chunk == sLayerIndexedChain.Current) ? NULL : chunk->Next)
+	{
+		if (chunk->IndexOffset > 0)
+		{
+			vertexCount += chunk->VertexOffset;
+			indexCount += chunk->IndexOffset;
+			rangeCount += 1;
+		}
+	}
+
+	Layer->VertexCount = vertexCount;
+
+	if (vertexCount > 0)
+	{
+		VERTEX* vertices = (VERTEX*)malloc(sizeof(VERTEX) * vertexCount);
+		UINT16* indices = (UINT16*)malloc(sizeof(UINT16) * (indexCount + 1));
+
+		Layer->Ranges = (LINE_LAYER_RANGE*)malloc(sizeof(LINE_LAYER_RANGE) * (rangeCount + 1));
+		Layer->RangeCount = 0;
+
+		UINT32 vertexOffset = 0;
+		UINT32 indexOffset = 0;
+
+		for (LINE_BATCH_CHUNK* chunk = sLayerLineChain.First; chunk; chunk = (chunk == sLayerLineChain.Current) ? NULL : chunk->Next)
+		{
+			memcpy(vertices + vertexOffset, chunk->Vertices, sizeof(VERTEX) * chunk->VertexOffset);
+
+			vertexOffset += chunk->VertexOffset;
+		}
+
+		for (LINE_BATCH_CHUNK* chunk = sLayerIndexedChain.First; chunk; chunk = (chunk == sLayerIndexedChain.Current) ? NULL : chunk->Next)
+		{
+			if (chunk->IndexOffset > 0)
+			{
+				memcpy(vertices + vertexOffset, chunk->Vertices, sizeof(VERTEX) * chunk->VertexOffset);
+				memcpy(indices + indexOffset, chunk->Indices, sizeof(UINT16) * chunk->IndexOffset);
+
+				Layer->Ranges[Layer->RangeCount].StartIndex = indexOffset;
+				Layer->Ranges[Layer->RangeCount].IndexCount = chunk->IndexOffset;
+				Layer->Ranges[Layer->RangeCount].BaseVertex = vertexOffset;
+
+				Layer->RangeCount += 1;
+
+				vertexOffset += chunk->VertexOffset;
+				indexOffset += chunk->IndexOffset;
+			}
+		}
+
+		D3D11_BUFFER_DESC bufferDescription = { 0 };
+		bufferDescription.Usage = D3D11_USAGE_IMMUTABLE;
+		bufferDescription.ByteWidth = sizeof(VERTEX) * vertexCount;
+		bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+		D3D11_SUBRESOURCE_DATA subResourceData = { 0 };
+		subResourceData.pSysMem = vertices;
+
+		HR_CHECK(gDevice->CreateBuffer(&bufferDescription, &subResourceData, &Layer->VertexBuffer));
+
+		if (indexCount > 0)
+		{
+			bufferDescription.ByteWidth = sizeof(UINT16) * indexCount;
+			bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+			subResourceData.pSysMem = indices;
+
+			HR_CHECK(gDevice->CreateBuffer(&bufferDescription, &subResourceData, &Layer->IndexBuffer));
+		}
+
+		free(vertices);
+		free(indices);
+	}
+
+	for (LINE_BATCH_CHUNK* chunk = sLayerLineChain.First; chunk; chunk = chunk->Next)
+	{
+		chunk->VertexOffset = 0;
+		chunk->PrimitiveCount = 0;
+	}
+
+	for (LINE_BATCH_CHUNK* chunk = sLayerIndexedChain.First; chunk; chunk = chunk->Next)
+	{
+		chunk->VertexOffset = 0;
+		chunk->IndexOffset = 0;
+		chunk->PrimitiveCount = 0;
+	}
+
+	sLayerLineChain.Current = sLayerLineChain.First;
+	sLayerIndexedChain.Current = sLayerIndexedChain.First;
+}
+static VOID VaReleaseLayer(LINE_LAYER_DATA* Layer)
+{
+	if (Layer->VertexBuffer)
+	{
+		Layer->VertexBuffer->Release();
+		Layer->VertexBuffer = NULL;
+	}
+
+	if (Layer->IndexBuffer)
+	{
+		Layer->IndexBuffer->Release();
+		Layer->IndexBuffer = NULL;
+	}
+
+	free(Layer->Ranges);
+
+	Layer->Ranges = NULL;
+	Layer->RangeCount = 0;
+	Layer->VertexCount = 0;
+	Layer->NonIndexedVertexCount = 0;
+}
+
+static LINE_PRODUCER* VaRegisterProducer(VOID)
+{
+	LINE_PRODUCER* producer = (LINE_PRODUCER*)calloc(1, sizeof(LINE_PRODUCER));
+
+	producer->IndexedChains[0].Indexed = TRUE;
+	producer->IndexedChains[1].Indexed = TRUE;
+
+	producer->Epoch = LINE_PRODUCER_IDLE;
+	producer->LastEpoch = sEpoch;
+
+	LINE_PRODUCER* head = NULL;
+
+	do
+	{
+		head = sProducers;
+
+		producer->Next = head;
+	} while (InterlockedCompareExchangePointer((PVOID volatile*)&sProducers, producer, head) != head);
+
+	return producer;
+}
+static VOID VaUnlinkProducer(LINE_PRODUCER* Previous, LINE_PRODUCER* Producer)
+{
+	// Only the render thread unlinks, registering threads only ever replace the head
+	if (Previous)
+	{
+		Previous->Next = Producer->Next;
+
+		return;
+	}
+
+	if (InterlockedCompareExchangePointer((PVOID volatile*)&sProducers, Producer->Next, Producer) == Producer)
+	{
+		return;
+	}
+
+	// A producer was registered in front of it, the new predecessor is found from the new head
+	LINE_PRODUCER* previous = sProducers;
+
+	while (previous->Next != Producer)
+	{
+		previous = previous->Next;
+	}
+
+	previous->Next = Producer->Next;
+}
+static VOID VaDestroyProducer(LINE_PRODUCER* Producer)
+{
+	VaDestroyChain(&Producer->LineChains[0]);
+	VaDestroyChain(&Producer->LineChains[1]);
+	VaDestroyChain(&Producer->IndexedChains[0]);
+	VaDestroyChain(&Producer->IndexedChains[1]);
+
+	free(Producer);
+}
+
+LINE_PRODUCER_SLOT::~LINE_PRODUCER_SLOT()
+{
+	if (!Producer || (Generation != sGeneration))
+	{
+		return;
+	}
+
+	// The render thread may be trimming the producer right now, it is retired as soon as it is idle again
+	while (InterlockedCompareExchange(&Producer->Epoch, LINE_PRODUCER_RETIRED, LINE_PRODUCER_IDLE) != LINE_PRODUCER_IDLE)
+	{
+		YieldProcessor();
+	}
+}
+
+static LINE_BATCH_CHAIN* VaBeginRecording(BOOL Indexed)
+{
+	// Layers are only ever recorded by the thread that owns them and bypass the producer handshake
+	if (tLayerLineChain)
+	{
+		return Indexed ? tLayerIndexedChain : tLayerLineChain;
+	}
+
+	LONG generation = sGeneration;
+
+	if (!tProducer.Producer || (tProducer.Generation != generation))
+	{
+		tProducer.Producer = VaRegisterProducer();
+		tProducer.Generation = generation;
+	}
+
+	LINE_PRODUCER* producer = tProducer.Producer;
+
+	LONG epoch = 0;
+	LONG expected = LINE_PRODUCER_IDLE;
+
+	// Publish the epoch before touching its chains, if the render thread flipped in between the publish is retried
+	// While the render thread trims the idle producer the publish waits for it to hand the producer back
+	while (TRUE)
+	{
+		epoch = sEpoch;
+
+		if (InterlockedCompareExchange(&producer->Epoch, epoch, expected) != expected)
+		{
+			YieldProcessor();
+
+			continue;
+		}
+
+		expected = epoch;
+
+		if (epoch == sEpoch)
+		{
+			break;
+		}
+	}
+
+	producer->LastEpoch = epoch;
+
+	return Indexed ? &producer->IndexedChains[epoch & 1] : &producer->LineChains[epoch & 1];
+}
+static VOID VaEndRecording(VOID)
+{
+	if (!tLayerLineChain)
+	{
+		InterlockedExchange(&tProducer.Producer->Epoch, LINE_PRODUCER_IDLE);
+	}
+}
+
+static VOID XM_CALLCONV VaStoreVertex(VERTEX* Vertex, FXMVECTOR Position, FXMVECTOR Color)
+{
+	// The packed color bits are blended into the w lane, so they never pass through float arithmetic
+	XMStoreFloat4((XMFLOAT4*)Vertex, XMVectorSelect(Position, Color, g_XMSelect0001));
+}
+static VOID XM_CALLCONV VaStoreGridLine(LINE_BATCH_CHUNK* Chunk, FXMVECTOR Offset, const XMVECTOR* Starts, FXMVECTOR Color)
+{
+	VERTEX* vertices = Chunk->Vertices + Chunk->VertexOffset;
+
+	XMVECTOR a = XMVectorMultiplyAdd(Offset, g_XMIdentityR0, Starts[0]);
+	XMVECTOR b = XMVectorMultiplyAdd(Offset, g_XMIdentityR0, Starts[1]);
+	XMVECTOR c = XMVectorMultiplyAdd(Offset, g_XMIdentityR2, Starts[2]);
+	XMVECTOR d = XMVectorMultiplyAdd(Offset, g_XMIdentityR2, Starts[3]);
+
+	VaStoreVertex(vertices + 0, a, Color);
+	VaStoreVertex(vertices + 1, b, Color);
+	VaStoreVertex(vertices + 2, c, Color);
+	VaStoreVertex(vertices + 3, d, Color);
+
+	// Both lines of a grid step are culled individually, a huge grid is mostly trimmed to the visible lines
+	VaPushPrimitive(Chunk, 2, 0, XMVectorMin(a, b), XMVectorMax(a, b));
+	VaPushPrimitive(Chunk, 2, 0, XMVectorMin(c, d), XMVectorMax(c, d));
 }
\ No newline at end of file
@@ -6,6 +6,29 @@
 
 using namespace DirectX;
 
+#define INVALID_LINE_LAYER (-1)
+
+typedef INT32 LINE_LAYER;
+
+struct LINE_BATCH_STATISTICS
+{
+	UINT32 ChunkCount;
+	UINT32 DrawCount;
+	UINT64 VertexCount;
+	UINT64 IndexCount;
+	UINT64 NonIndexedBytes;
+	UINT64 IndexedBytes;
+	UINT32 LayerDrawCount;
+	UINT64 LayerVertexCount;
+	UINT32 ProducerCount;
+	UINT32 DeferredProducerCount;
+	UINT32 RetiredProducerCount;
+	UINT32 TrimmedProducerCount;
+	UINT64 KeptPrimitiveCount;
+	UINT64 CulledPrimitiveCount;
+	UINT64 AllocatedBytes;
+};
+
 VOID VaCreateLineBatchRenderer(VOID);
 VOID VaDestroyLineBatchRenderer(VOID);
 
@@ -13,4 +36,14 @@ VOID VaDrawLine(XMFLOAT3 A, XMFLOAT3 B, XMFLOAT4 C);
 VOID VaDrawBox(XMFLOAT3 P, XMFLOAT3 S, XMFLOAT4 C);
 VOID VaDrawGrid(XMFLOAT3 P, FLOAT S, UINT32 N, XMFLOAT4 C);
 
-VOID VaRenderLineBatch(VOID);
\ No newline at end of file
+VOID VaRenderLineBatch(VOID);
+
+LINE_LAYER VaCreateLineLayer(VOID);
+VOID VaDestroyLineLayer(LINE_LAYER Layer);
+
+BOOL VaBeginLineLayer(LINE_LAYER Layer, PVOID Inputs, UINT32 InputSize);
+VOID VaEndLineLayer(VOID);
+VOID VaInvalidateLineLayer(LINE_LAYER Layer);
+VOID VaDrawLineLayer(LINE_LAYER Layer);
+
+VOID VaGetLineBatchStatistics(LINE_BATCH_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "profiler.h"
+#include "logger.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define LOG_RING_SIZE (4096)
+#define LOG_LINE_SIZE (1024)
+#define LOG_SPEC_SIZE (32)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// Sequence equals the ring position while the slot is free and the position plus one once it holds a record
+struct LOG_RECORD
+{
+	volatile LONG64 Sequence;
+	LOG_SITE* Site;
+	UINT64 Time;
+	UINT32 ThreadId;
+	UINT32 ArgumentCount;
+	UINT32 Suppressed;
+	UINT64 Arguments[LOG_ARGUMENT_COUNT];
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static LOG_RECORD sRecords[LOG_RING_SIZE] = { 0 };
+
+static volatile LONG64 sHead = 0;
+static LONG64 sTail = 0;
+
+static volatile BOOL sLoggerCreated = FALSE;
+
+static FILE* sFile = NULL;
+
+static UINT64 sStartTime = 0;
+
+static volatile LONG64 sWrittenCount = 0;
+static volatile LONG64 sDroppedCount = 0;
+static volatile LONG64 sSuppressedCount = 0; // Only counts suppressions reported by a later record
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static UINT32 VaFormatLogMessage(CHAR* Buffer, UINT32 Size, LPCSTR Format, const UINT64* Arguments, UINT32 ArgumentCount);
+
+template<typename T>
+static INT32 VaFormatLogArgument(CHAR* Buffer, UINT32 Size, LPCSTR Spec, const INT32* Stars, UINT32 StarCount, T Value);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateLogger(LPCSTR FilePath)
+{
+	for (UINT32 i = 0; i < LOG_RING_SIZE; i++)
+	{
+		sRecords[i].Sequence = i;
+	}
+
+	sHead = 0;
+	sTail = 0;
+
+	if (FilePath && (fopen_s(&sFile, FilePath, "w") != 0))
+	{
+		sFile = NULL;
+	}
+
+	sStartTime = VaQueryProfilerTime();
+
+	sLoggerCreated = TRUE;
+}
+VOID VaDestroyLogger(VOID)
+{
+	sLoggerCreated = FALSE;
+
+	VaFlushLogger();
+
+	if (sFile)
+	{
+		fclose(sFile);
+
+		sFile = NULL;
+	}
+}
+
+VOID VaFlushLogger(VOID)
+{
+	CHAR message[LOG_LINE_SIZE];
+	CHAR line[LOG_LINE_SIZE + 64];
+
+	BOOL written = FALSE;
+
+	while (TRUE)
+	{
+		LOG_RECORD* record = &sRecords[sTail % LOG_RING_SIZE];
+
+		if (ReadAcquire64(&record->Sequence) != (sTail + 1))
+		{
+			break;
+		}
+
+		VaFormatLogMessage(message, sizeof(message), record->Site->Format, record->Arguments, record->ArgumentCount);
+
+		UINT64 time = record->Time - sStartTime;
+
+		if (record->Suppressed)
+		{
+			snprintf(line, sizeof(line), "[%6llu.%03llu] %s (%u suppressed)\n", time / 1000000000, (time / 1000000) % 1000, message, record->Suppressed);
+		}
+		else
+		{
+			snprintf(line, sizeof(line), "[%6llu.%03llu] %s\n", time / 1000000000, (time / 1000000) % 1000, message);
+		}
+
+		WriteRelease64(&record->Sequence, sTail + LOG_RING_SIZE);
+
+		sTail += 1;
+
+		fputs(line, stdout);
+
+		if (sFile)
+		{
+			fputs(line, sFile);
+		}
+
+		sWrittenCount += 1;
+		sSuppressedCount += record->Suppressed;
+
+		written = TRUE;
+	}
+
+	if (written)
+	{
+		fflush(stdout);
+
+		if (sFile)
+		{
+			fflush(sFile);
+		}
+	}
+}
+
+BOOL VaBeginLogRecord(LOG_SITE* Site, UINT64* Time)
+{
+	if (!sLoggerCreated)
+	{
+		return FALSE;
+	}
+
+	UINT64 time = VaQueryProfilerTime();
+
+	// Racing threads may both reset the window, that only lets a few extra records through
+	LONG64 window = (LONG64)(time / 1000000000);
+
+	if (Site->Window != window)
+	{
+		Site->Window = window;
+		Site->Count = 0;
+	}
+
+	// A site over its limit is only read, so a flooding call site does not bounce the counter between cores
+	if (((UINT32)Site->Count >= Site->Limit) || ((UINT32)InterlockedIncrement(&Site->Count) > Site->Limit))
+	{
+		InterlockedIncrement(&Site->Suppressed);
+
+		return FALSE;
+	}
+
+	*Time = time;
+
+	return TRUE;
+}
+VOID VaCommitLogRecord(LOG_SITE* Site, UINT64 Time, const UINT64* Arguments, UINT32 ArgumentCount)
+{
+	LONG64 position = sHead;
+	LOG_RECORD* record = NULL;
+
+	while (TRUE)
+	{
+		record = &sRecords[position % LOG_RING_SIZE];
+
+		LONG64 sequence = ReadAcquire64(&record->Sequence);
+
+		if (sequence == position)
+		{
+			LONG64 previous = InterlockedCompareExchange64(&sHead, position + 1, position);
+
+			if (previous == position)
+			{
+				break;
+			}
+
+			position = previous;
+		}
+		else if (sequence < position)
+		{
+			// The formatting thread is a whole ring behind, the record is lost rather than stalling the caller
+			InterlockedIncrement64(&sDroppedCount);
+
+			return;
+		}
+		else
+		{
+			position = sHead;
+		}
+	}
+
+	record->Site = Site;
+	record->Time = Time;
+	record->ThreadId = GetCurrentThreadId();
+	record->ArgumentCount = ArgumentCount;
+	record->Suppressed = (UINT32)InterlockedExchange(&Site->Suppressed, 0);
+
+	memcpy(record->Arguments, Arguments, sizeof(UINT64) * ArgumentCount);
+
+	WriteRelease64(&record->Sequence, position + 1);
+}
+
+VOID VaGetLoggerStatistics(LOG_STATISTICS* Statistics)
+{
+	Statistics->WrittenCount = sWrittenCount;
+	Statistics->DroppedCount = sDroppedCount;
+	Statistics->SuppressedCount = sSuppressedCount;
+}
+
+static UINT32 VaFormatLogMessage(CHAR* Buffer, UINT32 Size, LPCSTR Format, const UINT64* Arguments, UINT32 ArgumentCount)
+{
+	UINT32 length = 0;
+	UINT32 argument = 0;
+
+	LPCSTR cursor = Format;
+
+	while (*cursor && (length < (Size - 1)))
+	{
+		if (*cursor != '%')
+		{
+			Buffer[length++] = *cursor++;
+
+			continue;
+		}
+
+		if (cursor[1] == '%')
+		{
+			Buffer[length++] = '%';
+
+			cursor += 2;
+
+			continue;
+		}
+
+		LPCSTR start = cursor++;
+
+		UINT32 starCount = 0;
+
+		while (*cursor && strchr("-+ #0", *cursor))
+		{
+			cursor++;
+		}
+
+		if (*cursor == '*')
+		{
+			starCount += 1;
+			cursor++;
+		}
+
+		while ((*cursor >= '0') && (*cursor <= '9'))
+		{
+			cursor++;
+		}
+
+		if (*cursor == '.')
+		{
+			cursor++;
+
+			if (*cursor == '*')
+			{
+				starCount += 1;
+				cursor++;
+			}
+
+			while ((*cursor >= '0') && (*cursor <= '9'))
+			{
+				cursor++;
+			}
+		}
+
+		// The length modifier only decides how wide the original argument was, it is replaced below
+		LPCSTR modifier = cursor;
+		UINT32 bits = 32;
+
+		if ((cursor[0] == 'h') && (cursor[1] == 'h')) { bits = 8; cursor += 2; }
+		else if (cursor[0] == 'h') { bits = 16; cursor += 1; }
+		else if ((cursor[0] == 'l') && (cursor[1] == 'l')) { bits = 64; cursor += 2; }
+		else if (cursor[0] == 'l') { bits = 32; cursor += 1; }
+		else if (strncmp(cursor, "I64", 3) == 0) { bits = 64; cursor += 3; }
+		else if (strncmp(cursor, "I32", 3) == 0) { bits = 32; cursor += 3; }
+		else if ((cursor[0] != 0) && strchr("zjtI", cursor[0])) { bits = 64; cursor += 1; }
+		else if (cursor[0] == 'L') { cursor += 1; }
+
+		CHAR conversion = *cursor;
+
+		if (!conversion)
+		{
+			break;
+		}
+
+		cursor++;
+
+		UINT32 prefixLength = (UINT32)(modifier - start);
+
+		if (((argument + starCount) >= ArgumentCount) || (prefixLength > (LOG_SPEC_SIZE - 4)))
+		{
+			// Missing arguments leave the conversion as written
+			while ((start != cursor) && (length < (Size - 1)))
+			{
+				Buffer[length++] = *start++;
+			}
+
+			continue;
+		}
+
+		INT32 stars[2] = { 0 };
+
+		for (UINT32 i = 0; i < starCount; i++)
+		{
+			stars[i] = (INT32)Arguments[argument++];
+		}
+
+		UINT64 value = Arguments[argument++];
+
+		CHAR spec[LOG_SPEC_SIZE];
+
+		memcpy(spec, start, prefixLength);
+
+		CHAR* specEnd = spec + prefixLength;
+
+		INT32 written = 0;
+
+		switch (conversion)
+		{
+			case 'd':
+			case 'i':
+			{
+				INT64 number = (bits == 8) ? (INT8)value : (bits == 16) ? (INT16)value : (bits == 32) ? (INT32)value : (INT64)value;
+
+				memcpy(specEnd, "ll", 2); specEnd[2] = conversion; specEnd[3] = 0;
+
+				written = VaFormatLogArgument(Buffer + length, Size - length, spec, stars, starCount, (long long)number);
+
+				break;
+			}
+			case 'u':
+			case 'x':
+			case 'X':
+			case 'o':
+			{
+				UINT64 number = (bits == 8) ? (UINT8)value : (bits == 16) ? (UINT16)value : (bits == 32) ? (UINT32)value : value;
+
+				memcpy(specEnd, "ll", 2); specEnd[2] = conversion; specEnd[3] = 0;
+
+				written = VaFormatLogArgument(Buffer + length, Size - length, spec, stars, starCount, (unsigned long long)number);
+
+				break;
+			}
+			case 'c':
+			{
+				specEnd[0] = conversion; specEnd[1] = 0;
+
+				written = VaFormatLogArgument(Buffer + length, Size - length, spec, stars, starCount, (INT32)value);
+
+				break;
+			}
+			case 'e':
+			case 'E':
+			case 'f':
+			case 'F':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+			{
+				DOUBLE number;
+
+				memcpy(&number, &value, sizeof(number));
+
+				specEnd[0] = conversion; specEnd[1] = 0;
+
+				written = VaFormatLogArgument(Buffer + length, Size - length, spec, stars, starCount, number);
+
+				break;
+			}
+			case 's':
+			{
+				specEnd[0] = conversion; specEnd[1] = 0;
+
+				written = VaFormatLogArgument(Buffer + length, Size - length, spec, stars, starCount, value ? (LPCSTR)value : "(null)");
+
+				break;
+			}
+			case 'p':
+			{
+				specEnd[0] = conversion; specEnd[1] = 0;
+
+				written = VaFormatLogArgument(Buffer + length, Size - length, spec, stars, starCount, (PVOID)value);
+
+				break;
+			}
+		}
+
+		if (written > 0)
+		{
+			length = min(length + (UINT32)written, Size - 1);
+		}
+	}
+
+	Buffer[length] = 0;
+
+	return length;
+}
+
+template<typename T>
+static INT32 VaFormatLogArgument(CHAR* Buffer, UINT32 Size, LPCSTR Spec, const INT32* Stars, UINT32 StarCount, T Value)
+{
+	switch (StarCount)
+	{
+		case 0: return snprintf(Buffer, Size, Spec, Value);
+		case 1: return snprintf(Buffer, Size, Spec, Stars[0], Value);
+		default: return snprintf(Buffer, Size, Spec, Stars[0], Stars[1], Value);
+	}
+}
\ No newline at end of file
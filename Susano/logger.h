@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string.h>
+
+#include <windows.h>
+
+#include <type_traits>
+
+#define LOG_ARGUMENT_COUNT (8)
+#define LOG_DEFAULT_RATE_LIMIT (16)
+
+#define VA_LOG(FORMAT, ...) VA_LOG_LIMITED(LOG_DEFAULT_RATE_LIMIT, FORMAT, ##__VA_ARGS__)
+
+// Every call site owns a static site, its address is the format id written into the records
+#define VA_LOG_LIMITED(LIMIT, FORMAT, ...) \
+	{ \
+		static LOG_SITE logSite = { FORMAT, LIMIT }; \
+		VaLog(&logSite, ##__VA_ARGS__); \
+	}
+
+// Limit is the number of records per second that get through, the rest is only counted
+struct LOG_SITE
+{
+	LPCSTR Format;
+	UINT32 Limit;
+	volatile LONG64 Window;
+	volatile LONG Count;
+	volatile LONG Suppressed;
+};
+
+struct LOG_STATISTICS
+{
+	UINT64 WrittenCount;
+	UINT64 DroppedCount;
+	UINT64 SuppressedCount;
+};
+
+VOID VaCreateLogger(LPCSTR FilePath);
+VOID VaDestroyLogger(VOID);
+
+// Formats and writes everything queued so far, only ever called from one thread at a time
+VOID VaFlushLogger(VOID);
+
+BOOL VaBeginLogRecord(LOG_SITE* Site, UINT64* Time);
+VOID VaCommitLogRecord(LOG_SITE* Site, UINT64 Time, const UINT64* Arguments, UINT32 ArgumentCount);
+
+VOID VaGetLoggerStatistics(LOG_STATISTICS* Statistics);
+
+// Arguments are widened to 64 bits, the formatting thread narrows them again according to the conversion
+inline UINT64 VaPackLogArgument(DOUBLE Value)
+{
+	UINT64 bits;
+
+	memcpy(&bits, &Value, sizeof(bits));
+
+	return bits;
+}
+inline UINT64 VaPackLogArgument(FLOAT Value)
+{
+	return VaPackLogArgument((DOUBLE)Value);
+}
+template<typename T>
+inline UINT64 VaPackLogArgument(T* Value)
+{
+	// Strings are kept by pointer and have to outlive the record, string literals always do
+	return (UINT64)Value;
+}
+template<typename T>
+inline UINT64 VaPackLogArgument(T Value)
+{
+	static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Unsupported log argument");
+
+	return (UINT64)(INT64)Value;
+}
+
+template<typename... ARGUMENTS>
+inline VOID VaLog(LOG_SITE* Site, ARGUMENTS... Arguments)
+{
+	static_assert(sizeof...(ARGUMENTS) <= LOG_ARGUMENT_COUNT, "Too many log arguments");
+
+	UINT64 time = 0;
+
+	if (!VaBeginLogRecord(Site, &time))
+	{
+		return;
+	}
+
+	UINT64 arguments[sizeof...(ARGUMENTS) + 1] = { VaPackLogArgument(Arguments)... };
+
+	VaCommitLogRecord(Site, time, arguments, sizeof...(ARGUMENTS));
+}
\ No newline at end of file
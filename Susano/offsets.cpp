@@ -0,0 +1,816 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "offsets.h"
+#include "scanner.h"
+#include "scancache.h"
+#include "safememory.h"
+#include "logger.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define OFFSET_LINE_LENGTH (512)
+#define OFFSET_TOKEN_COUNT (5 + SIGNATURE_LENGTH)
+#define OFFSET_MODULE_NAME_LENGTH (64)
+
+#define OFFSET_SCHEMA_MAXIMUM_SIZE (1024 * 1024)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// The root is the module base or a signature address plus Base, a chain dereferences it and every offset but the last
+struct OFFSET_FIELD_DATA
+{
+	CHAR Name[OFFSET_NAME_LENGTH];
+	INT32 Module;
+	INT32 Signature;
+	OFFSET_TYPE Type;
+	UINT64 Base;
+	INT64 Chain[OFFSET_CHAIN_LENGTH];
+	UINT32 ChainLength;
+	UINT64 Root;
+	UINT64 RootValue;
+};
+
+// Without an operand the signature address is the match itself, otherwise the rip relative target of that operand
+struct OFFSET_SIGNATURE_DATA
+{
+	CHAR Name[OFFSET_NAME_LENGTH];
+	UINT32 LineNumber;
+	INT32 Module;
+	UINT32 OperandOffset;
+	UINT32 InstructionLength;
+	SIGNATURE Signature;
+	UINT64 Address;
+};
+
+// Logged strings have to outlive the record, so problems are reported by the line that introduced them
+struct OFFSET_MODULE_DATA
+{
+	CHAR Name[OFFSET_MODULE_NAME_LENGTH];
+	UINT32 LineNumber;
+	UINT64 Base;
+};
+
+struct OFFSET_TABLE
+{
+	OFFSET_FIELD_DATA Fields[OFFSET_FIELD_COUNT];
+	OFFSET_MODULE_DATA Modules[OFFSET_MODULE_COUNT];
+	OFFSET_SIGNATURE_DATA Signatures[OFFSET_SIGNATURE_COUNT];
+	UINT32 FieldCount;
+	UINT32 ModuleCount;
+	UINT32 SignatureCount;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static CHAR sDefaultSchema[] = R"schema(
+	# signature name module operand length pattern, for example
+	# signature camera_block main.dll 3 7 48 8B 05 ?? ?? ?? ??
+	# lets a field use camera_block or camera_block+0x10 as its base, operand and length count from the match start
+	# and resolve the rip relative operand, - - uses the match itself
+
+	# name               module              base        chain    type
+	window_width         flower_kernel.dll   0x11C2C0    -        u32
+	window_height        flower_kernel.dll   0x11C2C4    -        u32
+	player_object        main.dll            0xB6B2D0    0x0      struct
+	camera_block         main.dll            0xB66390    -        struct
+	framerate_divisor    main.dll            0xB6AC45    -        u8
+)schema";
+
+static LPCSTR sTypeNames[] = { "u8", "u16", "u32", "u64", "i32", "f32", "f64", "ptr", "struct" };
+static UINT32 sTypeSizes[] = { 1, 2, 4, 8, 4, 4, 8, 8, 0 };
+
+static OFFSET_MODULE_PROC sModuleProc = NULL;
+
+// Loads swap the table and resolves re-walk chains under the exclusive lock, everything else only ever holds it shared
+static SRWLOCK sLock = SRWLOCK_INIT;
+
+static OFFSET_TABLE sTable = { 0 };
+
+// Kept apart from the descriptors so reads only touch one dense array
+static UINT64 sAddresses[OFFSET_FIELD_COUNT] = { 0 };
+
+static volatile LONG sGeneration = 0;
+
+static UINT64 sWalkCount = 0;
+
+static BOOL sEmbedded = FALSE;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static BOOL VaParseOffsetSchema(LPCSTR Text, OFFSET_TABLE* Table);
+static BOOL VaParseOffsetLine(CHAR* Line, UINT32 LineNumber, OFFSET_TABLE* Table);
+static BOOL VaParseOffsetField(CHAR** Tokens, UINT32 TokenCount, UINT32 LineNumber, OFFSET_TABLE* Table);
+static BOOL VaParseOffsetSignature(CHAR** Tokens, UINT32 TokenCount, UINT32 LineNumber, OFFSET_TABLE* Table);
+
+static INT32 VaFindOffsetModule(OFFSET_TABLE* Table, LPCSTR Name, UINT32 LineNumber);
+
+static VOID VaScanOffsetSignatures(OFFSET_TABLE* Table);
+static VOID VaApplyOffsetSignatureMatch(OFFSET_SIGNATURE_DATA* Signature, UINT64 Address, UINT32 MatchCount);
+
+static UINT64 VaWalkOffsetChain(UINT64 Pointer, const OFFSET_FIELD_DATA* Field);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateOffsets(OFFSET_MODULE_PROC ModuleProc)
+{
+	sModuleProc = ModuleProc;
+
+	memset(&sTable, 0, sizeof(sTable));
+	memset(sAddresses, 0, sizeof(sAddresses));
+
+	sGeneration = 0;
+	sWalkCount = 0;
+}
+VOID VaDestroyOffsets(VOID)
+{
+	AcquireSRWLockExclusive(&sLock);
+
+	memset(&sTable, 0, sizeof(sTable));
+	memset(sAddresses, 0, sizeof(sAddresses));
+
+	ReleaseSRWLockExclusive(&sLock);
+}
+
+BOOL VaLoadOffsetSchema(LPCSTR FilePath)
+{
+	FILE* file = NULL;
+
+	if (fopen_s(&file, FilePath, "rb") != 0)
+	{
+		return VaLoadOffsetSchemaText(sDefaultSchema, TRUE);
+	}
+
+	fseek(file, 0, SEEK_END);
+
+	LONG size = ftell(file);
+
+	fseek(file, 0, SEEK_SET);
+
+	BOOL loaded = FALSE;
+
+	if ((size >= 0) && (size <= OFFSET_SCHEMA_MAXIMUM_SIZE))
+	{
+		CHAR* text = (CHAR*)malloc(size + 1);
+
+		text[fread(text, 1, size, file)] = 0;
+
+		loaded = VaLoadOffsetSchemaText(text, FALSE);
+
+		free(text);
+	}
+
+	fclose(file);
+
+	// Without any table yet a broken file still has to leave the overlays something to read
+	if (!loaded && (sGeneration == 0))
+	{
+		return VaLoadOffsetSchemaText(sDefaultSchema, TRUE);
+	}
+
+	return loaded;
+}
+BOOL VaLoadOffsetSchemaText(LPCSTR Text, BOOL Embedded)
+{
+	OFFSET_TABLE* table = (OFFSET_TABLE*)calloc(1, sizeof(OFFSET_TABLE));
+
+	// A broken schema keeps the previous table alive instead of leaving every field unresolved
+	if (!VaParseOffsetSchema(Text, table))
+	{
+		free(table);
+
+		return FALSE;
+	}
+
+	for (UINT32 i = 0; i < table->ModuleCount; i++)
+	{
+		OFFSET_MODULE_DATA* module = &table->Modules[i];
+
+		module->Base = sModuleProc ? sModuleProc(module->Name) : 0;
+
+		if (!module->Base)
+		{
+			VA_LOG("Offset module from line %u is not loaded", module->LineNumber);
+		}
+	}
+
+	// Scanning happens before the lock is taken, readers keep using the previous table meanwhile
+	VaScanOffsetSignatures(table);
+
+	for (UINT32 i = 0; i < table->FieldCount; i++)
+	{
+		OFFSET_FIELD_DATA* field = &table->Fields[i];
+
+		UINT64 origin = (field->Signature >= 0) ? table->Signatures[field->Signature].Address : table->Modules[field->Module].Base;
+
+		field->Root = origin ? (origin + field->Base) : 0;
+	}
+
+	AcquireSRWLockExclusive(&sLock);
+
+	sTable = *table;
+
+	// Plain fields never move, only chained ones are left for VaResolveOffsets
+	for (UINT32 i = 0; i < OFFSET_FIELD_COUNT; i++)
+	{
+		OFFSET_FIELD_DATA* field = &sTable.Fields[i];
+
+		sAddresses[i] = ((i < sTable.FieldCount) && (field->ChainLength == 0)) ? field->Root : 0;
+	}
+
+	sEmbedded = Embedded;
+
+	InterlockedIncrement(&sGeneration);
+
+	UINT32 fieldCount = sTable.FieldCount;
+
+	ReleaseSRWLockExclusive(&sLock);
+
+	free(table);
+
+	VA_LOG("Loaded %u offset fields from the %s schema", fieldCount, Embedded ? "embedded" : "file");
+
+	return TRUE;
+}
+
+UINT32 VaGetOffsetGeneration(VOID)
+{
+	return (UINT32)sGeneration;
+}
+
+OFFSET_FIELD VaFindOffsetField(LPCSTR Name)
+{
+	for (UINT32 i = 0; i < sTable.FieldCount; i++)
+	{
+		if (strcmp(sTable.Fields[i].Name, Name) == 0)
+		{
+			return i;
+		}
+	}
+
+	return INVALID_OFFSET_FIELD;
+}
+
+VOID VaResolveOffsets(VOID)
+{
+	AcquireSRWLockExclusive(&sLock);
+
+	for (UINT32 i = 0; i < sTable.FieldCount; i++)
+	{
+		OFFSET_FIELD_DATA* field = &sTable.Fields[i];
+
+		if (!field->Root || (field->ChainLength == 0))
+		{
+			continue;
+		}
+
+		// Only a changed base pointer makes the chain worth walking again
+		UINT64 rootValue = 0;
+
+		VaSafeRead(field->Root, &rootValue, sizeof(rootValue));
+
+		if ((rootValue == field->RootValue) && sAddresses[i])
+		{
+			continue;
+		}
+
+		field->RootValue = rootValue;
+
+		sAddresses[i] = VaWalkOffsetChain(rootValue, field);
+
+		sWalkCount += 1;
+	}
+
+	ReleaseSRWLockExclusive(&sLock);
+}
+
+VOID VaAcquireOffsets(VOID)
+{
+	AcquireSRWLockShared(&sLock);
+}
+VOID VaReleaseOffsets(VOID)
+{
+	ReleaseSRWLockShared(&sLock);
+}
+
+UINT64 VaGetOffsetFieldAddress(OFFSET_FIELD Field)
+{
+	if ((Field < 0) || ((UINT32)Field >= sTable.FieldCount))
+	{
+		return 0;
+	}
+
+	return sAddresses[Field];
+}
+
+BOOL VaReadOffsetField(OFFSET_FIELD Field, VOID* Value, UINT32 Size)
+{
+	UINT64 address = VaGetOffsetFieldAddress(Field);
+
+	if (!address || (sTypeSizes[sTable.Fields[Field].Type] != Size))
+	{
+		return FALSE;
+	}
+
+	return VaSafeRead(address, Value, Size);
+}
+BOOL VaWriteOffsetField(OFFSET_FIELD Field, const VOID* Value, UINT32 Size)
+{
+	UINT64 address = VaGetOffsetFieldAddress(Field);
+
+	if (!address || (sTypeSizes[sTable.Fields[Field].Type] != Size))
+	{
+		return FALSE;
+	}
+
+	return VaSafeWrite(address, Value, Size);
+}
+
+VOID VaGetOffsetStatistics(OFFSET_STATISTICS* Statistics)
+{
+	AcquireSRWLockShared(&sLock);
+
+	Statistics->FieldCount = sTable.FieldCount;
+	Statistics->ResolvedCount = 0;
+	Statistics->Generation = sGeneration;
+	Statistics->WalkCount = sWalkCount;
+	Statistics->SignatureCount = sTable.SignatureCount;
+	Statistics->FoundSignatureCount = 0;
+	Statistics->Embedded = sEmbedded;
+
+	for (UINT32 i = 0; i < sTable.SignatureCount; i++)
+	{
+		if (sTable.Signatures[i].Address)
+		{
+			Statistics->FoundSignatureCount += 1;
+		}
+	}
+
+	for (UINT32 i = 0; i < sTable.FieldCount; i++)
+	{
+		if (sAddresses[i])
+		{
+			Statistics->ResolvedCount += 1;
+		}
+	}
+
+	ReleaseSRWLockShared(&sLock);
+}
+
+static BOOL VaParseOffsetSchema(LPCSTR Text, OFFSET_TABLE* Table)
+{
+	BOOL valid = TRUE;
+
+	CHAR line[OFFSET_LINE_LENGTH];
+
+	UINT32 lineNumber = 0;
+
+	LPCSTR cursor = Text;
+
+	while (*cursor)
+	{
+		LPCSTR end = cursor;
+
+		while (*end && (*end != '\n'))
+		{
+			end++;
+		}
+
+		lineNumber += 1;
+
+		UINT32 length = (UINT32)(end - cursor);
+
+		if (length >= OFFSET_LINE_LENGTH)
+		{
+			VA_LOG("Offset schema line %u is too long", lineNumber);
+
+			valid = FALSE;
+		}
+		else
+		{
+			memcpy(line, cursor, length);
+
+			line[length] = 0;
+
+			if (!VaParseOffsetLine(line, lineNumber, Table))
+			{
+				valid = FALSE;
+			}
+		}
+
+		cursor = *end ? (end + 1) : end;
+	}
+
+	return valid;
+}
+static BOOL VaParseOffsetLine(CHAR* Line, UINT32 LineNumber, OFFSET_TABLE* Table)
+{
+	CHAR* comment = strchr(Line, '#');
+
+	if (comment)
+	{
+		*comment = 0;
+	}
+
+	CHAR* tokens[OFFSET_TOKEN_COUNT] = { 0 };
+	CHAR* context = NULL;
+
+	UINT32 tokenCount = 0;
+
+	for (CHAR* token = strtok_s(Line, " \t\r", &context); token; token = strtok_s(NULL, " \t\r", &context))
+	{
+		if (tokenCount == OFFSET_TOKEN_COUNT)
+		{
+			VA_LOG("Offset schema line %u has too many tokens", LineNumber);
+
+			return FALSE;
+		}
+
+		tokens[tokenCount++] = token;
+	}
+
+	if (tokenCount == 0)
+	{
+		return TRUE;
+	}
+
+	if (strcmp(tokens[0], "signature") == 0)
+	{
+		return VaParseOffsetSignature(tokens + 1, tokenCount - 1, LineNumber, Table);
+	}
+
+	return VaParseOffsetField(tokens, tokenCount, LineNumber, Table);
+}
+static BOOL VaParseOffsetField(CHAR** Tokens, UINT32 TokenCount, UINT32 LineNumber, OFFSET_TABLE* Table)
+{
+	if (TokenCount != 5)
+	{
+		VA_LOG("Offset schema line %u needs name, module, base, chain and type", LineNumber);
+
+		return FALSE;
+	}
+
+	if ((strlen(Tokens[0]) >= OFFSET_NAME_LENGTH) || (strlen(Tokens[1]) >= OFFSET_MODULE_NAME_LENGTH))
+	{
+		VA_LOG("Offset schema line %u has a name that is too long", LineNumber);
+
+		return FALSE;
+	}
+
+	if (Table->FieldCount == OFFSET_FIELD_COUNT)
+	{
+		VA_LOG("Offset schema line %u exceeds the field limit", LineNumber);
+
+		return FALSE;
+	}
+
+	for (UINT32 i = 0; i < Table->FieldCount; i++)
+	{
+		if (strcmp(Table->Fields[i].Name, Tokens[0]) == 0)
+		{
+			VA_LOG("Offset schema line %u redefines a field", LineNumber);
+
+			return FALSE;
+		}
+	}
+
+	OFFSET_FIELD_DATA field = { 0 };
+
+	strcpy_s(field.Name, sizeof(field.Name), Tokens[0]);
+
+	field.Module = VaFindOffsetModule(Table, Tokens[1], LineNumber);
+	field.Signature = -1;
+
+	if (field.Module < 0)
+	{
+		return FALSE;
+	}
+
+	CHAR* end = Tokens[2];
+
+	// A base that does not start with a digit names a signature, optionally followed by a signed offset
+	if ((*end < '0') || (*end > '9'))
+	{
+		while (*end && (*end != '+') && (*end != '-'))
+		{
+			end++;
+		}
+
+		for (UINT32 i = 0; i < Table->SignatureCount; i++)
+		{
+			if ((strncmp(Table->Signatures[i].Name, Tokens[2], end - Tokens[2]) == 0) && (Table->Signatures[i].Name[end - Tokens[2]] == 0))
+			{
+				field.Signature = i;
+
+				break;
+			}
+		}
+
+		if ((field.Signature < 0) || (Table->Signatures[field.Signature].Module != field.Module))
+		{
+			VA_LOG("Offset schema line %u uses an unknown signature", LineNumber);
+
+			return FALSE;
+		}
+	}
+
+	field.Base = *end ? strtoull(end, &end, 0) : 0;
+
+	if (*end)
+	{
+		VA_LOG("Offset schema line %u has an invalid base", LineNumber);
+
+		return FALSE;
+	}
+
+	if (strcmp(Tokens[3], "-") != 0)
+	{
+		CHAR* chainContext = NULL;
+
+		for (CHAR* offset = strtok_s(Tokens[3], ",", &chainContext); offset; offset = strtok_s(NULL, ",", &chainContext))
+		{
+			if (field.ChainLength == OFFSET_CHAIN_LENGTH)
+			{
+				VA_LOG("Offset schema line %u has a chain that is too long", LineNumber);
+
+				return FALSE;
+			}
+
+			field.Chain[field.ChainLength++] = strtoll(offset, &end, 0);
+
+			if (*end)
+			{
+				VA_LOG("Offset schema line %u has an invalid chain offset", LineNumber);
+
+				return FALSE;
+			}
+		}
+	}
+
+	UINT32 type = 0;
+
+	while ((type < ARRAYSIZE(sTypeNames)) && (strcmp(sTypeNames[type], Tokens[4]) != 0))
+	{
+		type++;
+	}
+
+	if (type == ARRAYSIZE(sTypeNames))
+	{
+		VA_LOG("Offset schema line %u has an unknown type", LineNumber);
+
+		return FALSE;
+	}
+
+	field.Type = (OFFSET_TYPE)type;
+
+	Table->Fields[Table->FieldCount++] = field;
+
+	return TRUE;
+}
+static BOOL VaParseOffsetSignature(CHAR** Tokens, UINT32 TokenCount, UINT32 LineNumber, OFFSET_TABLE* Table)
+{
+	if (TokenCount < 5)
+	{
+		VA_LOG("Offset schema line %u needs name, module, operand, length and pattern", LineNumber);
+
+		return FALSE;
+	}
+
+	if (strlen(Tokens[0]) >= OFFSET_NAME_LENGTH)
+	{
+		VA_LOG("Offset schema line %u has a name that is too long", LineNumber);
+
+		return FALSE;
+	}
+
+	if (Table->SignatureCount == OFFSET_SIGNATURE_COUNT)
+	{
+		VA_LOG("Offset schema line %u exceeds the signature limit", LineNumber);
+
+		return FALSE;
+	}
+
+	for (UINT32 i = 0; i < Table->SignatureCount; i++)
+	{
+		if (strcmp(Table->Signatures[i].Name, Tokens[0]) == 0)
+		{
+			VA_LOG("Offset schema line %u redefines a signature", LineNumber);
+
+			return FALSE;
+		}
+	}
+
+	OFFSET_SIGNATURE_DATA* signature = &Table->Signatures[Table->SignatureCount];
+
+	strcpy_s(signature->Name, sizeof(signature->Name), Tokens[0]);
+
+	signature->LineNumber = LineNumber;
+
+	signature->Module = VaFindOffsetModule(Table, Tokens[1], LineNumber);
+
+	if (signature->Module < 0)
+	{
+		return FALSE;
+	}
+
+	if ((strcmp(Tokens[2], "-") != 0) || (strcmp(Tokens[3], "-") != 0))
+	{
+		CHAR* operandEnd = NULL;
+		CHAR* lengthEnd = NULL;
+
+		signature->OperandOffset = strtoul(Tokens[2], &operandEnd, 0);
+		signature->InstructionLength = strtoul(Tokens[3], &lengthEnd, 0);
+
+		if (*operandEnd || *lengthEnd || ((signature->OperandOffset + sizeof(INT32)) > signature->InstructionLength))
+		{
+			VA_LOG("Offset schema line %u has an invalid operand", LineNumber);
+
+			return FALSE;
+		}
+	}
+
+	// The pattern was split on whitespace like everything else, so its bytes are joined back together
+	CHAR pattern[SIGNATURE_LENGTH * 3 + 1] = { 0 };
+
+	for (UINT32 i = 4; i < TokenCount; i++)
+	{
+		if ((strlen(pattern) + strlen(Tokens[i]) + 2) > sizeof(pattern))
+		{
+			VA_LOG("Offset schema line %u has a pattern that is too long", LineNumber);
+
+			return FALSE;
+		}
+
+		strcat_s(pattern, sizeof(pattern), Tokens[i]);
+		strcat_s(pattern, sizeof(pattern), " ");
+	}
+
+	signature->Signature = VaParseSignature(pattern);
+
+	if (!signature->Signature.Valid)
+	{
+		VA_LOG("Offset schema line %u has an invalid pattern", LineNumber);
+
+		return FALSE;
+	}
+
+	Table->SignatureCount += 1;
+
+	return TRUE;
+}
+
+static INT32 VaFindOffsetModule(OFFSET_TABLE* Table, LPCSTR Name, UINT32 LineNumber)
+{
+	if (strlen(Name) >= OFFSET_MODULE_NAME_LENGTH)
+	{
+		VA_LOG("Offset schema line %u has a module name that is too long", LineNumber);
+
+		return -1;
+	}
+
+	// Modules are shared between fields and signatures, their base is looked up once per load
+	for (UINT32 i = 0; i < Table->ModuleCount; i++)
+	{
+		if (_stricmp(Table->Modules[i].Name, Name) == 0)
+		{
+			return i;
+		}
+	}
+
+	if (Table->ModuleCount == OFFSET_MODULE_COUNT)
+	{
+		VA_LOG("Offset schema line %u exceeds the module limit", LineNumber);
+
+		return -1;
+	}
+
+	strcpy_s(Table->Modules[Table->ModuleCount].Name, OFFSET_MODULE_NAME_LENGTH, Name);
+
+	Table->Modules[Table->ModuleCount].LineNumber = LineNumber;
+
+	return Table->ModuleCount++;
+}
+
+static VOID VaScanOffsetSignatures(OFFSET_TABLE* Table)
+{
+	SCAN_REQUEST* requests = (SCAN_REQUEST*)calloc(OFFSET_SIGNATURE_COUNT, sizeof(SCAN_REQUEST));
+
+	UINT32 requestSignatures[OFFSET_SIGNATURE_COUNT] = { 0 };
+
+	// Every module is walked at most once no matter how many signatures point into it, and not at all while the cache knows its build
+	for (UINT32 i = 0; i < Table->ModuleCount; i++)
+	{
+		OFFSET_MODULE_DATA* module = &Table->Modules[i];
+
+		BOOL used = FALSE;
+
+		for (UINT32 j = 0; j < Table->SignatureCount; j++)
+		{
+			used |= (Table->Signatures[j].Module == (INT32)i);
+		}
+
+		if (!used || !module->Base)
+		{
+			continue;
+		}
+
+		SCAN_MODULE_KEY key = { 0 };
+
+		VaGetScanModuleKey(module->Base, &key);
+
+		UINT32 requestCount = 0;
+
+		for (UINT32 j = 0; j < Table->SignatureCount; j++)
+		{
+			OFFSET_SIGNATURE_DATA* signature = &Table->Signatures[j];
+
+			if (signature->Module != (INT32)i)
+			{
+				continue;
+			}
+
+			UINT64 rva = 0;
+			UINT32 matchCount = 0;
+
+			if (VaLookupScanCache(module->Name, &key, &signature->Signature, &rva, &matchCount))
+			{
+				VaApplyOffsetSignatureMatch(signature, module->Base + rva, matchCount);
+
+				continue;
+			}
+
+			requests[requestCount].Signature = signature->Signature;
+			requestSignatures[requestCount] = j;
+
+			requestCount += 1;
+		}
+
+		if (!requestCount)
+		{
+			continue;
+		}
+
+		VaScanModule(module->Base, requests, requestCount);
+
+		for (UINT32 j = 0; j < requestCount; j++)
+		{
+			SCAN_REQUEST* request = &requests[j];
+
+			OFFSET_SIGNATURE_DATA* signature = &Table->Signatures[requestSignatures[j]];
+
+			VaStoreScanCache(module->Name, &key, &signature->Signature, request->MatchCount ? (request->Address - module->Base) : 0, request->MatchCount);
+
+			VaApplyOffsetSignatureMatch(signature, request->Address, request->MatchCount);
+		}
+	}
+
+	VaFlushScanCache();
+
+	free(requests);
+}
+static VOID VaApplyOffsetSignatureMatch(OFFSET_SIGNATURE_DATA* Signature, UINT64 Address, UINT32 MatchCount)
+{
+	if (MatchCount == 0)
+	{
+		VA_LOG("Signature from line %u was not found", Signature->LineNumber);
+
+		return;
+	}
+
+	if (MatchCount > 1)
+	{
+		VA_LOG("Signature from line %u matched %u times, using the first", Signature->LineNumber, MatchCount);
+	}
+
+	Signature->Address = Signature->InstructionLength ? VaResolveRelativeAddress(Address, Signature->OperandOffset, Signature->InstructionLength) : Address;
+}
+
+static UINT64 VaWalkOffsetChain(UINT64 Pointer, const OFFSET_FIELD_DATA* Field)
+{
+	for (UINT32 i = 0; (i + 1) < Field->ChainLength; i++)
+	{
+		if (!Pointer)
+		{
+			return 0;
+		}
+
+		// Objects along the chain get freed during area loads, a failed read ends the walk like a null link
+		if (!VaSafeRead(Pointer + Field->Chain[i], &Pointer, sizeof(Pointer)))
+		{
+			return 0;
+		}
+	}
+
+	return Pointer ? (Pointer + Field->Chain[Field->ChainLength - 1]) : 0;
+}
\ No newline at end of file
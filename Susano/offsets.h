@@ -0,0 +1,66 @@
+#pragma once
+
+#include <windows.h>
+
+#define INVALID_OFFSET_FIELD (-1)
+
+#define OFFSET_FIELD_COUNT (128)
+#define OFFSET_MODULE_COUNT (8)
+#define OFFSET_SIGNATURE_COUNT (32)
+#define OFFSET_CHAIN_LENGTH (8)
+#define OFFSET_NAME_LENGTH (32)
+
+typedef INT32 OFFSET_FIELD;
+
+typedef UINT64(*OFFSET_MODULE_PROC)(LPCSTR ModuleName);
+
+enum OFFSET_TYPE
+{
+	OFFSET_TYPE_U8,
+	OFFSET_TYPE_U16,
+	OFFSET_TYPE_U32,
+	OFFSET_TYPE_U64,
+	OFFSET_TYPE_I32,
+	OFFSET_TYPE_F32,
+	OFFSET_TYPE_F64,
+	OFFSET_TYPE_PTR,
+	// Only locates an object, its fields are read through a game structure plan instead
+	OFFSET_TYPE_STRUCT,
+};
+
+struct OFFSET_STATISTICS
+{
+	UINT32 FieldCount;
+	UINT32 ResolvedCount;
+	UINT32 Generation;
+	UINT32 SignatureCount;
+	UINT32 FoundSignatureCount;
+	UINT64 WalkCount;
+	BOOL Embedded;
+};
+
+VOID VaCreateOffsets(OFFSET_MODULE_PROC ModuleProc);
+VOID VaDestroyOffsets(VOID);
+
+// Falls back to the embedded schema when the file does not exist, every load bumps the generation
+BOOL VaLoadOffsetSchema(LPCSTR FilePath);
+BOOL VaLoadOffsetSchemaText(LPCSTR Text, BOOL Embedded);
+
+UINT32 VaGetOffsetGeneration(VOID);
+
+// Re-walks pointer chains whose base pointer changed, takes the lock exclusively and must not be called while holding it
+VOID VaResolveOffsets(VOID);
+
+// Everything below the acquire has to be called between VaAcquireOffsets and VaReleaseOffsets
+VOID VaAcquireOffsets(VOID);
+VOID VaReleaseOffsets(VOID);
+
+OFFSET_FIELD VaFindOffsetField(LPCSTR Name);
+
+UINT64 VaGetOffsetFieldAddress(OFFSET_FIELD Field);
+
+// Fails when the field is unresolved or its schema type does not have the given size
+BOOL VaReadOffsetField(OFFSET_FIELD Field, VOID* Value, UINT32 Size);
+BOOL VaWriteOffsetField(OFFSET_FIELD Field, const VOID* Value, UINT32 Size);
+
+VOID VaGetOffsetStatistics(OFFSET_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,409 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+
+#include "susano.h"
+#include "hash.h"
+#include "pipelinecache.h"
+#include "logger.h"
+
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define SHADER_COUNT (32)
+#define INPUT_LAYOUT_COUNT (32)
+#define PIPELINE_COUNT (32)
+
+#define CONSTANT_BUFFER_SLOT_COUNT (4)
+#define VERTEX_BUFFER_SLOT_COUNT (2)
+
+#define HR_CHECK(EXPRESSION) \
+	{ \
+		HRESULT result = (EXPRESSION); \
+		if (result != S_OK) \
+		{ \
+			VA_LOG("%s 0x%08X", #EXPRESSION, result); \
+		} \
+	}
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// Shaders are shared by the hash of their source, the vertex shader blob is kept for input layout creation
+struct SHADER_ENTRY
+{
+	UINT64 Hash;
+	ID3DBlob* Blob;
+	ID3D11DeviceChild* Shader;
+};
+
+struct INPUT_LAYOUT_ENTRY
+{
+	UINT64 Hash;
+	ID3D11InputLayout* InputLayout;
+};
+
+struct PIPELINE_DATA
+{
+	ID3D11VertexShader* VertexShader;
+	ID3D11PixelShader* PixelShader;
+	ID3D11InputLayout* InputLayout;
+	D3D11_PRIMITIVE_TOPOLOGY Topology;
+};
+
+// Everything last set on the immediate context through this module, NULL means unknown
+struct PIPELINE_STATE
+{
+	ID3D11VertexShader* VertexShader;
+	ID3D11PixelShader* PixelShader;
+	ID3D11InputLayout* InputLayout;
+	D3D11_PRIMITIVE_TOPOLOGY Topology;
+	ID3D11Buffer* ConstantBuffers[CONSTANT_BUFFER_SLOT_COUNT];
+	ID3D11Buffer* VertexBuffers[VERTEX_BUFFER_SLOT_COUNT];
+	UINT32 Strides[VERTEX_BUFFER_SLOT_COUNT];
+	UINT32 Offsets[VERTEX_BUFFER_SLOT_COUNT];
+	ID3D11Buffer* IndexBuffer;
+	UINT32 IndexOffset;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static SHADER_ENTRY sVertexShaders[SHADER_COUNT] = { 0 };
+static SHADER_ENTRY sPixelShaders[SHADER_COUNT] = { 0 };
+
+static UINT32 sVertexShaderCount = 0;
+static UINT32 sPixelShaderCount = 0;
+
+static INPUT_LAYOUT_ENTRY sInputLayouts[INPUT_LAYOUT_COUNT] = { 0 };
+
+static UINT32 sInputLayoutCount = 0;
+
+static PIPELINE_DATA sPipelines[PIPELINE_COUNT] = { 0 };
+
+static UINT32 sPipelineCount = 0;
+
+static PIPELINE_STATE sState = { 0 };
+
+static PIPELINE_CACHE_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static SHADER_ENTRY* VaAcquireVertexShader(CHAR* Source, UINT32 Size);
+static SHADER_ENTRY* VaAcquirePixelShader(CHAR* Source, UINT32 Size);
+static ID3D11InputLayout* VaAcquireInputLayout(SHADER_ENTRY* VertexShader, D3D11_INPUT_ELEMENT_DESC* InputElements, UINT32 InputElementCount);
+
+static VOID VaReleaseShaders(SHADER_ENTRY* Shaders, UINT32 Count);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreatePipelineCache(VOID)
+{
+	VaInvalidatePipelineState();
+}
+VOID VaDestroyPipelineCache(VOID)
+{
+	VaReleaseShaders(sVertexShaders, sVertexShaderCount);
+	VaReleaseShaders(sPixelShaders, sPixelShaderCount);
+
+	for (UINT32 i = 0; i < sInputLayoutCount; i++)
+	{
+		sInputLayouts[i].InputLayout->Release();
+	}
+
+	memset(sInputLayouts, 0, sizeof(sInputLayouts));
+	memset(sPipelines, 0, sizeof(sPipelines));
+	memset(&sState, 0, sizeof(sState));
+	memset(&sStatistics, 0, sizeof(sStatistics));
+
+	sVertexShaderCount = 0;
+	sPixelShaderCount = 0;
+	sInputLayoutCount = 0;
+	sPipelineCount = 0;
+}
+
+PIPELINE VaCreatePipeline(CHAR* VertexShaderSource, UINT32 VertexShaderSize, CHAR* PixelShaderSource, UINT32 PixelShaderSize, D3D11_INPUT_ELEMENT_DESC* InputElements, UINT32 InputElementCount, D3D11_PRIMITIVE_TOPOLOGY Topology)
+{
+	SHADER_ENTRY* vertexShader = VaAcquireVertexShader(VertexShaderSource, VertexShaderSize);
+	SHADER_ENTRY* pixelShader = VaAcquirePixelShader(PixelShaderSource, PixelShaderSize);
+
+	if (!vertexShader || !pixelShader)
+	{
+		return INVALID_PIPELINE;
+	}
+
+	ID3D11InputLayout* inputLayout = VaAcquireInputLayout(vertexShader, InputElements, InputElementCount);
+
+	if (!inputLayout)
+	{
+		return INVALID_PIPELINE;
+	}
+
+	PIPELINE_DATA pipeline = { 0 };
+	pipeline.VertexShader = (ID3D11VertexShader*)vertexShader->Shader;
+	pipeline.PixelShader = (ID3D11PixelShader*)pixelShader->Shader;
+	pipeline.InputLayout = inputLayout;
+	pipeline.Topology = Topology;
+
+	for (UINT32 i = 0; i < sPipelineCount; i++)
+	{
+		PIPELINE_DATA* existing = &sPipelines[i];
+
+		if ((existing->VertexShader == pipeline.VertexShader) && (existing->PixelShader == pipeline.PixelShader) && (existing->InputLayout == pipeline.InputLayout) && (existing->Topology == pipeline.Topology))
+		{
+			return (PIPELINE)i;
+		}
+	}
+
+	if (sPipelineCount == PIPELINE_COUNT)
+	{
+		return INVALID_PIPELINE;
+	}
+
+	sPipelines[sPipelineCount] = pipeline;
+
+	sPipelineCount += 1;
+
+	sStatistics.PipelineCount = sPipelineCount;
+
+	return (PIPELINE)(sPipelineCount - 1);
+}
+
+VOID VaBindPipeline(PIPELINE Pipeline)
+{
+	if (Pipeline == INVALID_PIPELINE)
+	{
+		return;
+	}
+
+	PIPELINE_DATA* pipeline = &sPipelines[Pipeline];
+
+	UINT32 changeCount = 0;
+
+	if (sState.InputLayout != pipeline->InputLayout)
+	{
+		gDeviceContext->IASetInputLayout(pipeline->InputLayout);
+
+		sState.InputLayout = pipeline->InputLayout;
+
+		changeCount += 1;
+	}
+
+	if (sState.VertexShader != pipeline->VertexShader)
+	{
+		gDeviceContext->VSSetShader(pipeline->VertexShader, NULL, 0);
+
+		sState.VertexShader = pipeline->VertexShader;
+
+		changeCount += 1;
+	}
+
+	if (sState.PixelShader != pipeline->PixelShader)
+	{
+		gDeviceContext->PSSetShader(pipeline->PixelShader, NULL, 0);
+
+		sState.PixelShader = pipeline->PixelShader;
+
+		changeCount += 1;
+	}
+
+	if (sState.Topology != pipeline->Topology)
+	{
+		gDeviceContext->IASetPrimitiveTopology(pipeline->Topology);
+
+		sState.Topology = pipeline->Topology;
+
+		changeCount += 1;
+	}
+
+	sStatistics.StateChangeCount += changeCount;
+	sStatistics.SkippedStateChangeCount += 4 - changeCount;
+}
+VOID VaBindConstantBuffers(UINT32 Slot, UINT32 Count, ID3D11Buffer** Buffers)
+{
+	if (memcmp(sState.ConstantBuffers + Slot, Buffers, sizeof(ID3D11Buffer*) * Count) == 0)
+	{
+		sStatistics.SkippedStateChangeCount += 1;
+
+		return;
+	}
+
+	gDeviceContext->VSSetConstantBuffers(Slot, Count, Buffers);
+
+	memcpy(sState.ConstantBuffers + Slot, Buffers, sizeof(ID3D11Buffer*) * Count);
+
+	sStatistics.StateChangeCount += 1;
+}
+VOID VaBindVertexBuffers(UINT32 Count, ID3D11Buffer** Buffers, UINT32* Strides, UINT32* Offsets)
+{
+	if ((memcmp(sState.VertexBuffers, Buffers, sizeof(ID3D11Buffer*) * Count) == 0) && (memcmp(sState.Strides, Strides, sizeof(UINT32) * Count) == 0) && (memcmp(sState.Offsets, Offsets, sizeof(UINT32) * Count) == 0))
+	{
+		sStatistics.SkippedStateChangeCount += 1;
+
+		return;
+	}
+
+	gDeviceContext->IASetVertexBuffers(0, Count, Buffers, Strides, Offsets);
+
+	memcpy(sState.VertexBuffers, Buffers, sizeof(ID3D11Buffer*) * Count);
+	memcpy(sState.Strides, Strides, sizeof(UINT32) * Count);
+	memcpy(sState.Offsets, Offsets, sizeof(UINT32) * Count);
+
+	sStatistics.StateChangeCount += 1;
+}
+VOID VaBindIndexBuffer(ID3D11Buffer* Buffer, UINT32 Offset)
+{
+	if ((sState.IndexBuffer == Buffer) && (sState.IndexOffset == Offset))
+	{
+		sStatistics.SkippedStateChangeCount += 1;
+
+		return;
+	}
+
+	gDeviceContext->IASetIndexBuffer(Buffer, DXGI_FORMAT_R16_UINT, Offset);
+
+	sState.IndexBuffer = Buffer;
+	sState.IndexOffset = Offset;
+
+	sStatistics.StateChangeCount += 1;
+}
+
+VOID VaInvalidatePipelineState(VOID)
+{
+	// The game and ImGui bind their own state between our frames, so nothing carries over
+	memset(&sState, 0, sizeof(sState));
+
+	sState.Topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+	sStatistics.StateChangeCount = 0;
+	sStatistics.SkippedStateChangeCount = 0;
+}
+
+VOID VaGetPipelineCacheStatistics(PIPELINE_CACHE_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+
+	Statistics->ShaderCount = sVertexShaderCount + sPixelShaderCount;
+	Statistics->InputLayoutCount = sInputLayoutCount;
+}
+
+static SHADER_ENTRY* VaAcquireVertexShader(CHAR* Source, UINT32 Size)
+{
+	UINT64 hash = VaHashMemory(Source, Size);
+
+	for (UINT32 i = 0; i < sVertexShaderCount; i++)
+	{
+		if (sVertexShaders[i].Hash == hash)
+		{
+			return &sVertexShaders[i];
+		}
+	}
+
+	if (sVertexShaderCount == SHADER_COUNT)
+	{
+		return NULL;
+	}
+
+	SHADER_ENTRY* entry = &sVertexShaders[sVertexShaderCount];
+
+	HR_CHECK(D3DCompile(Source, Size, NULL, NULL, NULL, "VS", "vs_4_0", 0, 0, &entry->Blob, NULL));
+	HR_CHECK(gDevice->CreateVertexShader(entry->Blob->GetBufferPointer(), entry->Blob->GetBufferSize(), NULL, (ID3D11VertexShader**)&entry->Shader));
+
+	entry->Hash = hash;
+
+	sVertexShaderCount += 1;
+
+	return entry;
+}
+static SHADER_ENTRY* VaAcquirePixelShader(CHAR* Source, UINT32 Size)
+{
+	UINT64 hash = VaHashMemory(Source, Size);
+
+	for (UINT32 i = 0; i < sPixelShaderCount; i++)
+	{
+		if (sPixelShaders[i].Hash == hash)
+		{
+			return &sPixelShaders[i];
+		}
+	}
+
+	if (sPixelShaderCount == SHADER_COUNT)
+	{
+		return NULL;
+	}
+
+	SHADER_ENTRY* entry = &sPixelShaders[sPixelShaderCount];
+
+	HR_CHECK(D3DCompile(Source, Size, NULL, NULL, NULL, "PS", "ps_4_0", 0, 0, &entry->Blob, NULL));
+	HR_CHECK(gDevice->CreatePixelShader(entry->Blob->GetBufferPointer(), entry->Blob->GetBufferSize(), NULL, (ID3D11PixelShader**)&entry->Shader));
+
+	entry->Hash = hash;
+
+	sPixelShaderCount += 1;
+
+	return entry;
+}
+static ID3D11InputLayout* VaAcquireInputLayout(SHADER_ENTRY* VertexShader, D3D11_INPUT_ELEMENT_DESC* InputElements, UINT32 InputElementCount)
+{
+	// Layouts are validated against the vertex shader signature, so the shader is part of the key
+	UINT64 hash = VertexShader->Hash;
+
+	for (UINT32 i = 0; i < InputElementCount; i++)
+	{
+		D3D11_INPUT_ELEMENT_DESC element = InputElements[i];
+
+		UINT64 key[3] = { hash, VaHashMemory(element.SemanticName, strlen(element.SemanticName)), 0 };
+
+		element.SemanticName = NULL;
+
+		key[2] = VaHashMemory(&element, sizeof(D3D11_INPUT_ELEMENT_DESC));
+
+		hash = VaHashMemory(key, sizeof(key));
+	}
+
+	for (UINT32 i = 0; i < sInputLayoutCount; i++)
+	{
+		if (sInputLayouts[i].Hash == hash)
+		{
+			return sInputLayouts[i].InputLayout;
+		}
+	}
+
+	if (sInputLayoutCount == INPUT_LAYOUT_COUNT)
+	{
+		return NULL;
+	}
+
+	INPUT_LAYOUT_ENTRY* entry = &sInputLayouts[sInputLayoutCount];
+
+	HR_CHECK(gDevice->CreateInputLayout(InputElements, InputElementCount, VertexShader->Blob->GetBufferPointer(), VertexShader->Blob->GetBufferSize(), &entry->InputLayout));
+
+	entry->Hash = hash;
+
+	sInputLayoutCount += 1;
+
+	return entry->InputLayout;
+}
+
+static VOID VaReleaseShaders(SHADER_ENTRY* Shaders, UINT32 Count)
+{
+	for (UINT32 i = 0; i < Count; i++)
+	{
+		Shaders[i].Blob->Release();
+		Shaders[i].Shader->Release();
+	}
+
+	memset(Shaders, 0, sizeof(SHADER_ENTRY) * Count);
+}
\ No newline at end of file
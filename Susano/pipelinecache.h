@@ -0,0 +1,32 @@
+#pragma once
+
+#include <windows.h>
+
+#include <d3d11.h>
+
+#define INVALID_PIPELINE (-1)
+
+typedef INT32 PIPELINE;
+
+struct PIPELINE_CACHE_STATISTICS
+{
+	UINT32 ShaderCount;
+	UINT32 InputLayoutCount;
+	UINT32 PipelineCount;
+	UINT32 StateChangeCount;
+	UINT32 SkippedStateChangeCount;
+};
+
+VOID VaCreatePipelineCache(VOID);
+VOID VaDestroyPipelineCache(VOID);
+
+PIPELINE VaCreatePipeline(CHAR* VertexShaderSource, UINT32 VertexShaderSize, CHAR* PixelShaderSource, UINT32 PixelShaderSize, D3D11_INPUT_ELEMENT_DESC* InputElements, UINT32 InputElementCount, D3D11_PRIMITIVE_TOPOLOGY Topology);
+
+VOID VaBindPipeline(PIPELINE Pipeline);
+VOID VaBindConstantBuffers(UINT32 Slot, UINT32 Count, ID3D11Buffer** Buffers);
+VOID VaBindVertexBuffers(UINT32 Count, ID3D11Buffer** Buffers, UINT32* Strides, UINT32* Offsets);
+VOID VaBindIndexBuffer(ID3D11Buffer* Buffer, UINT32 Offset);
+
+VOID VaInvalidatePipelineState(VOID);
+
+VOID VaGetPipelineCacheStatistics(PIPELINE_CACHE_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "profiler.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define PROFILER_STACK_DEPTH (16)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// Sample is -1 once the frame ran out of samples, the zone time is still accounted for
+struct PROFILER_STACK_ENTRY
+{
+	PROFILER_ZONE Zone;
+	INT32 Sample;
+	UINT64 Start;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static LPCSTR sZoneNames[PROFILER_ZONE_COUNT] = { 0 };
+
+static UINT32 sZoneCount = 0;
+
+static PROFILER_FRAME sFrames[PROFILER_HISTORY_SIZE] = { 0 };
+
+static UINT32 sFrameIndex = 0;
+static UINT32 sFrameCount = 0;
+
+static UINT64 sFrameStart = 0;
+static BOOL sFrameOpen = FALSE;
+
+static PROFILER_STACK_ENTRY sStack[PROFILER_STACK_DEPTH] = { 0 };
+
+static UINT32 sDepth = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static INT32 VaCompareTimes(const VOID* Left, const VOID* Right);
+
+static VOID VaComputeStatistics(UINT64* Times, UINT32 Count, PROFILER_STATISTICS* Statistics);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateProfiler(VOID)
+{
+	memset(sZoneNames, 0, sizeof(sZoneNames));
+	memset(sFrames, 0, sizeof(sFrames));
+
+	sZoneCount = 0;
+	sFrameIndex = 0;
+	sFrameCount = 0;
+	sFrameOpen = FALSE;
+	sDepth = 0;
+}
+
+PROFILER_ZONE VaRegisterProfilerZone(LPCSTR Name)
+{
+	if (sZoneCount == PROFILER_ZONE_COUNT)
+	{
+		return INVALID_PROFILER_ZONE;
+	}
+
+	sZoneNames[sZoneCount] = Name;
+
+	return sZoneCount++;
+}
+LPCSTR VaGetProfilerZoneName(PROFILER_ZONE Zone)
+{
+	if ((Zone < 0) || ((UINT32)Zone >= sZoneCount))
+	{
+		return "";
+	}
+
+	return sZoneNames[Zone];
+}
+UINT32 VaGetProfilerZoneCount(VOID)
+{
+	return sZoneCount;
+}
+
+VOID VaBeginProfilerFrame(VOID)
+{
+	PROFILER_FRAME* frame = &sFrames[sFrameIndex];
+
+	frame->Duration = 0;
+	frame->SampleCount = 0;
+	frame->ZoneMask = 0;
+
+	memset(frame->ZoneTimes, 0, sizeof(frame->ZoneTimes));
+
+	sDepth = 0;
+	sFrameOpen = TRUE;
+
+	sFrameStart = VaQueryProfilerTime();
+}
+VOID VaEndProfilerFrame(VOID)
+{
+	if (!sFrameOpen)
+	{
+		return;
+	}
+
+	sFrames[sFrameIndex].Duration = VaQueryProfilerTime() - sFrameStart;
+
+	sFrameIndex = (sFrameIndex + 1) % PROFILER_HISTORY_SIZE;
+
+	if (sFrameCount < PROFILER_HISTORY_SIZE)
+	{
+		sFrameCount += 1;
+	}
+
+	sFrameOpen = FALSE;
+}
+
+VOID VaBeginProfilerZone(PROFILER_ZONE Zone)
+{
+	// Zones outside of a frame or nested too deep are ignored, their end is ignored the same way
+	if (!sFrameOpen || (sDepth >= PROFILER_STACK_DEPTH) || (Zone < 0) || ((UINT32)Zone >= sZoneCount))
+	{
+		if (sDepth < PROFILER_STACK_DEPTH)
+		{
+			sStack[sDepth].Zone = INVALID_PROFILER_ZONE;
+		}
+
+		sDepth += 1;
+
+		return;
+	}
+
+	PROFILER_FRAME* frame = &sFrames[sFrameIndex];
+	PROFILER_STACK_ENTRY* entry = &sStack[sDepth];
+
+	entry->Zone = Zone;
+	entry->Sample = -1;
+	entry->Start = VaQueryProfilerTime() - sFrameStart;
+
+	if (frame->SampleCount < PROFILER_SAMPLE_COUNT)
+	{
+		PROFILER_SAMPLE* sample = &frame->Samples[frame->SampleCount];
+
+		sample->Zone = Zone;
+		sample->Depth = sDepth;
+		sample->Start = entry->Start;
+		sample->End = entry->Start;
+
+		entry->Sample = frame->SampleCount;
+
+		frame->SampleCount += 1;
+	}
+
+	sDepth += 1;
+}
+VOID VaEndProfilerZone(VOID)
+{
+	if (sDepth == 0)
+	{
+		return;
+	}
+
+	sDepth -= 1;
+
+	if (!sFrameOpen || (sDepth >= PROFILER_STACK_DEPTH) || (sStack[sDepth].Zone < 0))
+	{
+		return;
+	}
+
+	PROFILER_FRAME* frame = &sFrames[sFrameIndex];
+	PROFILER_STACK_ENTRY* entry = &sStack[sDepth];
+
+	UINT64 end = VaQueryProfilerTime() - sFrameStart;
+
+	if (entry->Sample >= 0)
+	{
+		frame->Samples[entry->Sample].End = end;
+	}
+
+	frame->ZoneTimes[entry->Zone] += end - entry->Start;
+	frame->ZoneMask |= 1u << entry->Zone;
+}
+
+UINT64 VaQueryProfilerTime(VOID)
+{
+	// Steady clock maps onto the performance counter on windows and onto the monotonic clock elsewhere
+	return (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const PROFILER_FRAME* VaGetProfilerFrame(UINT32 Age)
+{
+	if (Age >= sFrameCount)
+	{
+		return NULL;
+	}
+
+	return &sFrames[(sFrameIndex + PROFILER_HISTORY_SIZE - 1 - Age) % PROFILER_HISTORY_SIZE];
+}
+
+VOID VaGetProfilerFrameStatistics(PROFILER_STATISTICS* Statistics)
+{
+	UINT64 times[PROFILER_HISTORY_SIZE];
+
+	for (UINT32 i = 0; i < sFrameCount; i++)
+	{
+		times[i] = VaGetProfilerFrame(i)->Duration;
+	}
+
+	VaComputeStatistics(times, sFrameCount, Statistics);
+}
+VOID VaGetProfilerZoneStatistics(PROFILER_ZONE Zone, PROFILER_STATISTICS* Statistics)
+{
+	UINT64 times[PROFILER_HISTORY_SIZE];
+	UINT32 count = 0;
+
+	if ((Zone >= 0) && ((UINT32)Zone < sZoneCount))
+	{
+		for (UINT32 i = 0; i < sFrameCount; i++)
+		{
+			const PROFILER_FRAME* frame = VaGetProfilerFrame(i);
+
+			if (frame->ZoneMask & (1u << Zone))
+			{
+				times[count] = frame->ZoneTimes[Zone];
+
+				count += 1;
+			}
+		}
+	}
+
+	VaComputeStatistics(times, count, Statistics);
+}
+
+static INT32 VaCompareTimes(const VOID* Left, const VOID* Right)
+{
+	UINT64 left = *(const UINT64*)Left;
+	UINT64 right = *(const UINT64*)Right;
+
+	return (left > right) - (left < right);
+}
+
+static VOID VaComputeStatistics(UINT64* Times, UINT32 Count, PROFILER_STATISTICS* Statistics)
+{
+	memset(Statistics, 0, sizeof(PROFILER_STATISTICS));
+
+	if (Count == 0)
+	{
+		return;
+	}
+
+	qsort(Times, Count, sizeof(UINT64), VaCompareTimes);
+
+	UINT64 sum = 0;
+
+	for (UINT32 i = 0; i < Count; i++)
+	{
+		sum += Times[i];
+	}
+
+	// Nearest rank, the smallest time at or above which 1% of the frames lie
+	UINT32 rank = ((Count * 99) + 99) / 100;
+
+	Statistics->FrameCount = Count;
+	Statistics->Minimum = Times[0];
+	Statistics->Mean = sum / Count;
+	Statistics->P99 = Times[rank - 1];
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <windows.h>
+
+#include "trace.h"
+
+#define INVALID_PROFILER_ZONE (-1)
+
+#define PROFILER_ZONE_COUNT (32)
+#define PROFILER_SAMPLE_COUNT (64)
+#define PROFILER_HISTORY_SIZE (256)
+
+#define PROFILER_CONCAT_INNER(A, B) A##B
+#define PROFILER_CONCAT(A, B) PROFILER_CONCAT_INNER(A, B)
+
+#define PROFILE_SCOPE(ZONE) PROFILER_SCOPE PROFILER_CONCAT(profilerScope, __LINE__)(ZONE)
+
+typedef INT32 PROFILER_ZONE;
+
+// Times are nanoseconds relative to the start of the frame
+struct PROFILER_SAMPLE
+{
+	PROFILER_ZONE Zone;
+	UINT32 Depth;
+	UINT64 Start;
+	UINT64 End;
+};
+
+struct PROFILER_FRAME
+{
+	UINT64 Duration;
+	UINT32 SampleCount;
+	UINT32 ZoneMask;
+	UINT64 ZoneTimes[PROFILER_ZONE_COUNT];
+	PROFILER_SAMPLE Samples[PROFILER_SAMPLE_COUNT];
+};
+
+// Computed over every frame in the history the zone was entered in
+struct PROFILER_STATISTICS
+{
+	UINT32 FrameCount;
+	UINT64 Minimum;
+	UINT64 Mean;
+	UINT64 P99;
+};
+
+VOID VaCreateProfiler(VOID);
+
+PROFILER_ZONE VaRegisterProfilerZone(LPCSTR Name);
+LPCSTR VaGetProfilerZoneName(PROFILER_ZONE Zone);
+UINT32 VaGetProfilerZoneCount(VOID);
+
+VOID VaBeginProfilerFrame(VOID);
+VOID VaEndProfilerFrame(VOID);
+
+VOID VaBeginProfilerZone(PROFILER_ZONE Zone);
+VOID VaEndProfilerZone(VOID);
+
+UINT64 VaQueryProfilerTime(VOID);
+
+const PROFILER_FRAME* VaGetProfilerFrame(UINT32 Age);
+
+VOID VaGetProfilerFrameStatistics(PROFILER_STATISTICS* Statistics);
+VOID VaGetProfilerZoneStatistics(PROFILER_ZONE Zone, PROFILER_STATISTICS* Statistics);
+
+// Armed captures get every profiler zone as a trace event as well, disarmed they cost a single load
+struct PROFILER_SCOPE
+{
+	TRACE_SCOPE Trace;
+
+	PROFILER_SCOPE(PROFILER_ZONE Zone) { VaBeginProfilerZone(Zone); if (SUSANO_TRACE && gTraceArmed) Trace.Begin(VaGetProfilerZoneName(Zone)); }
+	~PROFILER_SCOPE() { VaEndProfilerZone(); }
+};
\ No newline at end of file
@@ -0,0 +1,306 @@
+#include <string.h>
+
+#include "safememory.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define SAFE_MEMORY_REGION_COUNT (64)
+
+#define SAFE_MEMORY_READABLE (PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)
+#define SAFE_MEMORY_WRITABLE (PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+struct SAFE_MEMORY_REGION
+{
+	UINT64 Base;
+	UINT64 End;
+	BOOL Writable;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static SRWLOCK sLock = SRWLOCK_INIT;
+
+// Committed ranges VirtualQuery already vouched for, a full table replaces its entries round robin
+static SAFE_MEMORY_REGION sRegions[SAFE_MEMORY_REGION_COUNT] = { 0 };
+static UINT32 sRegionCount = 0;
+static UINT32 sNextRegion = 0;
+
+// Bumped whenever a region is dropped, it retires every thread's last region at once
+static volatile LONG sEpoch = 1;
+
+// Most reads land in the same region as the previous one of their thread, that case needs neither the lock nor the table
+static thread_local SAFE_MEMORY_REGION tRegion = { 0 };
+static thread_local LONG tRegionEpoch = 0;
+
+static volatile LONG64 sHitCount = 0;
+static volatile LONG64 sMissCount = 0;
+static volatile LONG64 sQueryCount = 0;
+static volatile LONG64 sRejectCount = 0;
+static volatile LONG64 sFaultCount = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static BOOL VaIsRegionCached(UINT64 Address, UINT64 Size, BOOL Write);
+static BOOL VaValidateRegions(UINT64 Address, UINT64 Size, BOOL Write);
+
+static VOID VaInsertRegion(UINT64 Base, UINT64 End, BOOL Writable);
+static VOID VaRemoveRegion(UINT64 Address);
+
+static BOOL VaGuardedCopy(VOID* Destination, const VOID* Source, UINT64 Size);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateSafeMemory(VOID)
+{
+	VaInvalidateSafeMemory();
+}
+VOID VaDestroySafeMemory(VOID)
+{
+	VaInvalidateSafeMemory();
+}
+
+BOOL VaSafeRead(UINT64 Address, VOID* Buffer, UINT64 Size)
+{
+	if (!Address || ((Address + Size) < Address))
+	{
+		InterlockedIncrement64(&sRejectCount);
+
+		return FALSE;
+	}
+
+	if (!VaIsRegionCached(Address, Size, FALSE) && !VaValidateRegions(Address, Size, FALSE))
+	{
+		InterlockedIncrement64(&sRejectCount);
+
+		return FALSE;
+	}
+
+	// A cached region can still be freed behind our back, the fault drops it so the next access asks again
+	if (!VaGuardedCopy(Buffer, (const VOID*)Address, Size))
+	{
+		VaRemoveRegion(Address);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+BOOL VaSafeWrite(UINT64 Address, const VOID* Buffer, UINT64 Size)
+{
+	if (!Address || ((Address + Size) < Address))
+	{
+		InterlockedIncrement64(&sRejectCount);
+
+		return FALSE;
+	}
+
+	if (!VaIsRegionCached(Address, Size, TRUE) && !VaValidateRegions(Address, Size, TRUE))
+	{
+		InterlockedIncrement64(&sRejectCount);
+
+		return FALSE;
+	}
+
+	if (!VaGuardedCopy((VOID*)Address, Buffer, Size))
+	{
+		VaRemoveRegion(Address);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+VOID VaInvalidateSafeMemory(VOID)
+{
+	AcquireSRWLockExclusive(&sLock);
+
+	sRegionCount = 0;
+	sNextRegion = 0;
+
+	InterlockedIncrement(&sEpoch);
+
+	ReleaseSRWLockExclusive(&sLock);
+}
+
+VOID VaGetSafeMemoryStatistics(SAFE_MEMORY_STATISTICS* Statistics)
+{
+	AcquireSRWLockShared(&sLock);
+
+	Statistics->RegionCount = sRegionCount;
+
+	ReleaseSRWLockShared(&sLock);
+
+	Statistics->HitCount = (UINT64)sHitCount;
+	Statistics->MissCount = (UINT64)sMissCount;
+	Statistics->QueryCount = (UINT64)sQueryCount;
+	Statistics->RejectCount = (UINT64)sRejectCount;
+	Statistics->FaultCount = (UINT64)sFaultCount;
+}
+
+static BOOL VaIsRegionCached(UINT64 Address, UINT64 Size, BOOL Write)
+{
+	LONG epoch = sEpoch;
+
+	if ((tRegionEpoch == epoch) && (Address >= tRegion.Base) && ((Address + Size) <= tRegion.End) && (!Write || tRegion.Writable))
+	{
+		// Not interlocked on purpose, the hot path stays free of shared writes and the count only feeds the debug window
+		sHitCount += 1;
+
+		return TRUE;
+	}
+
+	BOOL cached = FALSE;
+
+	AcquireSRWLockShared(&sLock);
+
+	for (UINT32 i = 0; i < sRegionCount; i++)
+	{
+		const SAFE_MEMORY_REGION* region = &sRegions[i];
+
+		if ((Address >= region->Base) && ((Address + Size) <= region->End) && (!Write || region->Writable))
+		{
+			tRegion = *region;
+			tRegionEpoch = epoch;
+
+			cached = TRUE;
+
+			break;
+		}
+	}
+
+	ReleaseSRWLockShared(&sLock);
+
+	InterlockedIncrement64(cached ? &sHitCount : &sMissCount);
+
+	return cached;
+}
+static BOOL VaValidateRegions(UINT64 Address, UINT64 Size, BOOL Write)
+{
+	UINT64 end = Address + Size;
+
+	// An access may straddle regions with different attributes, every one of them has to allow it
+	while (Address < end)
+	{
+		MEMORY_BASIC_INFORMATION info = { 0 };
+
+		InterlockedIncrement64(&sQueryCount);
+
+		if (VirtualQuery((PVOID)Address, &info, sizeof(info)) != sizeof(info))
+		{
+			return FALSE;
+		}
+
+		DWORD protect = info.Protect & 0xFF;
+
+		if ((info.State != MEM_COMMIT) || (info.Protect & (PAGE_GUARD | PAGE_NOACCESS)) || !(protect & SAFE_MEMORY_READABLE))
+		{
+			return FALSE;
+		}
+
+		BOOL writable = (protect & SAFE_MEMORY_WRITABLE) ? TRUE : FALSE;
+
+		if (Write && !writable)
+		{
+			return FALSE;
+		}
+
+		UINT64 regionBase = (UINT64)info.BaseAddress;
+		UINT64 regionEnd = regionBase + info.RegionSize;
+
+		VaInsertRegion(regionBase, regionEnd, writable);
+
+		Address = regionEnd;
+	}
+
+	return TRUE;
+}
+
+static VOID VaInsertRegion(UINT64 Base, UINT64 End, BOOL Writable)
+{
+	AcquireSRWLockExclusive(&sLock);
+
+	SAFE_MEMORY_REGION* region = NULL;
+
+	// Two threads missing on the same region both end up here, the second one only refreshes the entry
+	for (UINT32 i = 0; i < sRegionCount; i++)
+	{
+		if (sRegions[i].Base == Base)
+		{
+			region = &sRegions[i];
+
+			break;
+		}
+	}
+
+	if (!region)
+	{
+		if (sRegionCount < SAFE_MEMORY_REGION_COUNT)
+		{
+			region = &sRegions[sRegionCount];
+
+			sRegionCount += 1;
+		}
+		else
+		{
+			region = &sRegions[sNextRegion];
+
+			sNextRegion = (sNextRegion + 1) % SAFE_MEMORY_REGION_COUNT;
+		}
+	}
+
+	region->Base = Base;
+	region->End = End;
+	region->Writable = Writable;
+
+	ReleaseSRWLockExclusive(&sLock);
+}
+static VOID VaRemoveRegion(UINT64 Address)
+{
+	AcquireSRWLockExclusive(&sLock);
+
+	for (UINT32 i = 0; i < sRegionCount; i++)
+	{
+		if ((Address >= sRegions[i].Base) && (Address < sRegions[i].End))
+		{
+			sRegionCount -= 1;
+
+			sRegions[i] = sRegions[sRegionCount];
+
+			break;
+		}
+	}
+
+	InterlockedIncrement(&sEpoch);
+
+	ReleaseSRWLockExclusive(&sLock);
+}
+
+static BOOL VaGuardedCopy(VOID* Destination, const VOID* Source, UINT64 Size)
+{
+	// Structured exception handling is table based on x64, the guard costs nothing until something faults
+	__try
+	{
+		memcpy(Destination, Source, Size);
+	}
+	__except ((GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION) || (GetExceptionCode() == EXCEPTION_GUARD_PAGE) ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		InterlockedIncrement64(&sFaultCount);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <windows.h>
+
+struct SAFE_MEMORY_STATISTICS
+{
+	UINT32 RegionCount;
+	UINT64 HitCount;
+	UINT64 MissCount;
+	UINT64 QueryCount;
+	UINT64 RejectCount;
+	UINT64 FaultCount;
+};
+
+VOID VaCreateSafeMemory(VOID);
+VOID VaDestroySafeMemory(VOID);
+
+// Copies only out of committed pages with a matching protection, an access that faults anyway fails instead of crashing the game
+BOOL VaSafeRead(UINT64 Address, VOID* Buffer, UINT64 Size);
+BOOL VaSafeWrite(UINT64 Address, const VOID* Buffer, UINT64 Size);
+
+// Forgets every validated region, they are queried again on their next access
+VOID VaInvalidateSafeMemory(VOID);
+
+VOID VaGetSafeMemoryStatistics(SAFE_MEMORY_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,476 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "hash.h"
+#include "profiler.h"
+#include "scancache.h"
+#include "logger.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define SCAN_CACHE_MAGIC (0x43435353)
+#define SCAN_CACHE_VERSION (1)
+
+#define SCAN_CACHE_PATH_LENGTH (260)
+#define SCAN_CACHE_NAME_LENGTH (64)
+
+#define SCAN_CACHE_PENDING_CAPACITY (64)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// The file is the header followed by entries sorted by module and signature hash, both fixed size and little endian
+struct SCAN_CACHE_HEADER
+{
+	UINT32 Magic;
+	UINT32 Version;
+	UINT32 EntrySize;
+	UINT32 EntryCount;
+};
+
+struct SCAN_CACHE_ENTRY
+{
+	UINT64 ModuleHash;
+	UINT64 SignatureHash;
+	UINT64 CodeHash;
+	UINT32 TimeDateStamp;
+	UINT32 SizeOfImage;
+	UINT64 Rva;
+	UINT32 MatchCount;
+	UINT32 Reserved;
+};
+
+static_assert(sizeof(SCAN_CACHE_ENTRY) == 48, "Scan cache entries are part of the file format");
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static CHAR sFilePath[SCAN_CACHE_PATH_LENGTH] = { 0 };
+
+static HANDLE sFile = INVALID_HANDLE_VALUE;
+static HANDLE sMapping = NULL;
+
+static PVOID sView = NULL;
+
+static const SCAN_CACHE_ENTRY* sMappedEntries = NULL;
+static UINT32 sMappedCount = 0;
+
+// Stores since the file was mapped, they shadow mapped entries until the next flush merges both
+static SCAN_CACHE_ENTRY* sPendingEntries = NULL;
+static UINT32 sPendingCount = 0;
+static UINT32 sPendingCapacity = 0;
+
+static SCAN_CACHE_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaMapScanCache(VOID);
+static VOID VaUnmapScanCache(VOID);
+
+static VOID VaFillScanCacheEntry(SCAN_CACHE_ENTRY* Entry, LPCSTR ModuleName, const SCAN_MODULE_KEY* Key, const SIGNATURE* Signature);
+
+static const SCAN_CACHE_ENTRY* VaFindScanCacheEntry(UINT64 ModuleHash, UINT64 SignatureHash);
+
+static BOOL VaIsSameModuleBuild(const SCAN_CACHE_ENTRY* Left, const SCAN_CACHE_ENTRY* Right);
+
+static int VaCompareScanCacheEntries(const VOID* Left, const VOID* Right);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaOpenScanCache(LPCSTR FilePath)
+{
+	strcpy_s(sFilePath, sizeof(sFilePath), FilePath);
+
+	VaMapScanCache();
+}
+VOID VaCloseScanCache(VOID)
+{
+	VaFlushScanCache();
+
+	VaUnmapScanCache();
+
+	free(sPendingEntries);
+
+	sPendingEntries = NULL;
+	sPendingCount = 0;
+	sPendingCapacity = 0;
+}
+
+VOID VaGetScanModuleKey(UINT64 ModuleBase, SCAN_MODULE_KEY* Key)
+{
+	UINT64 startTime = VaQueryProfilerTime();
+
+	PIMAGE_DOS_HEADER dosHeader = (PIMAGE_DOS_HEADER)ModuleBase;
+	PIMAGE_NT_HEADERS64 ntHeaders = (PIMAGE_NT_HEADERS64)(ModuleBase + dosHeader->e_lfanew);
+	PIMAGE_SECTION_HEADER sections = IMAGE_FIRST_SECTION(ntHeaders);
+
+	Key->TimeDateStamp = ntHeaders->FileHeader.TimeDateStamp;
+	Key->SizeOfImage = ntHeaders->OptionalHeader.SizeOfImage;
+
+	// Executable sections are copied back to back so the relocated slots can be cleared before hashing
+	UINT64 codeSize = 0;
+
+	for (UINT32 i = 0; i < ntHeaders->FileHeader.NumberOfSections; i++)
+	{
+		if (sections[i].Characteristics & IMAGE_SCN_MEM_EXECUTE)
+		{
+			codeSize += sections[i].Misc.VirtualSize;
+		}
+	}
+
+	PBYTE code = (PBYTE)malloc(codeSize + 1);
+
+	UINT64 codeOffset = 0;
+
+	for (UINT32 i = 0; i < ntHeaders->FileHeader.NumberOfSections; i++)
+	{
+		if (sections[i].Characteristics & IMAGE_SCN_MEM_EXECUTE)
+		{
+			memcpy(code + codeOffset, (const VOID*)(ModuleBase + sections[i].VirtualAddress), sections[i].Misc.VirtualSize);
+
+			codeOffset += sections[i].Misc.VirtualSize;
+		}
+	}
+
+	PIMAGE_DATA_DIRECTORY relocationDirectory = &ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+
+	UINT64 relocation = ModuleBase + relocationDirectory->VirtualAddress;
+	UINT64 relocationEnd = relocation + relocationDirectory->Size;
+
+	while (relocationDirectory->VirtualAddress && ((relocation + sizeof(IMAGE_BASE_RELOCATION)) <= relocationEnd))
+	{
+		PIMAGE_BASE_RELOCATION block = (PIMAGE_BASE_RELOCATION)relocation;
+
+		if (block->SizeOfBlock < sizeof(IMAGE_BASE_RELOCATION))
+		{
+			break;
+		}
+
+		const WORD* blockEntries = (const WORD*)(block + 1);
+
+		UINT32 blockEntryCount = (block->SizeOfBlock - sizeof(IMAGE_BASE_RELOCATION)) / sizeof(WORD);
+
+		for (UINT32 i = 0; i < blockEntryCount; i++)
+		{
+			UINT32 type = blockEntries[i] >> 12;
+			UINT32 slotSize = (type == IMAGE_REL_BASED_DIR64) ? 8 : ((type == IMAGE_REL_BASED_HIGHLOW) ? 4 : 0);
+
+			UINT32 rva = block->VirtualAddress + (blockEntries[i] & 0xFFF);
+
+			codeOffset = 0;
+
+			for (UINT32 j = 0; (j < ntHeaders->FileHeader.NumberOfSections) && slotSize; j++)
+			{
+				if ((sections[j].Characteristics & IMAGE_SCN_MEM_EXECUTE) == 0)
+				{
+					continue;
+				}
+
+				if ((rva >= sections[j].VirtualAddress) && (rva < (sections[j].VirtualAddress + sections[j].Misc.VirtualSize)))
+				{
+					UINT32 offset = rva - sections[j].VirtualAddress;
+
+					memset(code + codeOffset + offset, 0, min(slotSize, sections[j].Misc.VirtualSize - offset));
+
+					break;
+				}
+
+				codeOffset += sections[j].Misc.VirtualSize;
+			}
+		}
+
+		relocation += block->SizeOfBlock;
+	}
+
+	Key->CodeHash = VaHashMemory(code, codeSize);
+
+	free(code);
+
+	sStatistics.HashTime += VaQueryProfilerTime() - startTime;
+}
+
+BOOL VaLookupScanCache(LPCSTR ModuleName, const SCAN_MODULE_KEY* Key, const SIGNATURE* Signature, UINT64* Rva, UINT32* MatchCount)
+{
+	SCAN_CACHE_ENTRY search = { 0 };
+
+	VaFillScanCacheEntry(&search, ModuleName, Key, Signature);
+
+	const SCAN_CACHE_ENTRY* entry = VaFindScanCacheEntry(search.ModuleHash, search.SignatureHash);
+
+	if (!entry || !VaIsSameModuleBuild(entry, &search))
+	{
+		sStatistics.MissCount += 1;
+
+		return FALSE;
+	}
+
+	*Rva = entry->Rva;
+	*MatchCount = entry->MatchCount;
+
+	sStatistics.HitCount += 1;
+
+	return TRUE;
+}
+VOID VaStoreScanCache(LPCSTR ModuleName, const SCAN_MODULE_KEY* Key, const SIGNATURE* Signature, UINT64 Rva, UINT32 MatchCount)
+{
+	if (sPendingCount == sPendingCapacity)
+	{
+		sPendingCapacity = max(sPendingCapacity * 2, SCAN_CACHE_PENDING_CAPACITY);
+		sPendingEntries = (SCAN_CACHE_ENTRY*)realloc(sPendingEntries, sizeof(SCAN_CACHE_ENTRY) * sPendingCapacity);
+	}
+
+	SCAN_CACHE_ENTRY* entry = &sPendingEntries[sPendingCount];
+
+	VaFillScanCacheEntry(entry, ModuleName, Key, Signature);
+
+	entry->Rva = Rva;
+	entry->MatchCount = MatchCount;
+
+	// A newer store for the same signature replaces the older one instead of piling up
+	for (UINT32 i = 0; i < sPendingCount; i++)
+	{
+		if ((sPendingEntries[i].ModuleHash == entry->ModuleHash) && (sPendingEntries[i].SignatureHash == entry->SignatureHash))
+		{
+			sPendingEntries[i] = *entry;
+
+			return;
+		}
+	}
+
+	sPendingCount += 1;
+}
+
+BOOL VaFlushScanCache(VOID)
+{
+	if (!sPendingCount || !sFilePath[0])
+	{
+		return TRUE;
+	}
+
+	SCAN_CACHE_ENTRY* entries = (SCAN_CACHE_ENTRY*)malloc(sizeof(SCAN_CACHE_ENTRY) * (sMappedCount + sPendingCount));
+
+	UINT32 entryCount = 0;
+
+	for (UINT32 i = 0; i < sMappedCount; i++)
+	{
+		const SCAN_CACHE_ENTRY* mapped = &sMappedEntries[i];
+
+		BOOL keep = TRUE;
+
+		// Once a module was stored with a new build every entry of the old build is stale
+		for (UINT32 j = 0; (j < sPendingCount) && keep; j++)
+		{
+			const SCAN_CACHE_ENTRY* pending = &sPendingEntries[j];
+
+			if (pending->ModuleHash != mapped->ModuleHash)
+			{
+				continue;
+			}
+
+			if (!VaIsSameModuleBuild(pending, mapped))
+			{
+				sStatistics.InvalidatedCount += 1;
+
+				keep = FALSE;
+			}
+			else if (pending->SignatureHash == mapped->SignatureHash)
+			{
+				keep = FALSE;
+			}
+		}
+
+		if (keep)
+		{
+			entries[entryCount++] = *mapped;
+		}
+	}
+
+	memcpy(entries + entryCount, sPendingEntries, sizeof(SCAN_CACHE_ENTRY) * sPendingCount);
+
+	entryCount += sPendingCount;
+
+	qsort(entries, entryCount, sizeof(SCAN_CACHE_ENTRY), VaCompareScanCacheEntries);
+
+	SCAN_CACHE_HEADER header = { 0 };
+	header.Magic = SCAN_CACHE_MAGIC;
+	header.Version = SCAN_CACHE_VERSION;
+	header.EntrySize = sizeof(SCAN_CACHE_ENTRY);
+	header.EntryCount = entryCount;
+
+	// Written beside the real file and moved over it, a crash never leaves a half written cache behind
+	CHAR temporaryPath[SCAN_CACHE_PATH_LENGTH + 4] = { 0 };
+
+	sprintf_s(temporaryPath, sizeof(temporaryPath), "%s.tmp", sFilePath);
+
+	FILE* file = NULL;
+
+	BOOL written = FALSE;
+
+	if (fopen_s(&file, temporaryPath, "wb") == 0)
+	{
+		written = (fwrite(&header, sizeof(header), 1, file) == 1) && (fwrite(entries, sizeof(SCAN_CACHE_ENTRY), entryCount, file) == entryCount);
+
+		written = (fclose(file) == 0) && written;
+	}
+
+	free(entries);
+
+	if (!written)
+	{
+		VA_LOG("Scan cache could not be written");
+
+		return FALSE;
+	}
+
+	VaUnmapScanCache();
+
+	if (!MoveFileExA(temporaryPath, sFilePath, MOVEFILE_REPLACE_EXISTING))
+	{
+		VA_LOG("Scan cache could not be replaced 0x%08X", GetLastError());
+	}
+
+	sPendingCount = 0;
+
+	VaMapScanCache();
+
+	return TRUE;
+}
+
+VOID VaGetScanCacheStatistics(SCAN_CACHE_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+
+	Statistics->EntryCount = sMappedCount + sPendingCount;
+}
+
+static VOID VaMapScanCache(VOID)
+{
+	sFile = CreateFileA(sFilePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (sFile == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	LARGE_INTEGER fileSize = { 0 };
+
+	GetFileSizeEx(sFile, &fileSize);
+
+	if (fileSize.QuadPart >= (LONGLONG)sizeof(SCAN_CACHE_HEADER))
+	{
+		sMapping = CreateFileMappingA(sFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+		sView = sMapping ? MapViewOfFile(sMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	}
+
+	if (!sView)
+	{
+		VaUnmapScanCache();
+
+		return;
+	}
+
+	const SCAN_CACHE_HEADER* header = (const SCAN_CACHE_HEADER*)sView;
+
+	// Anything that does not describe exactly the bytes on disk is treated like no cache at all
+	if ((header->Magic != SCAN_CACHE_MAGIC) || (header->Version != SCAN_CACHE_VERSION) || (header->EntrySize != sizeof(SCAN_CACHE_ENTRY)) || ((UINT64)fileSize.QuadPart != (sizeof(SCAN_CACHE_HEADER) + (UINT64)header->EntryCount * sizeof(SCAN_CACHE_ENTRY))))
+	{
+		VA_LOG("Scan cache is malformed and will be rebuilt");
+
+		VaUnmapScanCache();
+
+		return;
+	}
+
+	sMappedEntries = (const SCAN_CACHE_ENTRY*)(header + 1);
+	sMappedCount = header->EntryCount;
+}
+static VOID VaUnmapScanCache(VOID)
+{
+	if (sView)
+	{
+		UnmapViewOfFile(sView);
+	}
+
+	if (sMapping)
+	{
+		CloseHandle(sMapping);
+	}
+
+	if (sFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(sFile);
+	}
+
+	sFile = INVALID_HANDLE_VALUE;
+	sMapping = NULL;
+	sView = NULL;
+
+	sMappedEntries = NULL;
+	sMappedCount = 0;
+}
+
+static VOID VaFillScanCacheEntry(SCAN_CACHE_ENTRY* Entry, LPCSTR ModuleName, const SCAN_MODULE_KEY* Key, const SIGNATURE* Signature)
+{
+	// Module names are matched the way the loader matches them, without regard to case
+	CHAR moduleName[SCAN_CACHE_NAME_LENGTH] = { 0 };
+
+	for (UINT32 i = 0; ModuleName[i] && (i < (SCAN_CACHE_NAME_LENGTH - 1)); i++)
+	{
+		moduleName[i] = (CHAR)tolower((UCHAR)ModuleName[i]);
+	}
+
+	memset(Entry, 0, sizeof(SCAN_CACHE_ENTRY));
+
+	Entry->ModuleHash = VaHashMemory(moduleName, strlen(moduleName));
+	Entry->SignatureHash = VaHashMemory(Signature, sizeof(SIGNATURE));
+	Entry->CodeHash = Key->CodeHash;
+	Entry->TimeDateStamp = Key->TimeDateStamp;
+	Entry->SizeOfImage = Key->SizeOfImage;
+}
+
+static const SCAN_CACHE_ENTRY* VaFindScanCacheEntry(UINT64 ModuleHash, UINT64 SignatureHash)
+{
+	for (UINT32 i = 0; i < sPendingCount; i++)
+	{
+		if ((sPendingEntries[i].ModuleHash == ModuleHash) && (sPendingEntries[i].SignatureHash == SignatureHash))
+		{
+			return &sPendingEntries[i];
+		}
+	}
+
+	SCAN_CACHE_ENTRY search = { 0 };
+
+	search.ModuleHash = ModuleHash;
+	search.SignatureHash = SignatureHash;
+
+	return (const SCAN_CACHE_ENTRY*)bsearch(&search, sMappedEntries, sMappedCount, sizeof(SCAN_CACHE_ENTRY), VaCompareScanCacheEntries);
+}
+
+static BOOL VaIsSameModuleBuild(const SCAN_CACHE_ENTRY* Left, const SCAN_CACHE_ENTRY* Right)
+{
+	return (Left->TimeDateStamp == Right->TimeDateStamp) && (Left->SizeOfImage == Right->SizeOfImage) && (Left->CodeHash == Right->CodeHash);
+}
+
+static int VaCompareScanCacheEntries(const VOID* Left, const VOID* Right)
+{
+	const SCAN_CACHE_ENTRY* left = (const SCAN_CACHE_ENTRY*)Left;
+	const SCAN_CACHE_ENTRY* right = (const SCAN_CACHE_ENTRY*)Right;
+
+	if (left->ModuleHash != right->ModuleHash)
+	{
+		return (left->ModuleHash < right->ModuleHash) ? -1 : 1;
+	}
+
+	return (left->SignatureHash < right->SignatureHash) ? -1 : (left->SignatureHash > right->SignatureHash);
+}
\ No newline at end of file
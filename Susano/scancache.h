@@ -0,0 +1,37 @@
+#pragma once
+
+#include <windows.h>
+
+#include "scanner.h"
+
+// Identifies one exact build of a module, relocated slots are left out of the code hash so a rebased image keeps its key
+struct SCAN_MODULE_KEY
+{
+	UINT32 TimeDateStamp;
+	UINT32 SizeOfImage;
+	UINT64 CodeHash;
+};
+
+struct SCAN_CACHE_STATISTICS
+{
+	UINT32 EntryCount;
+	UINT64 HitCount;
+	UINT64 MissCount;
+	UINT64 InvalidatedCount;
+	UINT64 HashTime;
+};
+
+// Maps an existing cache file read only, a missing or malformed one simply starts out empty
+VOID VaOpenScanCache(LPCSTR FilePath);
+VOID VaCloseScanCache(VOID);
+
+VOID VaGetScanModuleKey(UINT64 ModuleBase, SCAN_MODULE_KEY* Key);
+
+// Results are kept relative to the module base, so they stay valid when the module is loaded somewhere else
+BOOL VaLookupScanCache(LPCSTR ModuleName, const SCAN_MODULE_KEY* Key, const SIGNATURE* Signature, UINT64* Rva, UINT32* MatchCount);
+VOID VaStoreScanCache(LPCSTR ModuleName, const SCAN_MODULE_KEY* Key, const SIGNATURE* Signature, UINT64 Rva, UINT32 MatchCount);
+
+// Rewrites the file when anything was stored, entries of an older build of a stored module are dropped
+BOOL VaFlushScanCache(VOID);
+
+VOID VaGetScanCacheStatistics(SCAN_CACHE_STATISTICS* Statistics);
\ No newline at end of file
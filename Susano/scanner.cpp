@@ -0,0 +1,488 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <intrin.h>
+#include <immintrin.h>
+
+#include "profiler.h"
+#include "scanner.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define SCAN_ANCHOR_LENGTH (3)
+#define SCAN_BUCKET_COUNT (8)
+#define SCAN_BUCKET_SIZE (4)
+#define SCAN_GROUP_SIZE (SCAN_BUCKET_COUNT * SCAN_BUCKET_SIZE)
+
+// The scalar path packs the bucket masks of this many groups into one 64 bit table entry
+#define SCAN_LANE_SIZE (8)
+
+#define SCAN_BLOCK_SIZE (32)
+#define SCAN_CHUNK_SIZE (16 * 1024)
+
+#define SCAN_HISTOGRAM_STRIDE (509)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// Every anchor byte has a low and a high nibble table, a position is a candidate for a bucket when all six lookups keep its bit
+struct SCAN_GROUP
+{
+	UINT8 Low[SCAN_ANCHOR_LENGTH][16];
+	UINT8 High[SCAN_ANCHOR_LENGTH][16];
+	UINT32 BucketSizes[SCAN_BUCKET_COUNT];
+	UINT32 Buckets[SCAN_BUCKET_COUNT][SCAN_BUCKET_SIZE];
+};
+
+// Folds both nibble lookups of a byte into one entry for eight groups at once
+struct SCAN_LANE
+{
+	UINT64 Bytes[SCAN_ANCHOR_LENGTH][256];
+};
+
+// The window bytes are packed little endian so most false candidates are rejected by a single compare
+struct SCAN_ANCHOR
+{
+	UINT32 Request;
+	UINT32 Offset;
+	UINT32 Value;
+	UINT32 Mask;
+};
+
+struct SCAN_CONTEXT
+{
+	SCAN_REQUEST* Requests;
+	SCAN_ANCHOR* Anchors;
+	UINT32 AnchorCount;
+	SCAN_GROUP* Groups;
+	UINT32 GroupCount;
+	SCAN_LANE* Lanes;
+	UINT32 LaneCount;
+	UINT64 CandidateCount;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static SCANNER_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static BOOL VaHasAvx2(VOID);
+
+static VOID VaAccumulateHistogram(UINT32* Histogram, const UINT8* Base, UINT64 Size);
+
+static VOID VaCreateScanContext(SCAN_CONTEXT* Context, const UINT32* Histogram, SCAN_REQUEST* Requests, UINT32 RequestCount);
+static VOID VaDestroyScanContext(SCAN_CONTEXT* Context);
+
+static VOID VaScanRange(SCAN_CONTEXT* Context, const UINT8* Base, UINT64 Size);
+static VOID VaScanScalar(SCAN_CONTEXT* Context, const UINT8* Base, UINT64 Size, UINT64 Start);
+static UINT64 VaScanAvx2(SCAN_CONTEXT* Context, const UINT8* Base, UINT64 Size);
+
+static VOID VaVerifyCandidate(SCAN_CONTEXT* Context, const SCAN_GROUP* Group, UINT32 BucketMask, const UINT8* Base, UINT64 Size, UINT64 Position);
+
+static int VaCompareAnchors(const VOID* Left, const VOID* Right);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaScanMemory(const VOID* Base, UINT64 Size, SCAN_REQUEST* Requests, UINT32 RequestCount)
+{
+	UINT32 histogram[256] = { 0 };
+
+	VaAccumulateHistogram(histogram, (const UINT8*)Base, Size);
+
+	SCAN_CONTEXT context = { 0 };
+
+	VaCreateScanContext(&context, histogram, Requests, RequestCount);
+
+	VaScanRange(&context, (const UINT8*)Base, Size);
+
+	VaDestroyScanContext(&context);
+}
+VOID VaScanModule(UINT64 ModuleBase, SCAN_REQUEST* Requests, UINT32 RequestCount)
+{
+	PIMAGE_DOS_HEADER dosHeader = (PIMAGE_DOS_HEADER)ModuleBase;
+	PIMAGE_NT_HEADERS64 ntHeaders = (PIMAGE_NT_HEADERS64)(ModuleBase + dosHeader->e_lfanew);
+	PIMAGE_SECTION_HEADER sections = IMAGE_FIRST_SECTION(ntHeaders);
+
+	UINT32 histogram[256] = { 0 };
+
+	// Patterns describe code, so both the anchor rarity and the scan itself only look at executable sections
+	for (UINT32 i = 0; i < ntHeaders->FileHeader.NumberOfSections; i++)
+	{
+		if (sections[i].Characteristics & IMAGE_SCN_MEM_EXECUTE)
+		{
+			VaAccumulateHistogram(histogram, (const UINT8*)(ModuleBase + sections[i].VirtualAddress), sections[i].Misc.VirtualSize);
+		}
+	}
+
+	SCAN_CONTEXT context = { 0 };
+
+	VaCreateScanContext(&context, histogram, Requests, RequestCount);
+
+	for (UINT32 i = 0; i < ntHeaders->FileHeader.NumberOfSections; i++)
+	{
+		if (sections[i].Characteristics & IMAGE_SCN_MEM_EXECUTE)
+		{
+			VaScanRange(&context, (const UINT8*)(ModuleBase + sections[i].VirtualAddress), sections[i].Misc.VirtualSize);
+		}
+	}
+
+	VaDestroyScanContext(&context);
+}
+
+UINT64 VaResolveRelativeAddress(UINT64 Address, UINT32 OperandOffset, UINT32 InstructionLength)
+{
+	INT32 displacement = 0;
+
+	memcpy(&displacement, (const VOID*)(Address + OperandOffset), sizeof(displacement));
+
+	return Address + InstructionLength + displacement;
+}
+
+VOID VaGetScannerStatistics(SCANNER_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+}
+
+static BOOL VaHasAvx2(VOID)
+{
+	INT32 registers[4] = { 0 };
+
+	__cpuid(registers, 1);
+
+	// The os has to save ymm state, otherwise the instructions exist but must not be used
+	if (((registers[2] & (1 << 27)) == 0) || ((registers[2] & (1 << 28)) == 0) || ((_xgetbv(0) & 6) != 6))
+	{
+		return FALSE;
+	}
+
+	__cpuidex(registers, 7, 0);
+
+	return (registers[1] & (1 << 5)) != 0;
+}
+
+static VOID VaAccumulateHistogram(UINT32* Histogram, const UINT8* Base, UINT64 Size)
+{
+	// A sparse byte histogram is enough to tell common opcodes from rare ones
+	for (UINT64 i = 0; i < Size; i += SCAN_HISTOGRAM_STRIDE)
+	{
+		Histogram[Base[i]] += 1;
+	}
+}
+
+static VOID VaCreateScanContext(SCAN_CONTEXT* Context, const UINT32* Histogram, SCAN_REQUEST* Requests, UINT32 RequestCount)
+{
+	Context->Requests = Requests;
+	Context->Anchors = (SCAN_ANCHOR*)calloc(RequestCount + 1, sizeof(SCAN_ANCHOR));
+	Context->AnchorCount = 0;
+
+	UINT64 sampleCount = 0;
+
+	for (UINT32 i = 0; i < 256; i++)
+	{
+		sampleCount += Histogram[i];
+	}
+
+	for (UINT32 i = 0; i < RequestCount; i++)
+	{
+		SCAN_REQUEST* request = &Requests[i];
+
+		request->Address = 0;
+		request->MatchCount = 0;
+
+		if (!request->Signature.Valid)
+		{
+			continue;
+		}
+
+		UINT32 windowLength = min(request->Signature.Length, SCAN_ANCHOR_LENGTH);
+
+		UINT64 bestScore = ~0ULL;
+		UINT32 bestOffset = 0;
+
+		// Wildcards in the window pass everything, so they cost as much as the most common byte would
+		for (UINT32 offset = 0; (offset + windowLength) <= request->Signature.Length; offset++)
+		{
+			UINT64 score = 1;
+
+			for (UINT32 j = 0; j < windowLength; j++)
+			{
+				score *= request->Signature.Mask[offset + j] ? (Histogram[request->Signature.Bytes[offset + j]] + 1) : (sampleCount + 1);
+			}
+
+			if (score < bestScore)
+			{
+				bestScore = score;
+				bestOffset = offset;
+			}
+		}
+
+		SCAN_ANCHOR* anchor = &Context->Anchors[Context->AnchorCount++];
+
+		anchor->Request = i;
+		anchor->Offset = bestOffset;
+
+		for (UINT32 j = 0; j < windowLength; j++)
+		{
+			anchor->Value |= (UINT32)request->Signature.Bytes[bestOffset + j] << (j * 8);
+			anchor->Mask |= (UINT32)request->Signature.Mask[bestOffset + j] << (j * 8);
+		}
+	}
+
+	// Anchors starting with the same byte share buckets, which keeps the nibble tables sparse
+	qsort(Context->Anchors, Context->AnchorCount, sizeof(SCAN_ANCHOR), VaCompareAnchors);
+
+	Context->GroupCount = (Context->AnchorCount + SCAN_GROUP_SIZE - 1) / SCAN_GROUP_SIZE;
+	Context->Groups = (SCAN_GROUP*)calloc(Context->GroupCount + 1, sizeof(SCAN_GROUP));
+
+	for (UINT32 i = 0; i < Context->AnchorCount; i++)
+	{
+		SCAN_ANCHOR* anchor = &Context->Anchors[i];
+		SCAN_GROUP* group = &Context->Groups[i / SCAN_GROUP_SIZE];
+
+		const SIGNATURE* signature = &Requests[anchor->Request].Signature;
+
+		UINT32 bucket = (i % SCAN_GROUP_SIZE) / SCAN_BUCKET_SIZE;
+		UINT8 bit = (UINT8)(1u << bucket);
+
+		group->Buckets[bucket][group->BucketSizes[bucket]++] = i;
+
+		for (UINT32 j = 0; j < SCAN_ANCHOR_LENGTH; j++)
+		{
+			for (UINT32 nibble = 0; nibble < 16; nibble++)
+			{
+				// Past the end of a short pattern every nibble has to pass as well
+				BOOL fixed = ((anchor->Offset + j) < signature->Length) && signature->Mask[anchor->Offset + j];
+
+				if (!fixed || ((signature->Bytes[anchor->Offset + j] & 0xF) == nibble))
+				{
+					group->Low[j][nibble] |= bit;
+				}
+
+				if (!fixed || ((signature->Bytes[anchor->Offset + j] >> 4) == nibble))
+				{
+					group->High[j][nibble] |= bit;
+				}
+			}
+		}
+	}
+
+	Context->LaneCount = (Context->GroupCount + SCAN_LANE_SIZE - 1) / SCAN_LANE_SIZE;
+	Context->Lanes = (SCAN_LANE*)calloc(Context->LaneCount + 1, sizeof(SCAN_LANE));
+
+	for (UINT32 i = 0; i < Context->GroupCount; i++)
+	{
+		SCAN_GROUP* group = &Context->Groups[i];
+		SCAN_LANE* lane = &Context->Lanes[i / SCAN_LANE_SIZE];
+
+		UINT32 shift = (i % SCAN_LANE_SIZE) * 8;
+
+		for (UINT32 j = 0; j < SCAN_ANCHOR_LENGTH; j++)
+		{
+			for (UINT32 value = 0; value < 256; value++)
+			{
+				lane->Bytes[j][value] |= (UINT64)(group->Low[j][value & 0xF] & group->High[j][value >> 4]) << shift;
+			}
+		}
+	}
+
+	sStatistics.Avx2 = VaHasAvx2();
+}
+static VOID VaDestroyScanContext(SCAN_CONTEXT* Context)
+{
+	free(Context->Anchors);
+	free(Context->Groups);
+	free(Context->Lanes);
+
+	memset(Context, 0, sizeof(SCAN_CONTEXT));
+}
+
+static VOID VaScanRange(SCAN_CONTEXT* Context, const UINT8* Base, UINT64 Size)
+{
+	UINT64 startTime = VaQueryProfilerTime();
+
+	Context->CandidateCount = 0;
+
+	UINT64 scalarStart = sStatistics.Avx2 ? VaScanAvx2(Context, Base, Size) : 0;
+
+	VaScanScalar(Context, Base, Size, scalarStart);
+
+	sStatistics.ScannedBytes += Size;
+	sStatistics.CandidateCount += Context->CandidateCount;
+	sStatistics.ScanTime += VaQueryProfilerTime() - startTime;
+}
+static VOID VaScanScalar(SCAN_CONTEXT* Context, const UINT8* Base, UINT64 Size, UINT64 Start)
+{
+	for (UINT64 position = Start; position < Size; position++)
+	{
+		for (UINT32 i = 0; i < Context->LaneCount; i++)
+		{
+			const SCAN_LANE* lane = &Context->Lanes[i];
+
+			UINT64 bucketMasks = ~0ULL;
+
+			// Window bytes past the end pass everything, a pattern that does not fit is rejected during verification
+			for (UINT32 j = 0; (j < SCAN_ANCHOR_LENGTH) && ((position + j) < Size); j++)
+			{
+				bucketMasks &= lane->Bytes[j][Base[position + j]];
+			}
+
+			while (bucketMasks)
+			{
+				UINT32 bit = (UINT32)_tzcnt_u64(bucketMasks);
+				UINT32 group = (i * SCAN_LANE_SIZE) + (bit / 8);
+
+				VaVerifyCandidate(Context, &Context->Groups[group], (UINT32)(bucketMasks >> (bit & ~7u)) & 0xFF, Base, Size, position);
+
+				bucketMasks &= ~(0xFFULL << (bit & ~7u));
+			}
+		}
+	}
+}
+static UINT64 VaScanAvx2(SCAN_CONTEXT* Context, const UINT8* Base, UINT64 Size)
+{
+	if (Size < (SCAN_BLOCK_SIZE + SCAN_ANCHOR_LENGTH))
+	{
+		return 0;
+	}
+
+	UINT64 blockEnd = Size - (SCAN_BLOCK_SIZE + SCAN_ANCHOR_LENGTH - 1) + 1;
+
+	blockEnd -= blockEnd % SCAN_BLOCK_SIZE;
+
+	__m256i nibbleMask = _mm256_set1_epi8(0x0F);
+	__m256i zero = _mm256_setzero_si256();
+
+	// Every group walks the same chunk while it is still in the first level cache, memory is only streamed through once
+	for (UINT64 chunk = 0; chunk < blockEnd; chunk += SCAN_CHUNK_SIZE)
+	{
+		UINT64 chunkEnd = min(chunk + SCAN_CHUNK_SIZE, blockEnd);
+
+		for (UINT32 i = 0; i < Context->GroupCount; i++)
+		{
+			const SCAN_GROUP* group = &Context->Groups[i];
+
+			// Shuffles only index inside their own 128 bit lane, so both lanes get the same table
+			__m256i lowTable0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)group->Low[0]));
+			__m256i lowTable1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)group->Low[1]));
+			__m256i lowTable2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)group->Low[2]));
+			__m256i highTable0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)group->High[0]));
+			__m256i highTable1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)group->High[1]));
+			__m256i highTable2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)group->High[2]));
+
+			for (UINT64 position = chunk; position < chunkEnd; position += SCAN_BLOCK_SIZE)
+			{
+				__m256i data0 = _mm256_loadu_si256((const __m256i*)(Base + position));
+				__m256i data1 = _mm256_loadu_si256((const __m256i*)(Base + position + 1));
+				__m256i data2 = _mm256_loadu_si256((const __m256i*)(Base + position + 2));
+
+				__m256i buckets = _mm256_and_si256(
+					_mm256_shuffle_epi8(lowTable0, _mm256_and_si256(data0, nibbleMask)),
+					_mm256_shuffle_epi8(highTable0, _mm256_and_si256(_mm256_srli_epi16(data0, 4), nibbleMask)));
+
+				buckets = _mm256_and_si256(buckets, _mm256_shuffle_epi8(lowTable1, _mm256_and_si256(data1, nibbleMask)));
+				buckets = _mm256_and_si256(buckets, _mm256_shuffle_epi8(highTable1, _mm256_and_si256(_mm256_srli_epi16(data1, 4), nibbleMask)));
+				buckets = _mm256_and_si256(buckets, _mm256_shuffle_epi8(lowTable2, _mm256_and_si256(data2, nibbleMask)));
+				buckets = _mm256_and_si256(buckets, _mm256_shuffle_epi8(highTable2, _mm256_and_si256(_mm256_srli_epi16(data2, 4), nibbleMask)));
+
+				UINT32 candidates = ~(UINT32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(buckets, zero));
+
+				if (!candidates)
+				{
+					continue;
+				}
+
+				alignas(32) UINT8 bucketMasks[SCAN_BLOCK_SIZE];
+
+				_mm256_store_si256((__m256i*)bucketMasks, buckets);
+
+				while (candidates)
+				{
+					UINT32 index = _tzcnt_u32(candidates);
+
+					VaVerifyCandidate(Context, group, bucketMasks[index], Base, Size, position + index);
+
+					candidates &= candidates - 1;
+				}
+			}
+		}
+	}
+
+	return blockEnd;
+}
+
+static VOID VaVerifyCandidate(SCAN_CONTEXT* Context, const SCAN_GROUP* Group, UINT32 BucketMask, const UINT8* Base, UINT64 Size, UINT64 Position)
+{
+	Context->CandidateCount += 1;
+
+	UINT32 window = 0;
+
+	memcpy(&window, Base + Position, (UINT32)min(Size - Position, sizeof(window)));
+
+	while (BucketMask)
+	{
+		UINT32 bucket = _tzcnt_u32(BucketMask);
+
+		for (UINT32 i = 0; i < Group->BucketSizes[bucket]; i++)
+		{
+			const SCAN_ANCHOR* anchor = &Context->Anchors[Group->Buckets[bucket][i]];
+
+			SCAN_REQUEST* request = &Context->Requests[anchor->Request];
+
+			const SIGNATURE* signature = &request->Signature;
+
+			if (((window & anchor->Mask) != anchor->Value) || (Position < anchor->Offset) || ((Position - anchor->Offset + signature->Length) > Size))
+			{
+				continue;
+			}
+
+			const UINT8* start = Base + Position - anchor->Offset;
+
+			UINT32 j = 0;
+
+			while ((j < signature->Length) && ((start[j] & signature->Mask[j]) == signature->Bytes[j]))
+			{
+				j++;
+			}
+
+			if (j < signature->Length)
+			{
+				continue;
+			}
+
+			// Positions only ever grow, the first match is the lowest address
+			if (request->MatchCount == 0)
+			{
+				request->Address = (UINT64)start;
+			}
+
+			request->MatchCount += 1;
+
+			sStatistics.MatchCount += 1;
+		}
+
+		BucketMask &= BucketMask - 1;
+	}
+}
+
+static int VaCompareAnchors(const VOID* Left, const VOID* Right)
+{
+	const SCAN_ANCHOR* left = (const SCAN_ANCHOR*)Left;
+	const SCAN_ANCHOR* right = (const SCAN_ANCHOR*)Right;
+
+	if ((left->Value & 0xFF) != (right->Value & 0xFF))
+	{
+		return ((left->Value & 0xFF) < (right->Value & 0xFF)) ? -1 : 1;
+	}
+
+	return (left->Request < right->Request) ? -1 : (left->Request > right->Request);
+}
\ No newline at end of file
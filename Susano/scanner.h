@@ -0,0 +1,114 @@
+#pragma once
+
+#include <windows.h>
+
+#define SIGNATURE_LENGTH (64)
+
+// Parses the pattern at compile time, a malformed one fails the build instead of the scan
+#define DECLARE_SIGNATURE(NAME, TEXT) \
+	static constexpr SIGNATURE NAME = VaParseSignature(TEXT); \
+	static_assert(NAME.Valid, "Malformed signature " TEXT)
+
+// Bytes are stored already masked so a match is (Memory & Mask) == Bytes
+struct SIGNATURE
+{
+	UINT8 Bytes[SIGNATURE_LENGTH];
+	UINT8 Mask[SIGNATURE_LENGTH];
+	UINT32 Length;
+	BOOL Valid;
+};
+
+struct SCAN_REQUEST
+{
+	SIGNATURE Signature;
+	UINT64 Address;
+	UINT32 MatchCount;
+};
+
+struct SCANNER_STATISTICS
+{
+	UINT64 ScannedBytes;
+	UINT64 CandidateCount;
+	UINT64 MatchCount;
+	UINT64 ScanTime;
+	BOOL Avx2;
+};
+
+constexpr UINT32 VaParseSignatureNibble(CHAR Character)
+{
+	return ((Character >= '0') && (Character <= '9')) ? (Character - '0') :
+		((Character >= 'A') && (Character <= 'F')) ? (Character - 'A' + 10) :
+		((Character >= 'a') && (Character <= 'f')) ? (Character - 'a' + 10) : 16;
+}
+
+// Accepts space separated hex bytes where ? or ?? is a wildcard, for example "48 8B 05 ?? ?? ?? ??"
+constexpr SIGNATURE VaParseSignature(LPCSTR Text)
+{
+	SIGNATURE signature = {};
+
+	signature.Valid = TRUE;
+
+	while (*Text)
+	{
+		if (*Text == ' ')
+		{
+			Text++;
+
+			continue;
+		}
+
+		if (signature.Length == SIGNATURE_LENGTH)
+		{
+			signature.Valid = FALSE;
+
+			break;
+		}
+
+		if (*Text == '?')
+		{
+			Text += (Text[1] == '?') ? 2 : 1;
+		}
+		else
+		{
+			UINT32 high = VaParseSignatureNibble(Text[0]);
+			UINT32 low = Text[1] ? VaParseSignatureNibble(Text[1]) : 16;
+
+			if ((high > 15) || (low > 15))
+			{
+				signature.Valid = FALSE;
+
+				break;
+			}
+
+			signature.Bytes[signature.Length] = (UINT8)((high << 4) | low);
+			signature.Mask[signature.Length] = 0xFF;
+
+			Text += 2;
+		}
+
+		signature.Length += 1;
+
+		if (*Text && (*Text != ' '))
+		{
+			signature.Valid = FALSE;
+
+			break;
+		}
+	}
+
+	if (signature.Length == 0)
+	{
+		signature.Valid = FALSE;
+	}
+
+	return signature;
+}
+
+// Every request is matched in the same pass, the address is the lowest match and the count tells ambiguous patterns apart
+VOID VaScanMemory(const VOID* Base, UINT64 Size, SCAN_REQUEST* Requests, UINT32 RequestCount);
+VOID VaScanModule(UINT64 ModuleBase, SCAN_REQUEST* Requests, UINT32 RequestCount);
+
+// Turns an instruction with a rip relative disp32 operand into the address it refers to
+UINT64 VaResolveRelativeAddress(UINT64 Address, UINT32 OperandOffset, UINT32 InstructionLength);
+
+VOID VaGetScannerStatistics(SCANNER_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,567 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <d3d11.h>
+#include <dxgi.h>
+#include <d3dcompiler.h>
+
+#include "susano.h"
+#include "linebatchrenderer.h"
+#include "shaperenderer.h"
+#include "uploadring.h"
+#include "pipelinecache.h"
+#include "logger.h"
+
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define PRINT_LAST_ERROR() VA_LOG("0x%08X", GetLastError())
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+#define CIRCLE_SEGMENTS (16)
+
+#define SHAPE_VERTEX_BUFFER_SIZE (256)
+#define SHAPE_INDEX_BUFFER_SIZE (512)
+
+#define INSTANCE_BATCH_CAPACITY (1024)
+
+#define HR_CHECK(EXPRESSION) \
+	{ \
+		HRESULT result = (EXPRESSION); \
+		if (result != S_OK) \
+		{ \
+			VA_LOG("%s 0x%08X", #EXPRESSION, result); \
+		} \
+	}
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+enum SHAPE_KIND
+{
+	SHAPE_KIND_BOX,
+	SHAPE_KIND_SPHERE,
+	SHAPE_KIND_CYLINDER,
+	SHAPE_KIND_CAPSULE,
+	SHAPE_KIND_COUNT,
+};
+
+// Cap moves a vertex along the local y axis by the per-instance extension, this is how the capsule hemispheres are pulled apart without being stretched
+struct SHAPE_VERTEX
+{
+	XMFLOAT3 Position;
+	FLOAT Cap;
+};
+
+// The transform is a 3x4 affine matrix, each row produces one world component from float4(local, 1)
+struct SHAPE_INSTANCE
+{
+	XMFLOAT4 Rows[3];
+	UINT32 Color;
+	FLOAT Extension;
+	FLOAT Padding[2];
+};
+
+struct SHAPE_MESH
+{
+	UINT32 BaseVertex;
+	UINT32 StartIndex;
+	UINT32 IndexCount;
+};
+
+struct SHAPE_BATCH
+{
+	SHAPE_INSTANCE* Instances;
+	UINT32 Count;
+	UINT32 Capacity;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static PIPELINE sPipeline = INVALID_PIPELINE;
+static ID3D11Buffer* sVertexBuffer = NULL;
+static ID3D11Buffer* sIndexBuffer = NULL;
+
+static CHAR sVertexShaderSource[] = R"hlsl(
+	cbuffer ViewProjection : register(b0)
+	{
+		matrix viewProjection;
+	};
+
+	struct VS_INPUT
+	{
+		float3 position : POSITION;
+		float cap : CAP;
+		float4 row0 : TRANSFORM0;
+		float4 row1 : TRANSFORM1;
+		float4 row2 : TRANSFORM2;
+		float4 color : COLOR;
+		float extension : EXTENSION;
+	};
+
+	struct PS_INPUT
+	{
+		float4 position : SV_POSITION;
+		float4 color : COLOR;
+	};
+
+	PS_INPUT VS(VS_INPUT input)
+	{
+		PS_INPUT output;
+
+		float4 local = float4(input.position.x, input.position.y + input.cap * input.extension, input.position.z, 1.0f);
+		float4 position = float4(dot(input.row0, local), dot(input.row1, local), dot(input.row2, local), 1.0f);
+
+		position = mul(position, viewProjection);
+
+		output.position = position;
+		output.color = input.color;
+
+		return output;
+	}
+)hlsl";
+
+static CHAR sPixelShaderSource[] = R"hlsl(
+	struct PS_INPUT
+	{
+		float4 position : SV_POSITION;
+		float4 color : COLOR;
+	};
+
+	float4 PS(PS_INPUT input) : SV_TARGET
+	{
+		return input.color;
+	}
+)hlsl";
+
+static D3D11_INPUT_ELEMENT_DESC sInputLayoutSource[] =
+{
+	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "CAP", 0, DXGI_FORMAT_R32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TRANSFORM", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "TRANSFORM", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "TRANSFORM", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 1, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	{ "EXTENSION", 0, DXGI_FORMAT_R32_FLOAT, 1, 52, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+};
+
+// cos and sin of i * 22.5 degrees
+static constexpr FLOAT sUnitCircle[CIRCLE_SEGMENTS][2] =
+{
+	{ 1.000000000f, 0.000000000f },
+	{ 0.923879533f, 0.382683432f },
+	{ 0.707106781f, 0.707106781f },
+	{ 0.382683432f, 0.923879533f },
+	{ 0.000000000f, 1.000000000f },
+	{ -0.382683432f, 0.923879533f },
+	{ -0.707106781f, 0.707106781f },
+	{ -0.923879533f, 0.382683432f },
+	{ -1.000000000f, 0.000000000f },
+	{ -0.923879533f, -0.382683432f },
+	{ -0.707106781f, -0.707106781f },
+	{ -0.382683432f, -0.923879533f },
+	{ 0.000000000f, -1.000000000f },
+	{ 0.382683432f, -0.923879533f },
+	{ 0.707106781f, -0.707106781f },
+	{ 0.923879533f, -0.382683432f },
+};
+
+// Same corner order and edge list as VaDrawBox, so both paths produce identical lines
+static const SHAPE_VERTEX sUnitBoxVertices[8] =
+{
+	{ XMFLOAT3{ -0.5f, -0.5f, -0.5f }, 0.0f },
+	{ XMFLOAT3{  0.5f, -0.5f, -0.5f }, 0.0f },
+	{ XMFLOAT3{ -0.5f,  0.5f, -0.5f }, 0.0f },
+	{ XMFLOAT3{  0.5f,  0.5f, -0.5f }, 0.0f },
+	{ XMFLOAT3{ -0.5f, -0.5f,  0.5f }, 0.0f },
+	{ XMFLOAT3{  0.5f, -0.5f,  0.5f }, 0.0f },
+	{ XMFLOAT3{ -0.5f,  0.5f,  0.5f }, 0.0f },
+	{ XMFLOAT3{  0.5f,  0.5f,  0.5f }, 0.0f },
+};
+
+static constexpr UINT16 sUnitBoxIndices[24] =
+{
+	0, 1, 0, 2, 2, 3,
+	3, 1, 4, 5, 4, 6,
+	6, 7, 7, 5, 0, 4,
+	1, 5, 2, 6, 3, 7,
+};
+
+static SHAPE_VERTEX sShapeVertices[SHAPE_VERTEX_BUFFER_SIZE];
+static UINT16 sShapeIndices[SHAPE_INDEX_BUFFER_SIZE];
+
+static UINT32 sShapeVertexCount = 0;
+static UINT32 sShapeIndexCount = 0;
+
+static UINT32 sShapeBaseVertex = 0;
+
+static SHAPE_MESH sShapeMeshes[SHAPE_KIND_COUNT];
+
+static SHAPE_BATCH sShapeBatches[SHAPE_KIND_COUNT];
+
+static SHAPE_INSTANCE* sStagingInstances = NULL;
+
+static UINT32 sStagingInstanceCapacity = 0;
+
+static BOOL sInstancing = TRUE;
+
+static SHAPE_BATCH_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaCreatePipelines(VOID);
+static VOID VaCreateVertexBuffers(VOID);
+static VOID VaCreateIndexBuffers(VOID);
+
+static VOID VaBuildUnitMeshes(VOID);
+static VOID VaBeginUnitMesh(SHAPE_KIND Kind);
+static VOID VaEndUnitMesh(SHAPE_KIND Kind);
+static VOID VaAppendArc(XMFLOAT3 U, XMFLOAT3 V, FLOAT Height, FLOAT Cap, UINT32 First, UINT32 Count, BOOL Closed);
+static VOID VaAppendSegment(XMFLOAT3 A, FLOAT CapA, XMFLOAT3 B, FLOAT CapB);
+
+static VOID VaPushInstance(SHAPE_KIND Kind, XMFLOAT3 P, XMFLOAT3 S, FLOAT Extension, XMFLOAT4 C);
+static VOID VaExpandInstances(SHAPE_KIND Kind);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateShapeRenderer(VOID)
+{
+	VaBuildUnitMeshes();
+
+	VaCreatePipelines();
+	VaCreateVertexBuffers();
+	VaCreateIndexBuffers();
+}
+VOID VaDestroyShapeRenderer(VOID)
+{
+	sVertexBuffer->Release();
+	sIndexBuffer->Release();
+	free(sStagingInstances);
+
+	sStagingInstances = NULL;
+	sStagingInstanceCapacity = 0;
+
+	for (UINT32 i = 0; i < SHAPE_KIND_COUNT; i++)
+	{
+		free(sShapeBatches[i].Instances);
+
+		memset(&sShapeBatches[i], 0, sizeof(SHAPE_BATCH));
+	}
+}
+
+VOID VaDrawWireBox(XMFLOAT3 P, XMFLOAT3 S, XMFLOAT4 C)
+{
+	VaPushInstance(SHAPE_KIND_BOX, P, S, 0.0f, C);
+}
+VOID VaDrawWireSphere(XMFLOAT3 P, FLOAT R, XMFLOAT4 C)
+{
+	VaPushInstance(SHAPE_KIND_SPHERE, P, XMFLOAT3(R, R, R), 0.0f, C);
+}
+VOID VaDrawWireCylinder(XMFLOAT3 P, FLOAT R, FLOAT H, XMFLOAT4 C)
+{
+	VaPushInstance(SHAPE_KIND_CYLINDER, P, XMFLOAT3(R, H / 2.0f, R), 0.0f, C);
+}
+VOID VaDrawWireCapsule(XMFLOAT3 P, FLOAT R, FLOAT H, XMFLOAT4 C)
+{
+	// The unit capsule is scaled uniformly by the radius, the extension is therefore expressed in radii
+	FLOAT extension = (R > 0.0f) ? ((H / 2.0f) / R) : 0.0f;
+
+	VaPushInstance(SHAPE_KIND_CAPSULE, P, XMFLOAT3(R, R, R), extension, C);
+}
+
+VOID VaRenderShapeBatch(VOID)
+{
+	UINT32 instanceCount = 0;
+
+	for (UINT32 i = 0; i < SHAPE_KIND_COUNT; i++)
+	{
+		instanceCount += sShapeBatches[i].Count;
+	}
+
+	sStatistics.InstanceCount = instanceCount;
+	sStatistics.DrawCount = 0;
+	sStatistics.UploadedBytes = 0;
+
+	if (instanceCount == 0)
+	{
+		return;
+	}
+
+	// Without instancing every shape is expanded on the cpu into the line batch, which has to be rendered afterwards
+	if (!sInstancing)
+	{
+		for (UINT32 i = 0; i < SHAPE_KIND_COUNT; i++)
+		{
+			VaExpandInstances((SHAPE_KIND)i);
+
+			sShapeBatches[i].Count = 0;
+		}
+
+		return;
+	}
+
+	if (instanceCount > sStagingInstanceCapacity)
+	{
+		sStagingInstanceCapacity = max(instanceCount, sStagingInstanceCapacity * 2);
+		sStagingInstances = (SHAPE_INSTANCE*)realloc(sStagingInstances, sizeof(SHAPE_INSTANCE) * sStagingInstanceCapacity);
+	}
+
+	UINT32 instanceOffset = 0;
+
+	for (UINT32 i = 0; i < SHAPE_KIND_COUNT; i++)
+	{
+		memcpy(sStagingInstances + instanceOffset, sShapeBatches[i].Instances, sizeof(SHAPE_INSTANCE) * sShapeBatches[i].Count);
+
+		instanceOffset += sShapeBatches[i].Count;
+	}
+
+	UPLOAD_REGION instanceRegion = { 0 };
+
+	if (VaUploadCached(sStagingInstances, sizeof(SHAPE_INSTANCE) * instanceCount, sizeof(SHAPE_INSTANCE), &instanceRegion))
+	{
+		sStatistics.UploadedBytes = sizeof(SHAPE_INSTANCE) * instanceCount;
+	}
+
+	ID3D11Buffer* viewProjectionBuffer = VaCommitConstantBlock(gViewProjectionBlock);
+
+	ID3D11Buffer* vertexBuffers[] = { sVertexBuffer, instanceRegion.Buffer };
+
+	UINT32 strides[] = { sizeof(SHAPE_VERTEX), sizeof(SHAPE_INSTANCE) };
+	UINT32 offsets[] = { 0, instanceRegion.Offset };
+
+	VaBindPipeline(sPipeline);
+	VaBindConstantBuffers(0, 1, &viewProjectionBuffer);
+	VaBindVertexBuffers(2, vertexBuffers, strides, offsets);
+	VaBindIndexBuffer(sIndexBuffer, 0);
+
+	instanceOffset = 0;
+
+	for (UINT32 i = 0; i < SHAPE_KIND_COUNT; i++)
+	{
+		SHAPE_MESH* mesh = &sShapeMeshes[i];
+
+		if (sShapeBatches[i].Count > 0)
+		{
+			gDeviceContext->DrawIndexedInstanced(mesh->IndexCount, sShapeBatches[i].Count, mesh->StartIndex, mesh->BaseVertex, instanceOffset);
+
+			sStatistics.DrawCount += 1;
+		}
+
+		instanceOffset += sShapeBatches[i].Count;
+
+		sShapeBatches[i].Count = 0;
+	}
+}
+
+VOID VaSetShapeInstancing(BOOL Enabled)
+{
+	sInstancing = Enabled;
+}
+BOOL VaGetShapeInstancing(VOID)
+{
+	return sInstancing;
+}
+
+VOID VaGetShapeBatchStatistics(SHAPE_BATCH_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+}
+
+static VOID VaCreatePipelines(VOID)
+{
+	sPipeline = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+}
+static VOID VaCreateVertexBuffers(VOID)
+{
+	D3D11_BUFFER_DESC bufferDescription = { 0 };
+	bufferDescription.Usage = D3D11_USAGE_IMMUTABLE;
+	bufferDescription.ByteWidth = sizeof(SHAPE_VERTEX) * sShapeVertexCount;
+	bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+	D3D11_SUBRESOURCE_DATA subResourceData = { 0 };
+	subResourceData.pSysMem = sShapeVertices;
+
+	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, &subResourceData, &sVertexBuffer));
+}
+static VOID VaCreateIndexBuffers(VOID)
+{
+	D3D11_BUFFER_DESC bufferDescription = { 0 };
+	bufferDescription.Usage = D3D11_USAGE_IMMUTABLE;
+	bufferDescription.ByteWidth = sizeof(UINT16) * sShapeIndexCount;
+	bufferDescription.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+	D3D11_SUBRESOURCE_DATA subResourceData = { 0 };
+	subResourceData.pSysMem = sShapeIndices;
+
+	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, &subResourceData, &sIndexBuffer));
+}
+
+static VOID VaBuildUnitMeshes(VOID)
+{
+	sShapeVertexCount = 0;
+	sShapeIndexCount = 0;
+
+	VaBeginUnitMesh(SHAPE_KIND_BOX);
+
+	memcpy(sShapeVertices + sShapeVertexCount, sUnitBoxVertices, sizeof(sUnitBoxVertices));
+	memcpy(sShapeIndices + sShapeIndexCount, sUnitBoxIndices, sizeof(sUnitBoxIndices));
+
+	sShapeVertexCount += ARRAY_LENGTH(sUnitBoxVertices);
+	sShapeIndexCount += ARRAY_LENGTH(sUnitBoxIndices);
+
+	VaEndUnitMesh(SHAPE_KIND_BOX);
+
+	// Three great circles
+	VaBeginUnitMesh(SHAPE_KIND_SPHERE);
+	VaAppendArc({ 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 0.0f, 0.0f, 0, CIRCLE_SEGMENTS, TRUE);
+	VaAppendArc({ 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, 0.0f, 0.0f, 0, CIRCLE_SEGMENTS, TRUE);
+	VaAppendArc({ 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, 0.0f, 0.0f, 0, CIRCLE_SEGMENTS, TRUE);
+	VaEndUnitMesh(SHAPE_KIND_SPHERE);
+
+	// Two rings connected by four struts
+	VaBeginUnitMesh(SHAPE_KIND_CYLINDER);
+	VaAppendArc({ 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, 1.0f, 0.0f, 0, CIRCLE_SEGMENTS, TRUE);
+	VaAppendArc({ 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, -1.0f, 0.0f, 0, CIRCLE_SEGMENTS, TRUE);
+
+	for (UINT32 i = 0; i < CIRCLE_SEGMENTS; i += (CIRCLE_SEGMENTS / 4))
+	{
+		VaAppendSegment({ sUnitCircle[i][0], 1.0f, sUnitCircle[i][1] }, 0.0f, { sUnitCircle[i][0], -1.0f, sUnitCircle[i][1] }, 0.0f);
+	}
+
+	VaEndUnitMesh(SHAPE_KIND_CYLINDER);
+
+	// Two rings at the hemisphere centers, four struts and two half circles per hemisphere
+	VaBeginUnitMesh(SHAPE_KIND_CAPSULE);
+	VaAppendArc({ 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, 0.0f, 1.0f, 0, CIRCLE_SEGMENTS, TRUE);
+	VaAppendArc({ 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, 0.0f, -1.0f, 0, CIRCLE_SEGMENTS, TRUE);
+
+	for (UINT32 i = 0; i < CIRCLE_SEGMENTS; i += (CIRCLE_SEGMENTS / 4))
+	{
+		VaAppendSegment({ sUnitCircle[i][0], 0.0f, sUnitCircle[i][1] }, 1.0f, { sUnitCircle[i][0], 0.0f, sUnitCircle[i][1] }, -1.0f);
+	}
+
+	VaAppendArc({ 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 0.0f, 1.0f, 0, CIRCLE_SEGMENTS / 2, FALSE);
+	VaAppendArc({ 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }, 0.0f, 1.0f, 0, CIRCLE_SEGMENTS / 2, FALSE);
+	VaAppendArc({ 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 0.0f, -1.0f, CIRCLE_SEGMENTS / 2, CIRCLE_SEGMENTS / 2, FALSE);
+	VaAppendArc({ 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f }, 0.0f, -1.0f, CIRCLE_SEGMENTS / 2, CIRCLE_SEGMENTS / 2, FALSE);
+	VaEndUnitMesh(SHAPE_KIND_CAPSULE);
+}
+static VOID VaBeginUnitMesh(SHAPE_KIND Kind)
+{
+	sShapeMeshes[Kind].BaseVertex = sShapeVertexCount;
+
+	sShapeBaseVertex = sShapeVertexCount;
+	sShapeMeshes[Kind].StartIndex = sShapeIndexCount;
+}
+static VOID VaEndUnitMesh(SHAPE_KIND Kind)
+{
+	sShapeMeshes[Kind].IndexCount = sShapeIndexCount - sShapeMeshes[Kind].StartIndex;
+}
+static VOID VaAppendArc(XMFLOAT3 U, XMFLOAT3 V, FLOAT Height, FLOAT Cap, UINT32 First, UINT32 Count, BOOL Closed)
+{
+	// Indices are relative to the mesh, the draw call supplies the base vertex
+	UINT16 localVertex = (UINT16)(sShapeVertexCount - sShapeBaseVertex);
+
+	UINT32 pointCount = Closed ? Count : (Count + 1);
+
+	for (UINT32 i = 0; i < pointCount; i++)
+	{
+		UINT32 segment = (First + i) % CIRCLE_SEGMENTS;
+
+		FLOAT c = sUnitCircle[segment][0];
+		FLOAT s = sUnitCircle[segment][1];
+
+		sShapeVertices[sShapeVertexCount + i].Position = XMFLOAT3(U.x * c + V.x * s, U.y * c + V.y * s + Height, U.z * c + V.z * s);
+		sShapeVertices[sShapeVertexCount + i].Cap = Cap;
+	}
+
+	for (UINT32 i = 0; i < Count; i++)
+	{
+		sShapeIndices[sShapeIndexCount + i * 2 + 0] = localVertex + (UINT16)i;
+		sShapeIndices[sShapeIndexCount + i * 2 + 1] = localVertex + (UINT16)((i + 1) % pointCount);
+	}
+
+	sShapeVertexCount += pointCount;
+	sShapeIndexCount += Count * 2;
+}
+static VOID VaAppendSegment(XMFLOAT3 A, FLOAT CapA, XMFLOAT3 B, FLOAT CapB)
+{
+	UINT16 localVertex = (UINT16)(sShapeVertexCount - sShapeBaseVertex);
+
+	sShapeVertices[sShapeVertexCount + 0].Position = A;
+	sShapeVertices[sShapeVertexCount + 0].Cap = CapA;
+	sShapeVertices[sShapeVertexCount + 1].Position = B;
+	sShapeVertices[sShapeVertexCount + 1].Cap = CapB;
+
+	sShapeIndices[sShapeIndexCount + 0] = localVertex + 0;
+	sShapeIndices[sShapeIndexCount + 1] = localVertex + 1;
+
+	sShapeVertexCount += 2;
+	sShapeIndexCount += 2;
+}
+
+static VOID VaPushInstance(SHAPE_KIND Kind, XMFLOAT3 P, XMFLOAT3 S, FLOAT Extension, XMFLOAT4 C)
+{
+	SHAPE_BATCH* batch = &sShapeBatches[Kind];
+
+	if (batch->Count == batch->Capacity)
+	{
+		batch->Capacity = max(batch->Capacity * 2, INSTANCE_BATCH_CAPACITY);
+		batch->Instances = (SHAPE_INSTANCE*)realloc(batch->Instances, sizeof(SHAPE_INSTANCE) * batch->Capacity);
+	}
+
+	SHAPE_INSTANCE* instance = &batch->Instances[batch->Count];
+
+	instance->Rows[0] = XMFLOAT4(S.x, 0.0f, 0.0f, P.x);
+	instance->Rows[1] = XMFLOAT4(0.0f, S.y, 0.0f, P.y);
+	instance->Rows[2] = XMFLOAT4(0.0f, 0.0f, S.z, P.z);
+	instance->Color = VaPackColor(C);
+	instance->Extension = Extension;
+
+	batch->Count += 1;
+}
+static VOID VaExpandInstances(SHAPE_KIND Kind)
+{
+	SHAPE_MESH* mesh = &sShapeMeshes[Kind];
+	SHAPE_BATCH* batch = &sShapeBatches[Kind];
+
+	// Cpu reference of the vertex shader, every index pair becomes one line of the immediate batch
+	for (UINT32 i = 0; i < batch->Count; i++)
+	{
+		SHAPE_INSTANCE* instance = &batch->Instances[i];
+
+		XMFLOAT4 color;
+
+		XMStoreFloat4(&color, PackedVector::XMLoadUByteN4((PackedVector::XMUBYTEN4*)&instance->Color));
+
+		XMFLOAT3 positions[2];
+
+		for (UINT32 j = 0; j < mesh->IndexCount; j += 2)
+		{
+			for (UINT32 k = 0; k < 2; k++)
+			{
+				SHAPE_VERTEX* vertex = &sShapeVertices[mesh->BaseVertex + sShapeIndices[mesh->StartIndex + j + k]];
+
+				XMVECTOR local = XMVectorSet(vertex->Position.x, vertex->Position.y + vertex->Cap * instance->Extension, vertex->Position.z, 1.0f);
+
+				positions[k].x = XMVectorGetX(XMVector4Dot(XMLoadFloat4(&instance->Rows[0]), local));
+				positions[k].y = XMVectorGetX(XMVector4Dot(XMLoadFloat4(&instance->Rows[1]), local));
+				positions[k].z = XMVectorGetX(XMVector4Dot(XMLoadFloat4(&instance->Rows[2]), local));
+			}
+
+			VaDrawLine(positions[0], positions[1], color);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <windows.h>
+
+#include <directxmath.h>
+
+using namespace DirectX;
+
+struct SHAPE_BATCH_STATISTICS
+{
+	UINT32 InstanceCount;
+	UINT32 DrawCount;
+	UINT64 UploadedBytes;
+};
+
+VOID VaCreateShapeRenderer(VOID);
+VOID VaDestroyShapeRenderer(VOID);
+
+VOID VaDrawWireBox(XMFLOAT3 P, XMFLOAT3 S, XMFLOAT4 C);
+VOID VaDrawWireSphere(XMFLOAT3 P, FLOAT R, XMFLOAT4 C);
+VOID VaDrawWireCylinder(XMFLOAT3 P, FLOAT R, FLOAT H, XMFLOAT4 C);
+VOID VaDrawWireCapsule(XMFLOAT3 P, FLOAT R, FLOAT H, XMFLOAT4 C);
+
+VOID VaRenderShapeBatch(VOID);
+
+VOID VaSetShapeInstancing(BOOL Enabled);
+BOOL VaGetShapeInstancing(VOID);
+
+VOID VaGetShapeBatchStatistics(SHAPE_BATCH_STATISTICS* Statistics);
\ No newline at end of file
@@ -8,7 +8,20 @@
 #include "susano.h"
 
 #include "linebatchrenderer.h"
+#include "shaperenderer.h"
+#include "uploadring.h"
+#include "pipelinecache.h"
 #include "defaultgeorenderer.h"
+#include "profiler.h"
+#include "trace.h"
+#include "logger.h"
+#include "control.h"
+#include "gamestate.h"
+#include "offsets.h"
+#include "scanner.h"
+#include "scancache.h"
+#include "safememory.h"
+#include "telemetry.h"
 
 #include "minhook/minhook.h"
 
@@ -23,7 +36,7 @@
 // Macros
 /////////////////////////////////////////////////
 
-#define PRINT_LAST_ERROR() printf("0x%08X\n", GetLastError())
+#define PRINT_LAST_ERROR() VA_LOG("0x%08X", GetLastError())
 
 #define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
 
@@ -37,23 +50,20 @@
 #define DEG_TO_RAD(DEGREES) (DEGREES * ((FLOAT)0.01745329251994329576923690768489))
 #define RAD_TO_DEG(RADIANS) (RADIANS * ((FLOAT)57.295779513082320876798154814105))
 
+#define LOG_FLUSH_INTERVAL (50)
+
+#define OFFSET_SCHEMA_PATH "susano_offsets.txt"
+#define SCAN_CACHE_PATH "susano_scancache.bin"
+
 #define HR_CHECK(EXPRESSION) \
 	{ \
 		HRESULT result = (EXPRESSION); \
 		if (result != S_OK) \
 		{ \
-			printf("%s 0x%08X\n", #EXPRESSION, result); \
+			VA_LOG("%s 0x%08X", #EXPRESSION, result); \
 		} \
 	}
 
-#define COPY_INTO_CONSTANT_BUFFER(BUFFER, VALUE, SIZE) \
-	{ \
-		D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 }; \
-		HR_CHECK(gDeviceContext->Map((BUFFER), NULL, D3D11_MAP_WRITE_DISCARD, NULL, &mappedSubResource)); \
-		memcpy(mappedSubResource.pData, (VALUE), (SIZE)); \
-		gDeviceContext->Unmap((BUFFER), NULL); \
-	}
-
 /////////////////////////////////////////////////
 // Type Definition
 /////////////////////////////////////////////////
@@ -73,7 +83,8 @@ extern LRESULT ImGui_ImplWin32_WndProcHandler(HWND Window, UINT32 Msg, WPARAM WP
 ID3D11Device* gDevice = NULL;
 ID3D11DeviceContext* gDeviceContext = NULL;
 ID3D11RenderTargetView* gMainRenderTargetView = NULL;
-ID3D11Buffer* gModelViewProjectionBuffer = NULL;
+
+CONSTANT_BLOCK gViewProjectionBlock = INVALID_CONSTANT_BLOCK;
 
 MODEL_VIEW_PROJECTION gModelViewProjection;
 
@@ -81,8 +92,8 @@ MODEL_VIEW_PROJECTION gModelViewProjection;
 // Local Variables
 /////////////////////////////////////////////////
 
-static HANDLE sMainThread = NULL;
-static HANDLE sMainThreadExitEvent = NULL;
+static HANDLE sControlThread = NULL;
+static HANDLE sControlThreadExitEvent = NULL;
 
 static FILE* sConsoleInputStream = NULL;
 static FILE* sConsoleOutputStream = NULL;
@@ -91,7 +102,7 @@ static UINT64 sOkamiExeBase = 0;
 static UINT64 sFlowerKernelDllBase = 0;
 static UINT64 sMainDllBase = 0;
 
-static BOOL sRunning = TRUE;
+static volatile BOOL sHooksEnabled = FALSE;
 static BOOL sPresentInitialized = FALSE;
 static BOOL sAllowModelViewProjectionUpdate = TRUE; // TODO
 
@@ -103,6 +114,29 @@ static WNDPROC sWindowProc = NULL;
 
 static ImGuiContext* sImGuiContext = NULL;
 
+static LINE_LAYER sSceneryLayer = INVALID_LINE_LAYER;
+
+static BOOL sShowProfiler = FALSE;
+
+static UINT32 sGameplayFixesGeneration = 0;
+static OFFSET_FIELD sFramerateDivisorField = INVALID_OFFSET_FIELD;
+
+static INT32 sGameStateSampleRate = GAME_STATE_DEFAULT_RATE;
+
+static PROFILER_ZONE sInitializeZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sGameplayFixesZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sImGuiNewFrameZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sImGuiBuildZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sImGuiRenderZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sUpdateViewportZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sUpdateModelViewProjectionZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sRenderDirectXZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sDefaultGeoZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sShapeBatchZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sLineBatchZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sRenderDrawDataZone = INVALID_PROFILER_ZONE;
+static PROFILER_ZONE sEndUploadFrameZone = INVALID_PROFILER_ZONE;
+
 // TODO
 static FLOAT sScaleFactor = 1.0f;
 static FLOAT sPitchFactor = 1.0f;
@@ -128,12 +162,14 @@ VOID VaGameplayFixes(VOID);
 PVOID VaGetPresentPointer(VOID);
 
 VOID VaCreateConstantBuffers(VOID);
+VOID VaCreateProfilerZones(VOID);
 
 VOID VaUpdateViewport(VOID);
 VOID VaUpdateModelViewProjection(VOID);
 
 VOID VaRenderDirectX(VOID);
 VOID VaRenderImGui(VOID);
+VOID VaRenderProfiler(VOID);
 
 UINT32 VaDetourPresent(IDXGISwapChain* SwapChain, UINT32 SyncInterval, UINT32 Flags);
 
@@ -143,7 +179,12 @@ VOID VaCleanupDirectX(VOID);
 VOID VaCleanupWindow(VOID);
 VOID VaCleanupImGui(VOID);
 
-INT32 WINAPI VaMainThread(PVOID UserParam);
+VOID VaEnableHooks(VOID);
+VOID VaDisableHooks(VOID);
+
+VOID VaReloadOffsets(VOID);
+
+INT32 WINAPI VaControlThread(PVOID UserParam);
 
 /////////////////////////////////////////////////
 // Function Implementation
@@ -176,6 +217,14 @@ UINT64 VaFindModuleBase(LPCSTR ModuleName)
 
 VOID VaReadFromMemory(HANDLE Process, UINT64 Base, UINT64 Size, PVOID Buffer)
 {
+	// Our own pages need no protection changes, the validated region cache turns those into plain copies
+	if (Process == GetCurrentProcess())
+	{
+		VaSafeRead(Base, Buffer, Size);
+
+		return;
+	}
+
 	UINT64 pageBase = ALIGN_PAGE_DOWN(Base);
 	UINT64 pageSize = ALIGN_PAGE_UP(Size);
 
@@ -189,6 +238,12 @@ VOID VaReadFromMemory(HANDLE Process, UINT64 Base, UINT64 Size, PVOID Buffer)
 }
 VOID VaWriteIntoMemory(HANDLE Process, UINT64 Base, UINT64 Size, PVOID Buffer)
 {
+	// Read only pages like patched code still go through the protection change below
+	if ((Process == GetCurrentProcess()) && VaSafeWrite(Base, Buffer, Size))
+	{
+		return;
+	}
+
 	UINT64 pageBase = ALIGN_PAGE_DOWN(Base);
 	UINT64 pageSize = ALIGN_PAGE_UP(Size);
 
@@ -203,7 +258,22 @@ VOID VaWriteIntoMemory(HANDLE Process, UINT64 Base, UINT64 Size, PVOID Buffer)
 
 VOID VaApplyGameplayFixes(VOID)
 {
-	*(PBYTE)(sMainDllBase + 0xB6AC45) = 1; // Framerate divisor (60 / X)
+	VaAcquireOffsets();
+
+	UINT32 generation = VaGetOffsetGeneration();
+
+	if (generation != sGameplayFixesGeneration)
+	{
+		sFramerateDivisorField = VaFindOffsetField("framerate_divisor");
+
+		sGameplayFixesGeneration = generation;
+	}
+
+	BYTE framerateDivisor = 1; // Framerate divisor (60 / X)
+
+	VaWriteOffsetField(sFramerateDivisorField, &framerateDivisor, sizeof(framerateDivisor));
+
+	VaReleaseOffsets();
 }
 
 PVOID VaGetPresentPointer(VOID)
@@ -234,42 +304,59 @@ PVOID VaGetPresentPointer(VOID)
 
 VOID VaCreateConstantBuffers(VOID)
 {
-	D3D11_BUFFER_DESC bufferDescription = { 0 };
-	bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
-	bufferDescription.ByteWidth = sizeof(MODEL_VIEW_PROJECTION);
-	bufferDescription.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	VaCreateConstantBlocks();
 
-	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, NULL, &gModelViewProjectionBuffer));
+	gViewProjectionBlock = VaCreateConstantBlock(sizeof(VIEW_PROJECTION));
+}
+
+VOID VaCreateProfilerZones(VOID)
+{
+	VaCreateProfiler();
+
+	sInitializeZone = VaRegisterProfilerZone("Initialize");
+	sGameplayFixesZone = VaRegisterProfilerZone("Gameplay Fixes");
+	sImGuiNewFrameZone = VaRegisterProfilerZone("ImGui NewFrame");
+	sImGuiBuildZone = VaRegisterProfilerZone("ImGui Build");
+	sImGuiRenderZone = VaRegisterProfilerZone("ImGui Render");
+	sUpdateViewportZone = VaRegisterProfilerZone("Update Viewport");
+	sUpdateModelViewProjectionZone = VaRegisterProfilerZone("Update ModelViewProjection");
+	sRenderDirectXZone = VaRegisterProfilerZone("Render DirectX");
+	sDefaultGeoZone = VaRegisterProfilerZone("Default Geo");
+	sShapeBatchZone = VaRegisterProfilerZone("Shape Batch");
+	sLineBatchZone = VaRegisterProfilerZone("Line Batch");
+	sRenderDrawDataZone = VaRegisterProfilerZone("ImGui RenderDrawData");
+	sEndUploadFrameZone = VaRegisterProfilerZone("End Upload Frame");
 }
 
 VOID VaUpdateViewport(VOID)
 {
-	UINT32 windowWidth = *(PUINT32)(sFlowerKernelDllBase + 0x11C2C0);
-	UINT32 windowHeight = *(PUINT32)(sFlowerKernelDllBase + 0x11C2C4);
+	GAME_STATE state;
+
+	if (!VaReadGameState(&state))
+	{
+		return;
+	}
 
 	D3D11_VIEWPORT viewport = { 0 };
 	viewport.TopLeftX = 0;
 	viewport.TopLeftY = 0;
-	viewport.Width = (FLOAT)windowWidth;
-	viewport.Height = (FLOAT)windowHeight;
+	viewport.Width = (FLOAT)state.WindowWidth;
+	viewport.Height = (FLOAT)state.WindowHeight;
 
 	gDeviceContext->RSSetViewports(1, &viewport);
 }
 VOID VaUpdateModelViewProjection(VOID)
 {
-	if (sAllowModelViewProjectionUpdate)
-	{
-		UINT32 windowWidth = *(PUINT32)(sFlowerKernelDllBase + 0x11C2C0);
-		UINT32 windowHeight = *(PUINT32)(sFlowerKernelDllBase + 0x11C2C4);
-
-		FLOAT aspectRatio = ((FLOAT)windowWidth) / windowHeight;
+	GAME_STATE state;
 
-		UINT64 ammyObjBase = DEREF_POINTER(sMainDllBase + 0xB6B2D0);
+	// Without a player there is nothing to orbit around, the previous matrices stay in place
+	if (sAllowModelViewProjectionUpdate && VaReadGameState(&state) && state.PlayerValid)
+	{
+		FLOAT aspectRatio = ((FLOAT)state.WindowWidth) / state.WindowHeight;
 
-		FLOAT playerX = *(PFLOAT)(ammyObjBase + 0x80);
-		FLOAT playerY = *(PFLOAT)(ammyObjBase + 0x84);
-		FLOAT playerZ = *(PFLOAT)(ammyObjBase + 0x88);
+		FLOAT playerX = state.PlayerX;
+		FLOAT playerY = state.PlayerY;
+		FLOAT playerZ = state.PlayerZ;
 
 		// Center
 		//FLOAT cameraX = *(PFLOAT)(sMainDllBase + 0xB66370);
@@ -288,12 +375,12 @@ VOID VaUpdateModelViewProjection(VOID)
 		//FLOAT cameraY = *(PFLOAT)(sMainDllBase + 0xB665D4);
 		//FLOAT cameraZ = *(PFLOAT)(sMainDllBase + 0xB665D8);
 
-		FLOAT cameraPitch = *(PFLOAT)(sMainDllBase + 0xB66390);
+		FLOAT cameraPitch = state.CameraPitch;
 		//FLOAT cameraPitch = *(PFLOAT)(sMainDllBase + 0xB6659C);
-		FLOAT cameraYaw = *(PFLOAT)(sMainDllBase + 0xB66394);
+		FLOAT cameraYaw = state.CameraYaw;
 
-		FLOAT cameraDistance = *(PFLOAT)(sMainDllBase + 0xB663DC);
-		FLOAT cameraHeight = *(PFLOAT)(sMainDllBase + 0xB663E0);
+		FLOAT cameraDistance = state.CameraDistance;
+		FLOAT cameraHeight = state.CameraHeight;
 
 		playerX *= sScaleFactor;
 		playerY *= sScaleFactor;
@@ -303,7 +390,7 @@ VOID VaUpdateModelViewProjection(VOID)
 		//cameraY *= sScaleFactor;
 		//cameraZ *= sScaleFactor;
 
-		FLOAT fov = *(PFLOAT)(sMainDllBase + 0xB663B0);
+		FLOAT fov = state.Fov;
 
 		VaDrawGrid({ playerX, playerY, playerZ }, 10.0f, 10, { 1.0f, 1.0f, 0.0f, 1.0f }); // TODO
 
@@ -320,7 +407,7 @@ VOID VaUpdateModelViewProjection(VOID)
 		XMVECTOR upDirection = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
 		XMVECTOR forwardDirection = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
 
-		printf("[%f %f] [%f %f %f]\n", cameraPitch, cameraYaw, playerX, playerY, playerZ);
+		VA_LOG_LIMITED(1, "[%f %f] [%f %f %f]", cameraPitch, cameraYaw, playerX, playerY, playerZ);
 
 		// First-Person camera
 		//XMMATRIX rotationMatrix = XMMatrixRotationRollPitchYaw(cameraPitch * sPitchFactor, (cameraYaw + DEG_TO_RAD(sYawOffset)) * sYawFactor, 0.0f);
@@ -348,27 +435,58 @@ VOID VaUpdateModelViewProjection(VOID)
 		view = view * rotationYaw;
 		view = view * rotationPitch;
 
+		XMMATRIX viewProjection = XMMatrixTranspose(view * projection);
+
 		gModelViewProjection.Model = XMMatrixTranspose(model);
 		gModelViewProjection.View = XMMatrixTranspose(view);
 		gModelViewProjection.Projection = XMMatrixTranspose(projection);
+		gModelViewProjection.ViewProjection = viewProjection;
 
-		COPY_INTO_CONSTANT_BUFFER(gModelViewProjectionBuffer, &gModelViewProjection, sizeof(MODEL_VIEW_PROJECTION));
+		// Shaders only ever see the combined matrix, it is uploaded once per change by the first renderer committing it
+		VIEW_PROJECTION block = { viewProjection };
+
+		VaWriteConstantBlock(gViewProjectionBlock, &block);
 	}
 }
 
 VOID VaRenderDirectX(VOID)
 {
-	// TODO
-	VaDrawLine({ -10000.0f, 0.0f, 0.0f }, { 10000.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f });
-	VaDrawLine({ 0.0f, -10000.0f, 0.0f }, { 0.0f, 10000.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 1.0f });
-	VaDrawLine({ 0.0f, 0.0f, -10000.0f }, { 0.0f, 0.0f, 10000.0f }, { 0.0f, 0.0f, 1.0f, 1.0f });
+	VaInvalidatePipelineState();
+
+	// The scenery never changes, it is recorded once and redrawn from its immutable buffers
+	if (VaBeginLineLayer(sSceneryLayer, NULL, 0))
+	{
+		// TODO
+		VaDrawLine({ -10000.0f, 0.0f, 0.0f }, { 10000.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+		VaDrawLine({ 0.0f, -10000.0f, 0.0f }, { 0.0f, 10000.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+		VaDrawLine({ 0.0f, 0.0f, -10000.0f }, { 0.0f, 0.0f, 10000.0f }, { 0.0f, 0.0f, 1.0f, 1.0f });
 
-	// TODO
-	VaDrawGrid({ 0.0f, 0.0f, 0.0f }, 100.0f, 10, { 1.0f, 1.0f, 0.0f, 1.0f });
-	VaDrawGrid({ 0.0f, 0.0f, 0.0f }, 10000.0f, 10, { 1.0f, 1.0f, 0.0f, 1.0f });
+		// TODO
+		VaDrawGrid({ 0.0f, 0.0f, 0.0f }, 100.0f, 10, { 1.0f, 1.0f, 0.0f, 1.0f });
+		VaDrawGrid({ 0.0f, 0.0f, 0.0f }, 10000.0f, 10, { 1.0f, 1.0f, 0.0f, 1.0f });
 
-	VaRenderDefaultGeo();
-	VaRenderLineBatch();
+		VaEndLineLayer();
+	}
+
+	VaDrawLineLayer(sSceneryLayer);
+
+	{
+		PROFILE_SCOPE(sDefaultGeoZone);
+
+		VaRenderDefaultGeo();
+	}
+
+	{
+		PROFILE_SCOPE(sShapeBatchZone);
+
+		VaRenderShapeBatch();
+	}
+
+	{
+		PROFILE_SCOPE(sLineBatchZone);
+
+		VaRenderLineBatch();
+	}
 }
 VOID VaRenderImGui(VOID)
 {
@@ -381,6 +499,45 @@ VOID VaRenderImGui(VOID)
 			sAllowModelViewProjectionUpdate = !sAllowModelViewProjectionUpdate;
 		}
 
+		if (ImGui::MenuItem("Toggle Shape Instancing"))
+		{
+			VaSetShapeInstancing(!VaGetShapeInstancing());
+		}
+
+		if (ImGui::MenuItem("Toggle Profiler"))
+		{
+			sShowProfiler = !sShowProfiler;
+		}
+
+		if (ImGui::MenuItem("Disable Hooks", "F9"))
+		{
+			VaPostControlCommand(CONTROL_COMMAND_DISABLE_HOOKS);
+		}
+
+		if (ImGui::MenuItem("Reload Offsets"))
+		{
+			VaPostControlCommand(CONTROL_COMMAND_RELOAD_CONFIG);
+		}
+
+#if SUSANO_TRACE
+		ImGui::Separator();
+
+		if (ImGui::MenuItem("Arm Trace (Chrome JSON)", NULL, FALSE, !gTraceArmed))
+		{
+			VaArmTrace("susano_trace.json", TRACE_FORMAT_JSON);
+		}
+
+		if (ImGui::MenuItem("Arm Trace (Binary)", NULL, FALSE, !gTraceArmed))
+		{
+			VaArmTrace("susano_trace.bin", TRACE_FORMAT_BINARY);
+		}
+
+		if (ImGui::MenuItem("Disarm Trace", NULL, FALSE, gTraceArmed))
+		{
+			VaDisarmTrace();
+		}
+#endif
+
 		ImGui::EndMenu();
 	}
 
@@ -395,15 +552,225 @@ VOID VaRenderImGui(VOID)
 	ImGui::DragFloat("OrbitalPitch", &sOrbitalPitch, 0.01f, -XM_PI, XM_PI);
 	ImGui::DragFloat("OrbitalYaw", &sOrbitalYaw, 0.01f, -XM_PI, XM_PI);
 
+	LINE_BATCH_STATISTICS lineBatchStatistics = { 0 };
+
+	VaGetLineBatchStatistics(&lineBatchStatistics);
+
+	ImGui::Separator();
+
+	ImGui::Text("Line Batch Chunks: %u (%llu KiB)", lineBatchStatistics.ChunkCount, lineBatchStatistics.AllocatedBytes / 1024);
+	ImGui::Text("Line Batch Draws: %u", lineBatchStatistics.DrawCount);
+	ImGui::Text("Line Batch Vertices: %llu", lineBatchStatistics.VertexCount);
+	ImGui::Text("Line Batch Indices: %llu", lineBatchStatistics.IndexCount);
+	ImGui::Text("Line Batch Upload: %llu B non-indexed, %llu B indexed", lineBatchStatistics.NonIndexedBytes, lineBatchStatistics.IndexedBytes);
+	ImGui::Text("Line Layers: %u draws, %llu vertices", lineBatchStatistics.LayerDrawCount, lineBatchStatistics.LayerVertexCount);
+	ImGui::Text("Line Producers: %u (%u deferred, %u retired, %u trimmed)", lineBatchStatistics.ProducerCount, lineBatchStatistics.DeferredProducerCount, lineBatchStatistics.RetiredProducerCount, lineBatchStatistics.TrimmedProducerCount);
+	ImGui::Text("Line Primitives: %llu kept, %llu culled", lineBatchStatistics.KeptPrimitiveCount, lineBatchStatistics.CulledPrimitiveCount);
+
+	SHAPE_BATCH_STATISTICS shapeBatchStatistics = { 0 };
+
+	VaGetShapeBatchStatistics(&shapeBatchStatistics);
+
+	ImGui::Text("Shapes: %u instances, %u draws, %llu B (%s)", shapeBatchStatistics.InstanceCount, shapeBatchStatistics.DrawCount, shapeBatchStatistics.UploadedBytes, VaGetShapeInstancing() ? "instanced" : "expanded");
+
+	DEFAULT_GEO_STATISTICS defaultGeoStatistics = { 0 };
+
+	VaGetDefaultGeoStatistics(&defaultGeoStatistics);
+
+	ImGui::Text("Meshes: %u registered, %u draws, %llu indices", defaultGeoStatistics.MeshCount, defaultGeoStatistics.DrawCount, defaultGeoStatistics.IndexCount);
+
+	PIPELINE_CACHE_STATISTICS pipelineCacheStatistics = { 0 };
+
+	VaGetPipelineCacheStatistics(&pipelineCacheStatistics);
+
+	ImGui::Text("Pipelines: %u (%u shaders, %u layouts)", pipelineCacheStatistics.PipelineCount, pipelineCacheStatistics.ShaderCount, pipelineCacheStatistics.InputLayoutCount);
+	ImGui::Text("State Changes: %u issued, %u skipped", pipelineCacheStatistics.StateChangeCount, pipelineCacheStatistics.SkippedStateChangeCount);
+
+	CONSTANT_BLOCK_STATISTICS constantBlockStatistics = { 0 };
+
+	VaGetConstantBlockStatistics(&constantBlockStatistics);
+
+	ImGui::Text("Constant Blocks: %u blocks, %u writes, %u uploads, %u skipped", constantBlockStatistics.BlockCount, constantBlockStatistics.WriteCount, constantBlockStatistics.UploadCount, constantBlockStatistics.SkippedUploadCount);
+
+	UPLOAD_RING_STATISTICS uploadRingStatistics = { 0 };
+
+	VaGetUploadRingStatistics(&uploadRingStatistics);
+
+	ImGui::Text("Upload Ring: %llu / %llu KiB, %u frames in flight", uploadRingStatistics.UsedBytes / 1024, uploadRingStatistics.Capacity / 1024, uploadRingStatistics.InFlightFrameCount);
+	ImGui::Text("Upload Ring: %u grows, %u waits", uploadRingStatistics.GrowCount, uploadRingStatistics.WaitCount);
+	ImGui::Text("Upload Cache: %llu hits, %llu misses", uploadRingStatistics.HitCount, uploadRingStatistics.MissCount);
+	ImGui::Text("Upload Cache: %llu KiB skipped, %llu KiB uploaded", uploadRingStatistics.SkippedBytes / 1024, uploadRingStatistics.UploadedBytes / 1024);
+
+	GAME_STATE_STATISTICS gameStateStatistics = { 0 };
+
+	VaGetGameStateStatistics(&gameStateStatistics);
+
+	ImGui::Text("Game State: %llu samples, %llu reads, %llu retries", gameStateStatistics.SampleCount, gameStateStatistics.ReadCount, gameStateStatistics.RetryCount);
+
+	if (ImGui::SliderInt("Sample Rate", &sGameStateSampleRate, 1, 1000))
+	{
+		VaSetGameStateSampleRate(sGameStateSampleRate);
+	}
+
+	OFFSET_STATISTICS offsetStatistics = { 0 };
+
+	VaGetOffsetStatistics(&offsetStatistics);
+
+	ImGui::Text("Offsets: %u/%u resolved, %u/%u signatures, generation %u, %llu walks (%s)", offsetStatistics.ResolvedCount, offsetStatistics.FieldCount, offsetStatistics.FoundSignatureCount, offsetStatistics.SignatureCount, offsetStatistics.Generation, offsetStatistics.WalkCount, offsetStatistics.Embedded ? "embedded" : OFFSET_SCHEMA_PATH);
+
+	SCANNER_STATISTICS scannerStatistics = { 0 };
+
+	VaGetScannerStatistics(&scannerStatistics);
+
+	ImGui::Text("Scanner: %llu KiB in %.2f ms (%s), %llu candidates, %llu matches", scannerStatistics.ScannedBytes / 1024, scannerStatistics.ScanTime / 1000000.0, scannerStatistics.Avx2 ? "AVX2" : "scalar", scannerStatistics.CandidateCount, scannerStatistics.MatchCount);
+
+	SCAN_CACHE_STATISTICS scanCacheStatistics = { 0 };
+
+	VaGetScanCacheStatistics(&scanCacheStatistics);
+
+	ImGui::Text("Scan Cache: %u entries, %llu hits, %llu misses, %llu invalidated, hashed in %.2f ms", scanCacheStatistics.EntryCount, scanCacheStatistics.HitCount, scanCacheStatistics.MissCount, scanCacheStatistics.InvalidatedCount, scanCacheStatistics.HashTime / 1000000.0);
+
+	SAFE_MEMORY_STATISTICS safeMemoryStatistics = { 0 };
+
+	VaGetSafeMemoryStatistics(&safeMemoryStatistics);
+
+	ImGui::Text("Safe Memory: %u regions, %llu hits, %llu misses, %llu queries, %llu rejected, %llu faults", safeMemoryStatistics.RegionCount, safeMemoryStatistics.HitCount, safeMemoryStatistics.MissCount, safeMemoryStatistics.QueryCount, safeMemoryStatistics.RejectCount, safeMemoryStatistics.FaultCount);
+
+	TELEMETRY_STATISTICS telemetryStatistics = { 0 };
+
+	VaGetTelemetryStatistics(&telemetryStatistics);
+
+	ImGui::Text("Telemetry: %llu published, %llu dropped, %u pending (%s)", telemetryStatistics.PublishedCount, telemetryStatistics.DroppedCount, telemetryStatistics.PendingCount, telemetryStatistics.Mapped ? TELEMETRY_MAPPING_NAME : "unmapped");
+
+	CONTROL_STATISTICS controlStatistics = { 0 };
+
+	VaGetControlStatistics(&controlStatistics);
+
+	ImGui::Text("Control: %llu commands, %llu task runs, %llu wakes", controlStatistics.CommandCount, controlStatistics.TaskRunCount, controlStatistics.WakeCount);
+
+	LOG_STATISTICS loggerStatistics = { 0 };
+
+	VaGetLoggerStatistics(&loggerStatistics);
+
+	ImGui::Text("Log: %llu written, %llu dropped, %llu suppressed", loggerStatistics.WrittenCount, loggerStatistics.DroppedCount, loggerStatistics.SuppressedCount);
+
+#if SUSANO_TRACE
+	TRACE_STATISTICS traceStatistics = { 0 };
+
+	VaGetTraceStatistics(&traceStatistics);
+
+	ImGui::Text("Trace: %s, %u threads, %llu events, %llu dropped, %llu KiB", traceStatistics.Armed ? "armed" : "disarmed", traceStatistics.ThreadCount, traceStatistics.EventCount, traceStatistics.DroppedCount, traceStatistics.WrittenBytes / 1024);
+#endif
+
+	ImGui::End();
+
+	if (sShowProfiler)
+	{
+		VaRenderProfiler();
+	}
+}
+VOID VaRenderProfiler(VOID)
+{
+	ImGui::Begin("Profiler", &sShowProfiler);
+
+	// The frame currently being recorded is incomplete, the graph always shows the previous one
+	const PROFILER_FRAME* frame = VaGetProfilerFrame(0);
+
+	if (frame && (frame->Duration > 0))
+	{
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+
+		FLOAT width = ImGui::GetContentRegionAvail().x;
+		FLOAT rowHeight = ImGui::GetTextLineHeightWithSpacing();
+		FLOAT scale = width / (FLOAT)frame->Duration;
+
+		UINT32 zoneCount = VaGetProfilerZoneCount();
+		UINT32 depthCount = 1;
+
+		for (UINT32 i = 0; i < frame->SampleCount; i++)
+		{
+			const PROFILER_SAMPLE* sample = &frame->Samples[i];
+
+			LPCSTR name = VaGetProfilerZoneName(sample->Zone);
+
+			ImVec2 rectMin = ImVec2(origin.x + ((FLOAT)sample->Start * scale), origin.y + ((FLOAT)sample->Depth * rowHeight));
+			ImVec2 rectMax = ImVec2(origin.x + ((FLOAT)sample->End * scale), rectMin.y + rowHeight - 1.0f);
+
+			drawList->AddRectFilled(rectMin, rectMax, ImColor::HSV((FLOAT)sample->Zone / (FLOAT)zoneCount, 0.6f, 0.6f));
+
+			drawList->PushClipRect(rectMin, rectMax, TRUE);
+			drawList->AddText(ImVec2(rectMin.x + 2.0f, rectMin.y), IM_COL32_WHITE, name);
+			drawList->PopClipRect();
+
+			if (ImGui::IsMouseHoveringRect(rectMin, rectMax))
+			{
+				ImGui::SetTooltip("%s %.3f ms", name, (FLOAT)(sample->End - sample->Start) / 1000000.0f);
+			}
+
+			depthCount = max(depthCount, sample->Depth + 1);
+		}
+
+		ImGui::Dummy(ImVec2(width, (FLOAT)depthCount * rowHeight));
+	}
+
+	if (ImGui::BeginTable("Zones", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Zone");
+		ImGui::TableSetupColumn("Min (ms)");
+		ImGui::TableSetupColumn("Mean (ms)");
+		ImGui::TableSetupColumn("P99 (ms)");
+		ImGui::TableHeadersRow();
+
+		PROFILER_STATISTICS statistics = { 0 };
+
+		VaGetProfilerFrameStatistics(&statistics);
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn(); ImGui::Text("Frame");
+		ImGui::TableNextColumn(); ImGui::Text("%.3f", (FLOAT)statistics.Minimum / 1000000.0f);
+		ImGui::TableNextColumn(); ImGui::Text("%.3f", (FLOAT)statistics.Mean / 1000000.0f);
+		ImGui::TableNextColumn(); ImGui::Text("%.3f", (FLOAT)statistics.P99 / 1000000.0f);
+
+		for (UINT32 i = 0; i < VaGetProfilerZoneCount(); i++)
+		{
+			VaGetProfilerZoneStatistics(i, &statistics);
+
+			if (statistics.FrameCount == 0)
+			{
+				continue;
+			}
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%s", VaGetProfilerZoneName(i));
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", (FLOAT)statistics.Minimum / 1000000.0f);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", (FLOAT)statistics.Mean / 1000000.0f);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", (FLOAT)statistics.P99 / 1000000.0f);
+		}
+
+		ImGui::EndTable();
+	}
+
 	ImGui::End();
 }
 
 UINT32 VaDetourPresent(IDXGISwapChain* SwapChain, UINT32 SyncInterval, UINT32 Flags)
 {
-	VaApplyGameplayFixes();
+	TRACE_ZONE("Present");
+
+	VaBeginProfilerFrame();
+
+	{
+		PROFILE_SCOPE(sGameplayFixesZone);
+
+		VaApplyGameplayFixes();
+	}
 
 	if (!sPresentInitialized)
 	{
+		PROFILE_SCOPE(sInitializeZone);
+
 		sPresentInitialized = TRUE;
 
 		HR_CHECK(SwapChain->GetDevice(__uuidof(ID3D11Device), (PVOID*)&gDevice));
@@ -434,39 +801,102 @@ UINT32 VaDetourPresent(IDXGISwapChain* SwapChain, UINT32 SyncInterval, UINT32 Fl
 		ImGui_ImplWin32_Init(sWindow);
 		ImGui_ImplDX11_Init(gDevice, gDeviceContext);
 
+		VaCreatePipelineCache();
+		VaCreateUploadRing();
+		VaCreateConstantBuffers();
+
 		VaCreateLineBatchRenderer();
 		VaCreateDefaultGeoRenderer();
+		VaCreateShapeRenderer();
 
-		VaCreateConstantBuffers();
+		sSceneryLayer = VaCreateLineLayer();
 	}
 
-	ImGui_ImplDX11_NewFrame();
-	ImGui_ImplWin32_NewFrame();
+	{
+		PROFILE_SCOPE(sImGuiNewFrameZone);
+
+		ImGui_ImplDX11_NewFrame();
+		ImGui_ImplWin32_NewFrame();
 
-	ImGui::NewFrame();
+		ImGui::NewFrame();
+	}
 
-	VaRenderImGui();
+	{
+		PROFILE_SCOPE(sImGuiBuildZone);
 
-	ImGui::Render();
+		VaRenderImGui();
+	}
+
+	{
+		PROFILE_SCOPE(sImGuiRenderZone);
+
+		ImGui::Render();
+	}
 
 	gDeviceContext->OMSetRenderTargets(1, &gMainRenderTargetView, NULL);
 
-	VaUpdateViewport();
-	VaUpdateModelViewProjection();
+	VaResetConstantBlockStatistics();
+
+	VaBeginUploadFrame();
+
+	{
+		PROFILE_SCOPE(sUpdateViewportZone);
 
-	VaRenderDirectX();
+		VaUpdateViewport();
+	}
 
-	ImDrawData* drawData = ImGui::GetDrawData();
+	{
+		PROFILE_SCOPE(sUpdateModelViewProjectionZone);
 
-	ImGui_ImplDX11_RenderDrawData(drawData);
+		VaUpdateModelViewProjection();
+	}
 
-	return sPresentNew(SwapChain, SyncInterval, Flags);
+	{
+		PROFILE_SCOPE(sRenderDirectXZone);
+
+		VaRenderDirectX();
+	}
+
+	{
+		PROFILE_SCOPE(sRenderDrawDataZone);
+
+		ImDrawData* drawData = ImGui::GetDrawData();
+
+		ImGui_ImplDX11_RenderDrawData(drawData);
+	}
+
+	{
+		PROFILE_SCOPE(sEndUploadFrameZone);
+
+		VaEndUploadFrame();
+	}
+
+	// The original present is the game's cost, the profiled frame ends right before it
+	VaEndProfilerFrame();
+
+	VaPublishTelemetryFrame();
+
+	UINT32 result = 0;
+
+	{
+		TRACE_ZONE("Original Present");
+
+		result = sPresentNew(SwapChain, SyncInterval, Flags);
+	}
+
+	return result;
 }
 
 LRESULT VaWindowProc(HWND Window, UINT Msg, WPARAM WParam, LPARAM LParam)
 {
 	ShowCursor(TRUE);
 
+	// The window procedure stays subclassed while the hooks are off, so the hotkey can bring them back
+	if ((Msg == WM_KEYDOWN) && (WParam == VK_F9) && !(LParam & (1 << 30)))
+	{
+		VaPostControlCommand(sHooksEnabled ? CONTROL_COMMAND_DISABLE_HOOKS : CONTROL_COMMAND_ENABLE_HOOKS);
+	}
+
 	if (ImGui_ImplWin32_WndProcHandler(Window, Msg, WParam, LParam))
 	{
 		return TRUE;
@@ -478,9 +908,13 @@ LRESULT VaWindowProc(HWND Window, UINT Msg, WPARAM WParam, LPARAM LParam)
 VOID VaCleanupDirectX(VOID)
 {
 	VaDestroyDefaultGeoRenderer();
+	VaDestroyShapeRenderer();
 	VaDestroyLineBatchRenderer();
 
-	gModelViewProjectionBuffer->Release();
+	VaDestroyUploadRing();
+	VaDestroyPipelineCache();
+
+	VaDestroyConstantBlocks();
 	gMainRenderTargetView->Release();
 }
 VOID VaCleanupWindow(VOID)
@@ -495,28 +929,84 @@ VOID VaCleanupImGui(VOID)
 	ImGui::DestroyContext(sImGuiContext);
 }
 
-INT32 WINAPI VaMainThread(PVOID UserParam)
+VOID VaEnableHooks(VOID)
+{
+	if (!sHooksEnabled)
+	{
+		MH_EnableHook(sPresentOld);
+
+		sHooksEnabled = TRUE;
+
+		VA_LOG("Hooks enabled");
+	}
+}
+VOID VaDisableHooks(VOID)
+{
+	if (sHooksEnabled)
+	{
+		MH_DisableHook(sPresentOld);
+
+		sHooksEnabled = FALSE;
+
+		VA_LOG("Hooks disabled");
+	}
+}
+
+VOID VaReloadOffsets(VOID)
+{
+	VaLoadOffsetSchema(OFFSET_SCHEMA_PATH);
+}
+
+INT32 WINAPI VaControlThread(PVOID UserParam)
 {
 	VaCreateConsole();
+	VaCreateLogger("susano.log");
 
 	sOkamiExeBase = VaFindModuleBase("okami.exe");
 	sFlowerKernelDllBase = VaFindModuleBase("flower_kernel.dll");
 	sMainDllBase = VaFindModuleBase("main.dll");
 
+	VaCreateSafeMemory();
+	VaOpenScanCache(SCAN_CACHE_PATH);
+
+	VaCreateOffsets(VaFindModuleBase);
+	VaLoadOffsetSchema(OFFSET_SCHEMA_PATH);
+
+	VaCreateGameStateSampler();
+	VaCreateTelemetry();
+
 	sPresentOld = (PRESENT_PROC)VaGetPresentPointer();
 
+	VaCreateProfilerZones();
+
+	VaSetControlHandler(CONTROL_COMMAND_ENABLE_HOOKS, VaEnableHooks);
+	VaSetControlHandler(CONTROL_COMMAND_DISABLE_HOOKS, VaDisableHooks);
+	VaSetControlHandler(CONTROL_COMMAND_RELOAD_CONFIG, VaReloadOffsets);
+
+	VaRegisterControlTask(VaFlushLogger, LOG_FLUSH_INTERVAL);
+
 	MH_Initialize();
 	
 	MH_CreateHook(sPresentOld, VaDetourPresent, (PVOID*)&sPresentNew);
-	MH_EnableHook(sPresentOld);
 
-	while (sRunning);
+	VaEnableHooks();
+
+	// Blocks until the dll detaches, the thread only wakes for commands and due tasks
+	VaRunControlLoop();
+
+	VaDisableHooks();
 
-	MH_DisableHook(sPresentOld);
 	MH_RemoveHook(sPresentOld);
 
 	MH_Uninitialize();
 
+	VaDestroyTelemetry();
+	VaDestroyGameStateSampler();
+	VaDestroyOffsets();
+	VaCloseScanCache();
+	VaDestroySafeMemory();
+	VaDestroyTrace();
+
 	if (sPresentInitialized)
 	{
 		VaCleanupDirectX();
@@ -524,9 +1014,10 @@ INT32 WINAPI VaMainThread(PVOID UserParam)
 		VaCleanupImGui();
 	}
 
+	VaDestroyLogger();
 	VaDestroyConsole();
 
-	SetEvent(sMainThreadExitEvent);
+	SetEvent(sControlThreadExitEvent);
 
 	return 0;
 }
@@ -541,19 +1032,23 @@ BOOL APIENTRY DllMain(HMODULE Module, UINT32 CallReason, PVOID Reserved)
 	{
 		case DLL_PROCESS_ATTACH:
 		{
-			sMainThreadExitEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
-			sMainThread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)VaMainThread, Module, 0, NULL);
+			VaCreateControl();
+
+			sControlThreadExitEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+			sControlThread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)VaControlThread, Module, 0, NULL);
 
 			break;
 		}
 		case DLL_PROCESS_DETACH:
 		{
-			sRunning = FALSE;
+			VaRequestControlExit();
+
+			WaitForSingleObject(sControlThreadExitEvent, INFINITE);
 
-			WaitForSingleObject(sMainThreadExitEvent, INFINITE);
+			CloseHandle(sControlThread);
+			CloseHandle(sControlThreadExitEvent);
 
-			CloseHandle(sMainThread);
-			CloseHandle(sMainThreadExitEvent);
+			VaDestroyControl();
 		}
 	}
 
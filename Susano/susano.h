@@ -2,6 +2,9 @@
 
 #include <d3d11.h>
 #include <directxmath.h>
+#include <directxpackedvector.h>
+
+#include "constantblocks.h"
 
 using namespace DirectX;
 
@@ -9,11 +12,26 @@ using namespace DirectX;
 // Type Definition
 /////////////////////////////////////////////////
 
+// All matrices are stored transposed, ViewProjection is the product of View and Projection
 struct MODEL_VIEW_PROJECTION
 {
     XMMATRIX Model;
     XMMATRIX View;
     XMMATRIX Projection;
+    XMMATRIX ViewProjection;
+};
+
+// Constant block b0, shared by every overlay shader
+struct VIEW_PROJECTION
+{
+    XMMATRIX ViewProjection;
+};
+
+// 16 bytes, the color is stored as R8G8B8A8_UNORM
+struct VERTEX
+{
+    XMFLOAT3 Position;
+    UINT32 Color;
 };
 
 /////////////////////////////////////////////////
@@ -23,6 +41,20 @@ struct MODEL_VIEW_PROJECTION
 extern ID3D11Device* gDevice;
 extern ID3D11DeviceContext* gDeviceContext;
 extern ID3D11RenderTargetView* gMainRenderTargetView;
-extern ID3D11Buffer* gModelViewProjectionBuffer;
 
-extern MODEL_VIEW_PROJECTION gModelViewProjection;
\ No newline at end of file
+extern CONSTANT_BLOCK gViewProjectionBlock;
+
+extern MODEL_VIEW_PROJECTION gModelViewProjection;
+
+/////////////////////////////////////////////////
+// Inline Functions
+/////////////////////////////////////////////////
+
+inline UINT32 VaPackColor(XMFLOAT4 Color)
+{
+    PackedVector::XMUBYTEN4 packed;
+
+    PackedVector::XMStoreUByteN4(&packed, XMLoadFloat4(&Color));
+
+    return packed.v;
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include <string.h>
+
+#include <atomic>
+
+#include "profiler.h"
+#include "gamestate.h"
+#include "linebatchrenderer.h"
+#include "shaperenderer.h"
+#include "defaultgeorenderer.h"
+#include "telemetry.h"
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static_assert(PROFILER_ZONE_COUNT <= TELEMETRY_ZONE_COUNT, "Every profiler zone needs a telemetry slot");
+static_assert((TELEMETRY_FRAME_COUNT & (TELEMETRY_FRAME_COUNT - 1)) == 0, "Ring indices wrap with a mask");
+
+static HANDLE sMapping = NULL;
+
+static TELEMETRY_RING* sRing = NULL;
+
+static UINT64 sFrameIndex = 0;
+
+static UINT64 sPublishedCount = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaPublishTelemetryZoneNames(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateTelemetry(VOID)
+{
+	sMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(TELEMETRY_RING), TELEMETRY_MAPPING_NAME);
+
+	if (!sMapping)
+	{
+		return;
+	}
+
+	sRing = (TELEMETRY_RING*)MapViewOfFile(sMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(TELEMETRY_RING));
+
+	if (!sRing)
+	{
+		CloseHandle(sMapping);
+
+		sMapping = NULL;
+
+		return;
+	}
+
+	// A consumer that outlived an earlier injection keeps the mapping and its read position alive, a fresh one or one of another layout is set up
+	if ((sRing->Magic != TELEMETRY_MAGIC) || (sRing->Version != TELEMETRY_VERSION) || (sRing->FrameSize != sizeof(TELEMETRY_FRAME)) || (sRing->FrameCount != TELEMETRY_FRAME_COUNT))
+	{
+		sRing->Magic = 0;
+
+		std::atomic_thread_fence(std::memory_order_release);
+
+		sRing->Version = TELEMETRY_VERSION;
+		sRing->FrameSize = sizeof(TELEMETRY_FRAME);
+		sRing->FrameCount = TELEMETRY_FRAME_COUNT;
+		sRing->ZoneCount = 0;
+
+		WriteNoFence64(&sRing->WriteIndex, 0);
+		WriteNoFence64(&sRing->DroppedCount, 0);
+		WriteNoFence64(&sRing->ReadIndex, 0);
+
+		std::atomic_thread_fence(std::memory_order_release);
+
+		sRing->Magic = TELEMETRY_MAGIC;
+	}
+}
+VOID VaDestroyTelemetry(VOID)
+{
+	if (sRing)
+	{
+		UnmapViewOfFile(sRing);
+
+		sRing = NULL;
+	}
+
+	if (sMapping)
+	{
+		CloseHandle(sMapping);
+
+		sMapping = NULL;
+	}
+}
+
+VOID VaPublishTelemetryFrame(VOID)
+{
+	if (!sRing)
+	{
+		return;
+	}
+
+	sFrameIndex += 1;
+
+	if (sRing->ZoneCount != VaGetProfilerZoneCount())
+	{
+		VaPublishTelemetryZoneNames();
+	}
+
+	LONG64 writeIndex = sRing->WriteIndex;
+
+	// A slow or missing consumer costs dropped frames, never time on the render thread
+	if ((writeIndex - ReadAcquire64(&sRing->ReadIndex)) >= TELEMETRY_FRAME_COUNT)
+	{
+		WriteNoFence64(&sRing->DroppedCount, sRing->DroppedCount + 1);
+
+		return;
+	}
+
+	// Filled in place, the consumer does not look at the slot before the write index moves past it
+	TELEMETRY_FRAME* frame = &sRing->Frames[writeIndex & (TELEMETRY_FRAME_COUNT - 1)];
+
+	memset(frame, 0, sizeof(TELEMETRY_FRAME));
+
+	frame->FrameIndex = sFrameIndex;
+	frame->Time = VaQueryProfilerTime();
+
+	const PROFILER_FRAME* profilerFrame = VaGetProfilerFrame(0);
+
+	if (profilerFrame)
+	{
+		frame->Duration = profilerFrame->Duration;
+		frame->ZoneMask = profilerFrame->ZoneMask;
+
+		memcpy(frame->ZoneTimes, profilerFrame->ZoneTimes, sizeof(profilerFrame->ZoneTimes));
+	}
+
+	GAME_STATE state;
+
+	if (VaReadGameState(&state))
+	{
+		frame->PlayerValid = state.PlayerValid;
+		frame->PlayerX = state.PlayerX;
+		frame->PlayerY = state.PlayerY;
+		frame->PlayerZ = state.PlayerZ;
+		frame->CameraPitch = state.CameraPitch;
+		frame->CameraYaw = state.CameraYaw;
+		frame->CameraDistance = state.CameraDistance;
+		frame->CameraHeight = state.CameraHeight;
+		frame->Fov = state.Fov;
+	}
+
+	LINE_BATCH_STATISTICS lineBatchStatistics = { 0 };
+	SHAPE_BATCH_STATISTICS shapeBatchStatistics = { 0 };
+	DEFAULT_GEO_STATISTICS defaultGeoStatistics = { 0 };
+
+	VaGetLineBatchStatistics(&lineBatchStatistics);
+	VaGetShapeBatchStatistics(&shapeBatchStatistics);
+	VaGetDefaultGeoStatistics(&defaultGeoStatistics);
+
+	frame->LineDrawCount = lineBatchStatistics.DrawCount;
+	frame->LineVertexCount = lineBatchStatistics.VertexCount;
+	frame->ShapeInstanceCount = shapeBatchStatistics.InstanceCount;
+	frame->ShapeDrawCount = shapeBatchStatistics.DrawCount;
+	frame->GeoDrawCount = defaultGeoStatistics.DrawCount;
+
+	WriteRelease64(&sRing->WriteIndex, writeIndex + 1);
+
+	sPublishedCount += 1;
+}
+
+VOID VaGetTelemetryStatistics(TELEMETRY_STATISTICS* Statistics)
+{
+	Statistics->Mapped = (sRing != NULL);
+	Statistics->PublishedCount = sPublishedCount;
+	Statistics->DroppedCount = sRing ? (UINT64)sRing->DroppedCount : 0;
+	Statistics->PendingCount = sRing ? (UINT32)(sRing->WriteIndex - ReadAcquire64(&sRing->ReadIndex)) : 0;
+}
+
+static VOID VaPublishTelemetryZoneNames(VOID)
+{
+	UINT32 zoneCount = VaGetProfilerZoneCount();
+
+	// A consumer never trusts more names than the count it read, so the count is taken away before any name changes
+	sRing->ZoneCount = 0;
+
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (UINT32 i = 0; i < zoneCount; i++)
+	{
+		strncpy_s(sRing->ZoneNames[i], TELEMETRY_ZONE_NAME_LENGTH, VaGetProfilerZoneName(i), _TRUNCATE);
+	}
+
+	std::atomic_thread_fence(std::memory_order_release);
+
+	sRing->ZoneCount = zoneCount;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <windows.h>
+
+// The layout below is shared with external consumers, any change to it has to bump the version
+#define TELEMETRY_MAPPING_NAME "Local\\SusanoTelemetry"
+
+#define TELEMETRY_MAGIC (0x4D4C4554)
+#define TELEMETRY_VERSION (1)
+
+#define TELEMETRY_FRAME_COUNT (256)
+
+#define TELEMETRY_ZONE_COUNT (32)
+#define TELEMETRY_ZONE_NAME_LENGTH (32)
+
+// One presented frame, times are nanoseconds
+struct TELEMETRY_FRAME
+{
+	UINT64 FrameIndex;
+	UINT64 Time;
+	UINT64 Duration;
+	UINT64 ZoneTimes[TELEMETRY_ZONE_COUNT];
+	UINT32 ZoneMask;
+	BOOL PlayerValid;
+	FLOAT PlayerX;
+	FLOAT PlayerY;
+	FLOAT PlayerZ;
+	FLOAT CameraPitch;
+	FLOAT CameraYaw;
+	FLOAT CameraDistance;
+	FLOAT CameraHeight;
+	FLOAT Fov;
+	UINT32 LineDrawCount;
+	UINT32 ShapeInstanceCount;
+	UINT32 ShapeDrawCount;
+	UINT32 GeoDrawCount;
+	UINT64 LineVertexCount;
+};
+
+// Single producer single consumer, each side only ever writes its own index and both live on their own cache line
+struct TELEMETRY_RING
+{
+	UINT32 Magic;
+	UINT32 Version;
+	UINT32 FrameSize;
+	UINT32 FrameCount;
+	volatile UINT32 ZoneCount;
+	CHAR ZoneNames[TELEMETRY_ZONE_COUNT][TELEMETRY_ZONE_NAME_LENGTH];
+	alignas(64) volatile LONG64 WriteIndex;
+	volatile LONG64 DroppedCount;
+	alignas(64) volatile LONG64 ReadIndex;
+	alignas(64) TELEMETRY_FRAME Frames[TELEMETRY_FRAME_COUNT];
+};
+
+struct TELEMETRY_STATISTICS
+{
+	BOOL Mapped;
+	UINT64 PublishedCount;
+	UINT64 DroppedCount;
+	UINT32 PendingCount;
+};
+
+VOID VaCreateTelemetry(VOID);
+VOID VaDestroyTelemetry(VOID);
+
+// Snapshots the game state, the last profiled frame and the overlay statistics, a full ring drops the frame instead of waiting
+VOID VaPublishTelemetryFrame(VOID);
+
+VOID VaGetTelemetryStatistics(TELEMETRY_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,397 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "profiler.h"
+#include "trace.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define TRACE_BUFFER_SIZE (8192)
+#define TRACE_NAME_COUNT (256)
+
+#define TRACE_FLUSH_INTERVAL (50)
+
+#define TRACE_BINARY_MAGIC (0x52545553) // SUTR
+#define TRACE_BINARY_VERSION (1)
+
+#define TRACE_RECORD_NAME (0)
+#define TRACE_RECORD_EVENT (1)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+struct TRACE_EVENT
+{
+	LPCSTR Name;
+	UINT64 Start;
+	UINT64 End;
+};
+
+// Single producer is the owning thread, single consumer is the flusher, neither ever takes a lock
+struct TRACE_THREAD_BUFFER
+{
+	TRACE_THREAD_BUFFER* Next;
+	UINT32 ThreadId;
+	volatile LONG64 Head;
+	volatile LONG64 Tail;
+	volatile LONG64 DroppedCount;
+	TRACE_EVENT Events[TRACE_BUFFER_SIZE];
+};
+
+/////////////////////////////////////////////////
+// Global Variables
+/////////////////////////////////////////////////
+
+volatile BOOL gTraceArmed = FALSE;
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+// Buffers are only ever pushed, they live until the trace is destroyed
+static TRACE_THREAD_BUFFER* volatile sBuffers = NULL;
+
+static thread_local TRACE_THREAD_BUFFER* tBuffer = NULL;
+
+// The flusher owns the file until it signals the done event, nobody ever waits on the thread itself
+static HANDLE sFlushStopEvent = NULL;
+static HANDLE sFlushDoneEvent = NULL;
+
+static FILE* sFile = NULL;
+
+static TRACE_FORMAT sFormat = TRACE_FORMAT_JSON;
+
+static BOOL sFirstEvent = TRUE;
+
+static LPCSTR sNames[TRACE_NAME_COUNT] = { 0 };
+
+static UINT32 sNameCount = 0;
+
+static UINT64 sStartTime = 0;
+
+static TRACE_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static TRACE_THREAD_BUFFER* VaCreateThreadBuffer(VOID);
+
+static INT32 WINAPI VaFlushThread(PVOID UserParam);
+
+static VOID VaFlushBuffers(VOID);
+static VOID VaFinalizeFile(VOID);
+static VOID VaCloseFlushEvents(VOID);
+
+static VOID VaWriteJsonEvent(const TRACE_EVENT* Event, UINT32 ThreadId);
+static VOID VaWriteBinaryEvent(const TRACE_EVENT* Event, UINT32 ThreadId);
+
+static VOID VaWriteBytes(const VOID* Data, UINT32 Size);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaDestroyTrace(VOID)
+{
+	VaDisarmTrace();
+
+	// The flusher signals right before it returns, its thread handle would only be released under the loader lock
+	if (sFlushDoneEvent)
+	{
+		WaitForSingleObject(sFlushDoneEvent, INFINITE);
+	}
+
+	VaCloseFlushEvents();
+
+	TRACE_THREAD_BUFFER* buffer = sBuffers;
+
+	while (buffer)
+	{
+		TRACE_THREAD_BUFFER* next = buffer->Next;
+
+		VirtualFree(buffer, 0, MEM_RELEASE);
+
+		buffer = next;
+	}
+
+	sBuffers = NULL;
+}
+
+BOOL VaArmTrace(LPCSTR FilePath, TRACE_FORMAT Format)
+{
+	if (gTraceArmed)
+	{
+		return FALSE;
+	}
+
+	// A previous capture is still being finalized by its flusher
+	if (sFlushDoneEvent && (WaitForSingleObject(sFlushDoneEvent, 0) == WAIT_TIMEOUT))
+	{
+		return FALSE;
+	}
+
+	VaCloseFlushEvents();
+
+	if (fopen_s(&sFile, FilePath, (Format == TRACE_FORMAT_JSON) ? "w" : "wb") != 0)
+	{
+		sFile = NULL;
+
+		return FALSE;
+	}
+
+	sFormat = Format;
+	sFirstEvent = TRUE;
+	sNameCount = 0;
+	sStartTime = VaQueryTraceTime();
+
+	memset(&sStatistics, 0, sizeof(sStatistics));
+
+	// Whatever is left from a previous capture is discarded
+	for (TRACE_THREAD_BUFFER* buffer = sBuffers; buffer; buffer = buffer->Next)
+	{
+		buffer->Tail = buffer->Head;
+		buffer->DroppedCount = 0;
+	}
+
+	if (sFormat == TRACE_FORMAT_JSON)
+	{
+		fprintf(sFile, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	}
+	else
+	{
+		UINT32 header[] = { TRACE_BINARY_MAGIC, TRACE_BINARY_VERSION };
+
+		VaWriteBytes(header, sizeof(header));
+	}
+
+	sFlushStopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	sFlushDoneEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	CloseHandle(CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)VaFlushThread, NULL, 0, NULL));
+
+	gTraceArmed = TRUE;
+
+	return TRUE;
+}
+VOID VaDisarmTrace(VOID)
+{
+	if (!gTraceArmed)
+	{
+		return;
+	}
+
+	gTraceArmed = FALSE;
+
+	// Disarming never blocks, the flusher writes the tail of the file on its own
+	SetEvent(sFlushStopEvent);
+}
+
+VOID VaWriteTraceEvent(LPCSTR Name, UINT64 Start, UINT64 End)
+{
+	TRACE_THREAD_BUFFER* buffer = tBuffer;
+
+	if (!buffer)
+	{
+		buffer = VaCreateThreadBuffer();
+	}
+
+	LONG64 head = buffer->Head;
+
+	if ((head - ReadAcquire64(&buffer->Tail)) == TRACE_BUFFER_SIZE)
+	{
+		buffer->DroppedCount += 1;
+
+		return;
+	}
+
+	TRACE_EVENT* event = &buffer->Events[head % TRACE_BUFFER_SIZE];
+
+	event->Name = Name;
+	event->Start = Start;
+	event->End = End;
+
+	WriteRelease64(&buffer->Head, head + 1);
+}
+
+UINT64 VaQueryTraceTime(VOID)
+{
+	return VaQueryProfilerTime();
+}
+
+VOID VaGetTraceStatistics(TRACE_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+
+	Statistics->Armed = gTraceArmed;
+	Statistics->ThreadCount = 0;
+	Statistics->DroppedCount = 0;
+
+	for (TRACE_THREAD_BUFFER* buffer = sBuffers; buffer; buffer = buffer->Next)
+	{
+		Statistics->ThreadCount += 1;
+		Statistics->DroppedCount += buffer->DroppedCount;
+	}
+}
+
+static TRACE_THREAD_BUFFER* VaCreateThreadBuffer(VOID)
+{
+	TRACE_THREAD_BUFFER* buffer = (TRACE_THREAD_BUFFER*)VirtualAlloc(NULL, sizeof(TRACE_THREAD_BUFFER), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	buffer->ThreadId = GetCurrentThreadId();
+
+	TRACE_THREAD_BUFFER* next = NULL;
+
+	do
+	{
+		next = sBuffers;
+
+		buffer->Next = next;
+	} while (InterlockedCompareExchangePointer((PVOID volatile*)&sBuffers, buffer, next) != next);
+
+	tBuffer = buffer;
+
+	return buffer;
+}
+
+static INT32 WINAPI VaFlushThread(PVOID UserParam)
+{
+	while (WaitForSingleObject(sFlushStopEvent, TRACE_FLUSH_INTERVAL) == WAIT_TIMEOUT)
+	{
+		VaFlushBuffers();
+	}
+
+	VaFinalizeFile();
+
+	SetEvent(sFlushDoneEvent);
+
+	return 0;
+}
+
+static VOID VaFlushBuffers(VOID)
+{
+	for (TRACE_THREAD_BUFFER* buffer = sBuffers; buffer; buffer = buffer->Next)
+	{
+		LONG64 tail = buffer->Tail;
+		LONG64 head = ReadAcquire64(&buffer->Head);
+
+		while (tail != head)
+		{
+			const TRACE_EVENT* event = &buffer->Events[tail % TRACE_BUFFER_SIZE];
+
+			tail += 1;
+
+			// A zone opened during an earlier capture and closed during this one has no meaningful start
+			if (event->Start < sStartTime)
+			{
+				continue;
+			}
+
+			if (sFormat == TRACE_FORMAT_JSON)
+			{
+				VaWriteJsonEvent(event, buffer->ThreadId);
+			}
+			else
+			{
+				VaWriteBinaryEvent(event, buffer->ThreadId);
+			}
+
+			sStatistics.EventCount += 1;
+		}
+
+		WriteRelease64(&buffer->Tail, tail);
+	}
+
+	fflush(sFile);
+}
+static VOID VaFinalizeFile(VOID)
+{
+	// Zones that were already open when the capture got disarmed still land in the last flush
+	VaFlushBuffers();
+
+	if (sFormat == TRACE_FORMAT_JSON)
+	{
+		fprintf(sFile, "\n]}\n");
+	}
+
+	fclose(sFile);
+
+	sFile = NULL;
+}
+static VOID VaCloseFlushEvents(VOID)
+{
+	if (sFlushStopEvent)
+	{
+		CloseHandle(sFlushStopEvent);
+		CloseHandle(sFlushDoneEvent);
+	}
+
+	sFlushStopEvent = NULL;
+	sFlushDoneEvent = NULL;
+}
+
+static VOID VaWriteJsonEvent(const TRACE_EVENT* Event, UINT32 ThreadId)
+{
+	// Chrome wants microseconds, three decimals keep the nanoseconds
+	UINT64 start = Event->Start - sStartTime;
+	UINT64 duration = Event->End - Event->Start;
+
+	INT32 length = fprintf(sFile, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}", sFirstEvent ? "" : ",\n", Event->Name, GetCurrentProcessId(), ThreadId, start / 1000, start % 1000, duration / 1000, duration % 1000);
+
+	if (length > 0)
+	{
+		sStatistics.WrittenBytes += length;
+	}
+
+	sFirstEvent = FALSE;
+}
+static VOID VaWriteBinaryEvent(const TRACE_EVENT* Event, UINT32 ThreadId)
+{
+	// Names are written once and referenced by index afterwards
+	UINT32 name = 0;
+
+	while ((name < sNameCount) && (sNames[name] != Event->Name))
+	{
+		name += 1;
+	}
+
+	if (name == sNameCount)
+	{
+		if (sNameCount == TRACE_NAME_COUNT)
+		{
+			return;
+		}
+
+		sNames[sNameCount] = Event->Name;
+
+		sNameCount += 1;
+
+		BYTE type = TRACE_RECORD_NAME;
+		UINT16 length = (UINT16)strlen(Event->Name);
+
+		VaWriteBytes(&type, sizeof(type));
+		VaWriteBytes(&length, sizeof(length));
+		VaWriteBytes(Event->Name, length);
+	}
+
+	BYTE type = TRACE_RECORD_EVENT;
+	BYTE index = (BYTE)name;
+	UINT64 start = Event->Start - sStartTime;
+	UINT32 duration = (UINT32)min(Event->End - Event->Start, (UINT64)MAXUINT32);
+
+	VaWriteBytes(&type, sizeof(type));
+	VaWriteBytes(&index, sizeof(index));
+	VaWriteBytes(&ThreadId, sizeof(ThreadId));
+	VaWriteBytes(&start, sizeof(start));
+	VaWriteBytes(&duration, sizeof(duration));
+}
+
+static VOID VaWriteBytes(const VOID* Data, UINT32 Size)
+{
+	fwrite(Data, 1, Size, sFile);
+
+	sStatistics.WrittenBytes += Size;
+}
\ No newline at end of file
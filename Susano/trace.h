@@ -0,0 +1,65 @@
+#pragma once
+
+#include <windows.h>
+
+// Tracing is compiled in unless the build defines SUSANO_TRACE to 0
+#ifndef SUSANO_TRACE
+#define SUSANO_TRACE (1)
+#endif
+
+#define TRACE_CONCAT_INNER(A, B) A##B
+#define TRACE_CONCAT(A, B) TRACE_CONCAT_INNER(A, B)
+
+#if SUSANO_TRACE
+#define TRACE_ZONE(NAME) TRACE_SCOPE TRACE_CONCAT(traceScope, __LINE__)(NAME)
+#else
+#define TRACE_ZONE(NAME)
+#endif
+
+enum TRACE_FORMAT
+{
+	TRACE_FORMAT_JSON,
+	TRACE_FORMAT_BINARY,
+};
+
+struct TRACE_STATISTICS
+{
+	BOOL Armed;
+	UINT32 ThreadCount;
+	UINT64 EventCount;
+	UINT64 DroppedCount;
+	UINT64 WrittenBytes;
+};
+
+extern volatile BOOL gTraceArmed;
+
+VOID VaDestroyTrace(VOID);
+
+BOOL VaArmTrace(LPCSTR FilePath, TRACE_FORMAT Format);
+VOID VaDisarmTrace(VOID);
+
+VOID VaWriteTraceEvent(LPCSTR Name, UINT64 Start, UINT64 End);
+
+UINT64 VaQueryTraceTime(VOID);
+
+VOID VaGetTraceStatistics(TRACE_STATISTICS* Statistics);
+
+// Names must be string literals, the flusher only keeps the pointer
+struct TRACE_SCOPE
+{
+#if SUSANO_TRACE
+	LPCSTR Name;
+	UINT64 Start;
+
+	TRACE_SCOPE() : Name(NULL), Start(0) {}
+	TRACE_SCOPE(LPCSTR Name) : Name(NULL), Start(0) { if (gTraceArmed) Begin(Name); }
+	~TRACE_SCOPE() { if (Name) VaWriteTraceEvent(Name, Start, VaQueryTraceTime()); }
+
+	VOID Begin(LPCSTR Name) { this->Name = Name; Start = VaQueryTraceTime(); }
+#else
+	TRACE_SCOPE() {}
+	TRACE_SCOPE(LPCSTR Name) {}
+
+	VOID Begin(LPCSTR Name) {}
+#endif
+};
\ No newline at end of file
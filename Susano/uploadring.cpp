@@ -0,0 +1,381 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <d3d11.h>
+
+#include "susano.h"
+#include "hash.h"
+#include "uploadring.h"
+#include "logger.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define UPLOAD_RING_INITIAL_SIZE (4 * 1024 * 1024)
+#define UPLOAD_RING_MAXIMUM_SIZE (256 * 1024 * 1024)
+
+#define UPLOAD_FRAME_COUNT (8)
+
+#define UPLOAD_CACHE_SIZE (32)
+
+#define ALIGN_UP(VALUE, ALIGNMENT) ((((VALUE) + ((ALIGNMENT) - 1)) / (ALIGNMENT)) * (ALIGNMENT))
+
+#define HR_CHECK(EXPRESSION) \
+	{ \
+		HRESULT result = (EXPRESSION); \
+		if (result != S_OK) \
+		{ \
+			VA_LOG("%s 0x%08X", #EXPRESSION, result); \
+		} \
+	}
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// Positions are virtual and only ever grow, the byte inside the buffer is the position modulo the capacity
+struct UPLOAD_FRAME
+{
+	ID3D11Query* Query;
+	UINT64 RetainStart;
+};
+
+// A previous upload that can be drawn again as long as it lies within the last half lap of the head
+struct UPLOAD_CACHE_ENTRY
+{
+	UINT64 Hash;
+	UINT32 Size;
+	UINT64 Position;
+	UINT32 Generation;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static ID3D11Buffer* sBuffer = NULL;
+
+static UINT64 sCapacity = 0;
+static UINT64 sHead = 0;
+static UINT64 sTail = 0;
+
+static BOOL sFresh = TRUE;
+
+static UINT32 sGeneration = 0;
+
+static UPLOAD_FRAME sFrames[UPLOAD_FRAME_COUNT] = { 0 };
+
+static UINT32 sOldestFrame = 0;
+static UINT32 sFrameCount = 0;
+
+static UINT64 sFrameRetainStart = 0;
+
+static UPLOAD_CACHE_ENTRY sCacheEntries[UPLOAD_CACHE_SIZE] = { 0 };
+
+static UINT32 sNextCacheEntry = 0;
+
+static UPLOAD_RING_STATISTICS sStatistics = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaCreateRingBuffer(UINT64 Capacity);
+
+static VOID VaRetireFrames(BOOL Wait);
+static VOID VaUpdateTail(VOID);
+
+static BOOL VaReserve(UINT32 Size, UINT32 Alignment, UINT64* Position);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaCreateUploadRing(VOID)
+{
+	VaCreateRingBuffer(UPLOAD_RING_INITIAL_SIZE);
+
+	for (UINT32 i = 0; i < UPLOAD_FRAME_COUNT; i++)
+	{
+		D3D11_QUERY_DESC queryDescription = { 0 };
+		queryDescription.Query = D3D11_QUERY_EVENT;
+
+		HR_CHECK(gDevice->CreateQuery(&queryDescription, &sFrames[i].Query));
+	}
+}
+VOID VaDestroyUploadRing(VOID)
+{
+	sBuffer->Release();
+
+	sBuffer = NULL;
+
+	for (UINT32 i = 0; i < UPLOAD_FRAME_COUNT; i++)
+	{
+		sFrames[i].Query->Release();
+	}
+
+	memset(sFrames, 0, sizeof(sFrames));
+	memset(sCacheEntries, 0, sizeof(sCacheEntries));
+	memset(&sStatistics, 0, sizeof(sStatistics));
+
+	sOldestFrame = 0;
+	sFrameCount = 0;
+}
+
+VOID VaBeginUploadFrame(VOID)
+{
+	VaRetireFrames(FALSE);
+
+	sFrameRetainStart = sHead;
+}
+VOID VaEndUploadFrame(VOID)
+{
+	// Every slot still in flight means the gpu is that many frames behind, the oldest one has to finish first
+	if (sFrameCount == UPLOAD_FRAME_COUNT)
+	{
+		VaRetireFrames(TRUE);
+	}
+
+	UPLOAD_FRAME* frame = &sFrames[(sOldestFrame + sFrameCount) % UPLOAD_FRAME_COUNT];
+
+	gDeviceContext->End(frame->Query);
+
+	frame->RetainStart = sFrameRetainStart;
+
+	sFrameCount += 1;
+
+	sFrameRetainStart = sHead;
+}
+
+PVOID VaMapUploadRegion(UINT32 Size, UINT32 Alignment, UPLOAD_REGION* Region)
+{
+	UINT64 position = 0;
+
+	if (!VaReserve(Size, Alignment, &position))
+	{
+		return NULL;
+	}
+
+	// Only a buffer nothing was ever drawn from may be discarded, anything else would lose retained regions
+	D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 };
+
+	HR_CHECK(gDeviceContext->Map(sBuffer, NULL, sFresh ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, NULL, &mappedSubResource));
+
+	sFresh = FALSE;
+
+	Region->Buffer = sBuffer;
+	Region->Offset = (UINT32)(position % sCapacity);
+	Region->Size = Size;
+
+	sStatistics.UploadedBytes += Size;
+
+	return (PBYTE)mappedSubResource.pData + Region->Offset;
+}
+VOID VaUnmapUploadRegion(VOID)
+{
+	gDeviceContext->Unmap(sBuffer, NULL);
+}
+
+BOOL VaUploadCached(const VOID* Data, UINT32 Size, UINT32 Alignment, UPLOAD_REGION* Region)
+{
+	UINT64 hash = VaHashMemory(Data, Size);
+
+	for (UINT32 i = 0; i < UPLOAD_CACHE_SIZE; i++)
+	{
+		UPLOAD_CACHE_ENTRY* entry = &sCacheEntries[i];
+
+		// A retired region stays intact until the head laps it, but reusing it pulls the tail back to it, so older regions are uploaded again instead of pinning the whole ring
+		if ((entry->Hash != hash) || (entry->Size != Size) || (entry->Generation != sGeneration) || ((entry->Position + (sCapacity / 2)) < sHead) || (((entry->Position % sCapacity) % Alignment) != 0))
+		{
+			continue;
+		}
+
+		// The current frame now references the region, so the tail is pulled back and must not pass it until this frame retires
+		if (entry->Position < sFrameRetainStart)
+		{
+			sFrameRetainStart = entry->Position;
+		}
+
+		if (entry->Position < sTail)
+		{
+			sTail = entry->Position;
+		}
+
+		Region->Buffer = sBuffer;
+		Region->Offset = (UINT32)(entry->Position % sCapacity);
+		Region->Size = Size;
+
+		sStatistics.HitCount += 1;
+		sStatistics.SkippedBytes += Size;
+
+		return FALSE;
+	}
+
+	PVOID data = VaMapUploadRegion(Size, Alignment, Region);
+
+	if (!data)
+	{
+		return FALSE;
+	}
+
+	memcpy(data, Data, Size);
+
+	VaUnmapUploadRegion();
+
+	UPLOAD_CACHE_ENTRY* entry = &sCacheEntries[sNextCacheEntry];
+
+	entry->Hash = hash;
+	entry->Size = Size;
+	entry->Position = sHead - Size;
+	entry->Generation = sGeneration;
+
+	sNextCacheEntry = (sNextCacheEntry + 1) % UPLOAD_CACHE_SIZE;
+
+	sStatistics.MissCount += 1;
+
+	return TRUE;
+}
+
+VOID VaGetUploadRingStatistics(UPLOAD_RING_STATISTICS* Statistics)
+{
+	*Statistics = sStatistics;
+
+	Statistics->Capacity = sCapacity;
+	Statistics->UsedBytes = sHead - sTail;
+	Statistics->InFlightFrameCount = sFrameCount;
+}
+
+static VOID VaCreateRingBuffer(UINT64 Capacity)
+{
+	D3D11_BUFFER_DESC bufferDescription = { 0 };
+	bufferDescription.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDescription.ByteWidth = (UINT32)Capacity;
+	bufferDescription.BindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_INDEX_BUFFER;
+	bufferDescription.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	HR_CHECK(gDevice->CreateBuffer(&bufferDescription, NULL, &sBuffer));
+
+	sCapacity = Capacity;
+	sHead = 0;
+	sTail = 0;
+
+	sFresh = TRUE;
+
+	// Cached regions and pending frames all point into the previous buffer
+	sGeneration += 1;
+
+	sFrameRetainStart = 0;
+
+	for (UINT32 i = 0; i < UPLOAD_FRAME_COUNT; i++)
+	{
+		sFrames[i].RetainStart = 0;
+	}
+}
+
+static VOID VaRetireFrames(BOOL Wait)
+{
+	while (sFrameCount > 0)
+	{
+		UPLOAD_FRAME* frame = &sFrames[sOldestFrame];
+
+		if (Wait)
+		{
+			// Waiting is limited to the oldest frame, everything newer is only polled
+			while (gDeviceContext->GetData(frame->Query, NULL, 0, 0) != S_OK)
+			{
+				YieldProcessor();
+			}
+
+			sStatistics.WaitCount += 1;
+
+			Wait = FALSE;
+		}
+		else if (gDeviceContext->GetData(frame->Query, NULL, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		{
+			break;
+		}
+
+		sOldestFrame = (sOldestFrame + 1) % UPLOAD_FRAME_COUNT;
+		sFrameCount -= 1;
+	}
+
+	VaUpdateTail();
+}
+static VOID VaUpdateTail(VOID)
+{
+	// Reused regions can make a newer frame retain further back than an older one, so the tail is the minimum over all of them
+	UINT64 tail = sFrameRetainStart;
+
+	for (UINT32 i = 0; i < sFrameCount; i++)
+	{
+		UINT64 retainStart = sFrames[(sOldestFrame + i) % UPLOAD_FRAME_COUNT].RetainStart;
+
+		if (retainStart < tail)
+		{
+			tail = retainStart;
+		}
+	}
+
+	sTail = tail;
+}
+
+static BOOL VaReserve(UINT32 Size, UINT32 Alignment, UINT64* Position)
+{
+	while (TRUE)
+	{
+		// Alignments are vertex strides and not necessarily powers of two, it is the offset inside the buffer that has to be a multiple
+		UINT64 offset = ALIGN_UP(sHead % sCapacity, (UINT64)Alignment);
+		UINT64 position = sHead + (offset - (sHead % sCapacity));
+
+		// An allocation never straddles the end of the buffer, the rest of the lap is skipped instead
+		if ((offset + Size) > sCapacity)
+		{
+			position += sCapacity - offset;
+		}
+
+		if (((position + Size) - sTail) <= sCapacity)
+		{
+			*Position = position;
+
+			sHead = position + Size;
+
+			return TRUE;
+		}
+
+		UINT64 tail = sTail;
+
+		VaRetireFrames(FALSE);
+
+		if (sTail != tail)
+		{
+			continue;
+		}
+
+		// Growing abandons the old buffer to the draws already referencing it, d3d keeps it alive until they are done
+		if (sCapacity < UPLOAD_RING_MAXIMUM_SIZE)
+		{
+			UINT64 capacity = sCapacity * 2;
+
+			while ((capacity < ((UINT64)Size * 2)) && (capacity < UPLOAD_RING_MAXIMUM_SIZE))
+			{
+				capacity *= 2;
+			}
+
+			sBuffer->Release();
+
+			VaCreateRingBuffer(capacity);
+
+			sStatistics.GrowCount += 1;
+
+			continue;
+		}
+
+		if (sFrameCount == 0)
+		{
+			return FALSE;
+		}
+
+		VaRetireFrames(TRUE);
+	}
+}
\ No newline at end of file
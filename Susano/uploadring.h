@@ -0,0 +1,38 @@
+#pragma once
+
+#include <windows.h>
+
+#include <d3d11.h>
+
+struct UPLOAD_REGION
+{
+	ID3D11Buffer* Buffer;
+	UINT32 Offset;
+	UINT32 Size;
+};
+
+struct UPLOAD_RING_STATISTICS
+{
+	UINT64 Capacity;
+	UINT64 UsedBytes;
+	UINT32 InFlightFrameCount;
+	UINT32 GrowCount;
+	UINT32 WaitCount;
+	UINT64 HitCount;
+	UINT64 MissCount;
+	UINT64 SkippedBytes;
+	UINT64 UploadedBytes;
+};
+
+VOID VaCreateUploadRing(VOID);
+VOID VaDestroyUploadRing(VOID);
+
+VOID VaBeginUploadFrame(VOID);
+VOID VaEndUploadFrame(VOID);
+
+PVOID VaMapUploadRegion(UINT32 Size, UINT32 Alignment, UPLOAD_REGION* Region);
+VOID VaUnmapUploadRegion(VOID);
+
+BOOL VaUploadCached(const VOID* Data, UINT32 Size, UINT32 Alignment, UPLOAD_REGION* Region);
+
+VOID VaGetUploadRingStatistics(UPLOAD_RING_STATISTICS* Statistics);
\ No newline at end of file
@@ -0,0 +1,480 @@
+#pragma once
+
+// A null device that records what the renderers ask for, buffers are plain memory so tests can look at uploaded bytes
+
+#include <windows.h>
+
+#include <dxgi.h>
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+enum D3D11_USAGE
+{
+	D3D11_USAGE_DEFAULT = 0,
+	D3D11_USAGE_IMMUTABLE = 1,
+	D3D11_USAGE_DYNAMIC = 2,
+	D3D11_USAGE_STAGING = 3,
+};
+
+enum D3D11_BIND_FLAG
+{
+	D3D11_BIND_VERTEX_BUFFER = 0x1,
+	D3D11_BIND_INDEX_BUFFER = 0x2,
+	D3D11_BIND_CONSTANT_BUFFER = 0x4,
+};
+
+enum D3D11_CPU_ACCESS_FLAG
+{
+	D3D11_CPU_ACCESS_WRITE = 0x10000,
+	D3D11_CPU_ACCESS_READ = 0x20000,
+};
+
+enum D3D11_MAP
+{
+	D3D11_MAP_READ = 1,
+	D3D11_MAP_WRITE = 2,
+	D3D11_MAP_READ_WRITE = 3,
+	D3D11_MAP_WRITE_DISCARD = 4,
+	D3D11_MAP_WRITE_NO_OVERWRITE = 5,
+};
+
+enum D3D11_QUERY
+{
+	D3D11_QUERY_EVENT = 0,
+};
+
+enum D3D11_ASYNC_GETDATA_FLAG
+{
+	D3D11_ASYNC_GETDATA_DONOTFLUSH = 0x1,
+};
+
+enum D3D11_INPUT_CLASSIFICATION
+{
+	D3D11_INPUT_PER_VERTEX_DATA = 0,
+	D3D11_INPUT_PER_INSTANCE_DATA = 1,
+};
+
+enum D3D11_PRIMITIVE_TOPOLOGY
+{
+	D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D11_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D11_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5,
+};
+
+struct D3D11_BUFFER_DESC
+{
+	UINT ByteWidth;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+	UINT StructureByteStride;
+};
+
+struct D3D11_SUBRESOURCE_DATA
+{
+	const VOID* pSysMem;
+	UINT SysMemPitch;
+	UINT SysMemSlicePitch;
+};
+
+struct D3D11_MAPPED_SUBRESOURCE
+{
+	VOID* pData;
+	UINT RowPitch;
+	UINT DepthPitch;
+};
+
+// The overlay zero initializes descriptions before naming the query, so the type stays a plain integer
+struct D3D11_QUERY_DESC
+{
+	UINT Query;
+	UINT MiscFlags;
+};
+
+struct D3D11_INPUT_ELEMENT_DESC
+{
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D11_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+struct D3D11_VIEWPORT
+{
+	FLOAT TopLeftX;
+	FLOAT TopLeftY;
+	FLOAT Width;
+	FLOAT Height;
+	FLOAT MinDepth;
+	FLOAT MaxDepth;
+};
+
+struct ID3D11DeviceChild
+{
+	volatile LONG ReferenceCount = 1;
+
+	virtual ~ID3D11DeviceChild() {}
+
+	ULONG AddRef() { return (ULONG)InterlockedIncrement(&ReferenceCount); }
+	ULONG Release()
+	{
+		LONG count = InterlockedDecrement(&ReferenceCount);
+
+		if (count == 0)
+		{
+			delete this;
+		}
+
+		return (ULONG)count;
+	}
+};
+
+struct ID3D11Resource : ID3D11DeviceChild
+{
+};
+
+struct ID3D11Buffer : ID3D11Resource
+{
+	D3D11_BUFFER_DESC Desc = {};
+	BYTE* Data = NULL;
+	UINT32 MapCount = 0;
+
+	~ID3D11Buffer() { free(Data); }
+
+	VOID GetDesc(D3D11_BUFFER_DESC* Description) { *Description = Desc; }
+};
+
+struct ID3D11Asynchronous : ID3D11DeviceChild
+{
+};
+
+// Sequence is the position of the query in the mock command stream, zero until it was ended once
+struct ID3D11Query : ID3D11Asynchronous
+{
+	UINT64 Sequence = 0;
+};
+
+struct ID3D11InputLayout : ID3D11DeviceChild
+{
+	UINT ElementCount = 0;
+};
+
+struct ID3D11VertexShader : ID3D11DeviceChild
+{
+};
+
+struct ID3D11PixelShader : ID3D11DeviceChild
+{
+};
+
+struct ID3D11RenderTargetView : ID3D11DeviceChild
+{
+};
+
+struct ID3D11ClassLinkage;
+struct ID3D11ClassInstance;
+
+// Every call the renderers make is counted, the last draw also keeps the bound buffers so tests can read the geometry
+struct D3D11_MOCK_STATISTICS
+{
+	UINT32 CreatedBufferCount;
+	UINT64 CreatedBufferBytes;
+	UINT32 ImmutableBufferCount;
+	UINT32 ShaderCount;
+	UINT32 InputLayoutCount;
+	UINT32 MapCount;
+	UINT32 DiscardMapCount;
+	UINT32 NoOverwriteMapCount;
+	UINT32 DrawCount;
+	UINT32 DrawIndexedCount;
+	UINT32 DrawIndexedInstancedCount;
+	UINT64 DrawnVertexCount;
+	UINT64 DrawnIndexCount;
+	UINT64 DrawnInstanceCount;
+	UINT32 InputLayoutChangeCount;
+	UINT32 VertexShaderChangeCount;
+	UINT32 PixelShaderChangeCount;
+	UINT32 TopologyChangeCount;
+	UINT32 ConstantBufferChangeCount;
+	UINT32 VertexBufferChangeCount;
+	UINT32 IndexBufferChangeCount;
+	UINT32 QueryWaitCount;
+};
+
+struct D3D11_MOCK_DRAW
+{
+	BOOL Indexed;
+	UINT VertexCount;
+	UINT IndexCount;
+	UINT InstanceCount;
+	UINT StartVertex;
+	UINT StartIndex;
+	INT BaseVertex;
+	UINT StartInstance;
+	ID3D11Buffer* VertexBuffers[2];
+	UINT Strides[2];
+	UINT Offsets[2];
+	ID3D11Buffer* IndexBuffer;
+	UINT IndexOffset;
+	ID3D11Buffer* ConstantBuffer;
+	D3D11_PRIMITIVE_TOPOLOGY Topology;
+};
+
+typedef VOID (*D3D11_MOCK_DRAW_PROC)(const D3D11_MOCK_DRAW* Draw, PVOID UserParam);
+
+struct ID3D11DeviceContext : ID3D11DeviceChild
+{
+	D3D11_MOCK_STATISTICS Statistics = {};
+
+	// Queries complete as soon as they are ended unless a test holds them back to simulate a lagging GPU
+	BOOL HoldQueries = FALSE;
+	UINT64 IssuedQuerySequence = 0;
+	UINT64 CompletedQuerySequence = 0;
+
+	D3D11_MOCK_DRAW_PROC DrawProc = NULL;
+	PVOID DrawUserParam = NULL;
+
+	D3D11_MOCK_DRAW State = {};
+
+	HRESULT Map(ID3D11Resource* Resource, UINT Subresource, D3D11_MAP MapType, UINT MapFlags, D3D11_MAPPED_SUBRESOURCE* MappedResource)
+	{
+		ID3D11Buffer* buffer = (ID3D11Buffer*)Resource;
+
+		Statistics.MapCount += 1;
+		Statistics.DiscardMapCount += (MapType == D3D11_MAP_WRITE_DISCARD) ? 1 : 0;
+		Statistics.NoOverwriteMapCount += (MapType == D3D11_MAP_WRITE_NO_OVERWRITE) ? 1 : 0;
+
+		buffer->MapCount += 1;
+
+		MappedResource->pData = buffer->Data;
+		MappedResource->RowPitch = buffer->Desc.ByteWidth;
+		MappedResource->DepthPitch = buffer->Desc.ByteWidth;
+
+		return S_OK;
+	}
+	VOID Unmap(ID3D11Resource* Resource, UINT Subresource)
+	{
+	}
+
+	VOID Draw(UINT VertexCount, UINT StartVertex)
+	{
+		Statistics.DrawCount += 1;
+		Statistics.DrawnVertexCount += VertexCount;
+
+		D3D11_MOCK_DRAW draw = State;
+
+		draw.Indexed = FALSE;
+		draw.VertexCount = VertexCount;
+		draw.StartVertex = StartVertex;
+		draw.InstanceCount = 1;
+
+		Record(&draw);
+	}
+	VOID DrawIndexed(UINT IndexCount, UINT StartIndex, INT BaseVertex)
+	{
+		Statistics.DrawIndexedCount += 1;
+		Statistics.DrawnIndexCount += IndexCount;
+
+		D3D11_MOCK_DRAW draw = State;
+
+		draw.Indexed = TRUE;
+		draw.IndexCount = IndexCount;
+		draw.StartIndex = StartIndex;
+		draw.BaseVertex = BaseVertex;
+		draw.InstanceCount = 1;
+
+		Record(&draw);
+	}
+	VOID DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndex, INT BaseVertex, UINT StartInstance)
+	{
+		Statistics.DrawIndexedInstancedCount += 1;
+		Statistics.DrawnIndexCount += (UINT64)IndexCountPerInstance * InstanceCount;
+		Statistics.DrawnInstanceCount += InstanceCount;
+
+		D3D11_MOCK_DRAW draw = State;
+
+		draw.Indexed = TRUE;
+		draw.IndexCount = IndexCountPerInstance;
+		draw.InstanceCount = InstanceCount;
+		draw.StartIndex = StartIndex;
+		draw.BaseVertex = BaseVertex;
+		draw.StartInstance = StartInstance;
+
+		Record(&draw);
+	}
+
+	VOID End(ID3D11Asynchronous* Async)
+	{
+		IssuedQuerySequence += 1;
+
+		((ID3D11Query*)Async)->Sequence = IssuedQuerySequence;
+
+		if (!HoldQueries)
+		{
+			CompletedQuerySequence = IssuedQuerySequence;
+		}
+	}
+	HRESULT GetData(ID3D11Asynchronous* Async, VOID* Data, UINT DataSize, UINT GetDataFlags)
+	{
+		ID3D11Query* query = (ID3D11Query*)Async;
+
+		// A flushing poll is how the CPU waits, the GPU is assumed to catch up to that query while it does
+		if (!(GetDataFlags & D3D11_ASYNC_GETDATA_DONOTFLUSH) && (query->Sequence > CompletedQuerySequence))
+		{
+			Statistics.QueryWaitCount += 1;
+
+			CompletedQuerySequence = query->Sequence;
+		}
+
+		return (query->Sequence && (query->Sequence <= CompletedQuerySequence)) ? S_OK : S_FALSE;
+	}
+
+	VOID IASetInputLayout(ID3D11InputLayout* InputLayout)
+	{
+		Statistics.InputLayoutChangeCount += 1;
+	}
+	VOID IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY Topology)
+	{
+		Statistics.TopologyChangeCount += 1;
+
+		State.Topology = Topology;
+	}
+	VOID IASetVertexBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* VertexBuffers, const UINT* Strides, const UINT* Offsets)
+	{
+		Statistics.VertexBufferChangeCount += 1;
+
+		for (UINT i = 0; (i < NumBuffers) && ((StartSlot + i) < 2); i++)
+		{
+			State.VertexBuffers[StartSlot + i] = VertexBuffers[i];
+			State.Strides[StartSlot + i] = Strides[i];
+			State.Offsets[StartSlot + i] = Offsets[i];
+		}
+	}
+	VOID IASetIndexBuffer(ID3D11Buffer* IndexBuffer, DXGI_FORMAT Format, UINT Offset)
+	{
+		Statistics.IndexBufferChangeCount += 1;
+
+		State.IndexBuffer = IndexBuffer;
+		State.IndexOffset = Offset;
+	}
+	VOID VSSetShader(ID3D11VertexShader* VertexShader, ID3D11ClassInstance* const* ClassInstances, UINT NumClassInstances)
+	{
+		Statistics.VertexShaderChangeCount += 1;
+	}
+	VOID PSSetShader(ID3D11PixelShader* PixelShader, ID3D11ClassInstance* const* ClassInstances, UINT NumClassInstances)
+	{
+		Statistics.PixelShaderChangeCount += 1;
+	}
+	VOID VSSetConstantBuffers(UINT StartSlot, UINT NumBuffers, ID3D11Buffer* const* ConstantBuffers)
+	{
+		Statistics.ConstantBufferChangeCount += 1;
+
+		State.ConstantBuffer = ConstantBuffers[0];
+	}
+	VOID OMSetRenderTargets(UINT NumViews, ID3D11RenderTargetView* const* RenderTargetViews, PVOID DepthStencilView)
+	{
+	}
+	VOID RSSetViewports(UINT NumViewports, const D3D11_VIEWPORT* Viewports)
+	{
+	}
+
+	VOID Record(const D3D11_MOCK_DRAW* Draw)
+	{
+		if (DrawProc)
+		{
+			DrawProc(Draw, DrawUserParam);
+		}
+	}
+};
+
+struct ID3D11Device : ID3D11DeviceChild
+{
+	ID3D11DeviceContext* Context = NULL;
+
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC* Description, const D3D11_SUBRESOURCE_DATA* InitialData, ID3D11Buffer** Buffer)
+	{
+		if (!Description->ByteWidth || ((Description->Usage == D3D11_USAGE_IMMUTABLE) && !InitialData))
+		{
+			*Buffer = NULL;
+
+			return E_INVALIDARG;
+		}
+
+		ID3D11Buffer* buffer = new ID3D11Buffer();
+
+		buffer->Desc = *Description;
+		buffer->Data = (BYTE*)calloc(1, Description->ByteWidth);
+
+		if (InitialData)
+		{
+			memcpy(buffer->Data, InitialData->pSysMem, Description->ByteWidth);
+		}
+
+		Context->Statistics.CreatedBufferCount += 1;
+		Context->Statistics.CreatedBufferBytes += Description->ByteWidth;
+		Context->Statistics.ImmutableBufferCount += (Description->Usage == D3D11_USAGE_IMMUTABLE) ? 1 : 0;
+
+		*Buffer = buffer;
+
+		return S_OK;
+	}
+	HRESULT CreateQuery(const D3D11_QUERY_DESC* Description, ID3D11Query** Query)
+	{
+		*Query = new ID3D11Query();
+
+		return S_OK;
+	}
+	HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* InputElements, UINT NumElements, const VOID* ShaderBytecode, SIZE_T BytecodeLength, ID3D11InputLayout** InputLayout)
+	{
+		Context->Statistics.InputLayoutCount += 1;
+
+		*InputLayout = new ID3D11InputLayout();
+
+		(*InputLayout)->ElementCount = NumElements;
+
+		return S_OK;
+	}
+	HRESULT CreateVertexShader(const VOID* ShaderBytecode, SIZE_T BytecodeLength, ID3D11ClassLinkage* ClassLinkage, ID3D11VertexShader** VertexShader)
+	{
+		Context->Statistics.ShaderCount += 1;
+
+		*VertexShader = new ID3D11VertexShader();
+
+		return S_OK;
+	}
+	HRESULT CreatePixelShader(const VOID* ShaderBytecode, SIZE_T BytecodeLength, ID3D11ClassLinkage* ClassLinkage, ID3D11PixelShader** PixelShader)
+	{
+		Context->Statistics.ShaderCount += 1;
+
+		*PixelShader = new ID3D11PixelShader();
+
+		return S_OK;
+	}
+	VOID GetImmediateContext(ID3D11DeviceContext** ImmediateContext)
+	{
+		Context->AddRef();
+
+		*ImmediateContext = Context;
+	}
+};
+
+/////////////////////////////////////////////////
+// Inline Functions
+/////////////////////////////////////////////////
+
+inline VOID D3D11CreateMockDevice(ID3D11Device** Device, ID3D11DeviceContext** Context)
+{
+	*Device = new ID3D11Device();
+	*Context = new ID3D11DeviceContext();
+
+	(*Device)->Context = *Context;
+}
\ No newline at end of file
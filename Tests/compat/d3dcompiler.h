@@ -0,0 +1,43 @@
+#pragma once
+
+// Compilation is a copy of the source, the null device never runs shaders but pipelines still hash and cache the bytecode
+
+#include <d3d11.h>
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+struct ID3DBlob : ID3D11DeviceChild
+{
+	VOID* Buffer = NULL;
+	SIZE_T Size = 0;
+
+	~ID3DBlob() { free(Buffer); }
+
+	VOID* GetBufferPointer() { return Buffer; }
+	SIZE_T GetBufferSize() { return Size; }
+};
+
+/////////////////////////////////////////////////
+// Inline Functions
+/////////////////////////////////////////////////
+
+inline HRESULT D3DCompile(const VOID* Source, SIZE_T Size, LPCSTR SourceName, const VOID* Defines, VOID* Include, LPCSTR EntryPoint, LPCSTR Target, UINT Flags1, UINT Flags2, ID3DBlob** Code, ID3DBlob** ErrorMessages)
+{
+	ID3DBlob* blob = new ID3DBlob();
+
+	blob->Buffer = malloc(Size ? Size : 1);
+	blob->Size = Size;
+
+	memcpy(blob->Buffer, Source, Size);
+
+	*Code = blob;
+
+	if (ErrorMessages)
+	{
+		*ErrorMessages = NULL;
+	}
+
+	return S_OK;
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#pragma once
+
+// The subset of DirectXMath the overlay uses, implemented with the same SSE semantics so culling and packing behave alike
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <immintrin.h>
+
+#include <windows.h>
+
+#define XM_CALLCONV
+
+#define XM_PI (3.141592654f)
+
+#define XM_SELECT_0 (0x00000000)
+#define XM_SELECT_1 (0xFFFFFFFF)
+
+namespace DirectX
+{
+	/////////////////////////////////////////////////
+	// Type Definition
+	/////////////////////////////////////////////////
+
+	typedef __m128 XMVECTOR;
+
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+	};
+
+	typedef const XMMATRIX& FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	struct XMFLOAT3
+	{
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float X, float Y, float Z) : x(X), y(Y), z(Z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float X, float Y, float Z, float W) : x(X), y(Y), z(Z), w(W) {}
+	};
+
+	struct alignas(16) XMFLOAT4A : XMFLOAT4
+	{
+		using XMFLOAT4::XMFLOAT4;
+	};
+
+	struct XMFLOAT4X4
+	{
+		float m[4][4];
+	};
+
+	struct XMUINT4
+	{
+		uint32_t x;
+		uint32_t y;
+		uint32_t z;
+		uint32_t w;
+	};
+
+	struct alignas(16) XMVECTORF32
+	{
+		union
+		{
+			float f[4];
+			XMVECTOR v;
+		};
+
+		inline operator XMVECTOR() const { return v; }
+	};
+
+	struct alignas(16) XMVECTORU32
+	{
+		union
+		{
+			uint32_t u[4];
+			XMVECTOR v;
+		};
+
+		inline operator XMVECTOR() const { return v; }
+	};
+
+	/////////////////////////////////////////////////
+	// Global Variables
+	/////////////////////////////////////////////////
+
+	static const XMVECTORF32 g_XMIdentityR0 = { { { 1.0f, 0.0f, 0.0f, 0.0f } } };
+	static const XMVECTORF32 g_XMIdentityR1 = { { { 0.0f, 1.0f, 0.0f, 0.0f } } };
+	static const XMVECTORF32 g_XMIdentityR2 = { { { 0.0f, 0.0f, 1.0f, 0.0f } } };
+	static const XMVECTORF32 g_XMIdentityR3 = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+
+	static const XMVECTORU32 g_XMSelect0001 = { { { XM_SELECT_0, XM_SELECT_0, XM_SELECT_0, XM_SELECT_1 } } };
+
+	/////////////////////////////////////////////////
+	// Inline Functions
+	/////////////////////////////////////////////////
+
+	inline XMVECTOR XM_CALLCONV XMLoadFloat3(const XMFLOAT3* Source) { return _mm_set_ps(0.0f, Source->z, Source->y, Source->x); }
+	inline XMVECTOR XM_CALLCONV XMLoadFloat4(const XMFLOAT4* Source) { return _mm_loadu_ps(&Source->x); }
+	inline XMVECTOR XM_CALLCONV XMLoadFloat4A(const XMFLOAT4A* Source) { return _mm_load_ps(&Source->x); }
+	inline VOID XM_CALLCONV XMStoreFloat3(XMFLOAT3* Destination, FXMVECTOR V)
+	{
+		alignas(16) float f[4];
+
+		_mm_store_ps(f, V);
+
+		Destination->x = f[0];
+		Destination->y = f[1];
+		Destination->z = f[2];
+	}
+	inline VOID XM_CALLCONV XMStoreFloat4(XMFLOAT4* Destination, FXMVECTOR V) { _mm_storeu_ps(&Destination->x, V); }
+	inline VOID XM_CALLCONV XMStoreUInt4(XMUINT4* Destination, FXMVECTOR V) { _mm_storeu_si128((__m128i*)Destination, _mm_castps_si128(V)); }
+
+	inline XMVECTOR XM_CALLCONV XMVectorZero(VOID) { return _mm_setzero_ps(); }
+	inline XMVECTOR XM_CALLCONV XMVectorFalseInt(VOID) { return _mm_setzero_ps(); }
+	inline XMVECTOR XM_CALLCONV XMVectorSet(float X, float Y, float Z, float W) { return _mm_set_ps(W, Z, Y, X); }
+	inline XMVECTOR XM_CALLCONV XMVectorReplicate(float Value) { return _mm_set1_ps(Value); }
+	inline XMVECTOR XM_CALLCONV XMVectorReplicateInt(uint32_t Value) { return _mm_castsi128_ps(_mm_set1_epi32((int)Value)); }
+	inline XMVECTOR XM_CALLCONV XMVectorSplatX(FXMVECTOR V) { return _mm_shuffle_ps(V, V, _MM_SHUFFLE(0, 0, 0, 0)); }
+	inline XMVECTOR XM_CALLCONV XMVectorSplatY(FXMVECTOR V) { return _mm_shuffle_ps(V, V, _MM_SHUFFLE(1, 1, 1, 1)); }
+	inline XMVECTOR XM_CALLCONV XMVectorSplatZ(FXMVECTOR V) { return _mm_shuffle_ps(V, V, _MM_SHUFFLE(2, 2, 2, 2)); }
+	inline XMVECTOR XM_CALLCONV XMVectorSplatW(FXMVECTOR V) { return _mm_shuffle_ps(V, V, _MM_SHUFFLE(3, 3, 3, 3)); }
+	inline float XM_CALLCONV XMVectorGetX(FXMVECTOR V) { return _mm_cvtss_f32(V); }
+
+	inline XMVECTOR XM_CALLCONV XMVectorAdd(FXMVECTOR A, FXMVECTOR B) { return _mm_add_ps(A, B); }
+	inline XMVECTOR XM_CALLCONV XMVectorSubtract(FXMVECTOR A, FXMVECTOR B) { return _mm_sub_ps(A, B); }
+	inline XMVECTOR XM_CALLCONV XMVectorMultiply(FXMVECTOR A, FXMVECTOR B) { return _mm_mul_ps(A, B); }
+	inline XMVECTOR XM_CALLCONV XMVectorMultiplyAdd(FXMVECTOR A, FXMVECTOR B, FXMVECTOR C) { return _mm_add_ps(_mm_mul_ps(A, B), C); }
+	inline XMVECTOR XM_CALLCONV XMVectorScale(FXMVECTOR V, float Scale) { return _mm_mul_ps(V, _mm_set1_ps(Scale)); }
+	inline XMVECTOR XM_CALLCONV XMVectorMin(FXMVECTOR A, FXMVECTOR B) { return _mm_min_ps(A, B); }
+	inline XMVECTOR XM_CALLCONV XMVectorMax(FXMVECTOR A, FXMVECTOR B) { return _mm_max_ps(A, B); }
+	inline XMVECTOR XM_CALLCONV XMVectorLess(FXMVECTOR A, FXMVECTOR B) { return _mm_cmplt_ps(A, B); }
+	inline XMVECTOR XM_CALLCONV XMVectorOrInt(FXMVECTOR A, FXMVECTOR B) { return _mm_or_ps(A, B); }
+	inline XMVECTOR XM_CALLCONV XMVectorSelect(FXMVECTOR A, FXMVECTOR B, FXMVECTOR Control) { return _mm_or_ps(_mm_andnot_ps(Control, A), _mm_and_ps(B, Control)); }
+
+	inline XMVECTOR XM_CALLCONV XMVector4Dot(FXMVECTOR A, FXMVECTOR B) { return _mm_dp_ps(A, B, 0xFF); }
+
+	inline XMMATRIX XM_CALLCONV XMMatrixIdentity(VOID) { return XMMATRIX{ { g_XMIdentityR0, g_XMIdentityR1, g_XMIdentityR2, g_XMIdentityR3 } }; }
+	inline XMMATRIX XM_CALLCONV XMMatrixTranslation(float X, float Y, float Z) { return XMMATRIX{ { g_XMIdentityR0, g_XMIdentityR1, g_XMIdentityR2, XMVectorSet(X, Y, Z, 1.0f) } }; }
+	inline XMMATRIX XM_CALLCONV XMMatrixScaling(float X, float Y, float Z) { return XMMATRIX{ { XMVectorSet(X, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, Y, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, Z, 0.0f), g_XMIdentityR3 } }; }
+	inline XMMATRIX XM_CALLCONV XMMatrixTranspose(FXMMATRIX M)
+	{
+		XMMATRIX result = M;
+
+		_MM_TRANSPOSE4_PS(result.r[0], result.r[1], result.r[2], result.r[3]);
+
+		return result;
+	}
+	inline XMMATRIX XM_CALLCONV XMMatrixMultiply(FXMMATRIX A, CXMMATRIX B)
+	{
+		XMMATRIX result;
+
+		for (int i = 0; i < 4; i++)
+		{
+			XMVECTOR row = A.r[i];
+
+			result.r[i] = XMVectorMultiplyAdd(XMVectorSplatX(row), B.r[0], XMVectorMultiplyAdd(XMVectorSplatY(row), B.r[1], XMVectorMultiplyAdd(XMVectorSplatZ(row), B.r[2], XMVectorMultiply(XMVectorSplatW(row), B.r[3]))));
+		}
+
+		return result;
+	}
+	inline XMMATRIX XM_CALLCONV XMLoadFloat4x4(const XMFLOAT4X4* Source) { return XMMATRIX{ { _mm_loadu_ps(Source->m[0]), _mm_loadu_ps(Source->m[1]), _mm_loadu_ps(Source->m[2]), _mm_loadu_ps(Source->m[3]) } }; }
+	inline VOID XM_CALLCONV XMStoreFloat4x4(XMFLOAT4X4* Destination, FXMMATRIX M)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			_mm_storeu_ps(Destination->m[i], M.r[i]);
+		}
+	}
+}
\ No newline at end of file
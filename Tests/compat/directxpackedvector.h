@@ -0,0 +1,52 @@
+#pragma once
+
+#include <directxmath.h>
+
+namespace DirectX
+{
+	namespace PackedVector
+	{
+		/////////////////////////////////////////////////
+		// Type Definition
+		/////////////////////////////////////////////////
+
+		// x lives in the lowest byte, the same layout R8G8B8A8_UNORM expects
+		struct XMUBYTEN4
+		{
+			union
+			{
+				struct
+				{
+					uint8_t x;
+					uint8_t y;
+					uint8_t z;
+					uint8_t w;
+				};
+
+				uint32_t v;
+			};
+		};
+
+		/////////////////////////////////////////////////
+		// Inline Functions
+		/////////////////////////////////////////////////
+
+		inline VOID XM_CALLCONV XMStoreUByteN4(XMUBYTEN4* Destination, FXMVECTOR V)
+		{
+			XMVECTOR scaled = _mm_mul_ps(_mm_min_ps(_mm_max_ps(V, _mm_setzero_ps()), _mm_set1_ps(1.0f)), _mm_set1_ps(255.0f));
+
+			__m128i integers = _mm_cvtps_epi32(scaled);
+
+			integers = _mm_packs_epi32(integers, integers);
+			integers = _mm_packus_epi16(integers, integers);
+
+			Destination->v = (uint32_t)_mm_cvtsi128_si32(integers);
+		}
+		inline XMVECTOR XM_CALLCONV XMLoadUByteN4(const XMUBYTEN4* Source)
+		{
+			__m128i integers = _mm_cvtepu8_epi32(_mm_cvtsi32_si128((int)Source->v));
+
+			return _mm_mul_ps(_mm_cvtepi32_ps(integers), _mm_set1_ps(1.0f / 255.0f));
+		}
+	}
+}
\ No newline at end of file
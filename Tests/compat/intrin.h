@@ -0,0 +1,12 @@
+#pragma once
+
+#include <immintrin.h>
+#include <cpuid.h>
+
+// The gcc header defines __cpuid as a five argument macro, the MSVC form fills an array instead, __cpuidex already matches
+#undef __cpuid
+
+inline void __cpuid(int Registers[4], int Function)
+{
+	__cpuid_count(Function, 0, Registers[0], Registers[1], Registers[2], Registers[3]);
+}
\ No newline at end of file
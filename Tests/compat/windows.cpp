@@ -0,0 +1,970 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include <map>
+
+#include <windows.h>
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define COMPAT_PAGE_SIZE (4096)
+
+#define COMPAT_CURRENT_PROCESS ((HANDLE)(intptr_t)-1)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+enum COMPAT_OBJECT_TYPE
+{
+	COMPAT_OBJECT_THREAD,
+	COMPAT_OBJECT_EVENT,
+	COMPAT_OBJECT_TIMER,
+	COMPAT_OBJECT_PROCESS,
+	COMPAT_OBJECT_FILE,
+	COMPAT_OBJECT_MAPPING,
+};
+
+// Every handle points at one of these, waitable state is guarded by the single wait mutex
+struct COMPAT_OBJECT
+{
+	COMPAT_OBJECT_TYPE Type;
+	volatile LONG ReferenceCount;
+	BOOL Signaled;
+	BOOL ManualReset;
+	BOOL ReadOnly;
+	UINT64 DueTime;
+	LPTHREAD_START_ROUTINE Routine;
+	PVOID Parameter;
+	pid_t ProcessId;
+	INT32 Descriptor;
+	UINT64 Size;
+};
+
+/////////////////////////////////////////////////
+// Global Variables
+/////////////////////////////////////////////////
+
+volatile LONG gCompatThreadCount = 0;
+volatile LONG gCompatThreadWaitCount = 0;
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static pthread_mutex_t sWaitMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sWaitCondition;
+static pthread_once_t sWaitOnce = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t sMemoryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Neither munmap nor the views know their size on their own
+static std::map<UINT64, UINT64>* sAllocations = NULL;
+static std::map<UINT64, UINT64>* sViews = NULL;
+
+static pthread_once_t sSignalOnce = PTHREAD_ONCE_INIT;
+
+static thread_local COMPAT_SEH_SCOPE* tSehScope = NULL;
+static thread_local DWORD tExceptionCode = 0;
+static thread_local DWORD tLastError = 0;
+static thread_local DWORD tThreadId = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID CompatInitializeWait(VOID);
+static VOID CompatInitializeSignals(VOID);
+
+static VOID CompatSignalHandler(INT32 Signal, siginfo_t* Information, PVOID Context);
+
+static UINT64 CompatNow(VOID);
+
+static COMPAT_OBJECT* CompatCreateObject(COMPAT_OBJECT_TYPE Type);
+static VOID CompatReleaseObject(COMPAT_OBJECT* Object);
+
+static BOOL CompatIsSignaled(COMPAT_OBJECT* Object, UINT64 Now);
+static VOID CompatConsumeSignal(COMPAT_OBJECT* Object);
+
+static PVOID CompatThreadRoutine(PVOID Parameter);
+
+static INT32 CompatProtection(DWORD Protect);
+static DWORD CompatPageProtection(const CHAR* Permissions);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+COMPAT_SEH_SCOPE::COMPAT_SEH_SCOPE()
+{
+	pthread_once(&sSignalOnce, CompatInitializeSignals);
+
+	Previous = tSehScope;
+	Active = TRUE;
+
+	tSehScope = this;
+}
+COMPAT_SEH_SCOPE::~COMPAT_SEH_SCOPE()
+{
+	if (Active)
+	{
+		tSehScope = Previous;
+	}
+}
+
+BOOL CompatFilterException(INT32 Disposition)
+{
+	if (Disposition != EXCEPTION_EXECUTE_HANDLER)
+	{
+		fprintf(stderr, "Unhandled exception 0x%08X\n", tExceptionCode);
+
+		abort();
+	}
+
+	return TRUE;
+}
+
+DWORD GetExceptionCode(VOID)
+{
+	return tExceptionCode;
+}
+
+DWORD GetLastError(VOID)
+{
+	return tLastError;
+}
+VOID SetLastError(DWORD Error)
+{
+	tLastError = Error;
+}
+
+DWORD GetCurrentThreadId(VOID)
+{
+	// Windows reads the id from the thread block, caching it keeps the call as cheap as there
+	if (!tThreadId)
+	{
+		tThreadId = (DWORD)syscall(SYS_gettid);
+	}
+
+	return tThreadId;
+}
+DWORD GetCurrentProcessId(VOID)
+{
+	return (DWORD)getpid();
+}
+HANDLE GetCurrentProcess(VOID)
+{
+	return COMPAT_CURRENT_PROCESS;
+}
+
+ULONGLONG GetTickCount64(VOID)
+{
+	return CompatNow() / 1000000;
+}
+DWORD GetTickCount(VOID)
+{
+	return (DWORD)GetTickCount64();
+}
+BOOL QueryPerformanceCounter(LARGE_INTEGER* Counter)
+{
+	Counter->QuadPart = (LONGLONG)CompatNow();
+
+	return TRUE;
+}
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* Frequency)
+{
+	Frequency->QuadPart = 1000000000LL;
+
+	return TRUE;
+}
+VOID Sleep(DWORD Milliseconds)
+{
+	usleep((useconds_t)Milliseconds * 1000);
+}
+
+HANDLE CreateThread(PVOID Attributes, SIZE_T StackSize, LPTHREAD_START_ROUTINE Routine, PVOID Parameter, DWORD Flags, LPDWORD ThreadId)
+{
+	COMPAT_OBJECT* object = CompatCreateObject(COMPAT_OBJECT_THREAD);
+
+	object->Routine = Routine;
+	object->Parameter = Parameter;
+	object->ManualReset = TRUE;
+
+	// One reference belongs to the handle, the other one to the running thread
+	object->ReferenceCount = 2;
+
+	pthread_t thread;
+
+	InterlockedIncrement(&gCompatThreadCount);
+
+	if (pthread_create(&thread, NULL, CompatThreadRoutine, object) != 0)
+	{
+		InterlockedDecrement(&gCompatThreadCount);
+
+		free(object);
+
+		return NULL;
+	}
+
+	pthread_detach(thread);
+
+	return object;
+}
+HANDLE CreateEventA(PVOID Attributes, BOOL ManualReset, BOOL InitialState, LPCSTR Name)
+{
+	COMPAT_OBJECT* object = CompatCreateObject(COMPAT_OBJECT_EVENT);
+
+	object->ManualReset = ManualReset;
+	object->Signaled = InitialState;
+
+	return object;
+}
+BOOL SetEvent(HANDLE Event)
+{
+	pthread_once(&sWaitOnce, CompatInitializeWait);
+	pthread_mutex_lock(&sWaitMutex);
+
+	((COMPAT_OBJECT*)Event)->Signaled = TRUE;
+
+	pthread_cond_broadcast(&sWaitCondition);
+	pthread_mutex_unlock(&sWaitMutex);
+
+	return TRUE;
+}
+BOOL ResetEvent(HANDLE Event)
+{
+	pthread_once(&sWaitOnce, CompatInitializeWait);
+	pthread_mutex_lock(&sWaitMutex);
+
+	((COMPAT_OBJECT*)Event)->Signaled = FALSE;
+
+	pthread_mutex_unlock(&sWaitMutex);
+
+	return TRUE;
+}
+HANDLE CreateWaitableTimerExW(PVOID Attributes, LPCWSTR Name, DWORD Flags, DWORD Access)
+{
+	return CompatCreateObject(COMPAT_OBJECT_TIMER);
+}
+BOOL SetWaitableTimer(HANDLE Timer, const LARGE_INTEGER* DueTime, LONG Period, PVOID Routine, PVOID Argument, BOOL Resume)
+{
+	pthread_once(&sWaitOnce, CompatInitializeWait);
+	pthread_mutex_lock(&sWaitMutex);
+
+	COMPAT_OBJECT* object = (COMPAT_OBJECT*)Timer;
+
+	// Only relative due times are used, they are negative and counted in 100 ns units
+	object->Signaled = FALSE;
+	object->DueTime = CompatNow() + (UINT64)((DueTime->QuadPart < 0) ? -DueTime->QuadPart : DueTime->QuadPart) * 100;
+
+	pthread_cond_broadcast(&sWaitCondition);
+	pthread_mutex_unlock(&sWaitMutex);
+
+	return TRUE;
+}
+DWORD WaitForSingleObject(HANDLE Handle, DWORD Milliseconds)
+{
+	return WaitForMultipleObjects(1, &Handle, FALSE, Milliseconds);
+}
+DWORD WaitForMultipleObjects(DWORD Count, const HANDLE* Handles, BOOL WaitAll, DWORD Milliseconds)
+{
+	pthread_once(&sWaitOnce, CompatInitializeWait);
+	pthread_mutex_lock(&sWaitMutex);
+
+	UINT64 deadline = (Milliseconds == INFINITE) ? MAXUINT64 : CompatNow() + (UINT64)Milliseconds * 1000000;
+
+	for (DWORD i = 0; i < Count; i++)
+	{
+		if (((COMPAT_OBJECT*)Handles[i])->Type == COMPAT_OBJECT_THREAD)
+		{
+			InterlockedIncrement(&gCompatThreadWaitCount);
+		}
+	}
+
+	DWORD result = WAIT_TIMEOUT;
+
+	while (TRUE)
+	{
+		UINT64 now = CompatNow();
+		UINT64 wake = deadline;
+
+		for (DWORD i = 0; i < Count; i++)
+		{
+			COMPAT_OBJECT* object = (COMPAT_OBJECT*)Handles[i];
+
+			if (CompatIsSignaled(object, now))
+			{
+				CompatConsumeSignal(object);
+
+				result = WAIT_OBJECT_0 + i;
+
+				break;
+			}
+
+			if ((object->Type == COMPAT_OBJECT_TIMER) && object->DueTime)
+			{
+				wake = min(wake, object->DueTime);
+			}
+		}
+
+		if ((result != WAIT_TIMEOUT) || (now >= deadline))
+		{
+			break;
+		}
+
+		// Processes are not signaled by anyone, their exit is polled
+		for (DWORD i = 0; i < Count; i++)
+		{
+			if (((COMPAT_OBJECT*)Handles[i])->Type == COMPAT_OBJECT_PROCESS)
+			{
+				wake = min(wake, now + 1000000);
+			}
+		}
+
+		if (wake == MAXUINT64)
+		{
+			pthread_cond_wait(&sWaitCondition, &sWaitMutex);
+		}
+		else
+		{
+			timespec time = { (time_t)(wake / 1000000000), (long)(wake % 1000000000) };
+
+			pthread_cond_timedwait(&sWaitCondition, &sWaitMutex, &time);
+		}
+	}
+
+	pthread_mutex_unlock(&sWaitMutex);
+
+	return result;
+}
+BOOL CloseHandle(HANDLE Handle)
+{
+	if (!Handle || (Handle == INVALID_HANDLE_VALUE))
+	{
+		return FALSE;
+	}
+
+	CompatReleaseObject((COMPAT_OBJECT*)Handle);
+
+	return TRUE;
+}
+
+VOID InitializeCriticalSection(CRITICAL_SECTION* CriticalSection)
+{
+	pthread_mutexattr_t attributes;
+
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(CriticalSection, &attributes);
+	pthread_mutexattr_destroy(&attributes);
+}
+VOID DeleteCriticalSection(CRITICAL_SECTION* CriticalSection)
+{
+	pthread_mutex_destroy(CriticalSection);
+}
+VOID EnterCriticalSection(CRITICAL_SECTION* CriticalSection)
+{
+	pthread_mutex_lock(CriticalSection);
+}
+VOID LeaveCriticalSection(CRITICAL_SECTION* CriticalSection)
+{
+	pthread_mutex_unlock(CriticalSection);
+}
+
+VOID InitializeConditionVariable(CONDITION_VARIABLE* ConditionVariable)
+{
+	pthread_cond_init(ConditionVariable, NULL);
+}
+BOOL SleepConditionVariableCS(CONDITION_VARIABLE* ConditionVariable, CRITICAL_SECTION* CriticalSection, DWORD Milliseconds)
+{
+	if (Milliseconds == INFINITE)
+	{
+		pthread_cond_wait(ConditionVariable, CriticalSection);
+
+		return TRUE;
+	}
+
+	// Statically initialized conditions wait on the realtime clock
+	timespec time;
+
+	clock_gettime(CLOCK_REALTIME, &time);
+
+	UINT64 deadline = (UINT64)time.tv_sec * 1000000000 + time.tv_nsec + (UINT64)Milliseconds * 1000000;
+
+	time.tv_sec = (time_t)(deadline / 1000000000);
+	time.tv_nsec = (long)(deadline % 1000000000);
+
+	if (pthread_cond_timedwait(ConditionVariable, CriticalSection, &time) == ETIMEDOUT)
+	{
+		SetLastError(ERROR_TIMEOUT);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+VOID WakeConditionVariable(CONDITION_VARIABLE* ConditionVariable)
+{
+	pthread_cond_signal(ConditionVariable);
+}
+VOID WakeAllConditionVariable(CONDITION_VARIABLE* ConditionVariable)
+{
+	pthread_cond_broadcast(ConditionVariable);
+}
+
+VOID AcquireSRWLockExclusive(SRWLOCK* Lock)
+{
+	pthread_rwlock_wrlock(Lock);
+}
+VOID ReleaseSRWLockExclusive(SRWLOCK* Lock)
+{
+	pthread_rwlock_unlock(Lock);
+}
+VOID AcquireSRWLockShared(SRWLOCK* Lock)
+{
+	pthread_rwlock_rdlock(Lock);
+}
+VOID ReleaseSRWLockShared(SRWLOCK* Lock)
+{
+	pthread_rwlock_unlock(Lock);
+}
+
+LPVOID VirtualAlloc(LPVOID Address, SIZE_T Size, DWORD AllocationType, DWORD Protect)
+{
+	Size = (Size + COMPAT_PAGE_SIZE - 1) & ~(SIZE_T)(COMPAT_PAGE_SIZE - 1);
+
+	// Committing into an earlier reservation only changes the protection
+	if (Address)
+	{
+		return (mprotect(Address, Size, CompatProtection(Protect)) == 0) ? Address : NULL;
+	}
+
+	PVOID memory = mmap(NULL, Size, (AllocationType & MEM_COMMIT) ? CompatProtection(Protect) : PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (memory == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_lock(&sMemoryMutex);
+
+	if (!sAllocations)
+	{
+		sAllocations = new std::map<UINT64, UINT64>();
+	}
+
+	(*sAllocations)[(UINT64)memory] = Size;
+
+	pthread_mutex_unlock(&sMemoryMutex);
+
+	return memory;
+}
+BOOL VirtualFree(LPVOID Address, SIZE_T Size, DWORD FreeType)
+{
+	pthread_mutex_lock(&sMemoryMutex);
+
+	UINT64 size = 0;
+
+	if (sAllocations && (sAllocations->count((UINT64)Address)))
+	{
+		size = (*sAllocations)[(UINT64)Address];
+
+		sAllocations->erase((UINT64)Address);
+	}
+
+	pthread_mutex_unlock(&sMemoryMutex);
+
+	return size && (munmap(Address, size) == 0);
+}
+BOOL VirtualProtect(LPVOID Address, SIZE_T Size, DWORD NewProtect, LPDWORD OldProtect)
+{
+	MEMORY_BASIC_INFORMATION information;
+
+	if (OldProtect)
+	{
+		*OldProtect = VirtualQuery(Address, &information, sizeof(information)) ? information.Protect : PAGE_NOACCESS;
+	}
+
+	UINT64 start = (UINT64)Address & ~(UINT64)(COMPAT_PAGE_SIZE - 1);
+	UINT64 end = ((UINT64)Address + Size + COMPAT_PAGE_SIZE - 1) & ~(UINT64)(COMPAT_PAGE_SIZE - 1);
+
+	return mprotect((PVOID)start, end - start, CompatProtection(NewProtect)) == 0;
+}
+SIZE_T VirtualQuery(LPCVOID Address, PMEMORY_BASIC_INFORMATION Buffer, SIZE_T Length)
+{
+	FILE* maps = fopen("/proc/self/maps", "r");
+
+	if (!maps)
+	{
+		return 0;
+	}
+
+	UINT64 address = (UINT64)Address;
+	UINT64 page = address & ~(UINT64)(COMPAT_PAGE_SIZE - 1);
+
+	memset(Buffer, 0, sizeof(MEMORY_BASIC_INFORMATION));
+
+	Buffer->BaseAddress = (PVOID)page;
+	Buffer->State = MEM_FREE;
+	Buffer->Protect = PAGE_NOACCESS;
+	Buffer->RegionSize = COMPAT_PAGE_SIZE;
+
+	CHAR line[512];
+
+	while (fgets(line, sizeof(line), maps))
+	{
+		unsigned long long start = 0;
+		unsigned long long end = 0;
+
+		CHAR permissions[8] = { 0 };
+
+		if (sscanf(line, "%llx-%llx %4s", &start, &end, permissions) != 3)
+		{
+			continue;
+		}
+
+		// The first mapping above a free address bounds the free region
+		if (start > address)
+		{
+			Buffer->RegionSize = start - page;
+
+			break;
+		}
+
+		if (address < end)
+		{
+			Buffer->AllocationBase = (PVOID)start;
+			Buffer->RegionSize = end - page;
+			Buffer->State = MEM_COMMIT;
+			Buffer->Protect = CompatPageProtection(permissions);
+			Buffer->AllocationProtect = Buffer->Protect;
+			Buffer->Type = MEM_PRIVATE;
+
+			break;
+		}
+	}
+
+	fclose(maps);
+
+	return sizeof(MEMORY_BASIC_INFORMATION);
+}
+
+HANDLE OpenProcess(DWORD Access, BOOL InheritHandle, DWORD ProcessId)
+{
+	COMPAT_OBJECT* object = CompatCreateObject(COMPAT_OBJECT_PROCESS);
+
+	object->ProcessId = (pid_t)ProcessId;
+	object->ManualReset = TRUE;
+
+	return object;
+}
+BOOL ReadProcessMemory(HANDLE Process, LPCVOID BaseAddress, LPVOID Buffer, SIZE_T Size, SIZE_T* NumberOfBytesRead)
+{
+	pid_t processId = (Process == COMPAT_CURRENT_PROCESS) ? getpid() : ((COMPAT_OBJECT*)Process)->ProcessId;
+
+	iovec local = { Buffer, Size };
+	iovec remote = { (PVOID)BaseAddress, Size };
+
+	ssize_t result = process_vm_readv(processId, &local, 1, &remote, 1, 0);
+
+	if (NumberOfBytesRead)
+	{
+		*NumberOfBytesRead = (result > 0) ? (SIZE_T)result : 0;
+	}
+
+	// Like the real call a read that crosses into an unreadable page fails as a whole
+	if (result != (ssize_t)Size)
+	{
+		SetLastError((result < 0) ? ERROR_ACCESS_DENIED : ERROR_PARTIAL_COPY);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+BOOL WriteProcessMemory(HANDLE Process, LPVOID BaseAddress, LPCVOID Buffer, SIZE_T Size, SIZE_T* NumberOfBytesWritten)
+{
+	pid_t processId = (Process == COMPAT_CURRENT_PROCESS) ? getpid() : ((COMPAT_OBJECT*)Process)->ProcessId;
+
+	iovec local = { (PVOID)Buffer, Size };
+	iovec remote = { BaseAddress, Size };
+
+	ssize_t result = process_vm_writev(processId, &local, 1, &remote, 1, 0);
+
+	if (NumberOfBytesWritten)
+	{
+		*NumberOfBytesWritten = (result > 0) ? (SIZE_T)result : 0;
+	}
+
+	return result == (ssize_t)Size;
+}
+
+HANDLE CreateFileA(LPCSTR FileName, DWORD Access, DWORD ShareMode, PVOID Attributes, DWORD Disposition, DWORD Flags, HANDLE Template)
+{
+	INT32 flags = (Access & GENERIC_WRITE) ? ((Access & GENERIC_READ) ? O_RDWR : O_WRONLY) : O_RDONLY;
+
+	if (Disposition == CREATE_ALWAYS)
+	{
+		flags |= O_CREAT | O_TRUNC;
+	}
+
+	INT32 descriptor = open(FileName, flags, 0644);
+
+	if (descriptor < 0)
+	{
+		SetLastError(ERROR_FILE_NOT_FOUND);
+
+		return INVALID_HANDLE_VALUE;
+	}
+
+	COMPAT_OBJECT* object = CompatCreateObject(COMPAT_OBJECT_FILE);
+
+	object->Descriptor = descriptor;
+
+	return object;
+}
+BOOL GetFileSizeEx(HANDLE File, LARGE_INTEGER* Size)
+{
+	struct stat status;
+
+	if (fstat(((COMPAT_OBJECT*)File)->Descriptor, &status) != 0)
+	{
+		return FALSE;
+	}
+
+	Size->QuadPart = status.st_size;
+
+	return TRUE;
+}
+BOOL MoveFileExA(LPCSTR ExistingFileName, LPCSTR NewFileName, DWORD Flags)
+{
+	return rename(ExistingFileName, NewFileName) == 0;
+}
+BOOL DeleteFileA(LPCSTR FileName)
+{
+	return unlink(FileName) == 0;
+}
+
+HANDLE CreateFileMappingA(HANDLE File, PVOID Attributes, DWORD Protect, DWORD MaximumSizeHigh, DWORD MaximumSizeLow, LPCSTR Name)
+{
+	UINT64 size = ((UINT64)MaximumSizeHigh << 32) | MaximumSizeLow;
+
+	INT32 descriptor = -1;
+
+	SetLastError(ERROR_SUCCESS);
+
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		// Named sections live in POSIX shared memory, the kernel object namespace prefix is dropped
+		LPCSTR name = strrchr(Name, '\\') ? strrchr(Name, '\\') + 1 : Name;
+
+		CHAR path[256];
+
+		snprintf(path, sizeof(path), "/%s", name);
+
+		descriptor = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+		if (descriptor >= 0)
+		{
+			if (ftruncate(descriptor, (off_t)size) != 0)
+			{
+				close(descriptor);
+
+				return NULL;
+			}
+		}
+		else
+		{
+			descriptor = shm_open(path, O_RDWR, 0600);
+
+			SetLastError(ERROR_ALREADY_EXISTS);
+		}
+	}
+	else
+	{
+		descriptor = dup(((COMPAT_OBJECT*)File)->Descriptor);
+
+		if (!size)
+		{
+			struct stat status;
+
+			fstat(descriptor, &status);
+
+			size = status.st_size;
+		}
+
+		// Like on Windows an empty file can not be mapped
+		if (!size)
+		{
+			close(descriptor);
+
+			return NULL;
+		}
+	}
+
+	if (descriptor < 0)
+	{
+		return NULL;
+	}
+
+	COMPAT_OBJECT* object = CompatCreateObject(COMPAT_OBJECT_MAPPING);
+
+	object->Descriptor = descriptor;
+	object->Size = size;
+	object->ReadOnly = (Protect == PAGE_READONLY);
+
+	return object;
+}
+HANDLE OpenFileMappingA(DWORD Access, BOOL InheritHandle, LPCSTR Name)
+{
+	LPCSTR name = strrchr(Name, '\\') ? strrchr(Name, '\\') + 1 : Name;
+
+	CHAR path[256];
+
+	snprintf(path, sizeof(path), "/%s", name);
+
+	INT32 descriptor = shm_open(path, (Access & FILE_MAP_WRITE) ? O_RDWR : O_RDONLY, 0600);
+
+	if (descriptor < 0)
+	{
+		SetLastError(ERROR_FILE_NOT_FOUND);
+
+		return NULL;
+	}
+
+	struct stat status;
+
+	fstat(descriptor, &status);
+
+	COMPAT_OBJECT* object = CompatCreateObject(COMPAT_OBJECT_MAPPING);
+
+	object->Descriptor = descriptor;
+	object->Size = status.st_size;
+	object->ReadOnly = !(Access & FILE_MAP_WRITE);
+
+	return object;
+}
+LPVOID MapViewOfFile(HANDLE Mapping, DWORD Access, DWORD OffsetHigh, DWORD OffsetLow, SIZE_T Size)
+{
+	COMPAT_OBJECT* object = (COMPAT_OBJECT*)Mapping;
+
+	UINT64 size = Size ? Size : object->Size;
+
+	if (size > object->Size)
+	{
+		return NULL;
+	}
+
+	INT32 protection = ((Access & FILE_MAP_WRITE) && !object->ReadOnly) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+
+	PVOID view = mmap(NULL, size, protection, MAP_SHARED, object->Descriptor, ((off_t)OffsetHigh << 32) | OffsetLow);
+
+	if (view == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_lock(&sMemoryMutex);
+
+	if (!sViews)
+	{
+		sViews = new std::map<UINT64, UINT64>();
+	}
+
+	(*sViews)[(UINT64)view] = size;
+
+	pthread_mutex_unlock(&sMemoryMutex);
+
+	return view;
+}
+BOOL UnmapViewOfFile(LPCVOID Address)
+{
+	pthread_mutex_lock(&sMemoryMutex);
+
+	UINT64 size = 0;
+
+	if (sViews && sViews->count((UINT64)Address))
+	{
+		size = (*sViews)[(UINT64)Address];
+
+		sViews->erase((UINT64)Address);
+	}
+
+	pthread_mutex_unlock(&sMemoryMutex);
+
+	return size && (munmap((PVOID)Address, size) == 0);
+}
+
+static VOID CompatInitializeWait(VOID)
+{
+	pthread_condattr_t attributes;
+
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&sWaitCondition, &attributes);
+	pthread_condattr_destroy(&attributes);
+}
+static VOID CompatInitializeSignals(VOID)
+{
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+
+	// The handler leaves through siglongjmp, the signal must not stay blocked afterwards
+	action.sa_sigaction = CompatSignalHandler;
+	action.sa_flags = SA_SIGINFO | SA_NODEFER;
+
+	sigemptyset(&action.sa_mask);
+
+	sigaction(SIGSEGV, &action, NULL);
+	sigaction(SIGBUS, &action, NULL);
+}
+
+static VOID CompatSignalHandler(INT32 Signal, siginfo_t* Information, PVOID Context)
+{
+	COMPAT_SEH_SCOPE* scope = tSehScope;
+
+	// A fault outside of any guarded scope is a real crash
+	if (!scope)
+	{
+		signal(Signal, SIG_DFL);
+
+		return;
+	}
+
+	tExceptionCode = EXCEPTION_ACCESS_VIOLATION;
+
+	tSehScope = scope->Previous;
+
+	scope->Active = FALSE;
+
+	siglongjmp(scope->Buffer, 1);
+}
+
+static UINT64 CompatNow(VOID)
+{
+	timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (UINT64)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static COMPAT_OBJECT* CompatCreateObject(COMPAT_OBJECT_TYPE Type)
+{
+	COMPAT_OBJECT* object = (COMPAT_OBJECT*)calloc(1, sizeof(COMPAT_OBJECT));
+
+	object->Type = Type;
+	object->ReferenceCount = 1;
+	object->Descriptor = -1;
+
+	return object;
+}
+static VOID CompatReleaseObject(COMPAT_OBJECT* Object)
+{
+	if (InterlockedDecrement(&Object->ReferenceCount) != 0)
+	{
+		return;
+	}
+
+	if (Object->Descriptor >= 0)
+	{
+		close(Object->Descriptor);
+	}
+
+	free(Object);
+}
+
+static BOOL CompatIsSignaled(COMPAT_OBJECT* Object, UINT64 Now)
+{
+	switch (Object->Type)
+	{
+		case COMPAT_OBJECT_TIMER:
+		{
+			return Object->DueTime && (Now >= Object->DueTime);
+		}
+		case COMPAT_OBJECT_PROCESS:
+		{
+			return kill(Object->ProcessId, 0) != 0;
+		}
+		default:
+		{
+			return Object->Signaled;
+		}
+	}
+}
+static VOID CompatConsumeSignal(COMPAT_OBJECT* Object)
+{
+	if (Object->Type == COMPAT_OBJECT_TIMER)
+	{
+		Object->DueTime = 0;
+	}
+	else if (!Object->ManualReset)
+	{
+		Object->Signaled = FALSE;
+	}
+}
+
+static PVOID CompatThreadRoutine(PVOID Parameter)
+{
+	COMPAT_OBJECT* object = (COMPAT_OBJECT*)Parameter;
+
+	object->Routine(object->Parameter);
+
+	InterlockedDecrement(&gCompatThreadCount);
+
+	pthread_once(&sWaitOnce, CompatInitializeWait);
+	pthread_mutex_lock(&sWaitMutex);
+
+	object->Signaled = TRUE;
+
+	pthread_cond_broadcast(&sWaitCondition);
+	pthread_mutex_unlock(&sWaitMutex);
+
+	CompatReleaseObject(object);
+
+	return NULL;
+}
+
+static INT32 CompatProtection(DWORD Protect)
+{
+	switch (Protect & 0xFF)
+	{
+		case PAGE_READONLY: return PROT_READ;
+		case PAGE_READWRITE: return PROT_READ | PROT_WRITE;
+		case PAGE_WRITECOPY: return PROT_READ | PROT_WRITE;
+		case PAGE_EXECUTE: return PROT_EXEC;
+		case PAGE_EXECUTE_READ: return PROT_READ | PROT_EXEC;
+		case PAGE_EXECUTE_READWRITE: return PROT_READ | PROT_WRITE | PROT_EXEC;
+		case PAGE_EXECUTE_WRITECOPY: return PROT_READ | PROT_WRITE | PROT_EXEC;
+		default: return PROT_NONE;
+	}
+}
+static DWORD CompatPageProtection(const CHAR* Permissions)
+{
+	BOOL read = Permissions[0] == 'r';
+	BOOL write = Permissions[1] == 'w';
+	BOOL execute = Permissions[2] == 'x';
+
+	if (!read && !write && !execute)
+	{
+		return PAGE_NOACCESS;
+	}
+
+	if (execute)
+	{
+		return write ? PAGE_EXECUTE_READWRITE : (read ? PAGE_EXECUTE_READ : PAGE_EXECUTE);
+	}
+
+	return write ? PAGE_READWRITE : PAGE_READONLY;
+}
\ No newline at end of file
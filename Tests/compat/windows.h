@@ -0,0 +1,527 @@
+#pragma once
+
+// Just enough of the Win32 surface for the Susano sources to build and run on Linux, backed by pthreads and POSIX calls
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <setjmp.h>
+#include <pthread.h>
+
+#include <immintrin.h>
+
+// Standard headers that use min and max as identifiers have to be seen before the macros below exist
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+typedef void VOID;
+typedef char CHAR;
+typedef wchar_t WCHAR;
+typedef unsigned char UCHAR;
+typedef unsigned char BYTE;
+typedef int8_t INT8;
+typedef int16_t INT16;
+typedef int32_t INT32;
+typedef long long INT64;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef unsigned long long UINT64;
+typedef int32_t INT;
+typedef uint32_t UINT;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef long long LONG64;
+typedef long long LONGLONG;
+typedef unsigned long long ULONGLONG;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int32_t BOOL;
+typedef float FLOAT;
+typedef double DOUBLE;
+typedef size_t SIZE_T;
+typedef uintptr_t ULONG_PTR;
+typedef int32_t HRESULT;
+
+typedef void* PVOID;
+typedef void* LPVOID;
+typedef const void* LPCVOID;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef void* HWND;
+typedef char* LPSTR;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+typedef BYTE* PBYTE;
+typedef FLOAT* PFLOAT;
+typedef UINT32* PUINT32;
+typedef UINT64* PUINT64;
+typedef DWORD* LPDWORD;
+typedef SIZE_T* PSIZE_T;
+
+union LARGE_INTEGER
+{
+	struct
+	{
+		DWORD LowPart;
+		LONG HighPart;
+	};
+	LONGLONG QuadPart;
+};
+
+struct MEMORY_BASIC_INFORMATION
+{
+	PVOID BaseAddress;
+	PVOID AllocationBase;
+	DWORD AllocationProtect;
+	SIZE_T RegionSize;
+	DWORD State;
+	DWORD Protect;
+	DWORD Type;
+};
+
+typedef MEMORY_BASIC_INFORMATION* PMEMORY_BASIC_INFORMATION;
+
+// Portable executable headers, only the fields the scanner and the scan cache walk are named
+struct IMAGE_DOS_HEADER
+{
+	WORD e_magic;
+	WORD e_unused[29];
+	LONG e_lfanew;
+};
+
+struct IMAGE_FILE_HEADER
+{
+	WORD Machine;
+	WORD NumberOfSections;
+	DWORD TimeDateStamp;
+	DWORD PointerToSymbolTable;
+	DWORD NumberOfSymbols;
+	WORD SizeOfOptionalHeader;
+	WORD Characteristics;
+};
+
+struct IMAGE_DATA_DIRECTORY
+{
+	DWORD VirtualAddress;
+	DWORD Size;
+};
+
+struct IMAGE_OPTIONAL_HEADER64
+{
+	WORD Magic;
+	BYTE MajorLinkerVersion;
+	BYTE MinorLinkerVersion;
+	DWORD SizeOfCode;
+	DWORD SizeOfInitializedData;
+	DWORD SizeOfUninitializedData;
+	DWORD AddressOfEntryPoint;
+	DWORD BaseOfCode;
+	ULONGLONG ImageBase;
+	DWORD SectionAlignment;
+	DWORD FileAlignment;
+	WORD Versions[6];
+	DWORD Win32VersionValue;
+	DWORD SizeOfImage;
+	DWORD SizeOfHeaders;
+	DWORD CheckSum;
+	WORD Subsystem;
+	WORD DllCharacteristics;
+	ULONGLONG SizeOfStackReserve;
+	ULONGLONG SizeOfStackCommit;
+	ULONGLONG SizeOfHeapReserve;
+	ULONGLONG SizeOfHeapCommit;
+	DWORD LoaderFlags;
+	DWORD NumberOfRvaAndSizes;
+	IMAGE_DATA_DIRECTORY DataDirectory[16];
+};
+
+struct IMAGE_NT_HEADERS64
+{
+	DWORD Signature;
+	IMAGE_FILE_HEADER FileHeader;
+	IMAGE_OPTIONAL_HEADER64 OptionalHeader;
+};
+
+struct IMAGE_SECTION_HEADER
+{
+	BYTE Name[8];
+	union
+	{
+		DWORD PhysicalAddress;
+		DWORD VirtualSize;
+	} Misc;
+	DWORD VirtualAddress;
+	DWORD SizeOfRawData;
+	DWORD PointerToRawData;
+	DWORD PointerToRelocations;
+	DWORD PointerToLinenumbers;
+	WORD NumberOfRelocations;
+	WORD NumberOfLinenumbers;
+	DWORD Characteristics;
+};
+
+struct IMAGE_BASE_RELOCATION
+{
+	DWORD VirtualAddress;
+	DWORD SizeOfBlock;
+};
+
+typedef IMAGE_DOS_HEADER* PIMAGE_DOS_HEADER;
+typedef IMAGE_NT_HEADERS64 IMAGE_NT_HEADERS;
+typedef IMAGE_NT_HEADERS64* PIMAGE_NT_HEADERS64;
+typedef IMAGE_NT_HEADERS64* PIMAGE_NT_HEADERS;
+typedef IMAGE_DATA_DIRECTORY* PIMAGE_DATA_DIRECTORY;
+typedef IMAGE_SECTION_HEADER* PIMAGE_SECTION_HEADER;
+typedef IMAGE_BASE_RELOCATION* PIMAGE_BASE_RELOCATION;
+
+typedef DWORD (*LPTHREAD_START_ROUTINE)(PVOID);
+
+typedef pthread_mutex_t CRITICAL_SECTION;
+typedef pthread_cond_t CONDITION_VARIABLE;
+typedef pthread_rwlock_t SRWLOCK;
+
+#define CONDITION_VARIABLE_INIT PTHREAD_COND_INITIALIZER
+#define SRWLOCK_INIT PTHREAD_RWLOCK_INITIALIZER
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define TRUE (1)
+#define FALSE (0)
+
+#define WINAPI
+#define APIENTRY
+#define CALLBACK
+#define __forceinline inline __attribute__((always_inline))
+#define __declspec(SPECIFIER) __attribute__((SPECIFIER))
+#define align(ALIGNMENT) aligned(ALIGNMENT)
+
+#ifndef min
+#define min(A, B) (((A) < (B)) ? (A) : (B))
+#endif
+#ifndef max
+#define max(A, B) (((A) > (B)) ? (A) : (B))
+#endif
+
+#define ARRAYSIZE(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+#define IMAGE_DOS_SIGNATURE (0x5A4D)
+#define IMAGE_NT_SIGNATURE (0x00004550)
+#define IMAGE_NT_OPTIONAL_HDR64_MAGIC (0x20B)
+#define IMAGE_FILE_MACHINE_AMD64 (0x8664)
+#define IMAGE_DIRECTORY_ENTRY_BASERELOC (5)
+#define IMAGE_REL_BASED_ABSOLUTE (0)
+#define IMAGE_REL_BASED_HIGHLOW (3)
+#define IMAGE_REL_BASED_DIR64 (10)
+#define IMAGE_SCN_CNT_CODE (0x00000020)
+#define IMAGE_SCN_MEM_EXECUTE (0x20000000)
+#define IMAGE_SCN_MEM_READ (0x40000000)
+#define IMAGE_FIRST_SECTION(HEADERS) ((PIMAGE_SECTION_HEADER)((ULONG_PTR)(HEADERS) + offsetof(IMAGE_NT_HEADERS64, OptionalHeader) + (HEADERS)->FileHeader.SizeOfOptionalHeader))
+
+#define MAXUINT32 ((UINT32)~((UINT32)0))
+#define MAXUINT64 ((UINT64)~((UINT64)0))
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#define SUCCEEDED(RESULT) (((HRESULT)(RESULT)) >= 0)
+#define FAILED(RESULT) (((HRESULT)(RESULT)) < 0)
+
+#define INFINITE (0xFFFFFFFF)
+#define WAIT_OBJECT_0 (0x00000000)
+#define WAIT_TIMEOUT (0x00000102)
+#define WAIT_FAILED (0xFFFFFFFF)
+
+#define ERROR_SUCCESS (0)
+#define ERROR_FILE_NOT_FOUND (2)
+#define ERROR_ACCESS_DENIED (5)
+#define ERROR_INVALID_HANDLE (6)
+#define ERROR_PARTIAL_COPY (299)
+#define ERROR_ALREADY_EXISTS (183)
+#define ERROR_TIMEOUT (1460)
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+
+#define MEM_COMMIT (0x00001000)
+#define MEM_RESERVE (0x00002000)
+#define MEM_FREE (0x00010000)
+#define MEM_RELEASE (0x00008000)
+#define MEM_PRIVATE (0x00020000)
+
+#define PAGE_NOACCESS (0x01)
+#define PAGE_READONLY (0x02)
+#define PAGE_READWRITE (0x04)
+#define PAGE_WRITECOPY (0x08)
+#define PAGE_EXECUTE (0x10)
+#define PAGE_EXECUTE_READ (0x20)
+#define PAGE_EXECUTE_READWRITE (0x40)
+#define PAGE_EXECUTE_WRITECOPY (0x80)
+#define PAGE_GUARD (0x100)
+
+#define GENERIC_READ (0x80000000)
+#define GENERIC_WRITE (0x40000000)
+#define FILE_SHARE_READ (0x00000001)
+#define FILE_SHARE_WRITE (0x00000002)
+#define FILE_SHARE_DELETE (0x00000004)
+#define CREATE_ALWAYS (2)
+#define OPEN_EXISTING (3)
+#define FILE_ATTRIBUTE_NORMAL (0x80)
+#define MOVEFILE_REPLACE_EXISTING (0x00000001)
+
+#define FILE_MAP_WRITE (0x0002)
+#define FILE_MAP_READ (0x0004)
+#define FILE_MAP_ALL_ACCESS (0x000F001F)
+
+#define TIMER_ALL_ACCESS (0x001F0003)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION (0x00000002)
+
+#define PROCESS_VM_READ (0x0010)
+#define PROCESS_VM_WRITE (0x0020)
+#define PROCESS_VM_OPERATION (0x0008)
+#define PROCESS_QUERY_INFORMATION (0x0400)
+
+#define EXCEPTION_ACCESS_VIOLATION ((DWORD)0xC0000005)
+#define EXCEPTION_GUARD_PAGE ((DWORD)0x80000001)
+#define EXCEPTION_EXECUTE_HANDLER (1)
+#define EXCEPTION_CONTINUE_SEARCH (0)
+
+#define _TRUNCATE ((SIZE_T)-1)
+
+/////////////////////////////////////////////////
+// Interlocked
+/////////////////////////////////////////////////
+
+inline LONG InterlockedIncrement(volatile LONG* Target) { return __atomic_add_fetch(Target, 1, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedDecrement(volatile LONG* Target) { return __atomic_sub_fetch(Target, 1, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedExchange(volatile LONG* Target, LONG Value) { return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedExchangeAdd(volatile LONG* Target, LONG Value) { return __atomic_fetch_add(Target, Value, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedCompareExchange(volatile LONG* Target, LONG Exchange, LONG Comparand) { __atomic_compare_exchange_n(Target, &Comparand, Exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); return Comparand; }
+
+inline LONG64 InterlockedIncrement64(volatile LONG64* Target) { return __atomic_add_fetch(Target, 1, __ATOMIC_SEQ_CST); }
+inline LONG64 InterlockedDecrement64(volatile LONG64* Target) { return __atomic_sub_fetch(Target, 1, __ATOMIC_SEQ_CST); }
+inline LONG64 InterlockedExchange64(volatile LONG64* Target, LONG64 Value) { return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST); }
+inline LONG64 InterlockedExchangeAdd64(volatile LONG64* Target, LONG64 Value) { return __atomic_fetch_add(Target, Value, __ATOMIC_SEQ_CST); }
+inline LONG64 InterlockedCompareExchange64(volatile LONG64* Target, LONG64 Exchange, LONG64 Comparand) { __atomic_compare_exchange_n(Target, &Comparand, Exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); return Comparand; }
+
+inline PVOID InterlockedExchangePointer(PVOID volatile* Target, PVOID Value) { return __atomic_exchange_n(Target, Value, __ATOMIC_SEQ_CST); }
+inline PVOID InterlockedCompareExchangePointer(PVOID volatile* Target, PVOID Exchange, PVOID Comparand) { __atomic_compare_exchange_n(Target, &Comparand, Exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); return Comparand; }
+
+inline LONG ReadAcquire(volatile LONG* Source) { return __atomic_load_n(Source, __ATOMIC_ACQUIRE); }
+inline LONG ReadNoFence(volatile LONG* Source) { return __atomic_load_n(Source, __ATOMIC_RELAXED); }
+inline VOID WriteRelease(volatile LONG* Destination, LONG Value) { __atomic_store_n(Destination, Value, __ATOMIC_RELEASE); }
+inline VOID WriteNoFence(volatile LONG* Destination, LONG Value) { __atomic_store_n(Destination, Value, __ATOMIC_RELAXED); }
+
+inline LONG64 ReadAcquire64(volatile LONG64* Source) { return __atomic_load_n(Source, __ATOMIC_ACQUIRE); }
+inline LONG64 ReadNoFence64(volatile LONG64* Source) { return __atomic_load_n(Source, __ATOMIC_RELAXED); }
+inline VOID WriteRelease64(volatile LONG64* Destination, LONG64 Value) { __atomic_store_n(Destination, Value, __ATOMIC_RELEASE); }
+inline VOID WriteNoFence64(volatile LONG64* Destination, LONG64 Value) { __atomic_store_n(Destination, Value, __ATOMIC_RELAXED); }
+
+inline VOID YieldProcessor(VOID) { _mm_pause(); }
+inline VOID MemoryBarrier(VOID) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+/////////////////////////////////////////////////
+// Structured Exception Handling
+/////////////////////////////////////////////////
+
+// __try and __except become an if and else around a sigsetjmp, a SIGSEGV or SIGBUS inside the body jumps back into the else
+struct COMPAT_SEH_SCOPE
+{
+	sigjmp_buf Buffer;
+	COMPAT_SEH_SCOPE* Previous;
+	BOOL Active;
+
+	COMPAT_SEH_SCOPE();
+	~COMPAT_SEH_SCOPE();
+};
+
+BOOL CompatFilterException(INT32 Disposition);
+
+DWORD GetExceptionCode(VOID);
+
+// The standard library spells its own try blocks __try, so every library header has to be included above this point
+#undef __try
+#define __try if (COMPAT_SEH_SCOPE compatSehScope; sigsetjmp(compatSehScope.Buffer, 0) == 0)
+#define __except(FILTER) else if (CompatFilterException(FILTER))
+
+/////////////////////////////////////////////////
+// Global Variables
+/////////////////////////////////////////////////
+
+// Threads still inside their routine, and waits on a thread handle, which would deadlock when made from DllMain
+extern volatile LONG gCompatThreadCount;
+extern volatile LONG gCompatThreadWaitCount;
+
+/////////////////////////////////////////////////
+// Functions
+/////////////////////////////////////////////////
+
+DWORD GetLastError(VOID);
+VOID SetLastError(DWORD Error);
+
+DWORD GetCurrentThreadId(VOID);
+DWORD GetCurrentProcessId(VOID);
+HANDLE GetCurrentProcess(VOID);
+
+ULONGLONG GetTickCount64(VOID);
+DWORD GetTickCount(VOID);
+BOOL QueryPerformanceCounter(LARGE_INTEGER* Counter);
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* Frequency);
+VOID Sleep(DWORD Milliseconds);
+
+HANDLE CreateThread(PVOID Attributes, SIZE_T StackSize, LPTHREAD_START_ROUTINE Routine, PVOID Parameter, DWORD Flags, LPDWORD ThreadId);
+HANDLE CreateEventA(PVOID Attributes, BOOL ManualReset, BOOL InitialState, LPCSTR Name);
+BOOL SetEvent(HANDLE Event);
+BOOL ResetEvent(HANDLE Event);
+HANDLE CreateWaitableTimerExW(PVOID Attributes, LPCWSTR Name, DWORD Flags, DWORD Access);
+BOOL SetWaitableTimer(HANDLE Timer, const LARGE_INTEGER* DueTime, LONG Period, PVOID Routine, PVOID Argument, BOOL Resume);
+DWORD WaitForSingleObject(HANDLE Handle, DWORD Milliseconds);
+DWORD WaitForMultipleObjects(DWORD Count, const HANDLE* Handles, BOOL WaitAll, DWORD Milliseconds);
+BOOL CloseHandle(HANDLE Handle);
+
+VOID InitializeCriticalSection(CRITICAL_SECTION* CriticalSection);
+VOID DeleteCriticalSection(CRITICAL_SECTION* CriticalSection);
+VOID EnterCriticalSection(CRITICAL_SECTION* CriticalSection);
+VOID LeaveCriticalSection(CRITICAL_SECTION* CriticalSection);
+
+VOID InitializeConditionVariable(CONDITION_VARIABLE* ConditionVariable);
+BOOL SleepConditionVariableCS(CONDITION_VARIABLE* ConditionVariable, CRITICAL_SECTION* CriticalSection, DWORD Milliseconds);
+VOID WakeConditionVariable(CONDITION_VARIABLE* ConditionVariable);
+VOID WakeAllConditionVariable(CONDITION_VARIABLE* ConditionVariable);
+
+VOID AcquireSRWLockExclusive(SRWLOCK* Lock);
+VOID ReleaseSRWLockExclusive(SRWLOCK* Lock);
+VOID AcquireSRWLockShared(SRWLOCK* Lock);
+VOID ReleaseSRWLockShared(SRWLOCK* Lock);
+
+LPVOID VirtualAlloc(LPVOID Address, SIZE_T Size, DWORD AllocationType, DWORD Protect);
+BOOL VirtualFree(LPVOID Address, SIZE_T Size, DWORD FreeType);
+BOOL VirtualProtect(LPVOID Address, SIZE_T Size, DWORD NewProtect, LPDWORD OldProtect);
+SIZE_T VirtualQuery(LPCVOID Address, PMEMORY_BASIC_INFORMATION Buffer, SIZE_T Length);
+
+HANDLE OpenProcess(DWORD Access, BOOL InheritHandle, DWORD ProcessId);
+BOOL ReadProcessMemory(HANDLE Process, LPCVOID BaseAddress, LPVOID Buffer, SIZE_T Size, SIZE_T* NumberOfBytesRead);
+BOOL WriteProcessMemory(HANDLE Process, LPVOID BaseAddress, LPCVOID Buffer, SIZE_T Size, SIZE_T* NumberOfBytesWritten);
+
+HANDLE CreateFileA(LPCSTR FileName, DWORD Access, DWORD ShareMode, PVOID Attributes, DWORD Disposition, DWORD Flags, HANDLE Template);
+BOOL GetFileSizeEx(HANDLE File, LARGE_INTEGER* Size);
+BOOL MoveFileExA(LPCSTR ExistingFileName, LPCSTR NewFileName, DWORD Flags);
+BOOL DeleteFileA(LPCSTR FileName);
+
+HANDLE CreateFileMappingA(HANDLE File, PVOID Attributes, DWORD Protect, DWORD MaximumSizeHigh, DWORD MaximumSizeLow, LPCSTR Name);
+HANDLE OpenFileMappingA(DWORD Access, BOOL InheritHandle, LPCSTR Name);
+LPVOID MapViewOfFile(HANDLE Mapping, DWORD Access, DWORD OffsetHigh, DWORD OffsetLow, SIZE_T Size);
+BOOL UnmapViewOfFile(LPCVOID Address);
+
+/////////////////////////////////////////////////
+// C Runtime
+/////////////////////////////////////////////////
+
+inline INT32 fopen_s(FILE** File, LPCSTR FileName, LPCSTR Mode)
+{
+	*File = fopen(FileName, Mode);
+
+	return *File ? 0 : 1;
+}
+
+inline INT32 strcpy_s(CHAR* Destination, SIZE_T Size, LPCSTR Source)
+{
+	if (strlen(Source) >= Size)
+	{
+		Destination[0] = 0;
+
+		return 1;
+	}
+
+	strcpy(Destination, Source);
+
+	return 0;
+}
+template<SIZE_T SIZE>
+inline INT32 strcpy_s(CHAR (&Destination)[SIZE], LPCSTR Source)
+{
+	return strcpy_s(Destination, SIZE, Source);
+}
+
+inline INT32 strcat_s(CHAR* Destination, SIZE_T Size, LPCSTR Source)
+{
+	SIZE_T length = strlen(Destination);
+
+	if ((length + strlen(Source)) >= Size)
+	{
+		return 1;
+	}
+
+	strcpy(Destination + length, Source);
+
+	return 0;
+}
+template<SIZE_T SIZE>
+inline INT32 strcat_s(CHAR (&Destination)[SIZE], LPCSTR Source)
+{
+	return strcat_s(Destination, SIZE, Source);
+}
+
+inline INT32 strncpy_s(CHAR* Destination, SIZE_T Size, LPCSTR Source, SIZE_T Count)
+{
+	SIZE_T length = strnlen(Source, (Count == _TRUNCATE) ? Size : Count);
+
+	if (length >= Size)
+	{
+		length = Size - 1;
+	}
+
+	memcpy(Destination, Source, length);
+
+	Destination[length] = 0;
+
+	return 0;
+}
+
+template<typename... ARGUMENTS>
+inline INT32 sprintf_s(CHAR* Buffer, SIZE_T Size, LPCSTR Format, ARGUMENTS... Arguments)
+{
+	return snprintf(Buffer, Size, Format, Arguments...);
+}
+template<SIZE_T SIZE, typename... ARGUMENTS>
+inline INT32 sprintf_s(CHAR (&Buffer)[SIZE], LPCSTR Format, ARGUMENTS... Arguments)
+{
+	return snprintf(Buffer, SIZE, Format, Arguments...);
+}
+
+inline CHAR* strtok_s(CHAR* String, LPCSTR Delimiters, CHAR** Context)
+{
+	return strtok_r(String, Delimiters, Context);
+}
+
+inline INT32 _stricmp(LPCSTR A, LPCSTR B) { return strcasecmp(A, B); }
+inline INT32 _strnicmp(LPCSTR A, LPCSTR B, SIZE_T Count) { return strncasecmp(A, B, Count); }
+
+inline PVOID _aligned_malloc(SIZE_T Size, SIZE_T Alignment)
+{
+	PVOID memory = NULL;
+
+	return (posix_memalign(&memory, (Alignment < sizeof(PVOID)) ? sizeof(PVOID) : Alignment, Size) == 0) ? memory : NULL;
+}
+inline VOID _aligned_free(PVOID Memory)
+{
+	free(Memory);
+}
\ No newline at end of file
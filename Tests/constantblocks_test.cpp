@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "constantblocks.h"
+#include "linebatchrenderer.h"
+#include "shaperenderer.h"
+#include "defaultgeorenderer.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define FRAME_COUNT (8)
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestVersionFollowsContents(VOID);
+static VOID VaTestCommitUploadsOncePerVersion(VOID);
+static VOID VaTestBuffersArePadded(VOID);
+static VOID VaTestOneViewProjectionUploadPerFrame(VOID);
+static VOID VaTestModelBlockUploadsPerChange(VOID);
+
+static VOID VaRenderOverlayFrame(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateTestRenderer();
+
+	TEST_RUN(VaTestVersionFollowsContents);
+	TEST_RUN(VaTestCommitUploadsOncePerVersion);
+	TEST_RUN(VaTestBuffersArePadded);
+	TEST_RUN(VaTestOneViewProjectionUploadPerFrame);
+	TEST_RUN(VaTestModelBlockUploadsPerChange);
+
+	VaDestroyTestRenderer();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestVersionFollowsContents(VOID)
+{
+	CONSTANT_BLOCK block = VaCreateConstantBlock(sizeof(XMFLOAT4));
+
+	XMFLOAT4 value = { 1.0f, 2.0f, 3.0f, 4.0f };
+
+	TEST_CHECK(block != INVALID_CONSTANT_BLOCK);
+	TEST_CHECK(VaGetConstantBlockVersion(block) == 0);
+
+	// Even zeros are a change on the first write, the block only becomes valid through it
+	XMFLOAT4 zero = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	VaWriteConstantBlock(block, &zero);
+
+	TEST_CHECK(VaGetConstantBlockVersion(block) == 1);
+
+	VaWriteConstantBlock(block, &value);
+	VaWriteConstantBlock(block, &value);
+	VaWriteConstantBlock(block, &value);
+
+	TEST_CHECK(VaGetConstantBlockVersion(block) == 2);
+
+	value.w = 5.0f;
+
+	VaWriteConstantBlock(block, &value);
+
+	TEST_CHECK(VaGetConstantBlockVersion(block) == 3);
+}
+static VOID VaTestCommitUploadsOncePerVersion(VOID)
+{
+	CONSTANT_BLOCK block = VaCreateConstantBlock(sizeof(XMFLOAT4));
+
+	VaResetConstantBlockStatistics();
+
+	// A block nobody wrote yet has nothing to upload
+	ID3D11Buffer* buffer = VaCommitConstantBlock(block);
+
+	TEST_CHECK(buffer->MapCount == 0);
+
+	XMFLOAT4 value = { 1.0f, 2.0f, 3.0f, 4.0f };
+
+	VaWriteConstantBlock(block, &value);
+
+	for (UINT32 i = 0; i < 4; i++)
+	{
+		TEST_CHECK(VaCommitConstantBlock(block) == buffer);
+	}
+
+	TEST_CHECK(buffer->MapCount == 1);
+	TEST_CHECK(memcmp(buffer->Data, &value, sizeof(value)) == 0);
+
+	// Rewriting the same contents between commits keeps the upload skipped
+	VaWriteConstantBlock(block, &value);
+	VaCommitConstantBlock(block);
+
+	TEST_CHECK(buffer->MapCount == 1);
+
+	value.x = 8.0f;
+
+	VaWriteConstantBlock(block, &value);
+	VaCommitConstantBlock(block);
+
+	TEST_CHECK(buffer->MapCount == 2);
+	TEST_CHECK(memcmp(buffer->Data, &value, sizeof(value)) == 0);
+
+	CONSTANT_BLOCK_STATISTICS statistics;
+
+	VaGetConstantBlockStatistics(&statistics);
+
+	TEST_CHECK(statistics.WriteCount == 3);
+	TEST_CHECK(statistics.UploadCount == 2);
+	TEST_CHECK(statistics.SkippedUploadCount == 5);
+}
+static VOID VaTestBuffersArePadded(VOID)
+{
+	// Constant buffers are sized in multiples of 16 bytes, the shadow only compares the declared size
+	CONSTANT_BLOCK block = VaCreateConstantBlock(20);
+
+	BYTE data[20];
+
+	memset(data, 0xAB, sizeof(data));
+
+	VaWriteConstantBlock(block, data);
+
+	ID3D11Buffer* buffer = VaCommitConstantBlock(block);
+
+	TEST_CHECK(buffer->Desc.ByteWidth == 32);
+	TEST_CHECK(buffer->Desc.BindFlags == D3D11_BIND_CONSTANT_BUFFER);
+	TEST_CHECK(memcmp(buffer->Data, data, sizeof(data)) == 0);
+}
+static VOID VaTestOneViewProjectionUploadPerFrame(VOID)
+{
+	VaCreateDefaultGeoRenderer();
+	VaCreateShapeRenderer();
+	VaCreateLineBatchRenderer();
+
+	ID3D11Buffer* viewProjectionBuffer = VaCommitConstantBlock(gViewProjectionBlock);
+
+	// The shape and line renderers both commit the shared block, only a changed camera uploads it and only once
+	for (UINT32 frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		// The camera moves every other frame and holds still in between
+		BOOL cameraMoved = (frame % 2) == 0;
+
+		VaSetTestViewProjection(XMMatrixTranslation(0.0f, 0.0f, (FLOAT)((frame / 2) + 1) * 0.01f));
+
+		UINT32 mapCount = viewProjectionBuffer->MapCount;
+
+		VaRenderOverlayFrame();
+
+		CONSTANT_BLOCK_STATISTICS statistics;
+
+		VaGetConstantBlockStatistics(&statistics);
+
+		TEST_CHECK((viewProjectionBuffer->MapCount - mapCount) == (cameraMoved ? 1U : 0U));
+		TEST_CHECK(statistics.SkippedUploadCount >= (cameraMoved ? 1U : 2U));
+	}
+
+	VaSetTestViewProjection(XMMatrixIdentity());
+
+	VaDestroyLineBatchRenderer();
+	VaDestroyShapeRenderer();
+	VaDestroyDefaultGeoRenderer();
+}
+static VOID VaTestModelBlockUploadsPerChange(VOID)
+{
+	VaCreateDefaultGeoRenderer();
+
+	// The cube follows the shared model matrix and stays in the model block once its first frame uploaded it
+	VaBeginTestFrame();
+	VaRenderDefaultGeo();
+	VaEndTestFrame();
+
+	static VERTEX vertices[] =
+	{
+		{ { 0.0f, 0.0f, 0.0f }, 0xFFFFFFFF },
+		{ { 1.0f, 0.0f, 0.0f }, 0xFFFFFFFF },
+		{ { 0.0f, 1.0f, 0.0f }, 0xFFFFFFFF },
+	};
+
+	static UINT16 indices[] = { 0, 1, 2 };
+
+	MESH mesh = VaRegisterMesh(vertices, 3, indices, 3);
+
+	// Four draws with two distinct transforms in runs, then the cube with the shared model again
+	VaDrawMesh(mesh, XMMatrixTranslation(1.0f, 0.0f, 0.0f));
+	VaDrawMesh(mesh, XMMatrixTranslation(1.0f, 0.0f, 0.0f));
+	VaDrawMesh(mesh, XMMatrixTranslation(2.0f, 0.0f, 0.0f));
+	VaDrawMesh(mesh, XMMatrixTranslation(2.0f, 0.0f, 0.0f));
+
+	VaBeginTestFrame();
+	VaRenderDefaultGeo();
+	VaEndTestFrame();
+
+	CONSTANT_BLOCK_STATISTICS statistics;
+
+	VaGetConstantBlockStatistics(&statistics);
+
+	// Two model uploads for the translations and one for the cube, the repeated transforms are skipped
+	TEST_CHECK(statistics.WriteCount == 5);
+	TEST_CHECK(statistics.UploadCount == 3);
+	TEST_CHECK(statistics.SkippedUploadCount == 2);
+
+	VaUnregisterMesh(mesh);
+
+	VaDestroyDefaultGeoRenderer();
+}
+
+static VOID VaRenderOverlayFrame(VOID)
+{
+	VaDrawWireBox({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.1f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+	VaDrawLine({ -0.5f, 0.0f, 0.5f }, { 0.5f, 0.0f, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	VaBeginTestFrame();
+
+	VaRenderDefaultGeo();
+	VaRenderShapeBatch();
+	VaRenderLineBatch();
+
+	VaEndTestFrame();
+}
\ No newline at end of file
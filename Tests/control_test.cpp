@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <time.h>
+
+#include <thread>
+
+#include "testing.h"
+#include "control.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define CONTROL_QUEUE_SIZE (64)
+
+#define IDLE_DURATION (500)
+#define IDLE_CPU_BUDGET (5)
+
+#define TASK_INTERVAL (10)
+#define TASK_DURATION (200)
+
+#define EXIT_BUDGET (50)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static volatile LONG sEnableCount = 0;
+static volatile LONG sDisableCount = 0;
+static volatile LONG sTaskCount = 0;
+
+static DWORD sHandlerThreadId = 0;
+
+static CONTROL_COMMAND sOrder[CONTROL_QUEUE_SIZE] = { CONTROL_COMMAND_ENABLE_HOOKS };
+
+static volatile LONG sOrderCount = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestCommandsRunInOrder(VOID);
+static VOID VaTestFullQueueDropsCommands(VOID);
+static VOID VaTestTasksRunOnTheirInterval(VOID);
+static VOID VaTestIdleLoopUsesNoCpu(VOID);
+static VOID VaTestExitIsPrompt(VOID);
+
+static VOID VaHandleEnable(VOID);
+static VOID VaHandleDisable(VOID);
+
+static VOID VaCountTask(VOID);
+
+static VOID VaResetControl(VOID);
+
+static UINT64 VaQueryProcessCpuTime(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	TEST_RUN(VaTestCommandsRunInOrder);
+	TEST_RUN(VaTestFullQueueDropsCommands);
+	TEST_RUN(VaTestTasksRunOnTheirInterval);
+	TEST_RUN(VaTestIdleLoopUsesNoCpu);
+	TEST_RUN(VaTestExitIsPrompt);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestCommandsRunInOrder(VOID)
+{
+	VaResetControl();
+
+	std::thread control(VaRunControlLoop);
+
+	// Commands are executed one after another on the control thread, in the order they were posted
+	TEST_CHECK(VaPostControlCommand(CONTROL_COMMAND_ENABLE_HOOKS));
+	TEST_CHECK(VaPostControlCommand(CONTROL_COMMAND_DISABLE_HOOKS));
+	TEST_CHECK(VaPostControlCommand(CONTROL_COMMAND_ENABLE_HOOKS));
+
+	// Reloading has no handler here, it is counted and skipped
+	TEST_CHECK(VaPostControlCommand(CONTROL_COMMAND_RELOAD_CONFIG));
+	TEST_CHECK(VaPostControlCommand(CONTROL_COMMAND_DISABLE_HOOKS));
+
+	UINT64 start = VaQueryTestTime();
+
+	while ((sOrderCount < 4) && ((VaQueryTestTime() - start) < 1000000000ULL))
+	{
+		Sleep(1);
+	}
+
+	VaRequestControlExit();
+
+	control.join();
+
+	CONTROL_STATISTICS statistics;
+
+	VaGetControlStatistics(&statistics);
+
+	TEST_CHECK(sOrderCount == 4);
+	TEST_CHECK(sEnableCount == 2);
+	TEST_CHECK(sDisableCount == 2);
+	TEST_CHECK((sOrder[0] == CONTROL_COMMAND_ENABLE_HOOKS) && (sOrder[1] == CONTROL_COMMAND_DISABLE_HOOKS) && (sOrder[2] == CONTROL_COMMAND_ENABLE_HOOKS) && (sOrder[3] == CONTROL_COMMAND_DISABLE_HOOKS));
+	TEST_CHECK((sHandlerThreadId != 0) && (sHandlerThreadId != GetCurrentThreadId()));
+	TEST_CHECK(statistics.CommandCount == 5);
+	TEST_CHECK(statistics.DroppedCommandCount == 0);
+
+	VaDestroyControl();
+}
+static VOID VaTestFullQueueDropsCommands(VOID)
+{
+	VaResetControl();
+
+	// Posting never blocks the posting thread, commands past the queue size are dropped and counted
+	UINT32 postedCount = 0;
+
+	for (UINT32 i = 0; i < (CONTROL_QUEUE_SIZE + 8); i++)
+	{
+		postedCount += VaPostControlCommand(CONTROL_COMMAND_ENABLE_HOOKS) ? 1 : 0;
+	}
+
+	TEST_CHECK(postedCount == CONTROL_QUEUE_SIZE);
+
+	std::thread control(VaRunControlLoop);
+
+	UINT64 start = VaQueryTestTime();
+
+	while ((sEnableCount < CONTROL_QUEUE_SIZE) && ((VaQueryTestTime() - start) < 1000000000ULL))
+	{
+		Sleep(1);
+	}
+
+	VaRequestControlExit();
+
+	control.join();
+
+	CONTROL_STATISTICS statistics;
+
+	VaGetControlStatistics(&statistics);
+
+	TEST_CHECK(sEnableCount == CONTROL_QUEUE_SIZE);
+	TEST_CHECK(statistics.CommandCount == CONTROL_QUEUE_SIZE);
+	TEST_CHECK(statistics.DroppedCommandCount == 8);
+
+	VaDestroyControl();
+}
+static VOID VaTestTasksRunOnTheirInterval(VOID)
+{
+	VaResetControl();
+
+	TEST_CHECK(VaRegisterControlTask(VaCountTask, TASK_INTERVAL));
+
+	std::thread control(VaRunControlLoop);
+
+	Sleep(TASK_DURATION);
+
+	VaRequestControlExit();
+
+	control.join();
+
+	CONTROL_STATISTICS statistics;
+
+	VaGetControlStatistics(&statistics);
+
+	// Deadlines are kept by the loop itself, a late wake only delays a run and never doubles it up
+	UINT32 expectedCount = TASK_DURATION / TASK_INTERVAL;
+
+	TEST_CHECK(statistics.TaskRunCount >= (expectedCount / 2));
+	TEST_CHECK(statistics.TaskRunCount <= (expectedCount + 1));
+
+	// Every task runs once more on exit so nothing it drains is left behind
+	TEST_CHECK((UINT64)sTaskCount == (statistics.TaskRunCount + 1));
+
+	for (UINT32 i = 0; i < CONTROL_TASK_COUNT; i++)
+	{
+		VaRegisterControlTask(VaCountTask, 1000);
+	}
+
+	TEST_CHECK(!VaRegisterControlTask(VaCountTask, 1000));
+
+	VaDestroyControl();
+}
+static VOID VaTestIdleLoopUsesNoCpu(VOID)
+{
+	VaResetControl();
+
+	// The logger flush is the most frequent task Susano registers, it runs every few hundred milliseconds
+	TEST_CHECK(VaRegisterControlTask(VaCountTask, 250));
+
+	std::thread control(VaRunControlLoop);
+
+	Sleep(10);
+
+	UINT64 cpuTime = VaQueryProcessCpuTime();
+
+	CONTROL_STATISTICS before;
+
+	VaGetControlStatistics(&before);
+
+	Sleep(IDLE_DURATION);
+
+	CONTROL_STATISTICS after;
+
+	VaGetControlStatistics(&after);
+
+	cpuTime = VaQueryProcessCpuTime() - cpuTime;
+
+	VaRequestControlExit();
+
+	control.join();
+
+	// The old main thread spun for the whole half second, the control thread only wakes for its two task deadlines
+	TEST_CHECK(cpuTime < ((UINT64)IDLE_CPU_BUDGET * 1000000));
+	TEST_CHECK((after.WakeCount - before.WakeCount) <= 4);
+
+	printf("  %.3f ms cpu over %u ms idle, %llu wakes\n", cpuTime / 1000000.0, IDLE_DURATION, after.WakeCount - before.WakeCount);
+
+	VaDestroyControl();
+}
+static VOID VaTestExitIsPrompt(VOID)
+{
+	VaResetControl();
+
+	// Without any task the loop sleeps with an infinite timeout, only the exit request can wake it
+	std::thread control(VaRunControlLoop);
+
+	Sleep(50);
+
+	UINT64 start = VaQueryTestTime();
+
+	VaRequestControlExit();
+
+	control.join();
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	CONTROL_STATISTICS statistics;
+
+	VaGetControlStatistics(&statistics);
+
+	TEST_CHECK(elapsed < ((UINT64)EXIT_BUDGET * 1000000));
+	TEST_CHECK(statistics.WakeCount <= 1);
+
+	printf("  exit after %.3f ms\n", elapsed / 1000000.0);
+
+	VaDestroyControl();
+}
+
+static VOID VaHandleEnable(VOID)
+{
+	sHandlerThreadId = GetCurrentThreadId();
+
+	sOrder[sOrderCount % CONTROL_QUEUE_SIZE] = CONTROL_COMMAND_ENABLE_HOOKS;
+
+	InterlockedIncrement(&sOrderCount);
+	InterlockedIncrement(&sEnableCount);
+}
+static VOID VaHandleDisable(VOID)
+{
+	sOrder[sOrderCount % CONTROL_QUEUE_SIZE] = CONTROL_COMMAND_DISABLE_HOOKS;
+
+	InterlockedIncrement(&sOrderCount);
+	InterlockedIncrement(&sDisableCount);
+}
+
+static VOID VaCountTask(VOID)
+{
+	InterlockedIncrement(&sTaskCount);
+}
+
+static VOID VaResetControl(VOID)
+{
+	VaCreateControl();
+
+	VaSetControlHandler(CONTROL_COMMAND_ENABLE_HOOKS, VaHandleEnable);
+	VaSetControlHandler(CONTROL_COMMAND_DISABLE_HOOKS, VaHandleDisable);
+
+	sEnableCount = 0;
+	sDisableCount = 0;
+	sTaskCount = 0;
+	sOrderCount = 0;
+
+	sHandlerThreadId = 0;
+}
+
+static UINT64 VaQueryProcessCpuTime(VOID)
+{
+	struct timespec time;
+
+	// Counts every thread of the process, the test thread only sleeps so this is the control thread
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+
+	return ((UINT64)time.tv_sec * 1000000000) + (UINT64)time.tv_nsec;
+}
\ No newline at end of file
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "defaultgeorenderer.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define DRAW_RECORD_CAPACITY (1024)
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+struct DRAW_RECORD
+{
+	ID3D11Buffer* VertexBuffer;
+	ID3D11Buffer* IndexBuffer;
+	UINT32 IndexCount;
+	UINT32 VertexMapCount;
+	UINT32 IndexMapCount;
+	XMFLOAT4X4 ModelViewProjection;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static VERTEX sTriangleVertices[] =
+{
+	{ { 0.0f, 0.0f, 0.0f }, 0xFF0000FF },
+	{ { 1.0f, 0.0f, 0.0f }, 0xFF00FF00 },
+	{ { 0.0f, 1.0f, 0.0f }, 0xFFFF0000 },
+};
+
+static UINT16 sTriangleIndices[] = { 0, 1, 2 };
+
+static VERTEX sQuadVertices[] =
+{
+	{ { 0.0f, 0.0f, 0.0f }, 0xFFFFFFFF },
+	{ { 1.0f, 0.0f, 0.0f }, 0xFFFFFFFF },
+	{ { 1.0f, 1.0f, 0.0f }, 0xFFFFFFFF },
+	{ { 0.0f, 1.0f, 0.0f }, 0xFFFFFFFF },
+};
+
+static UINT16 sQuadIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+static DRAW_RECORD sDrawRecords[DRAW_RECORD_CAPACITY] = { 0 };
+
+static UINT32 sDrawRecordCount = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestMeshesAreUploadedOnce(VOID);
+static VOID VaTestEqualHandlesBindOnce(VOID);
+static VOID VaTestTransformsAreFolded(VOID);
+static VOID VaTestUnregisterFreesSlot(VOID);
+static VOID VaTestRegistryIsBounded(VOID);
+
+static VOID VaRenderRecordedFrame(VOID);
+
+static VOID VaRecordDraw(const D3D11_MOCK_DRAW* Draw, PVOID UserParam);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateTestRenderer();
+	VaCreateDefaultGeoRenderer();
+
+	TEST_RUN(VaTestMeshesAreUploadedOnce);
+	TEST_RUN(VaTestEqualHandlesBindOnce);
+	TEST_RUN(VaTestTransformsAreFolded);
+	TEST_RUN(VaTestUnregisterFreesSlot);
+	TEST_RUN(VaTestRegistryIsBounded);
+
+	VaDestroyDefaultGeoRenderer();
+	VaDestroyTestRenderer();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestMeshesAreUploadedOnce(VOID)
+{
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	MESH mesh = VaRegisterMesh(sTriangleVertices, ARRAY_LENGTH(sTriangleVertices), sTriangleIndices, ARRAY_LENGTH(sTriangleIndices));
+
+	D3D11_MOCK_STATISTICS registered = gMockContext->Statistics;
+
+	TEST_CHECK(mesh != INVALID_MESH);
+	TEST_CHECK((registered.CreatedBufferCount - before.CreatedBufferCount) == 2);
+	TEST_CHECK((registered.ImmutableBufferCount - before.ImmutableBufferCount) == 2);
+	TEST_CHECK((registered.CreatedBufferBytes - before.CreatedBufferBytes) == (sizeof(sTriangleVertices) + sizeof(sTriangleIndices)));
+
+	// Drawing only binds, ten frames of a hundred draws neither create nor map any mesh buffer
+	for (UINT32 frame = 0; frame < 10; frame++)
+	{
+		for (UINT32 i = 0; i < 100; i++)
+		{
+			VaDrawMesh(mesh, XMMatrixTranslation((FLOAT)i, 0.0f, 0.0f));
+		}
+
+		VaRenderRecordedFrame();
+
+		TEST_CHECK(sDrawRecordCount == 101);
+
+		for (UINT32 i = 0; i < sDrawRecordCount; i++)
+		{
+			TEST_CHECK(sDrawRecords[i].VertexMapCount == 0);
+			TEST_CHECK(sDrawRecords[i].IndexMapCount == 0);
+		}
+	}
+
+	TEST_CHECK(gMockContext->Statistics.CreatedBufferCount == registered.CreatedBufferCount);
+
+	DEFAULT_GEO_STATISTICS statistics;
+
+	VaGetDefaultGeoStatistics(&statistics);
+
+	// The default cube is a registered mesh too and is drawn once every frame
+	TEST_CHECK(statistics.MeshCount == 2);
+	TEST_CHECK(statistics.DrawCount == 101);
+	TEST_CHECK(statistics.IndexCount == (36 + 100 * ARRAY_LENGTH(sTriangleIndices)));
+
+	VaUnregisterMesh(mesh);
+}
+static VOID VaTestEqualHandlesBindOnce(VOID)
+{
+	MESH triangle = VaRegisterMesh(sTriangleVertices, ARRAY_LENGTH(sTriangleVertices), sTriangleIndices, ARRAY_LENGTH(sTriangleIndices));
+	MESH quad = VaRegisterMesh(sQuadVertices, ARRAY_LENGTH(sQuadVertices), sQuadIndices, ARRAY_LENGTH(sQuadIndices));
+
+	// Three runs of equal handles and the cube queued last, every run binds its buffers exactly once
+	MESH order[] = { triangle, triangle, triangle, quad, quad, triangle };
+
+	for (UINT32 i = 0; i < ARRAY_LENGTH(order); i++)
+	{
+		VaDrawMesh(order[i], XMMatrixIdentity());
+	}
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	VaRenderRecordedFrame();
+
+	D3D11_MOCK_STATISTICS after = gMockContext->Statistics;
+
+	TEST_CHECK(sDrawRecordCount == (1 + ARRAY_LENGTH(order)));
+	TEST_CHECK((after.VertexBufferChangeCount - before.VertexBufferChangeCount) == 4);
+	TEST_CHECK((after.IndexBufferChangeCount - before.IndexBufferChangeCount) == 4);
+	TEST_CHECK((after.DrawIndexedCount - before.DrawIndexedCount) == (1 + ARRAY_LENGTH(order)));
+
+	for (UINT32 i = 0; i < ARRAY_LENGTH(order); i++)
+	{
+		const DRAW_RECORD* record = &sDrawRecords[i];
+
+		TEST_CHECK(record->IndexCount == ((order[i] == quad) ? ARRAY_LENGTH(sQuadIndices) : ARRAY_LENGTH(sTriangleIndices)));
+		TEST_CHECK(record->VertexBuffer->Desc.Usage == D3D11_USAGE_IMMUTABLE);
+		TEST_CHECK(record->IndexBuffer->Desc.Usage == D3D11_USAGE_IMMUTABLE);
+	}
+
+	TEST_CHECK(sDrawRecords[0].VertexBuffer == sDrawRecords[5].VertexBuffer);
+	TEST_CHECK(sDrawRecords[0].VertexBuffer != sDrawRecords[3].VertexBuffer);
+	TEST_CHECK(sDrawRecords[6].IndexCount == 36);
+
+	VaUnregisterMesh(triangle);
+	VaUnregisterMesh(quad);
+}
+static VOID VaTestTransformsAreFolded(VOID)
+{
+	XMMATRIX viewProjection = XMMatrixMultiply(XMMatrixScaling(0.5f, 0.25f, 1.0f), XMMatrixTranslation(0.0f, 0.0f, 0.5f));
+
+	VaSetTestViewProjection(viewProjection);
+
+	MESH mesh = VaRegisterMesh(sTriangleVertices, ARRAY_LENGTH(sTriangleVertices), sTriangleIndices, ARRAY_LENGTH(sTriangleIndices));
+
+	for (UINT32 i = 0; i < 4; i++)
+	{
+		VaDrawMesh(mesh, XMMatrixTranslation((FLOAT)i, (FLOAT)(i * 2), 0.0f));
+	}
+
+	VaRenderRecordedFrame();
+
+	TEST_CHECK(sDrawRecordCount == 5);
+
+	// Every draw sees its own transform times the view projection in the model block, stored transposed for hlsl
+	for (UINT32 i = 0; i < 4; i++)
+	{
+		XMFLOAT4X4 expected;
+
+		XMStoreFloat4x4(&expected, XMMatrixTranspose(XMMatrixMultiply(XMMatrixTranslation((FLOAT)i, (FLOAT)(i * 2), 0.0f), viewProjection)));
+
+		TEST_CHECK(memcmp(&expected, &sDrawRecords[i].ModelViewProjection, sizeof(XMFLOAT4X4)) == 0);
+	}
+
+	VaUnregisterMesh(mesh);
+
+	VaSetTestViewProjection(XMMatrixIdentity());
+}
+static VOID VaTestUnregisterFreesSlot(VOID)
+{
+	MESH mesh = VaRegisterMesh(sQuadVertices, ARRAY_LENGTH(sQuadVertices), sQuadIndices, ARRAY_LENGTH(sQuadIndices));
+
+	DEFAULT_GEO_STATISTICS statistics;
+
+	VaGetDefaultGeoStatistics(&statistics);
+
+	TEST_CHECK(statistics.MeshCount == 2);
+
+	// A draw queued before the mesh went away is dropped, a stale handle is ignored from then on
+	VaDrawMesh(mesh, XMMatrixIdentity());
+	VaUnregisterMesh(mesh);
+	VaDrawMesh(mesh, XMMatrixIdentity());
+	VaUnregisterMesh(mesh);
+
+	VaRenderRecordedFrame();
+
+	VaGetDefaultGeoStatistics(&statistics);
+
+	TEST_CHECK(statistics.MeshCount == 1);
+	TEST_CHECK(statistics.DrawCount == 1);
+	TEST_CHECK(sDrawRecordCount == 1);
+
+	MESH reused = VaRegisterMesh(sTriangleVertices, ARRAY_LENGTH(sTriangleVertices), sTriangleIndices, ARRAY_LENGTH(sTriangleIndices));
+
+	TEST_CHECK(reused == mesh);
+
+	VaUnregisterMesh(reused);
+
+	VaDrawMesh(INVALID_MESH, XMMatrixIdentity());
+	VaUnregisterMesh(INVALID_MESH);
+
+	VaRenderRecordedFrame();
+
+	TEST_CHECK(sDrawRecordCount == 1);
+}
+static VOID VaTestRegistryIsBounded(VOID)
+{
+	MESH meshes[256];
+
+	UINT32 meshCount = 0;
+
+	while (meshCount < ARRAY_LENGTH(meshes))
+	{
+		MESH mesh = VaRegisterMesh(sTriangleVertices, ARRAY_LENGTH(sTriangleVertices), sTriangleIndices, ARRAY_LENGTH(sTriangleIndices));
+
+		if (mesh == INVALID_MESH)
+		{
+			break;
+		}
+
+		meshes[meshCount] = mesh;
+		meshCount += 1;
+	}
+
+	// The cube holds one of the 256 slots
+	TEST_CHECK(meshCount == 255);
+
+	for (UINT32 i = 0; i < meshCount; i++)
+	{
+		VaUnregisterMesh(meshes[i]);
+	}
+
+	DEFAULT_GEO_STATISTICS statistics;
+
+	VaGetDefaultGeoStatistics(&statistics);
+
+	TEST_CHECK(statistics.MeshCount == 1);
+}
+
+static VOID VaRenderRecordedFrame(VOID)
+{
+	sDrawRecordCount = 0;
+
+	gMockContext->DrawProc = VaRecordDraw;
+
+	VaBeginTestFrame();
+	VaRenderDefaultGeo();
+	VaEndTestFrame();
+
+	gMockContext->DrawProc = NULL;
+}
+
+static VOID VaRecordDraw(const D3D11_MOCK_DRAW* Draw, PVOID UserParam)
+{
+	if (sDrawRecordCount == DRAW_RECORD_CAPACITY)
+	{
+		return;
+	}
+
+	DRAW_RECORD* record = &sDrawRecords[sDrawRecordCount];
+
+	record->VertexBuffer = Draw->VertexBuffers[0];
+	record->IndexBuffer = Draw->IndexBuffer;
+	record->IndexCount = Draw->IndexCount;
+	record->VertexMapCount = Draw->VertexBuffers[0]->MapCount;
+	record->IndexMapCount = Draw->IndexBuffer->MapCount;
+
+	// The model block is the last constant buffer bound, the mock keeps its contents as of this draw
+	memcpy(&record->ModelViewProjection, Draw->ConstantBuffer->Data, sizeof(XMFLOAT4X4));
+
+	sDrawRecordCount += 1;
+}
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <thread>
+
+#include "testing.h"
+#include "offsets.h"
+#include "safememory.h"
+#include "gamestructs.h"
+#include "gamestate.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define READER_COUNT (3)
+
+#define PLAYER_POOL_SIZE (4096)
+#define PLAYER_OBJECT_STRIDE (0x100)
+
+#define MODULE_SIZE (0x1000)
+
+#define CAMERA_BLOCK_OFFSET (0x100)
+#define WINDOW_OFFSET (0x200)
+
+#define CONCURRENT_DURATION (500)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+struct READER_RESULT
+{
+	UINT64 ReadCount;
+	UINT64 ValidCount;
+	UINT32 TornCount;
+	UINT32 BackwardCount;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+// Stand-ins for the game modules, main.dll holds the player pointer and the camera block, flower_kernel.dll the window size
+alignas(16) static BYTE sMainModule[MODULE_SIZE] = { 0 };
+alignas(16) static BYTE sKernelModule[MODULE_SIZE] = { 0 };
+
+// Player objects are never written once published, the game thread only swings the pointer to the next one
+alignas(16) static BYTE sPlayerPool[PLAYER_POOL_SIZE * PLAYER_OBJECT_STRIDE] = { 0 };
+
+static CHAR sSchema[] = R"schema(
+	window_width         flower_kernel.dll   0x200       -        u32
+	window_height        flower_kernel.dll   0x204       -        u32
+	player_object        main.dll            0x0         0x0      struct
+	camera_block         main.dll            0x100       -        struct
+)schema";
+
+static volatile BOOL sRunning = FALSE;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestNothingIsReadBeforeTheFirstSample(VOID);
+static VOID VaTestSamplesFollowTheGame(VOID);
+static VOID VaTestConcurrentReadersNeverTear(VOID);
+static VOID VaTestSampleRateIsClamped(VOID);
+static VOID VaTestDestroyNeverJoins(VOID);
+
+static VOID VaRunGame(VOID);
+static VOID VaRunReader(READER_RESULT* Result);
+
+static VOID VaPublishPlayer(UINT32 Index);
+
+static BOOL VaWaitForSamples(UINT64 Count);
+
+static UINT64 VaGetTestModule(LPCSTR ModuleName);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	for (UINT32 i = 0; i < PLAYER_POOL_SIZE; i++)
+	{
+		FLOAT position[3] = { (FLOAT)i, (FLOAT)i * 2.0f, (FLOAT)i * 3.0f };
+
+		memcpy(sPlayerPool + (i * PLAYER_OBJECT_STRIDE) + PLAYER_OBJECT::PositionX::Offset, position, sizeof(position));
+	}
+
+	FLOAT camera[] = { 0.25f, 0.5f, 1.0f, 2.0f, 4.0f };
+
+	memcpy(sMainModule + CAMERA_BLOCK_OFFSET + CAMERA_BLOCK::Pitch::Offset, &camera[0], sizeof(FLOAT));
+	memcpy(sMainModule + CAMERA_BLOCK_OFFSET + CAMERA_BLOCK::Yaw::Offset, &camera[1], sizeof(FLOAT));
+	memcpy(sMainModule + CAMERA_BLOCK_OFFSET + CAMERA_BLOCK::Fov::Offset, &camera[2], sizeof(FLOAT));
+	memcpy(sMainModule + CAMERA_BLOCK_OFFSET + CAMERA_BLOCK::Distance::Offset, &camera[3], sizeof(FLOAT));
+	memcpy(sMainModule + CAMERA_BLOCK_OFFSET + CAMERA_BLOCK::Height::Offset, &camera[4], sizeof(FLOAT));
+
+	UINT32 window[] = { 1920, 1080 };
+
+	memcpy(sKernelModule + WINDOW_OFFSET, window, sizeof(window));
+
+	VaCreateSafeMemory();
+	VaCreateOffsets(VaGetTestModule);
+	VaLoadOffsetSchemaText(sSchema, FALSE);
+
+	TEST_RUN(VaTestNothingIsReadBeforeTheFirstSample);
+	TEST_RUN(VaTestSamplesFollowTheGame);
+	TEST_RUN(VaTestConcurrentReadersNeverTear);
+	TEST_RUN(VaTestSampleRateIsClamped);
+	TEST_RUN(VaTestDestroyNeverJoins);
+
+	VaDestroyOffsets();
+	VaDestroySafeMemory();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestNothingIsReadBeforeTheFirstSample(VOID)
+{
+	GAME_STATE state;
+
+	// A rate of one keeps the sampler asleep for the whole test
+	VaSetGameStateSampleRate(1);
+	VaCreateGameStateSampler();
+
+	TEST_CHECK(!VaReadGameState(&state));
+
+	VaDestroyGameStateSampler();
+}
+static VOID VaTestSamplesFollowTheGame(VOID)
+{
+	VaPublishPlayer(7);
+
+	VaSetGameStateSampleRate(1000);
+	VaCreateGameStateSampler();
+
+	TEST_CHECK(VaWaitForSamples(2));
+
+	GAME_STATE state;
+
+	TEST_CHECK(VaReadGameState(&state));
+	TEST_CHECK(state.PlayerValid);
+	TEST_CHECK((state.PlayerX == 7.0f) && (state.PlayerY == 14.0f) && (state.PlayerZ == 21.0f));
+	TEST_CHECK((state.CameraPitch == 0.25f) && (state.CameraYaw == 0.5f) && (state.Fov == 1.0f) && (state.CameraDistance == 2.0f) && (state.CameraHeight == 4.0f));
+	TEST_CHECK((state.WindowWidth == 1920) && (state.WindowHeight == 1080));
+
+	// Swinging the player pointer is picked up by the next sample through a re-walk of the chain
+	VaPublishPlayer(8);
+
+	GAME_STATE_STATISTICS statistics;
+
+	VaGetGameStateStatistics(&statistics);
+
+	TEST_CHECK(VaWaitForSamples(statistics.SampleCount + 2));
+	TEST_CHECK(VaReadGameState(&state));
+	TEST_CHECK(state.PlayerX == 8.0f);
+
+	// Without a player object the sample stays valid, only the player part is flagged
+	VaPublishPlayer(PLAYER_POOL_SIZE);
+
+	VaGetGameStateStatistics(&statistics);
+
+	TEST_CHECK(VaWaitForSamples(statistics.SampleCount + 2));
+	TEST_CHECK(VaReadGameState(&state));
+	TEST_CHECK(!state.PlayerValid);
+	TEST_CHECK(state.CameraDistance == 2.0f);
+
+	VaDestroyGameStateSampler();
+}
+static VOID VaTestConcurrentReadersNeverTear(VOID)
+{
+	VaPublishPlayer(0);
+
+	VaSetGameStateSampleRate(1000);
+	VaCreateGameStateSampler();
+
+	TEST_CHECK(VaWaitForSamples(1));
+
+	sRunning = TRUE;
+
+	READER_RESULT results[READER_COUNT] = { 0 };
+
+	std::thread game(VaRunGame);
+	std::thread readers[READER_COUNT];
+
+	for (UINT32 i = 0; i < READER_COUNT; i++)
+	{
+		readers[i] = std::thread(VaRunReader, &results[i]);
+	}
+
+	Sleep(CONCURRENT_DURATION);
+
+	sRunning = FALSE;
+
+	game.join();
+
+	for (UINT32 i = 0; i < READER_COUNT; i++)
+	{
+		readers[i].join();
+	}
+
+	GAME_STATE_STATISTICS statistics;
+
+	VaGetGameStateStatistics(&statistics);
+
+	VaDestroyGameStateSampler();
+
+	UINT64 readCount = 0;
+
+	// Every player object satisfies y = 2x and z = 3x, a copy mixing two samples breaks it as soon as the player moved
+	for (UINT32 i = 0; i < READER_COUNT; i++)
+	{
+		TEST_CHECK(results[i].ValidCount == results[i].ReadCount);
+		TEST_CHECK(results[i].TornCount == 0);
+		TEST_CHECK(results[i].BackwardCount == 0);
+
+		readCount += results[i].ReadCount;
+	}
+
+	TEST_CHECK(statistics.ReadCount >= readCount);
+	TEST_CHECK(statistics.SampleCount > (CONCURRENT_DURATION / 10));
+
+	printf("  %llu samples, %llu reads, %llu retries\n", statistics.SampleCount, readCount, statistics.RetryCount);
+}
+static VOID VaTestSampleRateIsClamped(VOID)
+{
+	GAME_STATE_STATISTICS statistics;
+
+	VaSetGameStateSampleRate(0);
+	VaGetGameStateStatistics(&statistics);
+
+	TEST_CHECK(statistics.Rate == 1);
+
+	VaSetGameStateSampleRate(1000000);
+	VaGetGameStateStatistics(&statistics);
+
+	TEST_CHECK(statistics.Rate == 1000);
+
+	VaSetGameStateSampleRate(GAME_STATE_DEFAULT_RATE);
+	VaGetGameStateStatistics(&statistics);
+
+	TEST_CHECK(statistics.Rate == GAME_STATE_DEFAULT_RATE);
+}
+static VOID VaTestDestroyNeverJoins(VOID)
+{
+	VaSetGameStateSampleRate(1000);
+	VaCreateGameStateSampler();
+
+	TEST_CHECK(VaWaitForSamples(1));
+
+	// Destroy runs under the loader lock, it may only wait for the done event and never on the thread handle
+	LONG threadWaitCount = gCompatThreadWaitCount;
+
+	VaDestroyGameStateSampler();
+
+	TEST_CHECK(gCompatThreadWaitCount == threadWaitCount);
+
+	UINT64 start = VaQueryTestTime();
+
+	while ((gCompatThreadCount != 0) && ((VaQueryTestTime() - start) < 1000000000ULL))
+	{
+		Sleep(1);
+	}
+
+	TEST_CHECK(gCompatThreadCount == 0);
+}
+
+static VOID VaRunGame(VOID)
+{
+	UINT32 index = 0;
+
+	// Moves the player about once per sample, objects are never reused so the sampler never copies one being written
+	while (sRunning && (index < (PLAYER_POOL_SIZE - 1)))
+	{
+		VaPublishPlayer(++index);
+
+		Sleep(1);
+	}
+}
+static VOID VaRunReader(READER_RESULT* Result)
+{
+	UINT64 lastIndex = 0;
+	UINT64 lastTime = 0;
+
+	while (sRunning)
+	{
+		GAME_STATE state;
+
+		if (!VaReadGameState(&state))
+		{
+			continue;
+		}
+
+		Result->ReadCount += 1;
+		Result->ValidCount += state.PlayerValid ? 1 : 0;
+
+		if ((state.PlayerY != (state.PlayerX * 2.0f)) || (state.PlayerZ != (state.PlayerX * 3.0f)) || (state.CameraDistance != 2.0f) || (state.WindowWidth != 1920))
+		{
+			Result->TornCount += 1;
+		}
+
+		if ((state.SampleIndex < lastIndex) || (state.SampleTime < lastTime))
+		{
+			Result->BackwardCount += 1;
+		}
+
+		lastIndex = state.SampleIndex;
+		lastTime = state.SampleTime;
+	}
+}
+
+static VOID VaPublishPlayer(UINT32 Index)
+{
+	// Past the pool the pointer is null, the game has no player object between levels
+	UINT64 address = (Index < PLAYER_POOL_SIZE) ? (UINT64)(sPlayerPool + (Index * PLAYER_OBJECT_STRIDE)) : 0;
+
+	WriteRelease64((volatile LONG64*)sMainModule, (LONG64)address);
+}
+
+static BOOL VaWaitForSamples(UINT64 Count)
+{
+	UINT64 start = VaQueryTestTime();
+
+	while ((VaQueryTestTime() - start) < 1000000000ULL)
+	{
+		GAME_STATE_STATISTICS statistics;
+
+		VaGetGameStateStatistics(&statistics);
+
+		if (statistics.SampleCount >= Count)
+		{
+			return TRUE;
+		}
+
+		Sleep(1);
+	}
+
+	return FALSE;
+}
+
+static UINT64 VaGetTestModule(LPCSTR ModuleName)
+{
+	if (strcmp(ModuleName, "main.dll") == 0)
+	{
+		return (UINT64)sMainModule;
+	}
+
+	if (strcmp(ModuleName, "flower_kernel.dll") == 0)
+	{
+		return (UINT64)sKernelModule;
+	}
+
+	return 0;
+}
\ No newline at end of file
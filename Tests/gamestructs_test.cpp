@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "safememory.h"
+#include "remotereader.h"
+#include "gamestructs.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define PAGE_SIZE (0x1000)
+
+// Every field type, declared out of order and starting away from the object base
+#define TEST_OBJECT_FIELDS(FIELD) \
+	FIELD(Health, 0x40, INT32) \
+	FIELD(Flags, 0x24, UINT8) \
+	FIELD(Level, 0x26, UINT16) \
+	FIELD(Id, 0x28, UINT64) \
+	FIELD(Speed, 0x30, FLOAT) \
+	FIELD(Time, 0x38, DOUBLE) \
+	FIELD(Mask, 0x44, UINT32)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+DECLARE_GAME_STRUCT(TEST_OBJECT, TEST_OBJECT_FIELDS);
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static_assert(TEST_OBJECT::FieldCount == 7, "Every declared field is counted");
+static_assert((TEST_OBJECT::Begin == 0x24) && (TEST_OBJECT::End == 0x48) && (TEST_OBJECT::Size == 0x24), "The plan spans the lowest to the highest field");
+static_assert((TEST_OBJECT::Level::Offset == 0x26) && (TEST_OBJECT::Level::End == 0x28), "Field tags carry their offset");
+static_assert(std::is_same<TEST_OBJECT::Time::Type, DOUBLE>::value && std::is_same<TEST_OBJECT::Health::Type, INT32>::value, "Field tags carry their type");
+static_assert(std::is_same<TEST_OBJECT::Speed::Owner, TEST_OBJECT>::value, "Field tags carry their owner");
+static_assert(sizeof(GAME_STRUCT_VIEW<TEST_OBJECT>) == TEST_OBJECT::Size, "A view is exactly the copied span");
+
+// Touching fields are fine, a single shared byte is not
+static constexpr GAME_FIELD_DESCRIPTION sTouchingFields[] = { { "A", 0x00, 4, GAME_FIELD_TYPE_U32 }, { "B", 0x04, 4, GAME_FIELD_TYPE_U32 } };
+static constexpr GAME_FIELD_DESCRIPTION sOverlappingFields[] = { { "A", 0x08, 8, GAME_FIELD_TYPE_U64 }, { "B", 0x00, 4, GAME_FIELD_TYPE_U32 }, { "C", 0x0F, 1, GAME_FIELD_TYPE_U8 } };
+
+static_assert(VaAreGameFieldsDisjoint(sTouchingFields, ARRAYSIZE(sTouchingFields)), "Adjacent fields do not overlap");
+static_assert(!VaAreGameFieldsDisjoint(sOverlappingFields, ARRAYSIZE(sOverlappingFields)), "Overlapping fields are found in any order");
+
+static UINT32 sReadCount = 0;
+static UINT64 sReadAddress = 0;
+static UINT64 sReadSize = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestViewsReadEveryFieldFromOneCopy(VOID);
+static VOID VaTestDescriptorsMatchTheDeclaration(VOID);
+static VOID VaTestSafeReadsUseOneAccess(VOID);
+static VOID VaTestRemoteBatchReadsTheSameSpan(VOID);
+
+static BOOL VaRecordRead(UINT64 Address, VOID* Buffer, UINT64 Size);
+static BOOL VaReadRemote(UINT64 Address, VOID* Buffer, UINT64 Size);
+
+static VOID VaWriteTestObject(PBYTE Object);
+static VOID VaCheckTestObject(const GAME_STRUCT_VIEW<TEST_OBJECT>* View);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateSafeMemory();
+
+	TEST_RUN(VaTestViewsReadEveryFieldFromOneCopy);
+	TEST_RUN(VaTestDescriptorsMatchTheDeclaration);
+	TEST_RUN(VaTestSafeReadsUseOneAccess);
+	TEST_RUN(VaTestRemoteBatchReadsTheSameSpan);
+
+	VaDestroySafeMemory();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestViewsReadEveryFieldFromOneCopy(VOID)
+{
+	alignas(16) BYTE blob[0x100];
+
+	memset(blob, 0xCC, sizeof(blob));
+
+	VaWriteTestObject(blob + 0x10);
+
+	GAME_STRUCT_VIEW<TEST_OBJECT> view;
+
+	sReadCount = 0;
+
+	TEST_CHECK(VaReadGameStruct(VaRecordRead, (UINT64)(blob + 0x10), &view));
+
+	// One copy from the first to the end of the last field, nothing of the object outside of it
+	TEST_CHECK(sReadCount == 1);
+	TEST_CHECK(sReadAddress == (UINT64)(blob + 0x10 + 0x24));
+	TEST_CHECK(sReadSize == 0x24);
+
+	VaCheckTestObject(&view);
+
+	// The declared player and camera layouts read the offsets the sampler used to read one by one
+	FLOAT position[] = { 1.5f, -2.5f, 3.25f };
+
+	memcpy(blob + 0x80, position, sizeof(position));
+
+	GAME_STRUCT_VIEW<PLAYER_OBJECT> player;
+
+	TEST_CHECK(VaReadGameStruct(VaRecordRead, (UINT64)blob, &player));
+	TEST_CHECK(sReadAddress == (UINT64)(blob + 0x80));
+	TEST_CHECK((player.Get<PLAYER_OBJECT::PositionX>() == 1.5f) && (player.Get<PLAYER_OBJECT::PositionY>() == -2.5f) && (player.Get<PLAYER_OBJECT::PositionZ>() == 3.25f));
+
+	// A missing object is not read at all
+	sReadCount = 0;
+
+	TEST_CHECK(!VaReadGameStruct(VaRecordRead, 0, &player));
+	TEST_CHECK(sReadCount == 0);
+}
+static VOID VaTestDescriptorsMatchTheDeclaration(VOID)
+{
+	GAME_STRUCT_DESCRIPTION description = TEST_OBJECT::Describe();
+
+	TEST_CHECK(strcmp(description.Name, "TEST_OBJECT") == 0);
+	TEST_CHECK((description.FieldCount == 7) && (description.Begin == 0x24) && (description.Size == 0x24));
+
+	// Tools see the fields in declaration order, with the size and type the accessors use
+	const GAME_FIELD_DESCRIPTION* fields = description.Fields;
+
+	TEST_CHECK((strcmp(fields[0].Name, "Health") == 0) && (fields[0].Offset == 0x40) && (fields[0].Size == 4) && (fields[0].Type == GAME_FIELD_TYPE_I32));
+	TEST_CHECK((strcmp(fields[1].Name, "Flags") == 0) && (fields[1].Size == 1) && (fields[1].Type == GAME_FIELD_TYPE_U8));
+	TEST_CHECK((strcmp(fields[2].Name, "Level") == 0) && (fields[2].Size == 2) && (fields[2].Type == GAME_FIELD_TYPE_U16));
+	TEST_CHECK((strcmp(fields[3].Name, "Id") == 0) && (fields[3].Size == 8) && (fields[3].Type == GAME_FIELD_TYPE_U64));
+	TEST_CHECK((strcmp(fields[4].Name, "Speed") == 0) && (fields[4].Size == 4) && (fields[4].Type == GAME_FIELD_TYPE_F32));
+	TEST_CHECK((strcmp(fields[5].Name, "Time") == 0) && (fields[5].Size == 8) && (fields[5].Type == GAME_FIELD_TYPE_F64));
+	TEST_CHECK((strcmp(fields[6].Name, "Mask") == 0) && (fields[6].Offset == 0x44) && (fields[6].Type == GAME_FIELD_TYPE_U32));
+
+	description = CAMERA_BLOCK::Describe();
+
+	TEST_CHECK(strcmp(description.Name, "CAMERA_BLOCK") == 0);
+	TEST_CHECK((description.FieldCount == 5) && (description.Begin == 0) && (description.Size == 0x54));
+	TEST_CHECK((strcmp(description.Fields[3].Name, "Distance") == 0) && (description.Fields[3].Offset == 0x4C));
+}
+static VOID VaTestSafeReadsUseOneAccess(VOID)
+{
+	PBYTE pages = (PBYTE)VirtualAlloc(NULL, 2 * PAGE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	// The object ends exactly at the end of the first page, the second one is not readable
+	PBYTE object = pages + PAGE_SIZE - TEST_OBJECT::End;
+
+	VaWriteTestObject(object);
+
+	DWORD oldProtect = 0;
+
+	VirtualProtect(pages + PAGE_SIZE, PAGE_SIZE, PAGE_NOACCESS, &oldProtect);
+
+	SAFE_MEMORY_STATISTICS before;
+	SAFE_MEMORY_STATISTICS after;
+
+	VaGetSafeMemoryStatistics(&before);
+
+	GAME_STRUCT_VIEW<TEST_OBJECT> view;
+
+	TEST_CHECK(VaReadGameStruct(VaSafeRead, (UINT64)object, &view));
+
+	VaGetSafeMemoryStatistics(&after);
+
+	// Seven fields, one checked access
+	TEST_CHECK(((after.HitCount + after.MissCount) - (before.HitCount + before.MissCount)) == 1);
+
+	VaCheckTestObject(&view);
+
+	// An object four bytes further runs into the unreadable page, the whole read fails instead of crashing
+	TEST_CHECK(!VaReadGameStruct(VaSafeRead, (UINT64)(object + 4), &view));
+
+	VaGetSafeMemoryStatistics(&before);
+
+	TEST_CHECK(before.FaultCount == after.FaultCount);
+
+	VirtualFree(pages, 0, MEM_RELEASE);
+
+	VaInvalidateSafeMemory();
+}
+static VOID VaTestRemoteBatchReadsTheSameSpan(VOID)
+{
+	alignas(16) BYTE blob[0x100];
+
+	memset(blob, 0xCC, sizeof(blob));
+
+	VaWriteTestObject(blob);
+
+	// The injector reads the same plan as one entry of a remote batch, here from its own process
+	VaCreateRemoteReader(GetCurrentProcess(), 1000);
+
+	GAME_STRUCT_VIEW<TEST_OBJECT> view;
+
+	memset(&view, 0, sizeof(view));
+
+	TEST_CHECK(VaReadGameStruct(VaReadRemote, (UINT64)blob, &view));
+
+	VaCheckTestObject(&view);
+
+	REMOTE_READER_STATISTICS statistics;
+
+	VaGetRemoteReaderStatistics(&statistics);
+
+	TEST_CHECK(statistics.ReadCount == 1);
+
+	VaDestroyRemoteReader();
+}
+
+static BOOL VaRecordRead(UINT64 Address, VOID* Buffer, UINT64 Size)
+{
+	sReadCount += 1;
+	sReadAddress = Address;
+	sReadSize = Size;
+
+	memcpy(Buffer, (const VOID*)Address, Size);
+
+	return TRUE;
+}
+static BOOL VaReadRemote(UINT64 Address, VOID* Buffer, UINT64 Size)
+{
+	REMOTE_READ read = { Address, (UINT32)Size, Buffer, FALSE };
+
+	return VaReadRemoteBatch(&read, 1) == 1;
+}
+
+static VOID VaWriteTestObject(PBYTE Object)
+{
+	INT32 health = -250;
+	UINT8 flags = 0xA5;
+	UINT16 level = 60;
+	UINT64 id = 0x0123456789ABCDEFULL;
+	FLOAT speed = 7.75f;
+	DOUBLE time = 12345.5;
+	UINT32 mask = 0xDEADBEEF;
+
+	memcpy(Object + TEST_OBJECT::Health::Offset, &health, sizeof(health));
+	memcpy(Object + TEST_OBJECT::Flags::Offset, &flags, sizeof(flags));
+	memcpy(Object + TEST_OBJECT::Level::Offset, &level, sizeof(level));
+	memcpy(Object + TEST_OBJECT::Id::Offset, &id, sizeof(id));
+	memcpy(Object + TEST_OBJECT::Speed::Offset, &speed, sizeof(speed));
+	memcpy(Object + TEST_OBJECT::Time::Offset, &time, sizeof(time));
+	memcpy(Object + TEST_OBJECT::Mask::Offset, &mask, sizeof(mask));
+}
+static VOID VaCheckTestObject(const GAME_STRUCT_VIEW<TEST_OBJECT>* View)
+{
+	TEST_CHECK(View->Get<TEST_OBJECT::Health>() == -250);
+	TEST_CHECK(View->Get<TEST_OBJECT::Flags>() == 0xA5);
+	TEST_CHECK(View->Get<TEST_OBJECT::Level>() == 60);
+	TEST_CHECK(View->Get<TEST_OBJECT::Id>() == 0x0123456789ABCDEFULL);
+	TEST_CHECK(View->Get<TEST_OBJECT::Speed>() == 7.75f);
+	TEST_CHECK(View->Get<TEST_OBJECT::Time>() == 12345.5);
+	TEST_CHECK(View->Get<TEST_OBJECT::Mask>() == 0xDEADBEEF);
+}
\ No newline at end of file
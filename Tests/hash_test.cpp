@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "hash.h"
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+// hash.cpp built a second time without SSE2, see the Makefile
+UINT64 VaHashMemoryScalar(const VOID* Data, SIZE_T Size);
+
+static VOID VaTestScalarMatchesVector(VOID);
+static VOID VaTestBitFlipsChangeHash(VOID);
+static VOID VaTestPaddingIsNotContent(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	TEST_RUN(VaTestScalarMatchesVector);
+	TEST_RUN(VaTestBitFlipsChangeHash);
+	TEST_RUN(VaTestPaddingIsNotContent);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestScalarMatchesVector(VOID)
+{
+	static BYTE data[4096 + 64];
+
+	UINT32 state = 0x12345678;
+
+	for (UINT32 i = 0; i < sizeof(data); i++)
+	{
+		state = state * 1664525 + 1013904223;
+
+		data[i] = (BYTE)(state >> 24);
+	}
+
+	UINT32 mismatchCount = 0;
+
+	// Every size up to a few blocks, at an aligned and an unaligned start, covers the short, tail and scramble paths
+	for (UINT32 size = 0; size <= 4096; size++)
+	{
+		mismatchCount += VaHashMemory(data, size) != VaHashMemoryScalar(data, size);
+		mismatchCount += VaHashMemory(data + 3, size) != VaHashMemoryScalar(data + 3, size);
+	}
+
+	TEST_CHECK(mismatchCount == 0);
+}
+static VOID VaTestBitFlipsChangeHash(VOID)
+{
+	static BYTE data[300];
+
+	memset(data, 0xA5, sizeof(data));
+
+	UINT32 unchangedCount = 0;
+
+	for (UINT32 size = 1; size <= sizeof(data); size += 7)
+	{
+		UINT64 hash = VaHashMemory(data, size);
+
+		for (UINT32 bit = 0; bit < size * 8; bit++)
+		{
+			data[bit / 8] ^= (BYTE)(1 << (bit % 8));
+
+			unchangedCount += VaHashMemory(data, size) == hash;
+
+			data[bit / 8] ^= (BYTE)(1 << (bit % 8));
+		}
+	}
+
+	TEST_CHECK(unchangedCount == 0);
+}
+static VOID VaTestPaddingIsNotContent(VOID)
+{
+	BYTE zeros[128] = { 0 };
+
+	// Short inputs are zero padded and long ones overlap their last stripe, the length keeps both apart
+	for (UINT32 size = 0; size < 127; size++)
+	{
+		TEST_CHECK(VaHashMemory(zeros, size) != VaHashMemory(zeros, size + 1));
+	}
+}
\ No newline at end of file
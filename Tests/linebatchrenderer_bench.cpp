@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "linebatchrenderer.h"
+#include "uploadring.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define BENCH_FRAME_COUNT (8)
+#define BENCH_LINE_COUNT (1000000)
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaBenchLineThroughput(VOID);
+static VOID VaBenchGridThroughput(VOID);
+static VOID VaBenchBoxThroughput(VOID);
+static VOID VaBenchCulling(VOID);
+
+static VOID VaRenderBenchFrame(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateTestRenderer();
+	VaCreateLineBatchRenderer();
+
+	VaBenchLineThroughput();
+	VaBenchGridThroughput();
+	VaBenchBoxThroughput();
+	VaBenchCulling();
+
+	VaDestroyLineBatchRenderer();
+	VaDestroyTestRenderer();
+
+	return 0;
+}
+
+static VOID VaBenchLineThroughput(VOID)
+{
+	UINT64 recordTime = 0;
+	UINT64 flushTime = 0;
+
+	UPLOAD_RING_STATISTICS before;
+	UPLOAD_RING_STATISTICS after;
+
+	VaGetUploadRingStatistics(&before);
+
+	for (UINT32 frame = 0; frame < BENCH_FRAME_COUNT; frame++)
+	{
+		UINT64 start = VaQueryTestTime();
+
+		// Every frame moves the lines a little, so the upload cache never gets to skip a chunk
+		for (UINT32 i = 0; i < BENCH_LINE_COUNT; i++)
+		{
+			FLOAT x = ((FLOAT)(i % 1000) / 1000.0f) - 0.5f + (FLOAT)frame * 0.001f;
+
+			VaDrawLine({ x, -0.5f, 0.5f }, { x, 0.5f, 0.5f }, { 1.0f, 0.5f, 0.25f, 1.0f });
+		}
+
+		UINT64 middle = VaQueryTestTime();
+
+		VaRenderBenchFrame();
+
+		recordTime += middle - start;
+		flushTime += VaQueryTestTime() - middle;
+	}
+
+	VaGetUploadRingStatistics(&after);
+
+	DOUBLE lineCount = (DOUBLE)BENCH_LINE_COUNT * BENCH_FRAME_COUNT;
+
+	printf("line record %.1f M lines/s, flush %.1f M lines/s\n", lineCount / (recordTime / 1000.0), lineCount / (flushTime / 1000.0));
+	printf("line upload %.1f bytes per line, vertex %u bytes\n", (DOUBLE)(after.UploadedBytes - before.UploadedBytes) / lineCount, (UINT32)sizeof(VERTEX));
+}
+static VOID VaBenchGridThroughput(VOID)
+{
+	UINT64 recordTime = 0;
+
+	for (UINT32 frame = 0; frame < BENCH_FRAME_COUNT; frame++)
+	{
+		UINT64 start = VaQueryTestTime();
+
+		for (UINT32 i = 0; i < 64; i++)
+		{
+			VaDrawGrid({ 0.0f, (FLOAT)i * 0.01f, 0.5f }, 1.0f, 4095, { 1.0f, 1.0f, 0.0f, 1.0f });
+		}
+
+		recordTime += VaQueryTestTime() - start;
+
+		VaRenderBenchFrame();
+	}
+
+	printf("grid record %.1f M lines/s\n", 64.0 * 4096.0 * 2.0 * BENCH_FRAME_COUNT / (recordTime / 1000.0));
+}
+static VOID VaBenchBoxThroughput(VOID)
+{
+	UINT64 recordTime = 0;
+
+	for (UINT32 frame = 0; frame < BENCH_FRAME_COUNT; frame++)
+	{
+		UINT64 start = VaQueryTestTime();
+
+		for (UINT32 i = 0; i < 100000; i++)
+		{
+			FLOAT x = ((FLOAT)(i % 1000) / 1000.0f) - 0.5f;
+
+			VaDrawBox({ x, 0.0f, 0.5f }, { 0.01f, 0.01f, 0.01f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+		}
+
+		recordTime += VaQueryTestTime() - start;
+
+		VaRenderBenchFrame();
+	}
+
+	printf("box record %.1f M boxes/s\n", 100000.0 * BENCH_FRAME_COUNT / (recordTime / 1000.0));
+}
+static VOID VaBenchCulling(VOID)
+{
+	// The same 100000 boxes once all inside the frustum and once spread so that half of them fall outside
+	for (UINT32 spread = 1; spread <= 2; spread++)
+	{
+		UINT64 flushTime = 0;
+		UINT64 keptCount = 0;
+		UINT64 culledCount = 0;
+
+		UPLOAD_RING_STATISTICS before;
+		UPLOAD_RING_STATISTICS after;
+
+		VaGetUploadRingStatistics(&before);
+
+		for (UINT32 frame = 0; frame < BENCH_FRAME_COUNT; frame++)
+		{
+			for (UINT32 i = 0; i < 100000; i++)
+			{
+				FLOAT x = (((FLOAT)(i % 1000) / 1000.0f) * 1.8f - 0.9f) * (FLOAT)spread + (FLOAT)frame * 0.0001f;
+
+				VaDrawBox({ x, 0.0f, 0.5f }, { 0.01f, 0.01f, 0.01f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+			}
+
+			UINT64 start = VaQueryTestTime();
+
+			VaRenderBenchFrame();
+
+			flushTime += VaQueryTestTime() - start;
+
+			LINE_BATCH_STATISTICS statistics;
+
+			VaGetLineBatchStatistics(&statistics);
+
+			keptCount += statistics.KeptPrimitiveCount;
+			culledCount += statistics.CulledPrimitiveCount;
+		}
+
+		VaGetUploadRingStatistics(&after);
+
+		printf("cull 100k boxes %s, %.1f%% culled, flush %.2f ms, upload %.1f MiB and %.1f MiB cached per frame\n", (spread == 1) ? "inside" : "spread", 100.0 * culledCount / (keptCount + culledCount), flushTime / 1000000.0 / BENCH_FRAME_COUNT, (after.UploadedBytes - before.UploadedBytes) / (1024.0 * 1024.0) / BENCH_FRAME_COUNT, (after.SkippedBytes - before.SkippedBytes) / (1024.0 * 1024.0) / BENCH_FRAME_COUNT);
+	}
+}
+
+static VOID VaRenderBenchFrame(VOID)
+{
+	VaBeginTestFrame();
+
+	VaRenderLineBatch();
+
+	VaEndTestFrame();
+}
\ No newline at end of file
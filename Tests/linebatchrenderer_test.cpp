@@ -0,0 +1,619 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <thread>
+
+#include "testing.h"
+#include "linebatchrenderer.h"
+#include "uploadring.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define CHUNK_VERTEX_COUNT (65535)
+
+#define PRODUCER_THREAD_COUNT (6)
+#define PRODUCER_LINE_COUNT (300000)
+
+#define TRIM_FRAME_COUNT (130)
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestLinesBeyondOneChunk(VOID);
+static VOID VaTestBoxesBeyondOneChunk(VOID);
+static VOID VaTestChunksAreReused(VOID);
+static VOID VaTestLinesSkipIndexBuffer(VOID);
+static VOID VaTestPackedColors(VOID);
+static VOID VaTestGridMatchesScalar(VOID);
+static VOID VaTestBoxMatchesScalar(VOID);
+static VOID VaTestConcurrentProducers(VOID);
+static VOID VaTestIdleProducersAreTrimmed(VOID);
+static VOID VaTestProducersSurviveRecreate(VOID);
+static VOID VaTestFrustumCulling(VOID);
+static VOID VaTestUnchangedChunksSkipUpload(VOID);
+
+static VOID VaRecordProducerLines(UINT32 Index);
+
+static VOID VaRenderTestFrame(TEST_FRAME_CAPTURE* Capture, LINE_BATCH_STATISTICS* Statistics);
+static VOID VaRenderCapturedFrame(TEST_FRAME_CAPTURE* Capture, VERTEX* Vertices, UINT64 VertexCapacity);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateTestRenderer();
+	VaCreateLineBatchRenderer();
+
+	TEST_RUN(VaTestLinesBeyondOneChunk);
+	TEST_RUN(VaTestBoxesBeyondOneChunk);
+	TEST_RUN(VaTestChunksAreReused);
+	TEST_RUN(VaTestLinesSkipIndexBuffer);
+	TEST_RUN(VaTestPackedColors);
+	TEST_RUN(VaTestGridMatchesScalar);
+	TEST_RUN(VaTestBoxMatchesScalar);
+	TEST_RUN(VaTestConcurrentProducers);
+	TEST_RUN(VaTestIdleProducersAreTrimmed);
+	TEST_RUN(VaTestProducersSurviveRecreate);
+	TEST_RUN(VaTestFrustumCulling);
+	TEST_RUN(VaTestUnchangedChunksSkipUpload);
+
+	VaDestroyLineBatchRenderer();
+	VaDestroyTestRenderer();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestLinesBeyondOneChunk(VOID)
+{
+	// The old fixed arrays silently dropped everything past 65535 vertices, two million lines span 31 chunks
+	UINT32 lineCount = 2000000;
+
+	for (UINT32 i = 0; i < lineCount; i++)
+	{
+		FLOAT x = ((FLOAT)(i % 1000) / 1000.0f) - 0.5f;
+
+		VaDrawLine({ x, -0.5f, 0.5f }, { x, 0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+	}
+
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	UINT32 minimumDrawCount = (lineCount * 2 + CHUNK_VERTEX_COUNT - 1) / CHUNK_VERTEX_COUNT;
+
+	TEST_CHECK(statistics.VertexCount == (UINT64)lineCount * 2);
+	TEST_CHECK(capture.VertexCount == (UINT64)lineCount * 2);
+	TEST_CHECK(capture.ColorSum == (UINT64)lineCount * 2 * 0xFFFFFFFFULL);
+	TEST_CHECK(statistics.DrawCount >= minimumDrawCount);
+	TEST_CHECK(statistics.ChunkCount >= minimumDrawCount);
+
+	printf("  %u lines in %u chunks and %u draws, %.1f MiB allocated\n", lineCount, statistics.ChunkCount, statistics.DrawCount, statistics.AllocatedBytes / (1024.0 * 1024.0));
+}
+static VOID VaTestBoxesBeyondOneChunk(VOID)
+{
+	// Eight vertices and 24 indices per box, 100000 boxes need 13 indexed chunks
+	UINT32 boxCount = 100000;
+
+	for (UINT32 i = 0; i < boxCount; i++)
+	{
+		FLOAT x = ((FLOAT)(i % 100) / 100.0f) - 0.5f;
+
+		VaDrawBox({ x, 0.0f, 0.5f }, { 0.01f, 0.01f, 0.01f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+	}
+
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	TEST_CHECK(statistics.VertexCount == (UINT64)boxCount * 8);
+	TEST_CHECK(statistics.IndexCount == (UINT64)boxCount * 24);
+	TEST_CHECK(capture.IndexCount == (UINT64)boxCount * 24);
+	TEST_CHECK(statistics.DrawCount >= ((boxCount * 8 + CHUNK_VERTEX_COUNT - 1) / CHUNK_VERTEX_COUNT));
+}
+static VOID VaTestChunksAreReused(VOID)
+{
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	UINT32 chunkCount = 0;
+	UINT64 allocatedBytes = 0;
+
+	// Recording the same amount every frame must run on the chunks of the first two frames, one per epoch half
+	for (UINT32 frame = 0; frame < 10; frame++)
+	{
+		for (UINT32 i = 0; i < 200000; i++)
+		{
+			VaDrawLine({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.5f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+		}
+
+		VaRenderTestFrame(&capture, &statistics);
+
+		TEST_CHECK(capture.VertexCount == 400000);
+
+		if (frame == 1)
+		{
+			chunkCount = statistics.ChunkCount;
+			allocatedBytes = statistics.AllocatedBytes;
+		}
+	}
+
+	TEST_CHECK(statistics.ChunkCount == chunkCount);
+	TEST_CHECK(statistics.AllocatedBytes == allocatedBytes);
+}
+static VOID VaTestLinesSkipIndexBuffer(VOID)
+{
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	// Lines and grids are drawn without indices, only the shared box corners still go through DrawIndexed
+	for (UINT32 i = 0; i < 1000; i++)
+	{
+		VaDrawLine({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.5f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+	}
+
+	VaDrawGrid({ 0.0f, 0.0f, 0.5f }, 1.0f, 10, { 1.0f, 1.0f, 0.0f, 1.0f });
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	D3D11_MOCK_STATISTICS after = gMockContext->Statistics;
+
+	UINT64 lineVertexCount = 1000 * 2 + 11 * 4;
+
+	TEST_CHECK(after.DrawIndexedCount == before.DrawIndexedCount);
+	TEST_CHECK(after.DrawnVertexCount - before.DrawnVertexCount == lineVertexCount);
+	TEST_CHECK(statistics.IndexCount == 0);
+	TEST_CHECK(statistics.IndexedBytes == 0);
+	TEST_CHECK(statistics.NonIndexedBytes == lineVertexCount * sizeof(VERTEX));
+
+	before = after;
+
+	for (UINT32 i = 0; i < 1000; i++)
+	{
+		VaDrawBox({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.1f }, { 0.0f, 0.0f, 1.0f, 1.0f });
+	}
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	after = gMockContext->Statistics;
+
+	TEST_CHECK(after.DrawCount == before.DrawCount);
+	TEST_CHECK(after.DrawnIndexCount - before.DrawnIndexCount == 1000 * 24);
+	TEST_CHECK(statistics.NonIndexedBytes == 0);
+	TEST_CHECK(statistics.IndexedBytes == 1000 * (8 * sizeof(VERTEX) + 24 * sizeof(UINT16)));
+
+	printf("  line %llu bytes, box %llu bytes\n", (UINT64)(2 * sizeof(VERTEX)), statistics.IndexedBytes / 1000);
+}
+static VOID VaTestPackedColors(VOID)
+{
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	TEST_CHECK(sizeof(VERTEX) == 16);
+
+	// R8G8B8A8_UNORM keeps red in the lowest byte, values round to the nearest step and clamp to 0..1
+	TEST_CHECK(VaPackColor({ 1.0f, 0.0f, 0.0f, 0.0f }) == 0x000000FF);
+	TEST_CHECK(VaPackColor({ 0.0f, 0.0f, 0.0f, 1.0f }) == 0xFF000000);
+	TEST_CHECK(VaPackColor({ 0.2f, 0.4f, 0.6f, 0.8f }) == 0xCC996633);
+	TEST_CHECK(VaPackColor({ -1.0f, 2.0f, 0.5f, 1.0f }) == 0xFF80FF00);
+
+	VaDrawLine({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.5f }, { 0.2f, 0.4f, 0.6f, 0.8f });
+	VaDrawBox({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.1f }, { 0.2f, 0.4f, 0.6f, 0.8f });
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	// Both vertices of the line and all 24 box indices must reference the packed word unchanged
+	TEST_CHECK(capture.ColorSum == 26 * 0xCC996633ULL);
+	TEST_CHECK(capture.PositionSum > 0.0);
+}
+static VOID VaTestGridMatchesScalar(VOID)
+{
+	static VERTEX vertices[64];
+
+	TEST_FRAME_CAPTURE capture;
+
+	XMFLOAT3 p = { 0.1f, 0.05f, 0.3f };
+
+	FLOAT s = 0.5f;
+
+	// 13 cells run the four wide loop three times and the scalar tail twice
+	UINT32 n = 13;
+
+	VaDrawGrid(p, s, n, { 0.2f, 0.4f, 0.6f, 0.8f });
+
+	VaRenderCapturedFrame(&capture, vertices, 64);
+
+	TEST_CHECK(capture.VertexCount == (n + 1) * 4);
+
+	FLOAT ss = s / n;
+	FLOAT hs = s / 2.0F;
+
+	BOOL exact = TRUE;
+
+	// The positions of the scalar generator this replaced, every component has to match bit for bit
+	for (UINT32 i = 0; i <= n; i++)
+	{
+		FLOAT go = ((FLOAT)i) * ss - hs;
+
+		XMFLOAT3 expected[4] =
+		{
+			{ p.x + go, p.y, p.z - hs },
+			{ p.x + go, p.y, p.z + hs },
+			{ p.x - hs, p.y, p.z + go },
+			{ p.x + hs, p.y, p.z + go },
+		};
+
+		for (UINT32 j = 0; j < 4; j++)
+		{
+			exact &= memcmp(&vertices[i * 4 + j].Position, &expected[j], sizeof(XMFLOAT3)) == 0;
+			exact &= vertices[i * 4 + j].Color == 0xCC996633;
+		}
+	}
+
+	TEST_CHECK(exact);
+}
+static VOID VaTestBoxMatchesScalar(VOID)
+{
+	static const UINT16 edges[24] = { 0, 1, 0, 2, 2, 3, 3, 1, 4, 5, 4, 6, 6, 7, 7, 5, 0, 4, 1, 5, 2, 6, 3, 7 };
+
+	static VERTEX vertices[24];
+
+	TEST_FRAME_CAPTURE capture;
+
+	XMFLOAT3 p = { 0.1f, 0.2f, 0.5f };
+	XMFLOAT3 s = { 0.2f, 0.1f, 0.3f };
+
+	VaDrawBox(p, s, { 1.0f, 0.0f, 0.0f, 1.0f });
+
+	VaRenderCapturedFrame(&capture, vertices, 24);
+
+	TEST_CHECK(capture.IndexCount == 24);
+
+	XMFLOAT3 min = { p.x - s.x * 0.5f, p.y - s.y * 0.5f, p.z - s.z * 0.5f };
+	XMFLOAT3 max = { p.x + s.x * 0.5f, p.y + s.y * 0.5f, p.z + s.z * 0.5f };
+
+	BOOL exact = TRUE;
+
+	// Corner k takes x, y and z from the maximum where bit 0, 1 and 2 of k are set
+	for (UINT32 i = 0; i < 24; i++)
+	{
+		UINT32 k = edges[i];
+
+		XMFLOAT3 expected = { (k & 1) ? max.x : min.x, (k & 2) ? max.y : min.y, (k & 4) ? max.z : min.z };
+
+		exact &= memcmp(&vertices[i].Position, &expected, sizeof(XMFLOAT3)) == 0;
+		exact &= vertices[i].Color == 0xFF0000FF;
+	}
+
+	TEST_CHECK(exact);
+}
+static VOID VaTestConcurrentProducers(VOID)
+{
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	volatile LONG finishedCount = 0;
+
+	std::thread threads[PRODUCER_THREAD_COUNT];
+
+	// Producers record while the render thread keeps flipping epochs, every line has to be drawn exactly once
+	VaBeginFrameCapture(&capture, NULL, 0);
+
+	for (UINT32 i = 0; i < PRODUCER_THREAD_COUNT; i++)
+	{
+		threads[i] = std::thread([i, &finishedCount]()
+		{
+			VaRecordProducerLines(i);
+
+			InterlockedIncrement(&finishedCount);
+		});
+	}
+
+	UINT32 frameCount = 0;
+
+	UINT32 maximumProducerCount = 0;
+	UINT32 deferredCount = 0;
+	UINT32 retiredCount = 0;
+
+	while (finishedCount < PRODUCER_THREAD_COUNT)
+	{
+		VaBeginTestFrame();
+
+		VaRenderLineBatch();
+
+		VaEndTestFrame();
+
+		VaGetLineBatchStatistics(&statistics);
+
+		maximumProducerCount = max(maximumProducerCount, statistics.ProducerCount);
+		deferredCount += statistics.DeferredProducerCount;
+		retiredCount += statistics.RetiredProducerCount;
+
+		frameCount += 1;
+	}
+
+	for (UINT32 i = 0; i < PRODUCER_THREAD_COUNT; i++)
+	{
+		threads[i].join();
+	}
+
+	// The exited threads retired their producers, whatever they left in either half is drawn by the next two frames
+	for (UINT32 i = 0; i < 2; i++)
+	{
+		VaBeginTestFrame();
+
+		VaRenderLineBatch();
+
+		VaEndTestFrame();
+
+		VaGetLineBatchStatistics(&statistics);
+
+		retiredCount += statistics.RetiredProducerCount;
+	}
+
+	VaEndFrameCapture();
+
+	UINT64 boxCount = (PRODUCER_LINE_COUNT + 63) / 64;
+	UINT64 expectedColorSum = 0;
+
+	for (UINT32 i = 0; i < PRODUCER_THREAD_COUNT; i++)
+	{
+		expectedColorSum += (UINT64)VaPackColor({ (FLOAT)(i + 1) / 8.0f, 0.0f, 0.0f, 1.0f }) * (PRODUCER_LINE_COUNT * 2 + boxCount * 24);
+	}
+
+	TEST_CHECK(capture.VertexCount == (UINT64)PRODUCER_THREAD_COUNT * PRODUCER_LINE_COUNT * 2);
+	TEST_CHECK(capture.IndexCount == PRODUCER_THREAD_COUNT * boxCount * 24);
+	TEST_CHECK(capture.ColorSum == expectedColorSum);
+	TEST_CHECK(retiredCount == PRODUCER_THREAD_COUNT);
+	TEST_CHECK(statistics.ProducerCount == 1);
+
+	printf("  %u producers over %u frames, %u peak, %u deferred flushes\n", PRODUCER_THREAD_COUNT, frameCount, maximumProducerCount, deferredCount);
+}
+static VOID VaTestIdleProducersAreTrimmed(VOID)
+{
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	for (UINT32 i = 0; i < 100000; i++)
+	{
+		VaDrawLine({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.5f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+	}
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	TEST_CHECK(statistics.ChunkCount > 0);
+
+	UINT32 trimmedCount = 0;
+
+	// A producer that recorded nothing for many frames gives its chunks back and allocates again on its next record
+	for (UINT32 i = 0; i < TRIM_FRAME_COUNT; i++)
+	{
+		VaRenderTestFrame(&capture, &statistics);
+
+		trimmedCount += statistics.TrimmedProducerCount;
+	}
+
+	TEST_CHECK(trimmedCount == 1);
+	TEST_CHECK(statistics.ChunkCount == 0);
+	TEST_CHECK(statistics.AllocatedBytes == 0);
+
+	VaDrawLine({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.5f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	TEST_CHECK(capture.VertexCount == 2);
+	TEST_CHECK(statistics.ChunkCount == 1);
+}
+static VOID VaTestProducersSurviveRecreate(VOID)
+{
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	HANDLE recordedEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+	HANDLE recreatedEvent = CreateEventA(NULL, FALSE, FALSE, NULL);
+
+	// The thread keeps its producer slot across a destroy, its next record has to register with the new renderer
+	std::thread thread([recordedEvent, recreatedEvent]()
+	{
+		VaDrawLine({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.5f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+
+		SetEvent(recordedEvent);
+		WaitForSingleObject(recreatedEvent, INFINITE);
+
+		for (UINT32 i = 0; i < 10; i++)
+		{
+			VaDrawLine({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.5f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+		}
+	});
+
+	WaitForSingleObject(recordedEvent, INFINITE);
+
+	VaDestroyLineBatchRenderer();
+	VaCreateLineBatchRenderer();
+
+	SetEvent(recreatedEvent);
+
+	thread.join();
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	TEST_CHECK(capture.VertexCount == 20);
+	TEST_CHECK(capture.ColorSum == 20ULL * VaPackColor({ 0.0f, 1.0f, 0.0f, 1.0f }));
+	TEST_CHECK(statistics.RetiredProducerCount == 1);
+	TEST_CHECK(statistics.ProducerCount == 0);
+
+	CloseHandle(recordedEvent);
+	CloseHandle(recreatedEvent);
+}
+static VOID VaTestFrustumCulling(VOID)
+{
+	static VERTEX vertices[64];
+
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	// With an identity view projection the frustum is x and y in -1..1 and z in 0..1
+	VaDrawBox({ 0.0f, 0.0f, 0.5f }, { 0.2f, 0.2f, 0.2f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+	VaDrawBox({ 3.0f, 0.0f, 0.5f }, { 0.2f, 0.2f, 0.2f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+	VaDrawBox({ 0.0f, 0.0f, -2.0f }, { 0.2f, 0.2f, 0.2f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+	VaDrawBox({ 1.05f, 0.0f, 0.5f }, { 0.2f, 0.2f, 0.2f }, { 0.0f, 0.0f, 1.0f, 1.0f });
+	VaDrawBox({ 0.0f, -5.0f, 0.5f }, { 0.2f, 0.2f, 0.2f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+
+	// A line is kept as soon as its box touches the frustum, even when both end points are outside
+	VaDrawLine({ -3.0f, 0.0f, 0.5f }, { 3.0f, 0.0f, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+	VaDrawLine({ -3.0f, 2.0f, 0.5f }, { 3.0f, 2.0f, 0.5f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+
+	VaBeginFrameCapture(&capture, vertices, 64);
+	VaBeginTestFrame();
+
+	VaRenderLineBatch();
+
+	VaEndTestFrame();
+	VaEndFrameCapture();
+
+	VaGetLineBatchStatistics(&statistics);
+
+	UINT64 visibleColorSum = 2ULL * 0xFFFFFFFF + 24ULL * VaPackColor({ 1.0f, 0.0f, 0.0f, 1.0f }) + 24ULL * VaPackColor({ 0.0f, 0.0f, 1.0f, 1.0f });
+
+	TEST_CHECK(statistics.KeptPrimitiveCount == 3);
+	TEST_CHECK(statistics.CulledPrimitiveCount == 4);
+	TEST_CHECK(capture.VertexCount == 2);
+	TEST_CHECK(capture.IndexCount == 48);
+	TEST_CHECK(capture.ColorSum == visibleColorSum);
+
+	// Moving the camera brings the far box in, the culled box indices have to be rebased onto the compacted vertices
+	VaSetTestViewProjection(XMMatrixTranslation(-3.0f, 0.0f, 0.0f));
+
+	VaDrawBox({ 0.0f, 0.0f, 0.5f }, { 0.2f, 0.2f, 0.2f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+	VaDrawBox({ 3.0f, 0.0f, 0.5f }, { 0.2f, 0.2f, 0.2f }, { 0.0f, 1.0f, 0.0f, 1.0f });
+
+	VaRenderCapturedFrame(&capture, vertices, 64);
+
+	VaGetLineBatchStatistics(&statistics);
+
+	TEST_CHECK(statistics.KeptPrimitiveCount == 1);
+	TEST_CHECK(statistics.CulledPrimitiveCount == 1);
+	TEST_CHECK(capture.IndexCount == 24);
+	TEST_CHECK(capture.ColorSum == 24ULL * VaPackColor({ 0.0f, 1.0f, 0.0f, 1.0f }));
+	TEST_CHECK((vertices[0].Position.x > 2.8f) && (vertices[0].Position.x < 3.2f));
+
+	VaSetTestViewProjection(XMMatrixIdentity());
+}
+static VOID VaTestUnchangedChunksSkipUpload(VOID)
+{
+	TEST_FRAME_CAPTURE capture;
+	LINE_BATCH_STATISTICS statistics;
+
+	UPLOAD_RING_STATISTICS before;
+	UPLOAD_RING_STATISTICS after;
+
+	UINT64 colorSum = 0;
+
+	// The second and third frame record exactly the same lines and are drawn from the regions the first one uploaded
+	for (UINT32 frame = 0; frame < 3; frame++)
+	{
+		for (UINT32 i = 0; i < 50000; i++)
+		{
+			FLOAT x = ((FLOAT)(i % 1000) / 1000.0f) - 0.5f;
+
+			VaDrawLine({ x, -0.5f, 0.5f }, { x, 0.5f, 0.5f }, { 0.0f, 0.5f, 1.0f, 1.0f });
+		}
+
+		VaDrawBox({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.1f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+
+		VaGetUploadRingStatistics(&before);
+
+		VaRenderTestFrame(&capture, &statistics);
+
+		VaGetUploadRingStatistics(&after);
+
+		if (frame == 0)
+		{
+			colorSum = capture.ColorSum;
+
+			TEST_CHECK((after.UploadedBytes - before.UploadedBytes) + (after.SkippedBytes - before.SkippedBytes) == 100000 * sizeof(VERTEX) + 8 * sizeof(VERTEX) + 24 * sizeof(UINT16));
+		}
+		else
+		{
+			TEST_CHECK(after.UploadedBytes == before.UploadedBytes);
+			TEST_CHECK(after.SkippedBytes - before.SkippedBytes == 100000 * sizeof(VERTEX) + 8 * sizeof(VERTEX) + 24 * sizeof(UINT16));
+			TEST_CHECK(after.HitCount - before.HitCount == 4);
+		}
+
+		TEST_CHECK(capture.VertexCount == 100000);
+		TEST_CHECK(capture.IndexCount == 24);
+		TEST_CHECK(capture.ColorSum == colorSum);
+	}
+
+	// A single changed vertex has to be uploaded again, only its chunk misses
+	for (UINT32 i = 0; i < 50000; i++)
+	{
+		FLOAT x = ((FLOAT)(i % 1000) / 1000.0f) - 0.5f;
+
+		VaDrawLine({ x, -0.5f, 0.5f }, { x, (i == 49999) ? 0.25f : 0.5f, 0.5f }, { 0.0f, 0.5f, 1.0f, 1.0f });
+	}
+
+	VaGetUploadRingStatistics(&before);
+
+	VaRenderTestFrame(&capture, &statistics);
+
+	VaGetUploadRingStatistics(&after);
+
+	TEST_CHECK(after.MissCount - before.MissCount == 1);
+	TEST_CHECK(after.HitCount - before.HitCount == 1);
+}
+
+static VOID VaRecordProducerLines(UINT32 Index)
+{
+	XMFLOAT4 color = { (FLOAT)(Index + 1) / 8.0f, 0.0f, 0.0f, 1.0f };
+
+	// Lines and boxes are interleaved so both chains of a producer are written while the epoch flips under them
+	for (UINT32 i = 0; i < PRODUCER_LINE_COUNT; i++)
+	{
+		FLOAT x = ((FLOAT)(i % 1000) / 1000.0f) - 0.5f;
+
+		VaDrawLine({ x, -0.5f, 0.5f }, { x, 0.5f, 0.5f }, color);
+
+		if ((i % 64) == 0)
+		{
+			VaDrawBox({ x, 0.0f, 0.5f }, { 0.01f, 0.01f, 0.01f }, color);
+		}
+
+		// Gives the render thread a chance to flip while this producer is mid stream, even on a single core
+		if ((i % 4096) == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+static VOID VaRenderTestFrame(TEST_FRAME_CAPTURE* Capture, LINE_BATCH_STATISTICS* Statistics)
+{
+	VaBeginFrameCapture(Capture, NULL, 0);
+	VaBeginTestFrame();
+
+	VaRenderLineBatch();
+
+	VaEndTestFrame();
+	VaEndFrameCapture();
+
+	VaGetLineBatchStatistics(Statistics);
+}
+static VOID VaRenderCapturedFrame(TEST_FRAME_CAPTURE* Capture, VERTEX* Vertices, UINT64 VertexCapacity)
+{
+	VaBeginFrameCapture(Capture, Vertices, VertexCapacity);
+	VaBeginTestFrame();
+
+	VaRenderLineBatch();
+
+	VaEndTestFrame();
+	VaEndFrameCapture();
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "testing.h"
+#include "logger.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define BENCH_BATCH_COUNT (512)
+#define BENCH_BATCH_SIZE (2048)
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaBenchRecordedCall(VOID);
+static VOID VaBenchSuppressedCall(VOID);
+static VOID VaBenchPrintfCall(VOID);
+
+static VOID VaFlushWithoutConsole(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateLogger("/dev/null");
+
+	VaBenchRecordedCall();
+	VaBenchSuppressedCall();
+	VaBenchPrintfCall();
+
+	VaDestroyLogger();
+
+	return 0;
+}
+
+static VOID VaBenchRecordedCall(VOID)
+{
+	static LOG_SITE site = { "[%f %f] [%f %f %f]", 0xFFFFFFFF };
+
+	UINT64 callTime = 0;
+	UINT64 flushTime = 0;
+
+	// The same five floats the camera line logs, a batch always fits the ring so no call is dropped
+	for (UINT32 batch = 0; batch < BENCH_BATCH_COUNT; batch++)
+	{
+		UINT64 start = VaQueryTestTime();
+
+		for (UINT32 i = 0; i < BENCH_BATCH_SIZE; i++)
+		{
+			FLOAT value = (FLOAT)i;
+
+			VaLog(&site, value, value + 1.0f, value + 2.0f, value + 3.0f, value + 4.0f);
+		}
+
+		UINT64 end = VaQueryTestTime();
+
+		VaFlushWithoutConsole();
+
+		callTime += end - start;
+		flushTime += VaQueryTestTime() - end;
+	}
+
+	LOG_STATISTICS statistics;
+
+	VaGetLoggerStatistics(&statistics);
+
+	UINT64 callCount = (UINT64)BENCH_BATCH_COUNT * BENCH_BATCH_SIZE;
+
+	printf("log call %.1f ns on the producer, formatting %.1f ns on the flushing thread, %llu dropped\n", (DOUBLE)callTime / callCount, (DOUBLE)flushTime / callCount, statistics.DroppedCount);
+}
+static VOID VaBenchSuppressedCall(VOID)
+{
+	static LOG_SITE site = { "[%f %f] [%f %f %f]", 1 };
+
+	UINT64 start = VaQueryTestTime();
+
+	// Past its limit a site only counts, this is what a flooding call site costs for the rest of its second
+	for (UINT32 batch = 0; batch < BENCH_BATCH_COUNT; batch++)
+	{
+		for (UINT32 i = 0; i < BENCH_BATCH_SIZE; i++)
+		{
+			FLOAT value = (FLOAT)i;
+
+			VaLog(&site, value, value + 1.0f, value + 2.0f, value + 3.0f, value + 4.0f);
+		}
+	}
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	VaFlushWithoutConsole();
+
+	printf("suppressed log call %.1f ns\n", (DOUBLE)elapsed / ((UINT64)BENCH_BATCH_COUNT * BENCH_BATCH_SIZE));
+}
+static VOID VaBenchPrintfCall(VOID)
+{
+	FILE* file = fopen("/dev/null", "w");
+
+	UINT64 start = VaQueryTestTime();
+
+	// Formatting in place into a buffered stream, a lower bound of what the render path paid for a console line
+	for (UINT32 batch = 0; batch < BENCH_BATCH_COUNT; batch++)
+	{
+		for (UINT32 i = 0; i < BENCH_BATCH_SIZE; i++)
+		{
+			FLOAT value = (FLOAT)i;
+
+			fprintf(file, "[%f %f] [%f %f %f]\n", value, value + 1.0f, value + 2.0f, value + 3.0f, value + 4.0f);
+		}
+	}
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	fclose(file);
+
+	printf("fprintf to /dev/null %.1f ns\n", (DOUBLE)elapsed / ((UINT64)BENCH_BATCH_COUNT * BENCH_BATCH_SIZE));
+}
+
+static VOID VaFlushWithoutConsole(VOID)
+{
+	fflush(stdout);
+
+	// The logger echoes every line to the console, the bench output only keeps the measurements
+	INT32 console = dup(STDOUT_FILENO);
+	INT32 null = open("/dev/null", O_WRONLY);
+
+	dup2(null, STDOUT_FILENO);
+
+	VaFlushLogger();
+
+	fflush(stdout);
+
+	dup2(console, STDOUT_FILENO);
+
+	close(null);
+	close(console);
+}
\ No newline at end of file
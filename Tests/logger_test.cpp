@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "testing.h"
+#include "logger.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+#define PRODUCER_COUNT (4)
+#define PRODUCER_RECORD_COUNT (1000)
+
+#define FLOOD_RECORD_COUNT (5000)
+
+#define LOG_PATH_SIZE (260)
+#define LOG_TEXT_SIZE (1024 * 1024)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static CHAR sFilePath[LOG_PATH_SIZE] = { 0 };
+
+static CHAR sText[LOG_TEXT_SIZE] = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestArgumentsAreFormatted(VOID);
+static VOID VaTestCallSitesAreRateLimited(VOID);
+static VOID VaTestProducersKeepTheirOrder(VOID);
+static VOID VaTestFullRingDropsRecords(VOID);
+static VOID VaTestDestroyedLoggerIgnoresCalls(VOID);
+
+static VOID VaLogRecords(UINT32 Producer);
+
+static VOID VaCreateTestLogger(VOID);
+static VOID VaDestroyTestLogger(VOID);
+
+static VOID VaFlushTestLogger(VOID);
+static VOID VaRunWithoutConsole(TEST_PROC Proc);
+
+static UINT32 VaReadLogLines(LPCSTR* Lines, UINT32 Capacity);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	snprintf(sFilePath, sizeof(sFilePath), "/tmp/susano_logger_test_%u.log", GetCurrentProcessId());
+
+	TEST_RUN(VaTestArgumentsAreFormatted);
+	TEST_RUN(VaTestCallSitesAreRateLimited);
+	TEST_RUN(VaTestProducersKeepTheirOrder);
+	TEST_RUN(VaTestFullRingDropsRecords);
+	TEST_RUN(VaTestDestroyedLoggerIgnoresCalls);
+
+	remove(sFilePath);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestArgumentsAreFormatted(VOID)
+{
+	VaCreateTestLogger();
+
+	VA_LOG("int %d uint %u hex %x char %c str %s float %.2f ll %lld short %hd", -5, 7U, 255, 'a', "text", 1.5f, -1234567890123LL, (INT16)-2);
+	VA_LOG("%*d|%-4s|%%|%08.3f", 5, 42, "ab", 3.14159);
+	VA_LOG("%hhu %llx %s", (UINT8)200, 0xFFFFFFFFFFULL, (LPCSTR)NULL);
+	VA_LOG("%d and %d", 1);
+	VA_LOG("No arguments");
+
+	VaDestroyTestLogger();
+
+	LPCSTR lines[8];
+
+	UINT32 lineCount = VaReadLogLines(lines, 8);
+
+	// The formatting thread narrows every widened argument back to the width its conversion declares
+	TEST_CHECK(lineCount == 5);
+	TEST_CHECK(strcmp(lines[0], "int -5 uint 7 hex ff char a str text float 1.50 ll -1234567890123 short -2") == 0);
+	TEST_CHECK(strcmp(lines[1], "   42|ab  |%|0003.142") == 0);
+	TEST_CHECK(strcmp(lines[2], "200 ffffffffff (null)") == 0);
+	TEST_CHECK(strcmp(lines[3], "1 and %d") == 0);
+	TEST_CHECK(strcmp(lines[4], "No arguments") == 0);
+}
+static VOID VaTestCallSitesAreRateLimited(VOID)
+{
+	static LOG_SITE site = { "Limited %u", 4 };
+
+	LOG_STATISTICS before;
+
+	VaGetLoggerStatistics(&before);
+
+	VaCreateTestLogger();
+
+	for (UINT32 i = 0; i < 100; i++)
+	{
+		VaLog(&site, i);
+	}
+
+	// Only the first records of a second get through, the rest are counted on the site
+	TEST_CHECK(site.Suppressed == 96);
+
+	// Stepping the window back makes the next call land in a new second, it reports what the last one swallowed
+	site.Window -= 1;
+
+	VaLog(&site, 100U);
+
+	TEST_CHECK(site.Suppressed == 0);
+
+	VaDestroyTestLogger();
+
+	LPCSTR lines[8];
+
+	UINT32 lineCount = VaReadLogLines(lines, 8);
+
+	LOG_STATISTICS after;
+
+	VaGetLoggerStatistics(&after);
+
+	TEST_CHECK(lineCount == 5);
+	TEST_CHECK((lineCount == 5) && (strcmp(lines[3], "Limited 3") == 0));
+	TEST_CHECK((lineCount == 5) && (strcmp(lines[4], "Limited 100 (96 suppressed)") == 0));
+	TEST_CHECK((after.WrittenCount - before.WrittenCount) == 5);
+	TEST_CHECK((after.SuppressedCount - before.SuppressedCount) == 96);
+}
+static VOID VaTestProducersKeepTheirOrder(VOID)
+{
+	LOG_STATISTICS before;
+
+	VaGetLoggerStatistics(&before);
+
+	VaCreateTestLogger();
+
+	std::thread threads[PRODUCER_COUNT];
+
+	for (UINT32 i = 0; i < PRODUCER_COUNT; i++)
+	{
+		threads[i] = std::thread(VaLogRecords, i);
+	}
+
+	for (UINT32 i = 0; i < PRODUCER_COUNT; i++)
+	{
+		threads[i].join();
+	}
+
+	VaDestroyTestLogger();
+
+	static LPCSTR lines[PRODUCER_COUNT * PRODUCER_RECORD_COUNT + 1];
+
+	UINT32 lineCount = VaReadLogLines(lines, ARRAY_LENGTH(lines));
+
+	UINT32 counts[PRODUCER_COUNT] = { 0 };
+
+	UINT32 mismatchCount = 0;
+
+	// Records of one producer are claimed in call order, so each producer's sequence has to come out unbroken
+	for (UINT32 i = 0; i < lineCount; i++)
+	{
+		UINT32 producer = 0;
+		UINT32 record = 0;
+
+		if ((sscanf(lines[i], "Producer %u record %u", &producer, &record) != 2) || (producer >= PRODUCER_COUNT) || (record != counts[producer]))
+		{
+			mismatchCount += 1;
+
+			continue;
+		}
+
+		counts[producer] += 1;
+	}
+
+	LOG_STATISTICS after;
+
+	VaGetLoggerStatistics(&after);
+
+	TEST_CHECK(lineCount == (PRODUCER_COUNT * PRODUCER_RECORD_COUNT));
+	TEST_CHECK(mismatchCount == 0);
+	TEST_CHECK(after.DroppedCount == before.DroppedCount);
+
+	for (UINT32 i = 0; i < PRODUCER_COUNT; i++)
+	{
+		TEST_CHECK(counts[i] == PRODUCER_RECORD_COUNT);
+	}
+}
+static VOID VaTestFullRingDropsRecords(VOID)
+{
+	static LOG_SITE site = { "Flood %u", 0xFFFFFFFF };
+
+	LOG_STATISTICS before;
+
+	VaGetLoggerStatistics(&before);
+
+	VaCreateTestLogger();
+
+	// Nobody flushes while the producer floods, it loses what does not fit instead of waiting for the formatter
+	for (UINT32 i = 0; i < FLOOD_RECORD_COUNT; i++)
+	{
+		VaLog(&site, i);
+	}
+
+	LOG_STATISTICS flooded;
+
+	VaGetLoggerStatistics(&flooded);
+
+	// Once flushed the ring takes records again
+	VaFlushTestLogger();
+
+	VaLog(&site, (UINT32)FLOOD_RECORD_COUNT);
+
+	VaDestroyTestLogger();
+
+	static LPCSTR lines[FLOOD_RECORD_COUNT + 1];
+
+	UINT32 lineCount = VaReadLogLines(lines, ARRAY_LENGTH(lines));
+
+	LOG_STATISTICS after;
+
+	VaGetLoggerStatistics(&after);
+
+	UINT32 droppedCount = (UINT32)(flooded.DroppedCount - before.DroppedCount);
+
+	TEST_CHECK(droppedCount > 0);
+	TEST_CHECK((lineCount + droppedCount) == (FLOOD_RECORD_COUNT + 1));
+	TEST_CHECK((lineCount > 0) && (strcmp(lines[0], "Flood 0") == 0));
+	TEST_CHECK((lineCount > 0) && (strcmp(lines[lineCount - 1], "Flood 5000") == 0));
+	TEST_CHECK(after.DroppedCount == flooded.DroppedCount);
+}
+static VOID VaTestDestroyedLoggerIgnoresCalls(VOID)
+{
+	LOG_STATISTICS before;
+
+	VaGetLoggerStatistics(&before);
+
+	VaCreateTestLogger();
+	VaDestroyTestLogger();
+
+	VA_LOG("After destroy %u", 1U);
+
+	VaFlushTestLogger();
+
+	LPCSTR lines[1];
+
+	LOG_STATISTICS after;
+
+	VaGetLoggerStatistics(&after);
+
+	TEST_CHECK(VaReadLogLines(lines, 1) == 0);
+	TEST_CHECK(after.WrittenCount == before.WrittenCount);
+	TEST_CHECK(after.DroppedCount == before.DroppedCount);
+}
+
+static VOID VaLogRecords(UINT32 Producer)
+{
+	for (UINT32 i = 0; i < PRODUCER_RECORD_COUNT; i++)
+	{
+		VA_LOG_LIMITED(0xFFFFFFFF, "Producer %u record %u", Producer, i);
+	}
+}
+
+static VOID VaCreateTestLogger(VOID)
+{
+	VaCreateLogger(sFilePath);
+}
+static VOID VaDestroyTestLogger(VOID)
+{
+	VaRunWithoutConsole(VaDestroyLogger);
+}
+
+static VOID VaFlushTestLogger(VOID)
+{
+	VaRunWithoutConsole(VaFlushLogger);
+}
+static VOID VaRunWithoutConsole(TEST_PROC Proc)
+{
+	fflush(stdout);
+
+	// The logger echoes every line to the console, the test output only keeps the results
+	INT32 console = dup(STDOUT_FILENO);
+	INT32 null = open("/dev/null", O_WRONLY);
+
+	dup2(null, STDOUT_FILENO);
+
+	Proc();
+
+	fflush(stdout);
+
+	dup2(console, STDOUT_FILENO);
+
+	close(null);
+	close(console);
+}
+
+static UINT32 VaReadLogLines(LPCSTR* Lines, UINT32 Capacity)
+{
+	FILE* file = fopen(sFilePath, "rb");
+
+	if (!file)
+	{
+		return 0;
+	}
+
+	UINT64 size = fread(sText, 1, sizeof(sText) - 1, file);
+
+	fclose(file);
+
+	sText[size] = 0;
+
+	UINT32 lineCount = 0;
+
+	// Every line starts with the time since the logger was created, only the message after it is compared
+	for (CHAR* line = strtok(sText, "\n"); line && (lineCount < Capacity); line = strtok(NULL, "\n"))
+	{
+		CHAR* message = strstr(line, "] ");
+
+		Lines[lineCount++] = message ? (message + 2) : line;
+	}
+
+	return lineCount;
+}
\ No newline at end of file
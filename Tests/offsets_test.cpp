@@ -0,0 +1,417 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <thread>
+
+#include "testing.h"
+#include "offsets.h"
+#include "safememory.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+#define IMAGE_CODE_SIZE (0x1000)
+#define IMAGE_DATA_SIZE (0x1000)
+#define IMAGE_DATA_RVA (TEST_IMAGE_CODE_RVA + IMAGE_CODE_SIZE)
+
+#define INSTRUCTION_RVA (TEST_IMAGE_CODE_RVA + 0x40)
+#define CAMERA_RVA (IMAGE_DATA_RVA + 0x200)
+
+#define READER_COUNT (2)
+#define RACE_DURATION (200)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// One link of the synthetic player chain, the root points at an owner, the owner at a holder and the holder at the player
+struct CHAIN_NODE
+{
+	BYTE Reserved[0x8];
+	CHAIN_NODE* Player;
+	BYTE Reserved2[0x8];
+	CHAIN_NODE* Holder;
+	BYTE Reserved3[0x60];
+	FLOAT PositionX;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static PBYTE sMainModule = NULL;
+
+alignas(16) static BYTE sKernelModule[0x1000] = { 0 };
+
+static CHAIN_NODE sOwners[2] = { 0 };
+static CHAIN_NODE sHolders[2] = { 0 };
+static CHAIN_NODE sPlayers[2] = { 0 };
+
+// The chain follows the holder link at 0x18 and the player link at 0x8 and lands on PositionX
+static CHAR sSchema[] = R"schema(
+	# Comments and blank lines are skipped
+
+	signature camera_sig     main.dll    3 7    48 8B 05 ?? ?? ?? ?? F3 0F 10
+	window_width             kernel.dll  0x0           -              u32   # trailing comment
+	window_height            kernel.dll  0x4           -              u32
+	framerate_divisor        main.dll    0x2010        -              u8
+	player_x                 main.dll    0x2100        0x18,0x8,0x80  f32
+	camera_pitch             main.dll    camera_sig+0x4 -             f32
+	camera_block             main.dll    camera_sig    -              struct
+)schema";
+
+static volatile BOOL sRunning = FALSE;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestSchemaIsParsed(VOID);
+static VOID VaTestBrokenSchemasKeepTheTable(VOID);
+static VOID VaTestPlainFieldsResolveOnLoad(VOID);
+static VOID VaTestChainsWalkOncePerBaseChange(VOID);
+static VOID VaTestSignatureBasesResolve(VOID);
+static VOID VaTestReadersRaceResolves(VOID);
+
+static VOID VaRunResolver(VOID);
+static VOID VaRunReader(UINT32* MismatchCount);
+
+static VOID VaSetPlayerRoot(CHAIN_NODE* Owner);
+
+static UINT64 VaGetTestModule(LPCSTR ModuleName);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	sMainModule = VaCreateTestImage(IMAGE_CODE_SIZE, IMAGE_DATA_SIZE, 0x5A5A0001, NULL, 0);
+
+	// mov rax, [rip + camera] followed by movss, the signature resolves the rip relative operand
+	BYTE instruction[] = { 0x48, 0x8B, 0x05, 0, 0, 0, 0, 0xF3, 0x0F, 0x10 };
+
+	INT32 displacement = CAMERA_RVA - (INSTRUCTION_RVA + 7);
+
+	memcpy(instruction + 3, &displacement, sizeof(displacement));
+	memcpy(sMainModule + INSTRUCTION_RVA, instruction, sizeof(instruction));
+
+	FLOAT pitch = 0.75f;
+
+	memcpy(sMainModule + CAMERA_RVA + 4, &pitch, sizeof(pitch));
+
+	sMainModule[IMAGE_DATA_RVA + 0x10] = 2;
+
+	UINT32 window[] = { 1920, 1080 };
+
+	memcpy(sKernelModule, window, sizeof(window));
+
+	for (UINT32 i = 0; i < 2; i++)
+	{
+		sOwners[i].Holder = &sHolders[i];
+		sHolders[i].Player = &sPlayers[i];
+		sPlayers[i].PositionX = (FLOAT)(i + 1) * 10.0f;
+	}
+
+	VaSetPlayerRoot(&sOwners[0]);
+
+	VaCreateSafeMemory();
+	VaCreateOffsets(VaGetTestModule);
+
+	TEST_RUN(VaTestSchemaIsParsed);
+	TEST_RUN(VaTestBrokenSchemasKeepTheTable);
+	TEST_RUN(VaTestPlainFieldsResolveOnLoad);
+	TEST_RUN(VaTestChainsWalkOncePerBaseChange);
+	TEST_RUN(VaTestSignatureBasesResolve);
+	TEST_RUN(VaTestReadersRaceResolves);
+
+	VaDestroyOffsets();
+	VaDestroySafeMemory();
+
+	VaDestroyTestImage(sMainModule);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestSchemaIsParsed(VOID)
+{
+	UINT32 generation = VaGetOffsetGeneration();
+
+	TEST_CHECK(VaLoadOffsetSchemaText(sSchema, FALSE));
+	TEST_CHECK(VaGetOffsetGeneration() == (generation + 1));
+
+	OFFSET_STATISTICS statistics;
+
+	VaGetOffsetStatistics(&statistics);
+
+	TEST_CHECK(statistics.FieldCount == 6);
+	TEST_CHECK(statistics.SignatureCount == 1);
+	TEST_CHECK(statistics.FoundSignatureCount == 1);
+	TEST_CHECK(!statistics.Embedded);
+
+	// Fields keep their schema order, names outside the schema are not found
+	TEST_CHECK(VaFindOffsetField("window_width") == 0);
+	TEST_CHECK(VaFindOffsetField("camera_block") == 5);
+	TEST_CHECK(VaFindOffsetField("player_object") == INVALID_OFFSET_FIELD);
+}
+static VOID VaTestBrokenSchemasKeepTheTable(VOID)
+{
+	LPCSTR schemas[] =
+	{
+		"a main.dll 0x0 -",
+		"a main.dll 0x0 - f128",
+		"a main.dll 0x0 - u32\na main.dll 0x4 - u32",
+		"a main.dll 0x0z - u32",
+		"a main.dll 0x0 1,2,3,4,5,6,7,8,9 u32",
+		"a main.dll 0x0 0x8,x u32",
+		"a main.dll unknown+0x4 - u32",
+		"signature s main.dll 3 7 48 8B ZZ",
+		"signature s main.dll 5 7 48 8B 05",
+		"signature s kernel.dll - - 48\na main.dll s - u32",
+		"window_width kernel.dll 0x0 - u32\nbroken",
+	};
+
+	UINT32 generation = VaGetOffsetGeneration();
+
+	UINT32 acceptedCount = 0;
+
+	// A single broken line rejects the whole text, readers keep the previous table
+	for (UINT32 i = 0; i < ARRAY_LENGTH(schemas); i++)
+	{
+		acceptedCount += VaLoadOffsetSchemaText(schemas[i], FALSE) ? 1 : 0;
+	}
+
+	TEST_CHECK(acceptedCount == 0);
+	TEST_CHECK(VaGetOffsetGeneration() == generation);
+
+	VaAcquireOffsets();
+
+	UINT32 width = 0;
+
+	TEST_CHECK(VaReadOffsetField(VaFindOffsetField("window_width"), &width, sizeof(width)));
+	TEST_CHECK(width == 1920);
+
+	VaReleaseOffsets();
+}
+static VOID VaTestPlainFieldsResolveOnLoad(VOID)
+{
+	VaAcquireOffsets();
+
+	OFFSET_FIELD width = VaFindOffsetField("window_width");
+	OFFSET_FIELD height = VaFindOffsetField("window_height");
+	OFFSET_FIELD divisor = VaFindOffsetField("framerate_divisor");
+
+	// Fields without a chain get their final address from the load alone
+	TEST_CHECK(VaGetOffsetFieldAddress(width) == (UINT64)sKernelModule);
+	TEST_CHECK(VaGetOffsetFieldAddress(height) == ((UINT64)sKernelModule + 4));
+	TEST_CHECK(VaGetOffsetFieldAddress(divisor) == ((UINT64)sMainModule + IMAGE_DATA_RVA + 0x10));
+	TEST_CHECK(VaGetOffsetFieldAddress(INVALID_OFFSET_FIELD) == 0);
+	TEST_CHECK(VaGetOffsetFieldAddress(OFFSET_FIELD_COUNT) == 0);
+
+	UINT32 value = 0;
+	UINT64 wide = 0;
+	UINT8 byte = 0;
+
+	// The read size has to match the schema type
+	TEST_CHECK(VaReadOffsetField(height, &value, sizeof(value)) && (value == 1080));
+	TEST_CHECK(!VaReadOffsetField(height, &wide, sizeof(wide)));
+	TEST_CHECK(VaReadOffsetField(divisor, &byte, sizeof(byte)) && (byte == 2));
+
+	byte = 1;
+
+	TEST_CHECK(VaWriteOffsetField(divisor, &byte, sizeof(byte)));
+	TEST_CHECK(sMainModule[IMAGE_DATA_RVA + 0x10] == 1);
+	TEST_CHECK(!VaWriteOffsetField(divisor, &value, sizeof(value)));
+
+	VaReleaseOffsets();
+}
+static VOID VaTestChainsWalkOncePerBaseChange(VOID)
+{
+	OFFSET_FIELD player = VaFindOffsetField("player_x");
+
+	// Chains are left for the first resolve, loading never walks them
+	TEST_CHECK(VaGetOffsetFieldAddress(player) == 0);
+
+	VaResolveOffsets();
+
+	OFFSET_STATISTICS before;
+
+	VaGetOffsetStatistics(&before);
+
+	TEST_CHECK(VaGetOffsetFieldAddress(player) == (UINT64)&sPlayers[0].PositionX);
+
+	// An unchanged base pointer keeps the precomputed address, reads never walk anything
+	for (UINT32 i = 0; i < 100; i++)
+	{
+		VaResolveOffsets();
+
+		VaAcquireOffsets();
+
+		FLOAT x = 0.0f;
+
+		TEST_CHECK(VaReadOffsetField(player, &x, sizeof(x)) && (x == 10.0f));
+
+		VaReleaseOffsets();
+	}
+
+	OFFSET_STATISTICS after;
+
+	VaGetOffsetStatistics(&after);
+
+	TEST_CHECK(after.WalkCount == before.WalkCount);
+	TEST_CHECK(after.ResolvedCount == 6);
+
+	VaSetPlayerRoot(&sOwners[1]);
+
+	VaResolveOffsets();
+
+	VaGetOffsetStatistics(&after);
+
+	TEST_CHECK(after.WalkCount == (before.WalkCount + 1));
+	TEST_CHECK(VaGetOffsetFieldAddress(player) == (UINT64)&sPlayers[1].PositionX);
+
+	// A null link anywhere in the chain leaves the field unresolved until the base moves again
+	CHAIN_NODE broken = { 0 };
+
+	VaSetPlayerRoot(&broken);
+
+	VaResolveOffsets();
+
+	VaAcquireOffsets();
+
+	FLOAT x = 0.0f;
+
+	TEST_CHECK(VaGetOffsetFieldAddress(player) == 0);
+	TEST_CHECK(!VaReadOffsetField(player, &x, sizeof(x)));
+
+	VaReleaseOffsets();
+
+	VaSetPlayerRoot(NULL);
+
+	VaResolveOffsets();
+
+	TEST_CHECK(VaGetOffsetFieldAddress(player) == 0);
+
+	VaSetPlayerRoot(&sOwners[0]);
+
+	VaResolveOffsets();
+
+	TEST_CHECK(VaGetOffsetFieldAddress(player) == (UINT64)&sPlayers[0].PositionX);
+}
+static VOID VaTestSignatureBasesResolve(VOID)
+{
+	VaAcquireOffsets();
+
+	// The signature address is the rip relative target of the mov, fields add their own offset to it
+	TEST_CHECK(VaGetOffsetFieldAddress(VaFindOffsetField("camera_block")) == ((UINT64)sMainModule + CAMERA_RVA));
+	TEST_CHECK(VaGetOffsetFieldAddress(VaFindOffsetField("camera_pitch")) == ((UINT64)sMainModule + CAMERA_RVA + 4));
+
+	FLOAT pitch = 0.0f;
+
+	TEST_CHECK(VaReadOffsetField(VaFindOffsetField("camera_pitch"), &pitch, sizeof(pitch)) && (pitch == 0.75f));
+
+	VaReleaseOffsets();
+}
+static VOID VaTestReadersRaceResolves(VOID)
+{
+	sRunning = TRUE;
+
+	UINT32 mismatchCounts[READER_COUNT] = { 0 };
+
+	std::thread resolver(VaRunResolver);
+	std::thread readers[READER_COUNT];
+
+	for (UINT32 i = 0; i < READER_COUNT; i++)
+	{
+		readers[i] = std::thread(VaRunReader, &mismatchCounts[i]);
+	}
+
+	Sleep(RACE_DURATION);
+
+	sRunning = FALSE;
+
+	resolver.join();
+
+	for (UINT32 i = 0; i < READER_COUNT; i++)
+	{
+		readers[i].join();
+	}
+
+	OFFSET_STATISTICS statistics;
+
+	VaGetOffsetStatistics(&statistics);
+
+	// Re-walks hold the lock exclusively, a reader always sees an address together with the value it points at
+	for (UINT32 i = 0; i < READER_COUNT; i++)
+	{
+		TEST_CHECK(mismatchCounts[i] == 0);
+	}
+
+	printf("  %llu walks\n", statistics.WalkCount);
+}
+
+static VOID VaRunResolver(VOID)
+{
+	UINT32 index = 0;
+
+	while (sRunning)
+	{
+		index ^= 1;
+
+		VaSetPlayerRoot(&sOwners[index]);
+
+		VaResolveOffsets();
+	}
+
+	VaSetPlayerRoot(&sOwners[0]);
+
+	VaResolveOffsets();
+}
+static VOID VaRunReader(UINT32* MismatchCount)
+{
+	OFFSET_FIELD player = VaFindOffsetField("player_x");
+
+	while (sRunning)
+	{
+		VaAcquireOffsets();
+
+		UINT64 address = VaGetOffsetFieldAddress(player);
+
+		FLOAT x = 0.0f;
+
+		BOOL read = VaReadOffsetField(player, &x, sizeof(x));
+
+		VaReleaseOffsets();
+
+		BOOL first = (address == (UINT64)&sPlayers[0].PositionX) && (x == 10.0f);
+		BOOL second = (address == (UINT64)&sPlayers[1].PositionX) && (x == 20.0f);
+
+		if (!read || (!first && !second))
+		{
+			*MismatchCount += 1;
+		}
+	}
+}
+
+static VOID VaSetPlayerRoot(CHAIN_NODE* Owner)
+{
+	WriteRelease64((volatile LONG64*)(sMainModule + IMAGE_DATA_RVA + 0x100), (LONG64)Owner);
+}
+
+static UINT64 VaGetTestModule(LPCSTR ModuleName)
+{
+	if (strcmp(ModuleName, "main.dll") == 0)
+	{
+		return (UINT64)sMainModule;
+	}
+
+	if (strcmp(ModuleName, "kernel.dll") == 0)
+	{
+		return (UINT64)sKernelModule;
+	}
+
+	return 0;
+}
\ No newline at end of file
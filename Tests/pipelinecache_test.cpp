@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "pipelinecache.h"
+#include "linebatchrenderer.h"
+#include "shaperenderer.h"
+#include "defaultgeorenderer.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static CHAR sVertexShaderSource[] = "float4 VS(float4 Position : POSITION) : SV_POSITION { return Position; }";
+static CHAR sOtherVertexShaderSource[] = "float4 VS(float4 Position : POSITION) : SV_POSITION { return Position * 2.0; }";
+static CHAR sPixelShaderSource[] = "float4 PS() : SV_TARGET { return 1.0; }";
+
+static D3D11_INPUT_ELEMENT_DESC sInputLayoutSource[] =
+{
+	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestPipelinesShareShaders(VOID);
+static VOID VaTestRedundantBindsAreSkipped(VOID);
+static VOID VaTestInvalidateForcesRebind(VOID);
+static VOID VaTestOverlayFrameStateChanges(VOID);
+
+static UINT32 VaCountMockStateChanges(const D3D11_MOCK_STATISTICS* Before);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateTestRenderer();
+
+	TEST_RUN(VaTestPipelinesShareShaders);
+	TEST_RUN(VaTestRedundantBindsAreSkipped);
+	TEST_RUN(VaTestInvalidateForcesRebind);
+	TEST_RUN(VaTestOverlayFrameStateChanges);
+
+	VaDestroyTestRenderer();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestPipelinesShareShaders(VOID)
+{
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	PIPELINE lines = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+	PIPELINE triangles = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	PIPELINE again = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+	PIPELINE other = VaCreatePipeline(sOtherVertexShaderSource, ARRAY_LENGTH(sOtherVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+
+	TEST_CHECK(lines != INVALID_PIPELINE);
+	TEST_CHECK(triangles != lines);
+	TEST_CHECK(again == lines);
+	TEST_CHECK((other != lines) && (other != triangles));
+
+	PIPELINE_CACHE_STATISTICS statistics;
+
+	VaGetPipelineCacheStatistics(&statistics);
+
+	// Two vertex shaders and one pixel shader, the layout is keyed by its vertex shader so there are two of them
+	TEST_CHECK(statistics.ShaderCount == 3);
+	TEST_CHECK(statistics.InputLayoutCount == 2);
+	TEST_CHECK(statistics.PipelineCount == 3);
+	TEST_CHECK((gMockContext->Statistics.ShaderCount - before.ShaderCount) == 3);
+	TEST_CHECK((gMockContext->Statistics.InputLayoutCount - before.InputLayoutCount) == 2);
+}
+static VOID VaTestRedundantBindsAreSkipped(VOID)
+{
+	PIPELINE lines = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+	PIPELINE triangles = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	ID3D11Buffer* buffer = VaCommitConstantBlock(gViewProjectionBlock);
+
+	UINT32 stride = sizeof(VERTEX);
+	UINT32 offset = 0;
+
+	VaInvalidatePipelineState();
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	VaBindPipeline(lines);
+	VaBindConstantBuffers(0, 1, &buffer);
+	VaBindVertexBuffers(1, &buffer, &stride, &offset);
+	VaBindIndexBuffer(buffer, 0);
+
+	TEST_CHECK(VaCountMockStateChanges(&before) == 7);
+
+	// Rebinding everything unchanged reaches the context not at all
+	before = gMockContext->Statistics;
+
+	VaBindPipeline(lines);
+	VaBindConstantBuffers(0, 1, &buffer);
+	VaBindVertexBuffers(1, &buffer, &stride, &offset);
+	VaBindIndexBuffer(buffer, 0);
+
+	TEST_CHECK(VaCountMockStateChanges(&before) == 0);
+
+	// Switching to the triangle pipeline only changes the topology, a new offset rebinds only the vertex buffer
+	before = gMockContext->Statistics;
+
+	offset = 16;
+
+	VaBindPipeline(triangles);
+	VaBindVertexBuffers(1, &buffer, &stride, &offset);
+
+	TEST_CHECK(VaCountMockStateChanges(&before) == 2);
+	TEST_CHECK((gMockContext->Statistics.TopologyChangeCount - before.TopologyChangeCount) == 1);
+	TEST_CHECK((gMockContext->Statistics.VertexBufferChangeCount - before.VertexBufferChangeCount) == 1);
+
+	PIPELINE_CACHE_STATISTICS statistics;
+
+	VaGetPipelineCacheStatistics(&statistics);
+
+	TEST_CHECK(statistics.StateChangeCount == 9);
+	TEST_CHECK(statistics.SkippedStateChangeCount == 10);
+}
+static VOID VaTestInvalidateForcesRebind(VOID)
+{
+	PIPELINE lines = VaCreatePipeline(sVertexShaderSource, ARRAY_LENGTH(sVertexShaderSource), sPixelShaderSource, ARRAY_LENGTH(sPixelShaderSource), sInputLayoutSource, ARRAY_LENGTH(sInputLayoutSource), D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+
+	VaBindPipeline(lines);
+
+	// The game binds its own state between overlay frames, nothing bound before the invalidate may be trusted
+	VaInvalidatePipelineState();
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	VaBindPipeline(lines);
+
+	TEST_CHECK(VaCountMockStateChanges(&before) == 4);
+
+	PIPELINE_CACHE_STATISTICS statistics;
+
+	VaGetPipelineCacheStatistics(&statistics);
+
+	TEST_CHECK(statistics.StateChangeCount == 4);
+	TEST_CHECK(statistics.SkippedStateChangeCount == 0);
+}
+static VOID VaTestOverlayFrameStateChanges(VOID)
+{
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	VaCreateDefaultGeoRenderer();
+	VaCreateShapeRenderer();
+	VaCreateLineBatchRenderer();
+
+	// All three overlay renderers draw with the same pixel shader, it is compiled once
+	TEST_CHECK((gMockContext->Statistics.ShaderCount - before.ShaderCount) == 4);
+
+	for (UINT32 frame = 0; frame < 2; frame++)
+	{
+		for (UINT32 i = 0; i < 16; i++)
+		{
+			FLOAT x = ((FLOAT)i / 16.0f) - 0.5f;
+
+			VaDrawWireBox({ x, 0.0f, 0.5f }, { 0.01f, 0.01f, 0.01f }, { 1.0f, 0.0f, 0.0f, 1.0f });
+			VaDrawWireSphere({ x, 0.2f, 0.5f }, 0.01f, { 0.0f, 1.0f, 0.0f, 1.0f });
+			VaDrawLine({ x, -0.5f, 0.5f }, { x, 0.5f, 0.5f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+			VaDrawBox({ x, -0.2f, 0.5f }, { 0.01f, 0.01f, 0.01f }, { 0.0f, 0.0f, 1.0f, 1.0f });
+		}
+
+		VaBeginTestFrame();
+
+		before = gMockContext->Statistics;
+
+		VaRenderDefaultGeo();
+		VaRenderShapeBatch();
+		VaRenderLineBatch();
+
+		D3D11_MOCK_STATISTICS after = gMockContext->Statistics;
+
+		VaEndTestFrame();
+
+		PIPELINE_CACHE_STATISTICS statistics;
+
+		VaGetPipelineCacheStatistics(&statistics);
+
+		UINT32 drawCount = (after.DrawCount - before.DrawCount) + (after.DrawIndexedCount - before.DrawIndexedCount) + (after.DrawIndexedInstancedCount - before.DrawIndexedInstancedCount);
+
+		// Binding everything for every draw would cost seven calls each, the cache issues only the ones that change something
+		TEST_CHECK(VaCountMockStateChanges(&before) == statistics.StateChangeCount);
+		TEST_CHECK(statistics.StateChangeCount < (drawCount * 7));
+		TEST_CHECK(statistics.SkippedStateChangeCount > 0);
+		TEST_CHECK((after.PixelShaderChangeCount - before.PixelShaderChangeCount) == 1);
+		TEST_CHECK((after.VertexShaderChangeCount - before.VertexShaderChangeCount) == 3);
+		TEST_CHECK((after.InputLayoutChangeCount - before.InputLayoutChangeCount) == 3);
+		TEST_CHECK((after.TopologyChangeCount - before.TopologyChangeCount) == 2);
+
+		printf("  %u draws, %u state changes issued, %u skipped\n", drawCount, statistics.StateChangeCount, statistics.SkippedStateChangeCount);
+	}
+
+	VaDestroyLineBatchRenderer();
+	VaDestroyShapeRenderer();
+	VaDestroyDefaultGeoRenderer();
+}
+
+static UINT32 VaCountMockStateChanges(const D3D11_MOCK_STATISTICS* Before)
+{
+	const D3D11_MOCK_STATISTICS* after = &gMockContext->Statistics;
+
+	return (after->InputLayoutChangeCount - Before->InputLayoutChangeCount) +
+		(after->VertexShaderChangeCount - Before->VertexShaderChangeCount) +
+		(after->PixelShaderChangeCount - Before->PixelShaderChangeCount) +
+		(after->TopologyChangeCount - Before->TopologyChangeCount) +
+		(after->ConstantBufferChangeCount - Before->ConstantBufferChangeCount) +
+		(after->VertexBufferChangeCount - Before->VertexBufferChangeCount) +
+		(after->IndexBufferChangeCount - Before->IndexBufferChangeCount);
+}
\ No newline at end of file
@@ -0,0 +1,418 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testing.h"
+#include "profiler.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define WRAPPED_FRAME_COUNT (300)
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestNestedZonesFormFlameGraph(VOID);
+static VOID VaTestRepeatedZonesAccumulate(VOID);
+static VOID VaTestSampleOverflowKeepsZoneTimes(VOID);
+static VOID VaTestDeepNestingStaysBalanced(VOID);
+static VOID VaTestZonesOutsideFramesAreIgnored(VOID);
+static VOID VaTestHistoryWrapsAround(VOID);
+static VOID VaTestStatisticsUseNearestRank(VOID);
+static VOID VaTestZoneRegistryIsBounded(VOID);
+static VOID VaTestClockResolution(VOID);
+
+static VOID VaSpin(UINT64 Nanoseconds);
+
+static INT32 VaCompareTimes(const VOID* Left, const VOID* Right);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	TEST_RUN(VaTestNestedZonesFormFlameGraph);
+	TEST_RUN(VaTestRepeatedZonesAccumulate);
+	TEST_RUN(VaTestSampleOverflowKeepsZoneTimes);
+	TEST_RUN(VaTestDeepNestingStaysBalanced);
+	TEST_RUN(VaTestZonesOutsideFramesAreIgnored);
+	TEST_RUN(VaTestHistoryWrapsAround);
+	TEST_RUN(VaTestStatisticsUseNearestRank);
+	TEST_RUN(VaTestZoneRegistryIsBounded);
+	TEST_RUN(VaTestClockResolution);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestNestedZonesFormFlameGraph(VOID)
+{
+	VaCreateProfiler();
+
+	PROFILER_ZONE present = VaRegisterProfilerZone("Present");
+	PROFILER_ZONE imgui = VaRegisterProfilerZone("ImGui");
+	PROFILER_ZONE directx = VaRegisterProfilerZone("DirectX");
+	PROFILER_ZONE lines = VaRegisterProfilerZone("Lines");
+
+	VaBeginProfilerFrame();
+
+	{
+		PROFILE_SCOPE(present);
+
+		{
+			PROFILE_SCOPE(imgui);
+
+			VaSpin(20000);
+		}
+
+		{
+			PROFILE_SCOPE(directx);
+
+			{
+				PROFILE_SCOPE(lines);
+
+				VaSpin(20000);
+			}
+		}
+	}
+
+	VaEndProfilerFrame();
+
+	const PROFILER_FRAME* frame = VaGetProfilerFrame(0);
+
+	TEST_CHECK(frame != NULL);
+	TEST_CHECK(frame->SampleCount == 4);
+
+	// Samples are stored in the order the zones were entered, a flame graph draws them row by depth
+	PROFILER_ZONE zones[] = { present, imgui, directx, lines };
+	UINT32 depths[] = { 0, 1, 1, 2 };
+	UINT32 parents[] = { 0, 0, 0, 2 };
+
+	for (UINT32 i = 0; i < frame->SampleCount; i++)
+	{
+		const PROFILER_SAMPLE* sample = &frame->Samples[i];
+		const PROFILER_SAMPLE* parent = &frame->Samples[parents[i]];
+
+		TEST_CHECK(sample->Zone == zones[i]);
+		TEST_CHECK(sample->Depth == depths[i]);
+		TEST_CHECK(sample->Start <= sample->End);
+		TEST_CHECK((sample->Start >= parent->Start) && (sample->End <= parent->End));
+		TEST_CHECK(sample->End <= frame->Duration);
+		TEST_CHECK(frame->ZoneTimes[sample->Zone] == (sample->End - sample->Start));
+	}
+
+	TEST_CHECK(frame->Samples[1].End <= frame->Samples[2].Start);
+	TEST_CHECK(frame->ZoneMask == 0xF);
+	TEST_CHECK(frame->ZoneTimes[present] >= (frame->ZoneTimes[imgui] + frame->ZoneTimes[directx]));
+	TEST_CHECK(frame->ZoneTimes[imgui] >= 20000);
+	TEST_CHECK(frame->ZoneTimes[lines] >= 20000);
+}
+static VOID VaTestRepeatedZonesAccumulate(VOID)
+{
+	VaCreateProfiler();
+
+	PROFILER_ZONE zone = VaRegisterProfilerZone("Repeated");
+	PROFILER_ZONE unused = VaRegisterProfilerZone("Unused");
+
+	VaBeginProfilerFrame();
+
+	for (UINT32 i = 0; i < 3; i++)
+	{
+		PROFILE_SCOPE(zone);
+
+		VaSpin(5000);
+	}
+
+	VaEndProfilerFrame();
+
+	const PROFILER_FRAME* frame = VaGetProfilerFrame(0);
+
+	UINT64 sum = 0;
+
+	for (UINT32 i = 0; i < frame->SampleCount; i++)
+	{
+		sum += frame->Samples[i].End - frame->Samples[i].Start;
+	}
+
+	TEST_CHECK(frame->SampleCount == 3);
+	TEST_CHECK(frame->ZoneTimes[zone] == sum);
+	TEST_CHECK(frame->ZoneMask == (1u << zone));
+
+	// A zone that was never entered has no statistics rather than a zero sample
+	PROFILER_STATISTICS statistics;
+
+	VaGetProfilerZoneStatistics(unused, &statistics);
+
+	TEST_CHECK(statistics.FrameCount == 0);
+
+	VaGetProfilerZoneStatistics(zone, &statistics);
+
+	TEST_CHECK(statistics.FrameCount == 1);
+	TEST_CHECK(statistics.Minimum == sum);
+}
+static VOID VaTestSampleOverflowKeepsZoneTimes(VOID)
+{
+	VaCreateProfiler();
+
+	PROFILER_ZONE zone = VaRegisterProfilerZone("Many");
+
+	VaBeginProfilerFrame();
+
+	for (UINT32 i = 0; i < PROFILER_SAMPLE_COUNT * 2; i++)
+	{
+		PROFILE_SCOPE(zone);
+
+		VaSpin(1000);
+	}
+
+	VaEndProfilerFrame();
+
+	const PROFILER_FRAME* frame = VaGetProfilerFrame(0);
+
+	UINT64 sum = 0;
+
+	for (UINT32 i = 0; i < frame->SampleCount; i++)
+	{
+		sum += frame->Samples[i].End - frame->Samples[i].Start;
+	}
+
+	// Only the flame graph loses the samples past the limit, the zone still accounts for every entry
+	TEST_CHECK(frame->SampleCount == PROFILER_SAMPLE_COUNT);
+	TEST_CHECK(frame->ZoneTimes[zone] > sum);
+	TEST_CHECK(frame->ZoneTimes[zone] >= (PROFILER_SAMPLE_COUNT * 2 * 1000));
+}
+static VOID VaTestDeepNestingStaysBalanced(VOID)
+{
+	VaCreateProfiler();
+
+	PROFILER_ZONE zone = VaRegisterProfilerZone("Deep");
+	PROFILER_ZONE after = VaRegisterProfilerZone("After");
+
+	VaBeginProfilerFrame();
+
+	// Twenty levels exceed the stack, the levels past it are dropped and their ends must not unwind the tracked ones
+	for (UINT32 i = 0; i < 20; i++)
+	{
+		VaBeginProfilerZone(zone);
+	}
+
+	for (UINT32 i = 0; i < 20; i++)
+	{
+		VaEndProfilerZone();
+	}
+
+	{
+		PROFILE_SCOPE(after);
+	}
+
+	VaEndProfilerFrame();
+
+	const PROFILER_FRAME* frame = VaGetProfilerFrame(0);
+
+	TEST_CHECK(frame->SampleCount == 17);
+	TEST_CHECK(frame->Samples[15].Depth == 15);
+	TEST_CHECK(frame->Samples[16].Zone == after);
+	TEST_CHECK(frame->Samples[16].Depth == 0);
+
+	for (UINT32 i = 1; i < 16; i++)
+	{
+		TEST_CHECK((frame->Samples[i].Start >= frame->Samples[i - 1].Start) && (frame->Samples[i].End <= frame->Samples[i - 1].End));
+	}
+
+	// Unmatched ends are harmless as well
+	VaEndProfilerZone();
+	VaEndProfilerZone();
+}
+static VOID VaTestZonesOutsideFramesAreIgnored(VOID)
+{
+	VaCreateProfiler();
+
+	PROFILER_ZONE zone = VaRegisterProfilerZone("Outside");
+
+	{
+		PROFILE_SCOPE(zone);
+	}
+
+	VaEndProfilerFrame();
+
+	TEST_CHECK(VaGetProfilerFrame(0) == NULL);
+
+	VaBeginProfilerFrame();
+
+	{
+		PROFILE_SCOPE(INVALID_PROFILER_ZONE);
+		PROFILE_SCOPE(zone + 1);
+		PROFILE_SCOPE(zone);
+	}
+
+	VaEndProfilerFrame();
+
+	const PROFILER_FRAME* frame = VaGetProfilerFrame(0);
+
+	// The invalid zones still take their stack levels, so the valid one nested inside them keeps its depth
+	TEST_CHECK(frame->SampleCount == 1);
+	TEST_CHECK(frame->Samples[0].Zone == zone);
+	TEST_CHECK(frame->Samples[0].Depth == 2);
+	TEST_CHECK(frame->ZoneMask == (1u << zone));
+}
+static VOID VaTestHistoryWrapsAround(VOID)
+{
+	VaCreateProfiler();
+
+	PROFILER_ZONE zone = VaRegisterProfilerZone("Frame");
+
+	// Every frame enters the zone a different number of times, so each one can be told apart by its sample count
+	for (UINT32 i = 0; i < WRAPPED_FRAME_COUNT; i++)
+	{
+		VaBeginProfilerFrame();
+
+		for (UINT32 j = 0; j < (i % PROFILER_SAMPLE_COUNT); j++)
+		{
+			PROFILE_SCOPE(zone);
+		}
+
+		VaEndProfilerFrame();
+	}
+
+	TEST_CHECK(VaGetProfilerFrame(PROFILER_HISTORY_SIZE - 1) != NULL);
+	TEST_CHECK(VaGetProfilerFrame(PROFILER_HISTORY_SIZE) == NULL);
+
+	for (UINT32 age = 0; age < PROFILER_HISTORY_SIZE; age++)
+	{
+		UINT32 index = WRAPPED_FRAME_COUNT - 1 - age;
+
+		TEST_CHECK(VaGetProfilerFrame(age)->SampleCount == (index % PROFILER_SAMPLE_COUNT));
+	}
+
+	PROFILER_STATISTICS statistics;
+
+	VaGetProfilerFrameStatistics(&statistics);
+
+	TEST_CHECK(statistics.FrameCount == PROFILER_HISTORY_SIZE);
+
+	// Frames that never entered the zone are left out of its statistics
+	VaGetProfilerZoneStatistics(zone, &statistics);
+
+	TEST_CHECK(statistics.FrameCount == (PROFILER_HISTORY_SIZE - 4));
+}
+static VOID VaTestStatisticsUseNearestRank(VOID)
+{
+	VaCreateProfiler();
+
+	PROFILER_ZONE zone = VaRegisterProfilerZone("Work");
+
+	// Every 50th frame is a slow one, the p99 has to land on the slow frames and the minimum on the fast ones
+	for (UINT32 i = 0; i < 200; i++)
+	{
+		VaBeginProfilerFrame();
+
+		{
+			PROFILE_SCOPE(zone);
+
+			VaSpin(((i % 50) == 49) ? 400000 : 10000);
+		}
+
+		VaEndProfilerFrame();
+	}
+
+	UINT64 times[PROFILER_HISTORY_SIZE];
+	UINT64 sum = 0;
+
+	for (UINT32 i = 0; i < 200; i++)
+	{
+		times[i] = VaGetProfilerFrame(i)->ZoneTimes[zone];
+
+		sum += times[i];
+	}
+
+	qsort(times, 200, sizeof(UINT64), VaCompareTimes);
+
+	PROFILER_STATISTICS statistics;
+
+	VaGetProfilerZoneStatistics(zone, &statistics);
+
+	// Nearest rank of 99% over 200 frames is the 198th smallest time
+	TEST_CHECK(statistics.FrameCount == 200);
+	TEST_CHECK(statistics.Minimum == times[0]);
+	TEST_CHECK(statistics.Mean == (sum / 200));
+	TEST_CHECK(statistics.P99 == times[197]);
+	TEST_CHECK(statistics.P99 >= 400000);
+	TEST_CHECK(statistics.Minimum < 400000);
+
+	VaGetProfilerFrameStatistics(&statistics);
+
+	TEST_CHECK(statistics.Minimum <= statistics.Mean);
+	TEST_CHECK(statistics.Mean <= statistics.P99);
+	TEST_CHECK(statistics.P99 >= times[197]);
+}
+static VOID VaTestZoneRegistryIsBounded(VOID)
+{
+	VaCreateProfiler();
+
+	for (UINT32 i = 0; i < PROFILER_ZONE_COUNT; i++)
+	{
+		TEST_CHECK(VaRegisterProfilerZone("Zone") == (PROFILER_ZONE)i);
+	}
+
+	TEST_CHECK(VaRegisterProfilerZone("Overflow") == INVALID_PROFILER_ZONE);
+	TEST_CHECK(VaGetProfilerZoneCount() == PROFILER_ZONE_COUNT);
+	TEST_CHECK(strcmp(VaGetProfilerZoneName(INVALID_PROFILER_ZONE), "") == 0);
+	TEST_CHECK(strcmp(VaGetProfilerZoneName(PROFILER_ZONE_COUNT), "") == 0);
+
+	// The last zone uses the top bit of the mask
+	VaBeginProfilerFrame();
+
+	{
+		PROFILE_SCOPE(PROFILER_ZONE_COUNT - 1);
+	}
+
+	VaEndProfilerFrame();
+
+	TEST_CHECK(VaGetProfilerFrame(0)->ZoneMask == 0x80000000);
+}
+static VOID VaTestClockResolution(VOID)
+{
+	UINT64 smallestStep = ~0ULL;
+
+	UINT64 previous = VaQueryProfilerTime();
+
+	// Sub-microsecond steps are what makes zones of a few microseconds measurable at all
+	for (UINT32 i = 0; i < 100000; i++)
+	{
+		UINT64 time = VaQueryProfilerTime();
+
+		TEST_CHECK(time >= previous);
+
+		if ((time > previous) && ((time - previous) < smallestStep))
+		{
+			smallestStep = time - previous;
+		}
+
+		previous = time;
+	}
+
+	TEST_CHECK(smallestStep < 1000);
+
+	printf("  smallest clock step %llu ns\n", smallestStep);
+}
+
+static VOID VaSpin(UINT64 Nanoseconds)
+{
+	UINT64 start = VaQueryProfilerTime();
+
+	while ((VaQueryProfilerTime() - start) < Nanoseconds)
+	{
+		YieldProcessor();
+	}
+}
+
+static INT32 VaCompareTimes(const VOID* Left, const VOID* Right)
+{
+	UINT64 left = *(const UINT64*)Left;
+	UINT64 right = *(const UINT64*)Right;
+
+	return (left > right) - (left < right);
+}
\ No newline at end of file
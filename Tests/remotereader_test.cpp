@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "testing.h"
+#include "remotereader.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+#define PAGE_SIZE (0x1000)
+
+// More pages than the reader caches, so one batch can overflow it
+#define CHILD_PAGE_COUNT (640)
+
+// Only the child changes its copy of the region, a value read from the parent's copy lacks the mark
+#define CHILD_MARK (0x5A5A000000000000ULL)
+
+#define UNREADABLE_PAGE (10)
+
+#define FIELD_COUNT (300)
+#define FIELD_PAGE_COUNT (64)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static PBYTE sRegion = NULL;
+
+static pid_t sChild = 0;
+
+static HANDLE sProcess = NULL;
+
+static INT32 sReleasePipe[2] = { -1, -1 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestScatteredFieldsAreCoalesced(VOID);
+static VOID VaTestPagesAreReusedWithinTheLifetime(VOID);
+static VOID VaTestUnreadablePageOnlyFailsItsFields(VOID);
+static VOID VaTestOversizedBatchFallsBack(VOID);
+static VOID VaTestExitedChildFailsCleanly(VOID);
+
+static VOID VaStartChild(VOID);
+static VOID VaRunChild(INT32 ReadyPipe);
+
+static VOID VaMakeScatteredReads(REMOTE_READ* Reads, UINT64* Values);
+
+static UINT32 VaCountCorrectValues(const REMOTE_READ* Reads, UINT32 Count);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaStartChild();
+
+	TEST_RUN(VaTestScatteredFieldsAreCoalesced);
+	TEST_RUN(VaTestPagesAreReusedWithinTheLifetime);
+	TEST_RUN(VaTestUnreadablePageOnlyFailsItsFields);
+	TEST_RUN(VaTestOversizedBatchFallsBack);
+	TEST_RUN(VaTestExitedChildFailsCleanly);
+
+	CloseHandle(sProcess);
+
+	VirtualFree(sRegion, 0, MEM_RELEASE);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestScatteredFieldsAreCoalesced(VOID)
+{
+	REMOTE_READ reads[FIELD_COUNT];
+	UINT64 values[FIELD_COUNT];
+
+	VaMakeScatteredReads(reads, values);
+
+	VaCreateRemoteReader(sProcess, 1000);
+
+	REMOTE_READER_STATISTICS before;
+	REMOTE_READER_STATISTICS after;
+
+	VaGetRemoteReaderStatistics(&before);
+
+	UINT32 validCount = VaReadRemoteBatch(reads, FIELD_COUNT);
+
+	VaGetRemoteReaderStatistics(&after);
+
+	// The fields cover pages 0 to 63 without the unreadable one, that is a run of 10, one of 32 and one of 21
+	TEST_CHECK(validCount == FIELD_COUNT);
+	TEST_CHECK(VaCountCorrectValues(reads, FIELD_COUNT) == FIELD_COUNT);
+	TEST_CHECK((after.SpanCount - before.SpanCount) == 3);
+	TEST_CHECK((after.SyscallCount - before.SyscallCount) == 3);
+	TEST_CHECK((after.PageMissCount - before.PageMissCount) == (FIELD_PAGE_COUNT - 1));
+
+	// A field across a page boundary is put together from both cached pages
+	UINT64 value = 0;
+
+	REMOTE_READ straddling = { (UINT64)(sRegion + (21 * PAGE_SIZE) - 4), sizeof(value), &value, FALSE };
+
+	UINT64 expected[] = { ((21 * PAGE_SIZE) - 8) ^ CHILD_MARK, (21 * PAGE_SIZE) ^ CHILD_MARK };
+
+	TEST_CHECK(VaReadRemoteBatch(&straddling, 1) == 1);
+	TEST_CHECK(memcmp(&value, (PBYTE)expected + 4, sizeof(value)) == 0);
+
+	// Timed again with the cache pages already touched, then the same fields one call each the way the old remote path read them
+	VaInvalidateRemoteReader();
+
+	UINT64 start = VaQueryTestTime();
+
+	VaReadRemoteBatch(reads, FIELD_COUNT);
+
+	UINT64 batchTime = VaQueryTestTime() - start;
+
+	start = VaQueryTestTime();
+
+	for (UINT32 i = 0; i < FIELD_COUNT; i++)
+	{
+		ReadProcessMemory(sProcess, (PVOID)reads[i].Address, reads[i].Buffer, reads[i].Size, NULL);
+	}
+
+	UINT64 singleTime = VaQueryTestTime() - start;
+
+	printf("  %u fields in %llu calls %.1f us, one call per field %.1f us\n", FIELD_COUNT, after.SyscallCount - before.SyscallCount, batchTime / 1000.0, singleTime / 1000.0);
+
+	VaDestroyRemoteReader();
+}
+static VOID VaTestPagesAreReusedWithinTheLifetime(VOID)
+{
+	REMOTE_READ reads[FIELD_COUNT];
+	UINT64 values[FIELD_COUNT];
+
+	VaMakeScatteredReads(reads, values);
+
+	VaCreateRemoteReader(sProcess, 1000);
+
+	VaReadRemoteBatch(reads, FIELD_COUNT);
+
+	REMOTE_READER_STATISTICS before;
+	REMOTE_READER_STATISTICS after;
+
+	VaGetRemoteReaderStatistics(&before);
+
+	// Several batches of one refresh share the pages the first one fetched
+	TEST_CHECK(VaReadRemoteBatch(reads, FIELD_COUNT) == FIELD_COUNT);
+
+	VaGetRemoteReaderStatistics(&after);
+
+	TEST_CHECK(after.SyscallCount == before.SyscallCount);
+	TEST_CHECK((after.PageHitCount - before.PageHitCount) >= FIELD_COUNT);
+
+	VaInvalidateRemoteReader();
+
+	TEST_CHECK(VaReadRemoteBatch(reads, FIELD_COUNT) == FIELD_COUNT);
+
+	VaGetRemoteReaderStatistics(&before);
+
+	TEST_CHECK((before.SyscallCount - after.SyscallCount) == 3);
+
+	VaDestroyRemoteReader();
+
+	// Past the lifetime the game has moved on, the pages are fetched again
+	VaCreateRemoteReader(sProcess, REMOTE_READER_DEFAULT_LIFETIME);
+
+	VaReadRemoteBatch(reads, FIELD_COUNT);
+
+	VaGetRemoteReaderStatistics(&before);
+
+	Sleep(REMOTE_READER_DEFAULT_LIFETIME * 3);
+
+	TEST_CHECK(VaReadRemoteBatch(reads, FIELD_COUNT) == FIELD_COUNT);
+
+	VaGetRemoteReaderStatistics(&after);
+
+	TEST_CHECK((after.SyscallCount - before.SyscallCount) == 3);
+	TEST_CHECK((after.FlushCount - before.FlushCount) == 1);
+
+	VaDestroyRemoteReader();
+}
+static VOID VaTestUnreadablePageOnlyFailsItsFields(VOID)
+{
+	UINT64 values[5] = { 0 };
+
+	// Fields on pages 8, 9 and 12, one inside the unreadable page and one running into it
+	REMOTE_READ reads[] =
+	{
+		{ (UINT64)(sRegion + (8 * PAGE_SIZE) + 0x100), sizeof(UINT64), &values[0], FALSE },
+		{ (UINT64)(sRegion + (9 * PAGE_SIZE) + 0x200), sizeof(UINT64), &values[1], FALSE },
+		{ (UINT64)(sRegion + (UNREADABLE_PAGE * PAGE_SIZE) + 0x300), sizeof(UINT64), &values[2], FALSE },
+		{ (UINT64)(sRegion + (UNREADABLE_PAGE * PAGE_SIZE) - 4), sizeof(UINT64), &values[3], FALSE },
+		{ (UINT64)(sRegion + (12 * PAGE_SIZE) + 0x500), sizeof(UINT64), &values[4], FALSE },
+	};
+
+	VaCreateRemoteReader(sProcess, 1000);
+
+	REMOTE_READER_STATISTICS before;
+	REMOTE_READER_STATISTICS after;
+
+	VaGetRemoteReaderStatistics(&before);
+
+	TEST_CHECK(VaReadRemoteBatch(reads, ARRAY_LENGTH(reads)) == 3);
+
+	VaGetRemoteReaderStatistics(&after);
+
+	TEST_CHECK(reads[0].Valid && reads[1].Valid && reads[4].Valid);
+	TEST_CHECK(!reads[2].Valid && !reads[3].Valid);
+	TEST_CHECK((values[0] == ((8 * PAGE_SIZE + 0x100) ^ CHILD_MARK)) && (values[4] == ((12 * PAGE_SIZE + 0x500) ^ CHILD_MARK)));
+	TEST_CHECK((after.FailedCount - before.FailedCount) == 2);
+
+	// Pages 8, 9, 10 and 12 make two spans, the first one fails and its three pages are retried alone
+	TEST_CHECK((after.SpanCount - before.SpanCount) == 2);
+	TEST_CHECK((after.SyscallCount - before.SyscallCount) == 5);
+
+	VaDestroyRemoteReader();
+}
+static VOID VaTestOversizedBatchFallsBack(VOID)
+{
+	static REMOTE_READ reads[CHILD_PAGE_COUNT];
+	static UINT64 values[CHILD_PAGE_COUNT];
+
+	UINT32 count = 0;
+
+	// One field on every readable page of the child, more pages than the cache can hold
+	for (UINT32 page = 0; page < CHILD_PAGE_COUNT; page++)
+	{
+		if (page == UNREADABLE_PAGE)
+		{
+			continue;
+		}
+
+		reads[count].Address = (UINT64)(sRegion + (page * PAGE_SIZE) + 0x10);
+		reads[count].Size = sizeof(UINT64);
+		reads[count].Buffer = &values[count];
+
+		count += 1;
+	}
+
+	VaCreateRemoteReader(sProcess, 1000);
+
+	REMOTE_READER_STATISTICS before;
+	REMOTE_READER_STATISTICS after;
+
+	VaGetRemoteReaderStatistics(&before);
+
+	TEST_CHECK(VaReadRemoteBatch(reads, count) == count);
+	TEST_CHECK(VaCountCorrectValues(reads, count) == count);
+
+	VaGetRemoteReaderStatistics(&after);
+
+	// The cached part still comes in spans, only the pages past the cache are read one field at a time
+	TEST_CHECK((after.SyscallCount - before.SyscallCount) < (count / 2));
+
+	VaDestroyRemoteReader();
+}
+static VOID VaTestExitedChildFailsCleanly(VOID)
+{
+	REMOTE_READ reads[FIELD_COUNT];
+	UINT64 values[FIELD_COUNT];
+
+	VaMakeScatteredReads(reads, values);
+
+	close(sReleasePipe[1]);
+
+	INT32 status = 0;
+
+	TEST_CHECK(waitpid(sChild, &status, 0) == sChild);
+
+	// The game closed while the monitor was polling it, every field is invalid and nothing else happens
+	VaCreateRemoteReader(sProcess, 1000);
+
+	TEST_CHECK(VaReadRemoteBatch(reads, FIELD_COUNT) == 0);
+
+	VaDestroyRemoteReader();
+}
+
+static VOID VaStartChild(VOID)
+{
+	sRegion = (PBYTE)VirtualAlloc(NULL, CHILD_PAGE_COUNT * PAGE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	for (UINT64 offset = 0; offset < (CHILD_PAGE_COUNT * PAGE_SIZE); offset += sizeof(UINT64))
+	{
+		*(UINT64*)(sRegion + offset) = offset;
+	}
+
+	INT32 readyPipe[2] = { -1, -1 };
+
+	pipe(readyPipe);
+	pipe(sReleasePipe);
+
+	// The child inherits the region at the same address, which stands in for a game module at a known base
+	sChild = fork();
+
+	if (sChild == 0)
+	{
+		close(readyPipe[0]);
+		close(sReleasePipe[1]);
+
+		VaRunChild(readyPipe[1]);
+	}
+
+	close(readyPipe[1]);
+	close(sReleasePipe[0]);
+
+	CHAR ready = 0;
+
+	read(readyPipe[0], &ready, sizeof(ready));
+
+	close(readyPipe[0]);
+
+	sProcess = OpenProcess(PROCESS_VM_READ, FALSE, (DWORD)sChild);
+}
+static VOID VaRunChild(INT32 ReadyPipe)
+{
+	for (UINT64 offset = 0; offset < (CHILD_PAGE_COUNT * PAGE_SIZE); offset += sizeof(UINT64))
+	{
+		*(UINT64*)(sRegion + offset) = offset ^ CHILD_MARK;
+	}
+
+	DWORD oldProtect = 0;
+
+	VirtualProtect(sRegion + (UNREADABLE_PAGE * PAGE_SIZE), PAGE_SIZE, PAGE_NOACCESS, &oldProtect);
+
+	CHAR ready = 1;
+
+	write(ReadyPipe, &ready, sizeof(ready));
+
+	// Stays alive until the parent closes its end
+	read(sReleasePipe[0], &ready, sizeof(ready));
+
+	_exit(0);
+}
+
+static VOID VaMakeScatteredReads(REMOTE_READ* Reads, UINT64* Values)
+{
+	// Every readable page below FIELD_PAGE_COUNT gets several fields, in an order that jumps between pages
+	for (UINT32 i = 0; i < FIELD_COUNT; i++)
+	{
+		UINT32 page = (i * 37) % (FIELD_PAGE_COUNT - 1);
+
+		page += (page >= UNREADABLE_PAGE) ? 1 : 0;
+
+		UINT32 offset = ((i * 328) % PAGE_SIZE) & ~7;
+
+		Reads[i].Address = (UINT64)(sRegion + (page * PAGE_SIZE) + offset);
+		Reads[i].Size = sizeof(UINT64);
+		Reads[i].Buffer = &Values[i];
+		Reads[i].Valid = FALSE;
+
+		Values[i] = 0;
+	}
+}
+
+static UINT32 VaCountCorrectValues(const REMOTE_READ* Reads, UINT32 Count)
+{
+	UINT32 correctCount = 0;
+
+	for (UINT32 i = 0; i < Count; i++)
+	{
+		UINT64 offset = Reads[i].Address - (UINT64)sRegion;
+
+		correctCount += (Reads[i].Valid && (*(const UINT64*)Reads[i].Buffer == (offset ^ CHILD_MARK))) ? 1 : 0;
+	}
+
+	return correctCount;
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "safememory.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define PAGE_SIZE (0x1000)
+
+#define REGION_PAGE_COUNT (16)
+
+#define BENCH_READ_COUNT (10000000)
+#define BENCH_SLOW_READ_COUNT (20000)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static PBYTE sRegion = NULL;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaBenchPlainLoad(VOID);
+static VOID VaBenchCachedRead(VOID);
+static VOID VaBenchUncachedRead(VOID);
+static VOID VaBenchProtectedRead(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	sRegion = (PBYTE)VirtualAlloc(NULL, REGION_PAGE_COUNT * PAGE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	memset(sRegion, 1, REGION_PAGE_COUNT * PAGE_SIZE);
+
+	VaCreateSafeMemory();
+
+	VaBenchPlainLoad();
+	VaBenchCachedRead();
+	VaBenchUncachedRead();
+	VaBenchProtectedRead();
+
+	VaDestroySafeMemory();
+
+	VirtualFree(sRegion, 0, MEM_RELEASE);
+
+	return 0;
+}
+
+static VOID VaBenchPlainLoad(VOID)
+{
+	UINT64 sum = 0;
+
+	UINT64 start = VaQueryTestTime();
+
+	// What the per frame reads did before, a raw dereference that crashes on a freed object
+	for (UINT32 i = 0; i < BENCH_READ_COUNT; i++)
+	{
+		UINT64 value = 0;
+
+		memcpy(&value, (const VOID*)(sRegion + ((i * 8) % (REGION_PAGE_COUNT * PAGE_SIZE))), sizeof(value));
+
+		sum += value;
+
+		__asm__ volatile("" : "+r"(sum));
+	}
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	printf("plain load %.1f ns, sum %llu\n", (DOUBLE)elapsed / BENCH_READ_COUNT, sum);
+}
+static VOID VaBenchCachedRead(VOID)
+{
+	UINT64 sum = 0;
+
+	UINT64 start = VaQueryTestTime();
+
+	for (UINT32 i = 0; i < BENCH_READ_COUNT; i++)
+	{
+		UINT64 value = 0;
+
+		VaSafeRead((UINT64)(sRegion + ((i * 8) % (REGION_PAGE_COUNT * PAGE_SIZE))), &value, sizeof(value));
+
+		sum += value;
+	}
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	SAFE_MEMORY_STATISTICS statistics;
+
+	VaGetSafeMemoryStatistics(&statistics);
+
+	printf("cached safe read %.1f ns, %llu hits %llu queries, sum %llu\n", (DOUBLE)elapsed / BENCH_READ_COUNT, statistics.HitCount, statistics.QueryCount, sum);
+}
+static VOID VaBenchUncachedRead(VOID)
+{
+	UINT64 sum = 0;
+
+	UINT64 start = VaQueryTestTime();
+
+	// Every read queries the region again, the cost a read pays after an area load retired the cache
+	for (UINT32 i = 0; i < BENCH_SLOW_READ_COUNT; i++)
+	{
+		UINT64 value = 0;
+
+		VaInvalidateSafeMemory();
+		VaSafeRead((UINT64)(sRegion + ((i * 8) % (REGION_PAGE_COUNT * PAGE_SIZE))), &value, sizeof(value));
+
+		sum += value;
+	}
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	printf("uncached safe read %.1f ns, sum %llu\n", (DOUBLE)elapsed / BENCH_SLOW_READ_COUNT, sum);
+}
+static VOID VaBenchProtectedRead(VOID)
+{
+	UINT64 sum = 0;
+
+	UINT64 start = VaQueryTestTime();
+
+	// The path VaReadFromMemory took for our own process, two protection changes around a process read
+	for (UINT32 i = 0; i < BENCH_SLOW_READ_COUNT; i++)
+	{
+		PBYTE address = sRegion + ((i * 8) % (REGION_PAGE_COUNT * PAGE_SIZE));
+
+		UINT64 value = 0;
+
+		DWORD oldProtect = 0;
+
+		if (VirtualProtect(address, sizeof(value), PAGE_EXECUTE_READWRITE, &oldProtect))
+		{
+			ReadProcessMemory(GetCurrentProcess(), address, &value, sizeof(value), NULL);
+
+			VirtualProtect(address, sizeof(value), oldProtect, &oldProtect);
+		}
+
+		sum += value;
+	}
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	printf("protect and read %.1f ns, sum %llu\n", (DOUBLE)elapsed / BENCH_SLOW_READ_COUNT, sum);
+}
\ No newline at end of file
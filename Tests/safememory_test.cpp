@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <thread>
+
+#include "testing.h"
+#include "safememory.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define PAGE_SIZE (0x1000)
+
+#define REGION_PAGE_COUNT (4)
+
+#define HOT_READ_COUNT (1000)
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestRepeatedReadsSkipTheQuery(VOID);
+static VOID VaTestUnreadablePagesAreRejected(VOID);
+static VOID VaTestFreedObjectFaultsWithoutCrashing(VOID);
+static VOID VaTestFaultRetiresEveryThreadsRegion(VOID);
+static VOID VaTestInvalidateForgetsRegions(VOID);
+
+static VOID VaReadOnOtherThread(PBYTE Region, BOOL* Result);
+
+static PBYTE VaCreateRegion(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateSafeMemory();
+
+	TEST_RUN(VaTestRepeatedReadsSkipTheQuery);
+	TEST_RUN(VaTestUnreadablePagesAreRejected);
+	TEST_RUN(VaTestFreedObjectFaultsWithoutCrashing);
+	TEST_RUN(VaTestFaultRetiresEveryThreadsRegion);
+	TEST_RUN(VaTestInvalidateForgetsRegions);
+
+	VaDestroySafeMemory();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestRepeatedReadsSkipTheQuery(VOID)
+{
+	PBYTE region = VaCreateRegion();
+
+	SAFE_MEMORY_STATISTICS before;
+	SAFE_MEMORY_STATISTICS after;
+
+	VaGetSafeMemoryStatistics(&before);
+
+	UINT64 value = 0;
+
+	// The first read asks the system once, every later read in the same region is a range check and a copy
+	TEST_CHECK(VaSafeRead((UINT64)(region + 0x10), &value, sizeof(value)));
+	TEST_CHECK(value == 0x10);
+
+	VaGetSafeMemoryStatistics(&after);
+
+	TEST_CHECK((after.MissCount - before.MissCount) == 1);
+	TEST_CHECK((after.QueryCount - before.QueryCount) == 1);
+
+	UINT64 sum = 0;
+
+	for (UINT32 i = 0; i < HOT_READ_COUNT; i++)
+	{
+		UINT64 offset = (i * 8) % (REGION_PAGE_COUNT * PAGE_SIZE);
+
+		VaSafeRead((UINT64)(region + offset), &value, sizeof(value));
+
+		sum += (value == offset) ? 1 : 0;
+	}
+
+	VaGetSafeMemoryStatistics(&before);
+
+	TEST_CHECK(sum == HOT_READ_COUNT);
+	TEST_CHECK((before.HitCount - after.HitCount) == HOT_READ_COUNT);
+	TEST_CHECK(before.QueryCount == after.QueryCount);
+	TEST_CHECK(before.MissCount == after.MissCount);
+
+	// Writes go through the same region
+	value = 0xABCD;
+
+	TEST_CHECK(VaSafeWrite((UINT64)(region + 0x20), &value, sizeof(value)));
+	TEST_CHECK(*(UINT64*)(region + 0x20) == 0xABCD);
+
+	VirtualFree(region, 0, MEM_RELEASE);
+	VaInvalidateSafeMemory();
+}
+static VOID VaTestUnreadablePagesAreRejected(VOID)
+{
+	PBYTE region = VaCreateRegion();
+
+	DWORD oldProtect = 0;
+
+	// Page two is no access and page three read only, neither was ever cached
+	VirtualProtect(region + PAGE_SIZE, PAGE_SIZE, PAGE_NOACCESS, &oldProtect);
+	VirtualProtect(region + (2 * PAGE_SIZE), PAGE_SIZE, PAGE_READONLY, &oldProtect);
+
+	SAFE_MEMORY_STATISTICS before;
+	SAFE_MEMORY_STATISTICS after;
+
+	VaGetSafeMemoryStatistics(&before);
+
+	UINT64 value = 0;
+
+	TEST_CHECK(VaSafeRead((UINT64)region, &value, sizeof(value)));
+	TEST_CHECK(!VaSafeRead((UINT64)(region + PAGE_SIZE + 8), &value, sizeof(value)));
+
+	// A read that starts readable and runs into the no access page fails as a whole
+	TEST_CHECK(!VaSafeRead((UINT64)(region + PAGE_SIZE - 4), &value, sizeof(value)));
+
+	TEST_CHECK(VaSafeRead((UINT64)(region + (2 * PAGE_SIZE)), &value, sizeof(value)));
+	TEST_CHECK(value == (2 * PAGE_SIZE));
+	TEST_CHECK(!VaSafeWrite((UINT64)(region + (2 * PAGE_SIZE)), &value, sizeof(value)));
+
+	// Null pointers and ranges that wrap around are refused before anything is queried
+	TEST_CHECK(!VaSafeRead(0, &value, sizeof(value)));
+	TEST_CHECK(!VaSafeRead(~0ULL - 4, &value, sizeof(value)));
+
+	VaGetSafeMemoryStatistics(&after);
+
+	TEST_CHECK((after.RejectCount - before.RejectCount) == 5);
+	TEST_CHECK(after.FaultCount == before.FaultCount);
+
+	VirtualFree(region, 0, MEM_RELEASE);
+	VaInvalidateSafeMemory();
+}
+static VOID VaTestFreedObjectFaultsWithoutCrashing(VOID)
+{
+	PBYTE region = VaCreateRegion();
+
+	UINT64 value = 0;
+
+	TEST_CHECK(VaSafeRead((UINT64)(region + 0x40), &value, sizeof(value)));
+
+	// The game releases the object during an area load, the cached region still claims it is readable
+	DWORD oldProtect = 0;
+
+	VirtualProtect(region, REGION_PAGE_COUNT * PAGE_SIZE, PAGE_NOACCESS, &oldProtect);
+
+	SAFE_MEMORY_STATISTICS before;
+	SAFE_MEMORY_STATISTICS after;
+
+	VaGetSafeMemoryStatistics(&before);
+
+	TEST_CHECK(!VaSafeRead((UINT64)(region + 0x40), &value, sizeof(value)));
+
+	VaGetSafeMemoryStatistics(&after);
+
+	TEST_CHECK((after.FaultCount - before.FaultCount) == 1);
+	TEST_CHECK(after.RegionCount == (before.RegionCount - 1));
+
+	// The faulting region was dropped, the next access asks again and is rejected without a second fault
+	TEST_CHECK(!VaSafeRead((UINT64)(region + 0x40), &value, sizeof(value)));
+
+	VaGetSafeMemoryStatistics(&before);
+
+	TEST_CHECK(before.FaultCount == after.FaultCount);
+	TEST_CHECK((before.RejectCount - after.RejectCount) == 1);
+	TEST_CHECK(before.QueryCount > after.QueryCount);
+
+	// Once the memory is back the reads are as well
+	VirtualProtect(region, REGION_PAGE_COUNT * PAGE_SIZE, PAGE_READWRITE, &oldProtect);
+
+	TEST_CHECK(VaSafeRead((UINT64)(region + 0x40), &value, sizeof(value)));
+	TEST_CHECK(value == 0x40);
+
+	VirtualFree(region, 0, MEM_RELEASE);
+	VaInvalidateSafeMemory();
+}
+static VOID VaTestFaultRetiresEveryThreadsRegion(VOID)
+{
+	PBYTE region = VaCreateRegion();
+
+	UINT64 value = 0;
+
+	// This thread now remembers the region as its last one
+	TEST_CHECK(VaSafeRead((UINT64)region, &value, sizeof(value)));
+
+	DWORD oldProtect = 0;
+
+	VirtualProtect(region, REGION_PAGE_COUNT * PAGE_SIZE, PAGE_NOACCESS, &oldProtect);
+
+	BOOL otherRead = TRUE;
+
+	// Another thread faults on it and drops it from the table
+	std::thread other(VaReadOnOtherThread, region, &otherRead);
+
+	other.join();
+
+	SAFE_MEMORY_STATISTICS before;
+	SAFE_MEMORY_STATISTICS after;
+
+	VaGetSafeMemoryStatistics(&before);
+
+	// The epoch moved, so this thread does not trust its own copy and is rejected by the query instead of faulting
+	TEST_CHECK(!VaSafeRead((UINT64)region, &value, sizeof(value)));
+
+	VaGetSafeMemoryStatistics(&after);
+
+	TEST_CHECK(!otherRead);
+	TEST_CHECK(before.FaultCount == after.FaultCount);
+	TEST_CHECK((after.RejectCount - before.RejectCount) == 1);
+
+	VirtualProtect(region, REGION_PAGE_COUNT * PAGE_SIZE, PAGE_READWRITE, &oldProtect);
+
+	VirtualFree(region, 0, MEM_RELEASE);
+	VaInvalidateSafeMemory();
+}
+static VOID VaTestInvalidateForgetsRegions(VOID)
+{
+	PBYTE region = VaCreateRegion();
+
+	UINT64 value = 0;
+
+	TEST_CHECK(VaSafeRead((UINT64)region, &value, sizeof(value)));
+
+	SAFE_MEMORY_STATISTICS before;
+	SAFE_MEMORY_STATISTICS after;
+
+	VaGetSafeMemoryStatistics(&before);
+
+	TEST_CHECK(before.RegionCount >= 1);
+
+	VaInvalidateSafeMemory();
+
+	VaGetSafeMemoryStatistics(&after);
+
+	TEST_CHECK(after.RegionCount == 0);
+
+	TEST_CHECK(VaSafeRead((UINT64)region, &value, sizeof(value)));
+
+	VaGetSafeMemoryStatistics(&after);
+
+	TEST_CHECK((after.QueryCount - before.QueryCount) == 1);
+	TEST_CHECK(after.RegionCount == 1);
+
+	VirtualFree(region, 0, MEM_RELEASE);
+	VaInvalidateSafeMemory();
+}
+
+static VOID VaReadOnOtherThread(PBYTE Region, BOOL* Result)
+{
+	UINT64 value = 0;
+
+	*Result = VaSafeRead((UINT64)Region, &value, sizeof(value));
+}
+
+static PBYTE VaCreateRegion(VOID)
+{
+	PBYTE region = (PBYTE)VirtualAlloc(NULL, REGION_PAGE_COUNT * PAGE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	// Every eight byte slot holds its own offset
+	for (UINT64 offset = 0; offset < (REGION_PAGE_COUNT * PAGE_SIZE); offset += sizeof(UINT64))
+	{
+		*(UINT64*)(region + offset) = offset;
+	}
+
+	return region;
+}
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#include "testing.h"
+#include "scanner.h"
+#include "scancache.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+#define IMAGE_CODE_SIZE (0x2000)
+#define IMAGE_DATA_SIZE (0x1000)
+
+#define CACHE_HEADER_SIZE (16)
+#define CACHE_ENTRY_SIZE (48)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+DECLARE_SIGNATURE(sCameraSignature, "48 8B 05 ?? ?? ?? ?? F3 0F 10");
+DECLARE_SIGNATURE(sPlayerSignature, "48 8B 0D ?? ?? ?? ?? 48 85 C9");
+DECLARE_SIGNATURE(sWindowSignature, "8B 05 ?? ?? ?? ?? 89 44 24");
+
+// One absolute pointer inside the code, one on a page boundary and one in data which is not hashed anyway
+static UINT32 sRelocations[] = { TEST_IMAGE_CODE_RVA + 0x10, TEST_IMAGE_CODE_RVA + 0x1000, TEST_IMAGE_CODE_RVA + IMAGE_CODE_SIZE + 0x20 };
+
+static CHAR sCachePath[64] = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestRebasedModuleKeepsItsKey(VOID);
+static VOID VaTestResultsSurviveAReopen(VOID);
+static VOID VaTestNewBuildInvalidatesOldEntries(VOID);
+static VOID VaTestMalformedFileIsRebuilt(VOID);
+
+static PBYTE VaCreateModule(UINT32 TimeDateStamp, UINT64 Base);
+
+static VOID VaStoreKnownResults(const SCAN_MODULE_KEY* MainKey, const SCAN_MODULE_KEY* KernelKey);
+
+static VOID VaWriteCacheFile(const VOID* Data, UINT64 Size);
+
+static UINT64 VaQueryCacheFileSize(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	snprintf(sCachePath, sizeof(sCachePath), "/tmp/susano_scancache_test_%d.bin", getpid());
+
+	TEST_RUN(VaTestRebasedModuleKeepsItsKey);
+	TEST_RUN(VaTestResultsSurviveAReopen);
+	TEST_RUN(VaTestNewBuildInvalidatesOldEntries);
+	TEST_RUN(VaTestMalformedFileIsRebuilt);
+
+	DeleteFileA(sCachePath);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestRebasedModuleKeepsItsKey(VOID)
+{
+	PBYTE module = VaCreateModule(1, 0x140000000ULL);
+	PBYTE rebased = VaCreateModule(1, 0x7FF600000000ULL);
+
+	SCAN_MODULE_KEY moduleKey;
+	SCAN_MODULE_KEY rebasedKey;
+
+	VaGetScanModuleKey((UINT64)module, &moduleKey);
+	VaGetScanModuleKey((UINT64)rebased, &rebasedKey);
+
+	// The loader patched different bases into the relocated slots, everything else is the same build
+	TEST_CHECK(memcmp(module + sRelocations[0], rebased + sRelocations[0], sizeof(UINT64)) != 0);
+	TEST_CHECK(memcmp(&moduleKey, &rebasedKey, sizeof(SCAN_MODULE_KEY)) == 0);
+	TEST_CHECK(moduleKey.TimeDateStamp == 1);
+	TEST_CHECK(moduleKey.SizeOfImage != 0);
+
+	// Data is not part of the identity, a game writes to it all the time
+	rebased[TEST_IMAGE_CODE_RVA + IMAGE_CODE_SIZE + 0x40] ^= 0xFF;
+
+	VaGetScanModuleKey((UINT64)rebased, &rebasedKey);
+
+	TEST_CHECK(rebasedKey.CodeHash == moduleKey.CodeHash);
+
+	// A single changed instruction byte outside the relocations is a different build
+	rebased[TEST_IMAGE_CODE_RVA + 0x18] ^= 0x01;
+
+	VaGetScanModuleKey((UINT64)rebased, &rebasedKey);
+
+	TEST_CHECK(rebasedKey.CodeHash != moduleKey.CodeHash);
+
+	VaDestroyTestImage(rebased);
+	VaDestroyTestImage(module);
+}
+static VOID VaTestResultsSurviveAReopen(VOID)
+{
+	DeleteFileA(sCachePath);
+
+	SCAN_MODULE_KEY mainKey = { 1, 0x5000, 0x1111 };
+	SCAN_MODULE_KEY kernelKey = { 2, 0x3000, 0x2222 };
+
+	UINT64 rva = 0;
+	UINT32 matchCount = 0;
+
+	VaOpenScanCache(sCachePath);
+
+	TEST_CHECK(!VaLookupScanCache("main.dll", &mainKey, &sCameraSignature, &rva, &matchCount));
+
+	VaStoreKnownResults(&mainKey, &kernelKey);
+
+	// Stores are visible right away, before anything was written
+	TEST_CHECK(VaLookupScanCache("main.dll", &mainKey, &sCameraSignature, &rva, &matchCount));
+	TEST_CHECK((rva == 0x1234) && (matchCount == 1));
+
+	TEST_CHECK(VaFlushScanCache());
+	TEST_CHECK(VaQueryCacheFileSize() == (CACHE_HEADER_SIZE + (3 * CACHE_ENTRY_SIZE)));
+
+	VaCloseScanCache();
+
+	SCAN_CACHE_STATISTICS before;
+
+	VaGetScanCacheStatistics(&before);
+
+	VaOpenScanCache(sCachePath);
+
+	SCAN_CACHE_STATISTICS after;
+
+	VaGetScanCacheStatistics(&after);
+
+	TEST_CHECK(after.EntryCount == 3);
+
+	// Names are matched without regard to case, the loader does the same
+	TEST_CHECK(VaLookupScanCache("MAIN.DLL", &mainKey, &sCameraSignature, &rva, &matchCount));
+	TEST_CHECK((rva == 0x1234) && (matchCount == 1));
+	TEST_CHECK(VaLookupScanCache("main.dll", &mainKey, &sPlayerSignature, &rva, &matchCount));
+	TEST_CHECK((rva == 0) && (matchCount == 0));
+	TEST_CHECK(VaLookupScanCache("flower_kernel.dll", &kernelKey, &sWindowSignature, &rva, &matchCount));
+	TEST_CHECK((rva == 0x0ABC) && (matchCount == 2));
+
+	// The same signature in another module is another entry
+	TEST_CHECK(!VaLookupScanCache("flower_kernel.dll", &kernelKey, &sCameraSignature, &rva, &matchCount));
+
+	VaGetScanCacheStatistics(&after);
+
+	TEST_CHECK((after.HitCount - before.HitCount) == 3);
+	TEST_CHECK((after.MissCount - before.MissCount) == 1);
+
+	// Nothing was stored, closing leaves the file alone
+	VaCloseScanCache();
+
+	TEST_CHECK(VaQueryCacheFileSize() == (CACHE_HEADER_SIZE + (3 * CACHE_ENTRY_SIZE)));
+}
+static VOID VaTestNewBuildInvalidatesOldEntries(VOID)
+{
+	DeleteFileA(sCachePath);
+
+	SCAN_MODULE_KEY mainKey = { 1, 0x5000, 0x1111 };
+	SCAN_MODULE_KEY kernelKey = { 2, 0x3000, 0x2222 };
+
+	VaOpenScanCache(sCachePath);
+	VaStoreKnownResults(&mainKey, &kernelKey);
+	VaCloseScanCache();
+
+	// A game update changes the stamp or only the code, either way the old results must not be used
+	SCAN_MODULE_KEY updatedKeys[] = { { 3, 0x5000, 0x1111 }, { 1, 0x6000, 0x1111 }, { 1, 0x5000, 0x3333 } };
+
+	UINT64 rva = 0;
+	UINT32 matchCount = 0;
+
+	VaOpenScanCache(sCachePath);
+
+	for (UINT32 i = 0; i < ARRAY_LENGTH(updatedKeys); i++)
+	{
+		TEST_CHECK(!VaLookupScanCache("main.dll", &updatedKeys[i], &sCameraSignature, &rva, &matchCount));
+	}
+
+	SCAN_CACHE_STATISTICS before;
+
+	VaGetScanCacheStatistics(&before);
+
+	// Rescanning the new build stores one result, the flush drops both entries of the old build
+	VaStoreScanCache("main.dll", &updatedKeys[2], &sCameraSignature, 0x4321, 1);
+
+	TEST_CHECK(VaFlushScanCache());
+
+	SCAN_CACHE_STATISTICS after;
+
+	VaGetScanCacheStatistics(&after);
+
+	TEST_CHECK((after.InvalidatedCount - before.InvalidatedCount) == 2);
+	TEST_CHECK(after.EntryCount == 2);
+
+	VaCloseScanCache();
+
+	VaOpenScanCache(sCachePath);
+
+	TEST_CHECK(VaLookupScanCache("main.dll", &updatedKeys[2], &sCameraSignature, &rva, &matchCount));
+	TEST_CHECK(rva == 0x4321);
+	TEST_CHECK(!VaLookupScanCache("main.dll", &mainKey, &sCameraSignature, &rva, &matchCount));
+	TEST_CHECK(!VaLookupScanCache("main.dll", &mainKey, &sPlayerSignature, &rva, &matchCount));
+
+	// Other modules did not change and keep their results
+	TEST_CHECK(VaLookupScanCache("flower_kernel.dll", &kernelKey, &sWindowSignature, &rva, &matchCount));
+	TEST_CHECK(rva == 0x0ABC);
+
+	VaCloseScanCache();
+
+	TEST_CHECK(VaQueryCacheFileSize() == (CACHE_HEADER_SIZE + (2 * CACHE_ENTRY_SIZE)));
+}
+static VOID VaTestMalformedFileIsRebuilt(VOID)
+{
+	SCAN_MODULE_KEY mainKey = { 1, 0x5000, 0x1111 };
+	SCAN_MODULE_KEY kernelKey = { 2, 0x3000, 0x2222 };
+
+	// A header with a foreign magic, one claiming more entries than the file holds and one shorter than a header
+	UINT32 foreignHeader[] = { 0x12345678, 1, CACHE_ENTRY_SIZE, 0 };
+	UINT32 truncatedHeader[] = { 0x43435353, 1, CACHE_ENTRY_SIZE, 4 };
+	UINT32 shortHeader[] = { 0x43435353 };
+
+	struct
+	{
+		const VOID* Data;
+		UINT64 Size;
+	} files[] = { { foreignHeader, sizeof(foreignHeader) }, { truncatedHeader, sizeof(truncatedHeader) }, { shortHeader, sizeof(shortHeader) } };
+
+	UINT64 rva = 0;
+	UINT32 matchCount = 0;
+
+	for (UINT32 i = 0; i < ARRAY_LENGTH(files); i++)
+	{
+		VaWriteCacheFile(files[i].Data, files[i].Size);
+
+		VaOpenScanCache(sCachePath);
+
+		SCAN_CACHE_STATISTICS statistics;
+
+		VaGetScanCacheStatistics(&statistics);
+
+		TEST_CHECK(statistics.EntryCount == 0);
+		TEST_CHECK(!VaLookupScanCache("main.dll", &mainKey, &sCameraSignature, &rva, &matchCount));
+
+		VaStoreKnownResults(&mainKey, &kernelKey);
+
+		VaCloseScanCache();
+
+		TEST_CHECK(VaQueryCacheFileSize() == (CACHE_HEADER_SIZE + (3 * CACHE_ENTRY_SIZE)));
+	}
+
+	VaOpenScanCache(sCachePath);
+
+	TEST_CHECK(VaLookupScanCache("main.dll", &mainKey, &sCameraSignature, &rva, &matchCount));
+
+	VaCloseScanCache();
+}
+
+static PBYTE VaCreateModule(UINT32 TimeDateStamp, UINT64 Base)
+{
+	PBYTE module = VaCreateTestImage(IMAGE_CODE_SIZE, IMAGE_DATA_SIZE, TimeDateStamp, sRelocations, ARRAY_LENGTH(sRelocations));
+
+	for (UINT32 i = 0; i < IMAGE_CODE_SIZE; i++)
+	{
+		module[TEST_IMAGE_CODE_RVA + i] = (BYTE)(i * 13 + 5);
+	}
+
+	// What the loader leaves in the slots after applying the delta to a preferred base of zero
+	for (UINT32 i = 0; i < ARRAY_LENGTH(sRelocations); i++)
+	{
+		UINT64 pointer = Base + sRelocations[i];
+
+		memcpy(module + sRelocations[i], &pointer, sizeof(pointer));
+	}
+
+	return module;
+}
+
+static VOID VaStoreKnownResults(const SCAN_MODULE_KEY* MainKey, const SCAN_MODULE_KEY* KernelKey)
+{
+	// A signature that was not found is a result as well, it saves the same scan on the next load
+	VaStoreScanCache("main.dll", MainKey, &sCameraSignature, 0x1234, 1);
+	VaStoreScanCache("main.dll", MainKey, &sPlayerSignature, 0, 0);
+	VaStoreScanCache("flower_kernel.dll", KernelKey, &sWindowSignature, 0x0ABC, 2);
+}
+
+static VOID VaWriteCacheFile(const VOID* Data, UINT64 Size)
+{
+	FILE* file = fopen(sCachePath, "wb");
+
+	fwrite(Data, 1, Size, file);
+	fclose(file);
+}
+
+static UINT64 VaQueryCacheFileSize(VOID)
+{
+	FILE* file = fopen(sCachePath, "rb");
+
+	if (!file)
+	{
+		return 0;
+	}
+
+	fseek(file, 0, SEEK_END);
+
+	UINT64 size = (UINT64)ftell(file);
+
+	fclose(file);
+
+	return size;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testing.h"
+#include "scanner.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+#define BENCH_IMAGE_SIZE (100ULL * 1024 * 1024)
+#define BENCH_REQUEST_COUNT (200)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+// The bytes x64 code is made of most, the synthetic image draws half of its bytes from them
+static UINT8 sCommonBytes[] = { 0x00, 0x48, 0x8B, 0x89, 0xFF, 0x0F, 0x83, 0xC4, 0xE8, 0x24, 0x4C, 0x85, 0xC0, 0x74, 0x75, 0x44 };
+
+static UINT64 sRandomState = 0x2545F4914F6CDD1DULL;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaBenchScan(const UINT8* Image, SCAN_REQUEST* Requests, UINT32 RequestCount);
+
+static UINT64 VaNextRandom(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	UINT8* image = (UINT8*)malloc(BENCH_IMAGE_SIZE);
+
+	for (UINT64 i = 0; i < BENCH_IMAGE_SIZE; i++)
+	{
+		UINT64 random = VaNextRandom();
+
+		image[i] = (random & 1) ? sCommonBytes[(random >> 8) % ARRAY_LENGTH(sCommonBytes)] : (UINT8)(random >> 16);
+	}
+
+	SCAN_REQUEST* requests = (SCAN_REQUEST*)calloc(BENCH_REQUEST_COUNT, sizeof(SCAN_REQUEST));
+
+	// Patterns are cut out of the image like real ones are cut out of a build, displacement bytes become wildcards
+	for (UINT32 i = 0; i < BENCH_REQUEST_COUNT; i++)
+	{
+		SIGNATURE* signature = &requests[i].Signature;
+
+		UINT32 length = 8 + (UINT32)(VaNextRandom() % 9);
+
+		UINT64 start = VaNextRandom() % (BENCH_IMAGE_SIZE - length);
+
+		for (UINT32 j = 0; j < length; j++)
+		{
+			BOOL wildcard = (j >= 3) && (j < 7);
+
+			signature->Mask[j] = wildcard ? 0 : 0xFF;
+			signature->Bytes[j] = image[start + j] & signature->Mask[j];
+		}
+
+		signature->Length = length;
+		signature->Valid = TRUE;
+	}
+
+	UINT32 requestCounts[] = { 1, 8, 32, 64, BENCH_REQUEST_COUNT };
+
+	for (UINT32 i = 0; i < ARRAY_LENGTH(requestCounts); i++)
+	{
+		VaBenchScan(image, requests, requestCounts[i]);
+	}
+
+	free(requests);
+	free(image);
+
+	return 0;
+}
+
+static VOID VaBenchScan(const UINT8* Image, SCAN_REQUEST* Requests, UINT32 RequestCount)
+{
+	SCANNER_STATISTICS before;
+	SCANNER_STATISTICS after;
+
+	VaGetScannerStatistics(&before);
+
+	UINT64 start = VaQueryTestTime();
+
+	VaScanMemory(Image, BENCH_IMAGE_SIZE, Requests, RequestCount);
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	VaGetScannerStatistics(&after);
+
+	UINT32 foundCount = 0;
+
+	for (UINT32 i = 0; i < RequestCount; i++)
+	{
+		foundCount += Requests[i].MatchCount ? 1 : 0;
+	}
+
+	printf("%3u patterns over 100 MiB %.2f GB/s, %.1f candidates per KiB, %u of %u found, avx2 %s\n", RequestCount, (DOUBLE)BENCH_IMAGE_SIZE / elapsed, (DOUBLE)(after.CandidateCount - before.CandidateCount) * 1024.0 / BENCH_IMAGE_SIZE, foundCount, RequestCount, after.Avx2 ? "on" : "off");
+}
+
+static UINT64 VaNextRandom(VOID)
+{
+	sRandomState ^= sRandomState << 13;
+	sRandomState ^= sRandomState >> 7;
+	sRandomState ^= sRandomState << 17;
+
+	return sRandomState;
+}
\ No newline at end of file
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testing.h"
+#include "scanner.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define ARRAY_LENGTH(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+#define RANDOM_BUFFER_SIZE (256 * 1024)
+#define RANDOM_REQUEST_COUNT (300)
+
+#define IMAGE_CODE_SIZE (0x3000)
+#define IMAGE_DATA_SIZE (0x1000)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+DECLARE_SIGNATURE(sMovSignature, "48 8B 05 ?? ?? ?? ??");
+DECLARE_SIGNATURE(sShortWildcardSignature, "E8 ? ? ? ? 90");
+
+static UINT64 sRandomState = 0x9E3779B97F4A7C15ULL;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestSignaturesAreParsed(VOID);
+static VOID VaTestScanMatchesBruteForce(VOID);
+static VOID VaTestBufferEdgesMatch(VOID);
+static VOID VaTestModulesOnlyScanCode(VOID);
+static VOID VaTestRelativeAddressesResolve(VOID);
+
+static VOID VaCompareWithBruteForce(const UINT8* Buffer, UINT64 Size, SCAN_REQUEST* Requests, UINT32 RequestCount, UINT32* MismatchCount);
+
+static VOID VaMakeRandomSignature(SIGNATURE* Signature, const UINT8* Buffer, UINT64 Size);
+
+static UINT64 VaNextRandom(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	TEST_RUN(VaTestSignaturesAreParsed);
+	TEST_RUN(VaTestScanMatchesBruteForce);
+	TEST_RUN(VaTestBufferEdgesMatch);
+	TEST_RUN(VaTestModulesOnlyScanCode);
+	TEST_RUN(VaTestRelativeAddressesResolve);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestSignaturesAreParsed(VOID)
+{
+	// Both forms of wildcard are accepted and stored with a zero mask
+	TEST_CHECK(sMovSignature.Length == 7);
+	TEST_CHECK((sMovSignature.Bytes[0] == 0x48) && (sMovSignature.Bytes[2] == 0x05) && (sMovSignature.Mask[2] == 0xFF));
+	TEST_CHECK((sMovSignature.Bytes[3] == 0) && (sMovSignature.Mask[3] == 0) && (sMovSignature.Mask[6] == 0));
+	TEST_CHECK((sShortWildcardSignature.Length == 6) && (sShortWildcardSignature.Mask[5] == 0xFF));
+
+	TEST_CHECK(VaParseSignature("aB cd").Valid);
+	TEST_CHECK(!VaParseSignature("").Valid);
+	TEST_CHECK(!VaParseSignature("   ").Valid);
+	TEST_CHECK(!VaParseSignature("4").Valid);
+	TEST_CHECK(!VaParseSignature("XY").Valid);
+	TEST_CHECK(!VaParseSignature("48 8B05").Valid);
+	TEST_CHECK(!VaParseSignature("48 ??? 05").Valid);
+
+	CHAR tooLong[(SIGNATURE_LENGTH + 1) * 3 + 1] = { 0 };
+
+	for (UINT32 i = 0; i <= SIGNATURE_LENGTH; i++)
+	{
+		strcat(tooLong, "90 ");
+	}
+
+	TEST_CHECK(!VaParseSignature(tooLong).Valid);
+
+	tooLong[SIGNATURE_LENGTH * 3] = 0;
+
+	TEST_CHECK(VaParseSignature(tooLong).Valid);
+}
+static VOID VaTestScanMatchesBruteForce(VOID)
+{
+	UINT8* buffer = (UINT8*)malloc(RANDOM_BUFFER_SIZE);
+
+	// Few distinct byte values make partial matches and repeated matches common
+	for (UINT32 i = 0; i < RANDOM_BUFFER_SIZE; i++)
+	{
+		buffer[i] = (UINT8)(VaNextRandom() % 8) * 0x11;
+	}
+
+	SCAN_REQUEST* requests = (SCAN_REQUEST*)calloc(RANDOM_REQUEST_COUNT, sizeof(SCAN_REQUEST));
+
+	for (UINT32 i = 0; i < RANDOM_REQUEST_COUNT; i++)
+	{
+		VaMakeRandomSignature(&requests[i].Signature, buffer, RANDOM_BUFFER_SIZE);
+	}
+
+	// Invalid requests are skipped without disturbing the rest
+	requests[17].Signature.Valid = FALSE;
+
+	// One group, one lane of groups and several lanes take different paths through the tables
+	UINT32 requestCounts[] = { 1, 7, 32, 33, 257, RANDOM_REQUEST_COUNT };
+
+	UINT32 mismatchCount = 0;
+
+	for (UINT32 i = 0; i < ARRAY_LENGTH(requestCounts); i++)
+	{
+		VaScanMemory(buffer, RANDOM_BUFFER_SIZE, requests, requestCounts[i]);
+
+		VaCompareWithBruteForce(buffer, RANDOM_BUFFER_SIZE, requests, requestCounts[i], &mismatchCount);
+	}
+
+	UINT32 foundCount = 0;
+
+	for (UINT32 i = 0; i < RANDOM_REQUEST_COUNT; i++)
+	{
+		foundCount += requests[i].MatchCount ? 1 : 0;
+	}
+
+	SCANNER_STATISTICS statistics;
+
+	VaGetScannerStatistics(&statistics);
+
+	TEST_CHECK(mismatchCount == 0);
+	TEST_CHECK(foundCount > (RANDOM_REQUEST_COUNT / 2));
+	TEST_CHECK(foundCount < RANDOM_REQUEST_COUNT);
+	TEST_CHECK((requests[17].MatchCount == 0) && (requests[17].Address == 0));
+
+	printf("  %u of %u patterns found, avx2 %s\n", foundCount, RANDOM_REQUEST_COUNT, statistics.Avx2 ? "on" : "off");
+
+	free(requests);
+	free(buffer);
+}
+static VOID VaTestBufferEdgesMatch(VOID)
+{
+	UINT8 buffer[100];
+
+	for (UINT32 i = 0; i < sizeof(buffer); i++)
+	{
+		buffer[i] = (UINT8)(i * 7 + 3);
+	}
+
+	SCAN_REQUEST requests[6] = { 0 };
+
+	// First bytes, last bytes, a pattern that runs off the end, a single byte, a wildcard lead and one crossing the vector tail
+	requests[0].Signature = VaParseSignature("03 0A 11 18");
+	requests[1].Signature = VaParseSignature("AA B1 B8");
+	requests[2].Signature = VaParseSignature("B1 B8 BF");
+	requests[3].Signature = VaParseSignature("B8");
+	requests[4].Signature = VaParseSignature("?? ?? 11");
+	requests[5].Signature = VaParseSignature("C3 CA ?? D8 DF");
+
+	UINT32 mismatchCount = 0;
+
+	// Every size from below one vector block up to the whole buffer moves the scalar tail across the patterns
+	for (UINT64 size = 1; size <= sizeof(buffer); size++)
+	{
+		VaScanMemory(buffer, size, requests, ARRAY_LENGTH(requests));
+
+		VaCompareWithBruteForce(buffer, size, requests, ARRAY_LENGTH(requests), &mismatchCount);
+	}
+
+	VaScanMemory(buffer, sizeof(buffer), requests, ARRAY_LENGTH(requests));
+
+	TEST_CHECK(mismatchCount == 0);
+	TEST_CHECK(requests[0].Address == (UINT64)buffer);
+	TEST_CHECK(requests[1].Address == (UINT64)(buffer + 97));
+	TEST_CHECK(requests[2].MatchCount == 0);
+	TEST_CHECK(requests[3].Address == (UINT64)(buffer + 99));
+	TEST_CHECK(requests[4].Address == (UINT64)buffer);
+	TEST_CHECK(requests[5].Address == (UINT64)(buffer + 64));
+}
+static VOID VaTestModulesOnlyScanCode(VOID)
+{
+	PBYTE image = VaCreateTestImage(IMAGE_CODE_SIZE, IMAGE_DATA_SIZE, 1, NULL, 0);
+
+	BYTE pattern[] = { 0x48, 0x8B, 0x05, 0x10, 0x20, 0x30, 0x40 };
+
+	// The same bytes in data are not code and must not be reported, the two in code are
+	memcpy(image + TEST_IMAGE_CODE_RVA + 0x2FF0, pattern, sizeof(pattern));
+	memcpy(image + TEST_IMAGE_CODE_RVA + 0x0123, pattern, sizeof(pattern));
+	memcpy(image + TEST_IMAGE_CODE_RVA + IMAGE_CODE_SIZE + 0x10, pattern, sizeof(pattern));
+
+	SCAN_REQUEST request = { 0 };
+
+	request.Signature = sMovSignature;
+
+	VaScanModule((UINT64)image, &request, 1);
+
+	TEST_CHECK(request.MatchCount == 2);
+	TEST_CHECK(request.Address == (UINT64)(image + TEST_IMAGE_CODE_RVA + 0x0123));
+
+	VaDestroyTestImage(image);
+}
+static VOID VaTestRelativeAddressesResolve(VOID)
+{
+	BYTE code[32] = { 0 };
+
+	// lea rcx, [rip - 0x10] at offset 8, the target is relative to the end of the instruction
+	BYTE instruction[] = { 0x48, 0x8D, 0x0D, 0xF0, 0xFF, 0xFF, 0xFF };
+
+	memcpy(code + 8, instruction, sizeof(instruction));
+
+	TEST_CHECK(VaResolveRelativeAddress((UINT64)(code + 8), 3, 7) == ((UINT64)code + 8 + 7 - 0x10));
+
+	INT32 forward = 0x12345;
+
+	memcpy(code + 8 + 3, &forward, sizeof(forward));
+
+	TEST_CHECK(VaResolveRelativeAddress((UINT64)(code + 8), 3, 7) == ((UINT64)code + 8 + 7 + 0x12345));
+}
+
+static VOID VaCompareWithBruteForce(const UINT8* Buffer, UINT64 Size, SCAN_REQUEST* Requests, UINT32 RequestCount, UINT32* MismatchCount)
+{
+	for (UINT32 i = 0; i < RequestCount; i++)
+	{
+		const SIGNATURE* signature = &Requests[i].Signature;
+
+		UINT64 address = 0;
+		UINT32 matchCount = 0;
+
+		for (UINT64 position = 0; signature->Valid && ((position + signature->Length) <= Size); position++)
+		{
+			UINT32 j = 0;
+
+			while ((j < signature->Length) && ((Buffer[position + j] & signature->Mask[j]) == signature->Bytes[j]))
+			{
+				j++;
+			}
+
+			if (j == signature->Length)
+			{
+				address = matchCount ? address : (UINT64)(Buffer + position);
+				matchCount += 1;
+			}
+		}
+
+		if ((Requests[i].Address != address) || (Requests[i].MatchCount != matchCount))
+		{
+			*MismatchCount += 1;
+		}
+	}
+}
+
+static VOID VaMakeRandomSignature(SIGNATURE* Signature, const UINT8* Buffer, UINT64 Size)
+{
+	memset(Signature, 0, sizeof(SIGNATURE));
+
+	UINT32 length = 1 + (UINT32)(VaNextRandom() % 12);
+
+	// Most patterns are cut out of the buffer so they exist, a few are made up and only exist by chance
+	BOOL present = (VaNextRandom() % 4) != 0;
+
+	UINT64 start = VaNextRandom() % (Size - length);
+
+	for (UINT32 i = 0; i < length; i++)
+	{
+		BOOL wildcard = (length > 2) && ((VaNextRandom() % 4) == 0);
+
+		UINT8 value = present ? Buffer[start + i] : (UINT8)VaNextRandom();
+
+		Signature->Mask[i] = wildcard ? 0 : 0xFF;
+		Signature->Bytes[i] = value & Signature->Mask[i];
+	}
+
+	// A pattern has to pin at least one byte
+	Signature->Mask[0] = 0xFF;
+	Signature->Bytes[0] = present ? Buffer[start] : (UINT8)VaNextRandom();
+
+	Signature->Length = length;
+	Signature->Valid = TRUE;
+}
+
+static UINT64 VaNextRandom(VOID)
+{
+	sRandomState ^= sRandomState << 13;
+	sRandomState ^= sRandomState >> 7;
+	sRandomState ^= sRandomState << 17;
+
+	return sRandomState;
+}
\ No newline at end of file
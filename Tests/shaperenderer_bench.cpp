@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "shaperenderer.h"
+#include "linebatchrenderer.h"
+#include "uploadring.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define BENCH_FRAME_COUNT (16)
+#define BENCH_SHAPE_COUNT (10000)
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaBenchShapes(BOOL Instancing);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateTestRenderer();
+	VaCreateLineBatchRenderer();
+	VaCreateShapeRenderer();
+
+	VaBenchShapes(TRUE);
+	VaBenchShapes(FALSE);
+
+	VaDestroyShapeRenderer();
+	VaDestroyLineBatchRenderer();
+	VaDestroyTestRenderer();
+
+	return 0;
+}
+
+static VOID VaBenchShapes(BOOL Instancing)
+{
+	UINT64 frameTime = 0;
+
+	UPLOAD_RING_STATISTICS before;
+	UPLOAD_RING_STATISTICS after;
+
+	VaSetShapeInstancing(Instancing);
+
+	VaGetUploadRingStatistics(&before);
+
+	D3D11_MOCK_STATISTICS mockBefore = gMockContext->Statistics;
+
+	for (UINT32 frame = 0; frame < BENCH_FRAME_COUNT; frame++)
+	{
+		UINT64 start = VaQueryTestTime();
+
+		// A quarter of each kind, moved a little every frame so nothing is served from the upload cache
+		for (UINT32 i = 0; i < BENCH_SHAPE_COUNT; i++)
+		{
+			FLOAT x = ((FLOAT)(i % 100) / 100.0f) - 0.5f + (FLOAT)frame * 0.0001f;
+			FLOAT y = ((FLOAT)(i / 100) / 100.0f) - 0.5f;
+
+			switch (i % 4)
+			{
+				case 0: VaDrawWireBox({ x, y, 0.5f }, { 0.01f, 0.02f, 0.03f }, { 1.0f, 0.0f, 0.0f, 1.0f }); break;
+				case 1: VaDrawWireSphere({ x, y, 0.5f }, 0.02f, { 0.0f, 1.0f, 0.0f, 1.0f }); break;
+				case 2: VaDrawWireCylinder({ x, y, 0.5f }, 0.01f, 0.05f, { 0.0f, 0.0f, 1.0f, 1.0f }); break;
+				case 3: VaDrawWireCapsule({ x, y, 0.5f }, 0.01f, 0.05f, { 1.0f, 1.0f, 0.0f, 1.0f }); break;
+			}
+		}
+
+		VaBeginTestFrame();
+
+		VaRenderShapeBatch();
+		VaRenderLineBatch();
+
+		VaEndTestFrame();
+
+		frameTime += VaQueryTestTime() - start;
+	}
+
+	VaGetUploadRingStatistics(&after);
+
+	D3D11_MOCK_STATISTICS mockAfter = gMockContext->Statistics;
+
+	UINT32 drawCount = (mockAfter.DrawCount + mockAfter.DrawIndexedCount + mockAfter.DrawIndexedInstancedCount) - (mockBefore.DrawCount + mockBefore.DrawIndexedCount + mockBefore.DrawIndexedInstancedCount);
+
+	printf("shapes %s, 10k shapes %.2f ms cpu per frame, upload %.1f KiB per frame, %.1f draws per frame\n", Instancing ? "instanced" : "expanded", frameTime / 1000000.0 / BENCH_FRAME_COUNT, (after.UploadedBytes - before.UploadedBytes) / 1024.0 / BENCH_FRAME_COUNT, (DOUBLE)drawCount / BENCH_FRAME_COUNT);
+}
\ No newline at end of file
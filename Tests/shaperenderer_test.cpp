@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "shaperenderer.h"
+#include "linebatchrenderer.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define SHAPE_COUNT (1000)
+
+#define MAXIMUM_VERTEX_COUNT (4 * 1024 * 1024)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// Mirrors the private layouts of shaperenderer.cpp, the instanced draws are decoded from the bound buffers
+struct SHAPE_VERTEX
+{
+	XMFLOAT3 Position;
+	FLOAT Cap;
+};
+
+struct SHAPE_INSTANCE
+{
+	XMFLOAT4 Rows[3];
+	UINT32 Color;
+	FLOAT Extension;
+	FLOAT Padding[2];
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static VERTEX* sInstancedVertices = NULL;
+static UINT64 sInstancedVertexCount = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestInstancedMatchesExpanded(VOID);
+static VOID VaTestInstanceUploadSize(VOID);
+
+static VOID VaDrawTestShapes(VOID);
+
+static VOID VaRunVertexShader(const D3D11_MOCK_DRAW* Draw, PVOID UserParam);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateTestRenderer();
+	VaCreateLineBatchRenderer();
+	VaCreateShapeRenderer();
+
+	sInstancedVertices = (VERTEX*)malloc(sizeof(VERTEX) * MAXIMUM_VERTEX_COUNT);
+
+	TEST_RUN(VaTestInstancedMatchesExpanded);
+	TEST_RUN(VaTestInstanceUploadSize);
+
+	free(sInstancedVertices);
+
+	VaDestroyShapeRenderer();
+	VaDestroyLineBatchRenderer();
+	VaDestroyTestRenderer();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestInstancedMatchesExpanded(VOID)
+{
+	VERTEX* expandedVertices = (VERTEX*)malloc(sizeof(VERTEX) * MAXIMUM_VERTEX_COUNT);
+
+	// The instanced draws run through a cpu copy of the vertex shader
+	VaSetShapeInstancing(TRUE);
+
+	VaDrawTestShapes();
+
+	sInstancedVertexCount = 0;
+
+	gMockContext->DrawProc = VaRunVertexShader;
+
+	VaBeginTestFrame();
+
+	VaRenderShapeBatch();
+
+	VaEndTestFrame();
+
+	gMockContext->DrawProc = NULL;
+
+	SHAPE_BATCH_STATISTICS statistics;
+
+	VaGetShapeBatchStatistics(&statistics);
+
+	TEST_CHECK(statistics.InstanceCount == SHAPE_COUNT);
+	TEST_CHECK(statistics.DrawCount == 4);
+
+	// The fallback expands the same shapes into the line batch, both have to produce the same lines in the same order
+	VaSetShapeInstancing(FALSE);
+
+	VaDrawTestShapes();
+
+	TEST_FRAME_CAPTURE capture;
+
+	VaBeginFrameCapture(&capture, expandedVertices, MAXIMUM_VERTEX_COUNT);
+	VaBeginTestFrame();
+
+	VaRenderShapeBatch();
+	VaRenderLineBatch();
+
+	VaEndTestFrame();
+	VaEndFrameCapture();
+
+	TEST_CHECK(sInstancedVertexCount > 0);
+	TEST_CHECK(capture.VertexCount == sInstancedVertexCount);
+
+	UINT64 mismatchCount = 0;
+
+	for (UINT64 i = 0; (i < sInstancedVertexCount) && (i < capture.VertexCount); i++)
+	{
+		VERTEX* a = &sInstancedVertices[i];
+		VERTEX* b = &expandedVertices[i];
+
+		BOOL equal = (fabsf(a->Position.x - b->Position.x) < 1e-4f) && (fabsf(a->Position.y - b->Position.y) < 1e-4f) && (fabsf(a->Position.z - b->Position.z) < 1e-4f) && (a->Color == b->Color);
+
+		mismatchCount += equal ? 0 : 1;
+	}
+
+	TEST_CHECK(mismatchCount == 0);
+
+	VaSetShapeInstancing(TRUE);
+
+	free(expandedVertices);
+}
+static VOID VaTestInstanceUploadSize(VOID)
+{
+	SHAPE_BATCH_STATISTICS statistics;
+
+	VaDrawTestShapes();
+	VaDrawWireBox({ 0.0f, 0.0f, 0.5f }, { 0.1f, 0.1f, 0.1f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	VaBeginTestFrame();
+
+	VaRenderShapeBatch();
+
+	VaEndTestFrame();
+
+	D3D11_MOCK_STATISTICS after = gMockContext->Statistics;
+
+	VaGetShapeBatchStatistics(&statistics);
+
+	// One 64 byte instance per shape and one draw per shape kind, the unit meshes are never uploaded again
+	TEST_CHECK(sizeof(SHAPE_INSTANCE) == 64);
+	TEST_CHECK(after.DrawIndexedInstancedCount - before.DrawIndexedInstancedCount == 4);
+	TEST_CHECK(after.DrawnInstanceCount - before.DrawnInstanceCount == SHAPE_COUNT + 1);
+	TEST_CHECK(after.CreatedBufferCount == before.CreatedBufferCount);
+	TEST_CHECK(statistics.UploadedBytes == (SHAPE_COUNT + 1) * sizeof(SHAPE_INSTANCE));
+}
+
+static VOID VaDrawTestShapes(VOID)
+{
+	// Everything stays well inside the identity frustum so the line batch culls nothing
+	for (UINT32 i = 0; i < SHAPE_COUNT; i++)
+	{
+		FLOAT x = ((FLOAT)(i % 50) / 50.0f) - 0.5f;
+		FLOAT y = ((FLOAT)(i / 50) / 40.0f) - 0.25f;
+
+		XMFLOAT4 color = { (FLOAT)(i % 7) / 7.0f, (FLOAT)(i % 3) / 3.0f, 1.0f, 1.0f };
+
+		switch (i % 4)
+		{
+			case 0: VaDrawWireBox({ x, y, 0.5f }, { 0.01f, 0.02f, 0.03f }, color); break;
+			case 1: VaDrawWireSphere({ x, y, 0.5f }, 0.02f, color); break;
+			case 2: VaDrawWireCylinder({ x, y, 0.5f }, 0.01f, 0.05f, color); break;
+			case 3: VaDrawWireCapsule({ x, y, 0.5f }, 0.01f, 0.05f, color); break;
+		}
+	}
+}
+
+static VOID VaRunVertexShader(const D3D11_MOCK_DRAW* Draw, PVOID UserParam)
+{
+	const SHAPE_VERTEX* vertices = (const SHAPE_VERTEX*)(Draw->VertexBuffers[0]->Data + Draw->Offsets[0]);
+	const SHAPE_INSTANCE* instances = (const SHAPE_INSTANCE*)(Draw->VertexBuffers[1]->Data + Draw->Offsets[1]);
+	const UINT16* indices = (const UINT16*)(Draw->IndexBuffer->Data + Draw->IndexOffset);
+
+	for (UINT32 i = 0; i < Draw->InstanceCount; i++)
+	{
+		const SHAPE_INSTANCE* instance = &instances[Draw->StartInstance + i];
+
+		for (UINT32 j = 0; j < Draw->IndexCount; j++)
+		{
+			const SHAPE_VERTEX* vertex = &vertices[Draw->BaseVertex + indices[Draw->StartIndex + j]];
+
+			XMVECTOR local = XMVectorSet(vertex->Position.x, vertex->Position.y + vertex->Cap * instance->Extension, vertex->Position.z, 1.0f);
+
+			VERTEX* output = &sInstancedVertices[sInstancedVertexCount++];
+
+			output->Position.x = XMVectorGetX(XMVector4Dot(XMLoadFloat4(&instance->Rows[0]), local));
+			output->Position.y = XMVectorGetX(XMVector4Dot(XMLoadFloat4(&instance->Rows[1]), local));
+			output->Position.z = XMVectorGetX(XMVector4Dot(XMLoadFloat4(&instance->Rows[2]), local));
+			output->Color = instance->Color;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "testing.h"
+#include "profiler.h"
+#include "telemetry.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+// Where compat puts the named section, the kernel object namespace prefix is dropped
+#define TELEMETRY_SHM_NAME "/SusanoTelemetry"
+
+#define STREAM_FRAME_COUNT (5000)
+#define STREAM_BURST (400)
+
+#define CONSUMER_TIMEOUT (5000000000ULL)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+struct CONSUMER_RESULT
+{
+	BOOL Mapped;
+	UINT64 ReceivedCount;
+	UINT64 DroppedCount;
+	UINT32 TornCount;
+	UINT32 OutOfOrderCount;
+	UINT32 ZoneCount;
+	CHAR ZoneName[TELEMETRY_ZONE_NAME_LENGTH];
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static PROFILER_ZONE sPublishZone = 0;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestFreshRingIsInitialized(VOID);
+static VOID VaTestConsumerProcessSeesEveryFrame(VOID);
+static VOID VaTestFullRingDropsWithoutWaiting(VOID);
+static VOID VaTestReinjectionKeepsTheConsumer(VOID);
+static VOID VaTestOtherLayoutIsReset(VOID);
+
+static VOID VaRunConsumer(INT32 ReadyPipe, INT32 ResultPipe);
+
+static VOID VaPublishProfiledFrame(VOID);
+
+static TELEMETRY_RING* VaOpenConsumerView(HANDLE* Mapping);
+static VOID VaCloseConsumerView(TELEMETRY_RING* Ring, HANDLE Mapping);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	// A section left behind by an aborted run would otherwise be reused
+	shm_unlink(TELEMETRY_SHM_NAME);
+
+	VaCreateProfiler();
+
+	sPublishZone = VaRegisterProfilerZone("Publish");
+
+	TEST_RUN(VaTestFreshRingIsInitialized);
+	TEST_RUN(VaTestConsumerProcessSeesEveryFrame);
+	TEST_RUN(VaTestFullRingDropsWithoutWaiting);
+	TEST_RUN(VaTestReinjectionKeepsTheConsumer);
+	TEST_RUN(VaTestOtherLayoutIsReset);
+
+	shm_unlink(TELEMETRY_SHM_NAME);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestFreshRingIsInitialized(VOID)
+{
+	VaCreateTelemetry();
+
+	HANDLE mapping = NULL;
+
+	TELEMETRY_RING* ring = VaOpenConsumerView(&mapping);
+
+	TEST_CHECK(ring != NULL);
+
+	if (!ring)
+	{
+		VaDestroyTelemetry();
+
+		return;
+	}
+
+	TEST_CHECK(ring->Magic == TELEMETRY_MAGIC);
+	TEST_CHECK(ring->Version == TELEMETRY_VERSION);
+	TEST_CHECK(ring->FrameSize == sizeof(TELEMETRY_FRAME));
+	TEST_CHECK(ring->FrameCount == TELEMETRY_FRAME_COUNT);
+	TEST_CHECK((ring->WriteIndex == 0) && (ring->ReadIndex == 0) && (ring->DroppedCount == 0));
+	TEST_CHECK(ring->ZoneCount == 0);
+
+	VaPublishProfiledFrame();
+
+	// Zone names are published with the first frame, the profiler already knows its zones by then
+	TEST_CHECK(ring->ZoneCount == VaGetProfilerZoneCount());
+	TEST_CHECK(strcmp(ring->ZoneNames[sPublishZone], "Publish") == 0);
+	TEST_CHECK(ring->WriteIndex == 1);
+
+	const TELEMETRY_FRAME* frame = &ring->Frames[0];
+
+	TEST_CHECK(frame->FrameIndex >= 1);
+	TEST_CHECK(frame->ZoneMask & (1 << sPublishZone));
+	TEST_CHECK((frame->ZoneTimes[sPublishZone] > 0) && (frame->ZoneTimes[sPublishZone] <= frame->Duration));
+
+	WriteRelease64(&ring->ReadIndex, 1);
+
+	VaCloseConsumerView(ring, mapping);
+
+	VaDestroyTelemetry();
+}
+static VOID VaTestConsumerProcessSeesEveryFrame(VOID)
+{
+	VaCreateTelemetry();
+
+	INT32 readyPipe[2] = { -1, -1 };
+	INT32 resultPipe[2] = { -1, -1 };
+
+	pipe(readyPipe);
+	pipe(resultPipe);
+
+	// The external tool is another process that only knows the section name
+	pid_t consumer = fork();
+
+	if (consumer == 0)
+	{
+		close(readyPipe[0]);
+		close(resultPipe[0]);
+
+		VaRunConsumer(readyPipe[1], resultPipe[1]);
+	}
+
+	close(readyPipe[1]);
+	close(resultPipe[1]);
+
+	CHAR ready = 0;
+
+	read(readyPipe[0], &ready, sizeof(ready));
+
+	TELEMETRY_STATISTICS before;
+	TELEMETRY_STATISTICS after;
+
+	VaGetTelemetryStatistics(&before);
+
+	UINT64 publishTime = 0;
+
+	// Bursts are longer than the ring, whether frames are dropped depends on when the consumer gets to run
+	for (UINT32 i = 0; i < STREAM_FRAME_COUNT; i++)
+	{
+		VaBeginProfilerFrame();
+
+		{
+			PROFILE_SCOPE(sPublishZone);
+		}
+
+		VaEndProfilerFrame();
+
+		UINT64 start = VaQueryTestTime();
+
+		VaPublishTelemetryFrame();
+
+		publishTime += VaQueryTestTime() - start;
+
+		if ((i % STREAM_BURST) == (STREAM_BURST - 1))
+		{
+			Sleep(1);
+		}
+	}
+
+	CONSUMER_RESULT result = { 0 };
+
+	read(resultPipe[0], &result, sizeof(result));
+
+	INT32 status = 0;
+
+	waitpid(consumer, &status, 0);
+
+	close(readyPipe[0]);
+	close(resultPipe[0]);
+
+	VaGetTelemetryStatistics(&after);
+
+	UINT64 publishedCount = after.PublishedCount - before.PublishedCount;
+	UINT64 droppedCount = after.DroppedCount - before.DroppedCount;
+
+	// Every frame is either handed over or counted as dropped, and what was handed over arrived whole and in order
+	TEST_CHECK(result.Mapped);
+	TEST_CHECK(result.ReceivedCount == publishedCount);
+	TEST_CHECK((publishedCount + droppedCount) == STREAM_FRAME_COUNT);
+	TEST_CHECK(result.ReceivedCount > 0);
+	TEST_CHECK(result.TornCount == 0);
+	TEST_CHECK(result.OutOfOrderCount == 0);
+	TEST_CHECK(result.ZoneCount == VaGetProfilerZoneCount());
+	TEST_CHECK(strcmp(result.ZoneName, "Publish") == 0);
+	TEST_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+	printf("  %llu frames received, %llu dropped, %.1f ns per publish\n", result.ReceivedCount, droppedCount, (DOUBLE)publishTime / STREAM_FRAME_COUNT);
+
+	VaDestroyTelemetry();
+}
+static VOID VaTestFullRingDropsWithoutWaiting(VOID)
+{
+	VaCreateTelemetry();
+
+	HANDLE mapping = NULL;
+
+	TELEMETRY_RING* ring = VaOpenConsumerView(&mapping);
+
+	// The consumer caught up with everything so far and then stopped reading
+	WriteRelease64(&ring->ReadIndex, ring->WriteIndex);
+
+	TELEMETRY_STATISTICS before;
+	TELEMETRY_STATISTICS after;
+
+	VaGetTelemetryStatistics(&before);
+
+	for (UINT32 i = 0; i < (TELEMETRY_FRAME_COUNT + 10); i++)
+	{
+		VaPublishProfiledFrame();
+	}
+
+	VaGetTelemetryStatistics(&after);
+
+	TEST_CHECK((after.PublishedCount - before.PublishedCount) == TELEMETRY_FRAME_COUNT);
+	TEST_CHECK((after.DroppedCount - before.DroppedCount) == 10);
+	TEST_CHECK(after.PendingCount == TELEMETRY_FRAME_COUNT);
+
+	// Slots come back as soon as the read index moves past them
+	WriteRelease64(&ring->ReadIndex, ring->ReadIndex + 100);
+
+	VaPublishProfiledFrame();
+
+	VaGetTelemetryStatistics(&before);
+
+	TEST_CHECK((before.PublishedCount - after.PublishedCount) == 1);
+	TEST_CHECK(before.DroppedCount == after.DroppedCount);
+	TEST_CHECK(before.PendingCount == (TELEMETRY_FRAME_COUNT - 100 + 1));
+
+	VaCloseConsumerView(ring, mapping);
+
+	VaDestroyTelemetry();
+}
+static VOID VaTestReinjectionKeepsTheConsumer(VOID)
+{
+	VaCreateTelemetry();
+
+	HANDLE mapping = NULL;
+
+	TELEMETRY_RING* ring = VaOpenConsumerView(&mapping);
+
+	WriteRelease64(&ring->ReadIndex, ring->WriteIndex);
+
+	for (UINT32 i = 0; i < 5; i++)
+	{
+		VaPublishProfiledFrame();
+	}
+
+	LONG64 writeIndex = ring->WriteIndex;
+	LONG64 readIndex = ring->ReadIndex + 2;
+
+	WriteRelease64(&ring->ReadIndex, readIndex);
+
+	// HotLoader unloads and loads the DLL while the tool stays attached, the same layout is picked up where it was
+	VaDestroyTelemetry();
+	VaCreateTelemetry();
+
+	TEST_CHECK(ring->Magic == TELEMETRY_MAGIC);
+	TEST_CHECK(ring->WriteIndex == writeIndex);
+	TEST_CHECK(ring->ReadIndex == readIndex);
+
+	VaPublishProfiledFrame();
+
+	TEST_CHECK(ring->WriteIndex == (writeIndex + 1));
+
+	VaCloseConsumerView(ring, mapping);
+
+	VaDestroyTelemetry();
+}
+static VOID VaTestOtherLayoutIsReset(VOID)
+{
+	VaCreateTelemetry();
+
+	HANDLE mapping = NULL;
+
+	TELEMETRY_RING* ring = VaOpenConsumerView(&mapping);
+
+	VaPublishProfiledFrame();
+
+	VaDestroyTelemetry();
+
+	// A build with another version, frame size or frame count left its ring behind, only the magic still matches
+	for (UINT32 i = 0; i < 3; i++)
+	{
+		ring->Version = TELEMETRY_VERSION + ((i == 0) ? 1 : 0);
+		ring->FrameSize = sizeof(TELEMETRY_FRAME) + ((i == 1) ? 8 : 0);
+		ring->FrameCount = TELEMETRY_FRAME_COUNT / ((i == 2) ? 2 : 1);
+
+		WriteRelease64(&ring->WriteIndex, 77);
+		WriteRelease64(&ring->ReadIndex, 70);
+
+		ring->ZoneCount = 5;
+
+		VaCreateTelemetry();
+
+		TEST_CHECK(ring->Magic == TELEMETRY_MAGIC);
+		TEST_CHECK((ring->Version == TELEMETRY_VERSION) && (ring->FrameSize == sizeof(TELEMETRY_FRAME)) && (ring->FrameCount == TELEMETRY_FRAME_COUNT));
+		TEST_CHECK((ring->WriteIndex == 0) && (ring->ReadIndex == 0));
+		TEST_CHECK(ring->ZoneCount == 0);
+
+		VaDestroyTelemetry();
+	}
+
+	VaCloseConsumerView(ring, mapping);
+}
+
+static VOID VaRunConsumer(INT32 ReadyPipe, INT32 ResultPipe)
+{
+	CONSUMER_RESULT result = { 0 };
+
+	HANDLE mapping = NULL;
+
+	TELEMETRY_RING* ring = VaOpenConsumerView(&mapping);
+
+	result.Mapped = (ring != NULL) && (ring->Magic == TELEMETRY_MAGIC) && (ring->FrameSize == sizeof(TELEMETRY_FRAME));
+
+	CHAR ready = 1;
+
+	write(ReadyPipe, &ready, sizeof(ready));
+
+	UINT64 lastFrameIndex = 0;
+
+	UINT64 start = VaQueryTestTime();
+
+	// Reads frames in place like the sample consumer and returns each slot once it is done with it
+	while (result.Mapped && ((result.ReceivedCount + ring->DroppedCount) < STREAM_FRAME_COUNT) && ((VaQueryTestTime() - start) < CONSUMER_TIMEOUT))
+	{
+		LONG64 readIndex = ring->ReadIndex;
+		LONG64 writeIndex = ReadAcquire64(&ring->WriteIndex);
+
+		if (readIndex == writeIndex)
+		{
+			Sleep(0);
+
+			continue;
+		}
+
+		for (; readIndex < writeIndex; readIndex++)
+		{
+			const TELEMETRY_FRAME* frame = &ring->Frames[readIndex & (TELEMETRY_FRAME_COUNT - 1)];
+
+			// Every published frame profiled the publish zone, a slot read while being filled lacks it
+			if (!(frame->ZoneMask & (1 << sPublishZone)) || !frame->Duration || (frame->ZoneTimes[sPublishZone] > frame->Duration))
+			{
+				result.TornCount += 1;
+			}
+
+			if (frame->FrameIndex <= lastFrameIndex)
+			{
+				result.OutOfOrderCount += 1;
+			}
+
+			lastFrameIndex = frame->FrameIndex;
+
+			result.ReceivedCount += 1;
+		}
+
+		WriteRelease64(&ring->ReadIndex, readIndex);
+	}
+
+	if (result.Mapped)
+	{
+		result.ZoneCount = ring->ZoneCount;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		memcpy(result.ZoneName, ring->ZoneNames[sPublishZone], TELEMETRY_ZONE_NAME_LENGTH);
+
+		result.DroppedCount = ring->DroppedCount;
+	}
+
+	write(ResultPipe, &result, sizeof(result));
+
+	_exit(0);
+}
+
+static VOID VaPublishProfiledFrame(VOID)
+{
+	VaBeginProfilerFrame();
+
+	{
+		PROFILE_SCOPE(sPublishZone);
+	}
+
+	VaEndProfilerFrame();
+
+	VaPublishTelemetryFrame();
+}
+
+static TELEMETRY_RING* VaOpenConsumerView(HANDLE* Mapping)
+{
+	*Mapping = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, TELEMETRY_MAPPING_NAME);
+
+	if (!*Mapping)
+	{
+		return NULL;
+	}
+
+	return (TELEMETRY_RING*)MapViewOfFile(*Mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, sizeof(TELEMETRY_RING));
+}
+static VOID VaCloseConsumerView(TELEMETRY_RING* Ring, HANDLE Mapping)
+{
+	if (Ring)
+	{
+		UnmapViewOfFile(Ring);
+	}
+
+	if (Mapping)
+	{
+		CloseHandle(Mapping);
+	}
+}
\ No newline at end of file
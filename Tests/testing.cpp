@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <time.h>
+
+#include "testing.h"
+#include "uploadring.h"
+#include "pipelinecache.h"
+#include "constantblocks.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define TEST_IMAGE_PAGE_SIZE (0x1000)
+
+#define ALIGN_PAGE(VALUE) ((((VALUE) + TEST_IMAGE_PAGE_SIZE - 1) / TEST_IMAGE_PAGE_SIZE) * TEST_IMAGE_PAGE_SIZE)
+
+/////////////////////////////////////////////////
+// Global Variables
+/////////////////////////////////////////////////
+
+ID3D11Device* gDevice = NULL;
+ID3D11DeviceContext* gDeviceContext = NULL;
+ID3D11RenderTargetView* gMainRenderTargetView = NULL;
+
+CONSTANT_BLOCK gViewProjectionBlock = INVALID_CONSTANT_BLOCK;
+
+MODEL_VIEW_PROJECTION gModelViewProjection = {};
+
+ID3D11DeviceContext* gMockContext = NULL;
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static UINT32 sFailedCheckCount = 0;
+static UINT32 sFailedTestCount = 0;
+static UINT32 sTestCount = 0;
+
+static TEST_FRAME_CAPTURE* sCapture = NULL;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaCaptureDraw(const D3D11_MOCK_DRAW* Draw, PVOID UserParam);
+static VOID VaCaptureVertex(const VERTEX* Vertex);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+VOID VaFailTest(LPCSTR File, INT32 Line, LPCSTR Condition)
+{
+	printf("  %s:%d: check failed: %s\n", File, Line, Condition);
+
+	sFailedCheckCount += 1;
+}
+VOID VaRunTest(LPCSTR Name, TEST_PROC Test)
+{
+	UINT32 failedCheckCount = sFailedCheckCount;
+
+	UINT64 start = VaQueryTestTime();
+
+	Test();
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	BOOL passed = sFailedCheckCount == failedCheckCount;
+
+	printf("%s %s (%.1f ms)\n", passed ? "PASS" : "FAIL", Name, elapsed / 1000000.0);
+
+	sFailedTestCount += passed ? 0 : 1;
+	sTestCount += 1;
+}
+INT32 VaFinishTests(VOID)
+{
+	printf("%u of %u tests passed\n", sTestCount - sFailedTestCount, sTestCount);
+
+	return sFailedTestCount ? 1 : 0;
+}
+
+VOID VaCreateTestRenderer(VOID)
+{
+	D3D11CreateMockDevice(&gDevice, &gDeviceContext);
+
+	gMockContext = gDeviceContext;
+
+	VaCreatePipelineCache();
+	VaCreateUploadRing();
+	VaCreateConstantBlocks();
+
+	gViewProjectionBlock = VaCreateConstantBlock(sizeof(VIEW_PROJECTION));
+
+	VaSetTestViewProjection(XMMatrixIdentity());
+}
+VOID VaDestroyTestRenderer(VOID)
+{
+	VaDestroyUploadRing();
+	VaDestroyPipelineCache();
+	VaDestroyConstantBlocks();
+
+	gDeviceContext->Release();
+	gDevice->Release();
+
+	gDevice = NULL;
+	gDeviceContext = NULL;
+	gMockContext = NULL;
+}
+
+VOID VaSetTestViewProjection(FXMMATRIX ViewProjection)
+{
+	gModelViewProjection.Model = XMMatrixIdentity();
+	gModelViewProjection.View = XMMatrixIdentity();
+	gModelViewProjection.Projection = XMMatrixTranspose(ViewProjection);
+	gModelViewProjection.ViewProjection = XMMatrixTranspose(ViewProjection);
+
+	VIEW_PROJECTION block = { gModelViewProjection.ViewProjection };
+
+	VaWriteConstantBlock(gViewProjectionBlock, &block);
+}
+
+VOID VaBeginTestFrame(VOID)
+{
+	VaResetConstantBlockStatistics();
+	VaBeginUploadFrame();
+	VaInvalidatePipelineState();
+}
+VOID VaEndTestFrame(VOID)
+{
+	VaEndUploadFrame();
+}
+
+VOID VaBeginFrameCapture(TEST_FRAME_CAPTURE* Capture, VERTEX* Vertices, UINT64 VertexCapacity)
+{
+	memset(Capture, 0, sizeof(TEST_FRAME_CAPTURE));
+
+	Capture->Vertices = Vertices;
+	Capture->VertexCapacity = VertexCapacity;
+
+	sCapture = Capture;
+
+	gMockContext->DrawProc = VaCaptureDraw;
+	gMockContext->DrawUserParam = NULL;
+}
+VOID VaEndFrameCapture(VOID)
+{
+	gMockContext->DrawProc = NULL;
+
+	sCapture = NULL;
+}
+
+UINT64 VaQueryTestTime(VOID)
+{
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (UINT64)time.tv_sec * 1000000000ULL + (UINT64)time.tv_nsec;
+}
+
+PBYTE VaCreateTestImage(UINT32 CodeSize, UINT32 DataSize, UINT32 TimeDateStamp, const UINT32* Relocations, UINT32 RelocationCount)
+{
+	UINT32 dataRva = TEST_IMAGE_CODE_RVA + ALIGN_PAGE(CodeSize);
+	UINT32 relocationRva = dataRva + ALIGN_PAGE(DataSize);
+
+	// Every relocation gets its own block, padded to four bytes with an absolute entry the loader skips
+	UINT32 relocationSize = RelocationCount * ((UINT32)sizeof(IMAGE_BASE_RELOCATION) + (2 * (UINT32)sizeof(WORD)));
+	UINT32 imageSize = relocationRva + ALIGN_PAGE(relocationSize);
+
+	PBYTE image = (PBYTE)VirtualAlloc(NULL, imageSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+	PIMAGE_DOS_HEADER dosHeader = (PIMAGE_DOS_HEADER)image;
+
+	dosHeader->e_magic = IMAGE_DOS_SIGNATURE;
+	dosHeader->e_lfanew = 0x80;
+
+	PIMAGE_NT_HEADERS64 ntHeaders = (PIMAGE_NT_HEADERS64)(image + dosHeader->e_lfanew);
+
+	ntHeaders->Signature = IMAGE_NT_SIGNATURE;
+	ntHeaders->FileHeader.Machine = IMAGE_FILE_MACHINE_AMD64;
+	ntHeaders->FileHeader.NumberOfSections = 2;
+	ntHeaders->FileHeader.TimeDateStamp = TimeDateStamp;
+	ntHeaders->FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER64);
+	ntHeaders->OptionalHeader.Magic = IMAGE_NT_OPTIONAL_HDR64_MAGIC;
+	ntHeaders->OptionalHeader.SizeOfCode = CodeSize;
+	ntHeaders->OptionalHeader.BaseOfCode = TEST_IMAGE_CODE_RVA;
+	ntHeaders->OptionalHeader.SectionAlignment = TEST_IMAGE_PAGE_SIZE;
+	ntHeaders->OptionalHeader.SizeOfImage = imageSize;
+	ntHeaders->OptionalHeader.SizeOfHeaders = TEST_IMAGE_PAGE_SIZE;
+	ntHeaders->OptionalHeader.NumberOfRvaAndSizes = 16;
+
+	PIMAGE_SECTION_HEADER sections = IMAGE_FIRST_SECTION(ntHeaders);
+
+	memcpy(sections[0].Name, ".text", 5);
+
+	sections[0].Misc.VirtualSize = CodeSize;
+	sections[0].VirtualAddress = TEST_IMAGE_CODE_RVA;
+	sections[0].Characteristics = IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_EXECUTE | IMAGE_SCN_MEM_READ;
+
+	memcpy(sections[1].Name, ".data", 5);
+
+	sections[1].Misc.VirtualSize = DataSize;
+	sections[1].VirtualAddress = dataRva;
+	sections[1].Characteristics = IMAGE_SCN_MEM_READ;
+
+	if (RelocationCount)
+	{
+		PBYTE relocation = image + relocationRva;
+
+		for (UINT32 i = 0; i < RelocationCount; i++)
+		{
+			PIMAGE_BASE_RELOCATION block = (PIMAGE_BASE_RELOCATION)relocation;
+
+			block->VirtualAddress = Relocations[i] & ~(TEST_IMAGE_PAGE_SIZE - 1);
+			block->SizeOfBlock = sizeof(IMAGE_BASE_RELOCATION) + (2 * sizeof(WORD));
+
+			WORD* entries = (WORD*)(block + 1);
+
+			entries[0] = (WORD)((IMAGE_REL_BASED_DIR64 << 12) | (Relocations[i] & (TEST_IMAGE_PAGE_SIZE - 1)));
+			entries[1] = (WORD)(IMAGE_REL_BASED_ABSOLUTE << 12);
+
+			relocation += block->SizeOfBlock;
+		}
+
+		ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].VirtualAddress = relocationRva;
+		ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC].Size = relocationSize;
+	}
+
+	return image;
+}
+VOID VaDestroyTestImage(PBYTE Image)
+{
+	VirtualFree(Image, 0, MEM_RELEASE);
+}
+
+static VOID VaCaptureDraw(const D3D11_MOCK_DRAW* Draw, PVOID UserParam)
+{
+	// Only the line batch layout is decoded, one 16 byte vertex in slot 0
+	const VERTEX* vertices = (const VERTEX*)(Draw->VertexBuffers[0]->Data + Draw->Offsets[0]);
+
+	if (Draw->Indexed)
+	{
+		const UINT16* indices = (const UINT16*)(Draw->IndexBuffer->Data + Draw->IndexOffset);
+
+		for (UINT32 i = 0; i < Draw->IndexCount; i++)
+		{
+			VaCaptureVertex(&vertices[Draw->BaseVertex + indices[Draw->StartIndex + i]]);
+		}
+
+		sCapture->IndexCount += Draw->IndexCount;
+	}
+	else
+	{
+		for (UINT32 i = 0; i < Draw->VertexCount; i++)
+		{
+			VaCaptureVertex(&vertices[Draw->StartVertex + i]);
+		}
+
+		sCapture->VertexCount += Draw->VertexCount;
+	}
+}
+static VOID VaCaptureVertex(const VERTEX* Vertex)
+{
+	if (sCapture->Vertices && (sCapture->PrimitiveVertexCount < sCapture->VertexCapacity))
+	{
+		sCapture->Vertices[sCapture->PrimitiveVertexCount] = *Vertex;
+	}
+
+	sCapture->ColorSum += Vertex->Color;
+	sCapture->PositionSum += Vertex->Position.x + Vertex->Position.y + Vertex->Position.z;
+
+	sCapture->PrimitiveVertexCount += 1;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <windows.h>
+
+#include <d3d11.h>
+
+#include "susano.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+// A failed check is reported and counted, the test keeps running so one run shows every broken expectation
+#define TEST_CHECK(CONDITION) \
+	{ \
+		if (!(CONDITION)) \
+		{ \
+			VaFailTest(__FILE__, __LINE__, #CONDITION); \
+		} \
+	}
+
+#define TEST_RUN(TEST) VaRunTest(#TEST, TEST)
+
+#define TEST_IMAGE_CODE_RVA (0x1000)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+typedef VOID (*TEST_PROC)(VOID);
+
+// Every vertex and index the device was asked to draw during one frame, read back from the bound buffers
+// When Vertices is set the drawn vertices are also copied out in draw order, indexed draws are expanded
+struct TEST_FRAME_CAPTURE
+{
+	VERTEX* Vertices;
+	UINT64 VertexCapacity;
+	UINT64 VertexCount;
+	UINT64 IndexCount;
+	UINT64 PrimitiveVertexCount;
+	UINT64 ColorSum;
+	DOUBLE PositionSum;
+};
+
+/////////////////////////////////////////////////
+// Global Variables
+/////////////////////////////////////////////////
+
+extern ID3D11DeviceContext* gMockContext;
+
+/////////////////////////////////////////////////
+// Functions
+/////////////////////////////////////////////////
+
+VOID VaFailTest(LPCSTR File, INT32 Line, LPCSTR Condition);
+VOID VaRunTest(LPCSTR Name, TEST_PROC Test);
+INT32 VaFinishTests(VOID);
+
+// Brings up the same renderer stack VaDetourPresent creates, on top of the null device
+VOID VaCreateTestRenderer(VOID);
+VOID VaDestroyTestRenderer(VOID);
+
+// The view projection is stored transposed like VaUpdateModelViewProjection does, identity makes clip space the world
+VOID VaSetTestViewProjection(FXMMATRIX ViewProjection);
+
+VOID VaBeginTestFrame(VOID);
+VOID VaEndTestFrame(VOID);
+
+VOID VaBeginFrameCapture(TEST_FRAME_CAPTURE* Capture, VERTEX* Vertices, UINT64 VertexCapacity);
+VOID VaEndFrameCapture(VOID);
+
+UINT64 VaQueryTestTime(VOID);
+
+// A 64 bit image with one executable section of CodeSize bytes at TEST_IMAGE_CODE_RVA and DataSize bytes of data behind it,
+// every relocation rva gets a DIR64 entry in the relocation directory, the caller fills code and data
+PBYTE VaCreateTestImage(UINT32 CodeSize, UINT32 DataSize, UINT32 TimeDateStamp, const UINT32* Relocations, UINT32 RelocationCount);
+VOID VaDestroyTestImage(PBYTE Image);
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+
+#include "testing.h"
+#include "trace.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define TRACE_THREAD_COUNT (4)
+#define TRACE_ZONE_COUNT (2000)
+
+#define TRACE_OVERFLOW_COUNT (20000)
+
+#define DISARMED_ZONE_COUNT (10000000)
+
+#define FINALIZE_TIMEOUT (5000)
+
+#define TRACE_PATH_SIZE (260)
+
+#define TRACE_BINARY_MAGIC (0x52545553)
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static CHAR sFilePath[TRACE_PATH_SIZE] = { 0 };
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestJsonCaptureIsFinalized(VOID);
+static VOID VaTestBinaryCaptureRoundTrips(VOID);
+static VOID VaTestFullBuffersDropEvents(VOID);
+static VOID VaTestRearmWaitsForFinalize(VOID);
+static VOID VaTestDisarmedZonesCostNothing(VOID);
+
+static VOID VaRecordZones(UINT32 Count);
+
+static BOOL VaWaitForFinalizedTrace(VOID);
+
+static PBYTE VaReadTraceFile(UINT64* Size);
+
+static UINT32 VaCountOccurrences(LPCSTR Text, LPCSTR Pattern);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	snprintf(sFilePath, sizeof(sFilePath), "/tmp/susano_trace_test_%u.trace", GetCurrentProcessId());
+
+	TEST_RUN(VaTestJsonCaptureIsFinalized);
+	TEST_RUN(VaTestBinaryCaptureRoundTrips);
+	TEST_RUN(VaTestFullBuffersDropEvents);
+	TEST_RUN(VaTestRearmWaitsForFinalize);
+	TEST_RUN(VaTestDisarmedZonesCostNothing);
+
+	VaDestroyTrace();
+
+	remove(sFilePath);
+
+	return VaFinishTests();
+}
+
+static VOID VaTestJsonCaptureIsFinalized(VOID)
+{
+	LONG threadWaitCount = gCompatThreadWaitCount;
+
+	TEST_CHECK(VaArmTrace(sFilePath, TRACE_FORMAT_JSON));
+	TEST_CHECK(!VaArmTrace(sFilePath, TRACE_FORMAT_JSON));
+
+	std::thread threads[TRACE_THREAD_COUNT];
+
+	for (UINT32 i = 0; i < TRACE_THREAD_COUNT; i++)
+	{
+		threads[i] = std::thread(VaRecordZones, TRACE_ZONE_COUNT);
+	}
+
+	VaRecordZones(TRACE_ZONE_COUNT);
+
+	for (UINT32 i = 0; i < TRACE_THREAD_COUNT; i++)
+	{
+		threads[i].join();
+	}
+
+	// Disarming only signals the flusher, which writes the last events and the closing bracket on its own
+	VaDisarmTrace();
+
+	TEST_CHECK(VaWaitForFinalizedTrace());
+
+	UINT64 size = 0;
+	PBYTE data = VaReadTraceFile(&size);
+
+	LPCSTR text = (LPCSTR)data;
+
+	TRACE_STATISTICS statistics;
+
+	VaGetTraceStatistics(&statistics);
+
+	// Every zone of all five threads made it into the file, the flusher closed the array and the object
+	UINT32 expectedCount = (TRACE_THREAD_COUNT + 1) * TRACE_ZONE_COUNT * 2;
+
+	TEST_CHECK(!statistics.Armed);
+	TEST_CHECK(statistics.DroppedCount == 0);
+	TEST_CHECK(statistics.EventCount == expectedCount);
+	TEST_CHECK(statistics.WrittenBytes > 0);
+	TEST_CHECK(strncmp(text, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", 40) == 0);
+	TEST_CHECK((size > 4) && (strcmp(text + size - 4, "\n]}\n") == 0));
+	TEST_CHECK(VaCountOccurrences(text, "\"ph\":\"X\"") == expectedCount);
+	TEST_CHECK(VaCountOccurrences(text, "\"name\":\"Outer\"") == (expectedCount / 2));
+	TEST_CHECK(VaCountOccurrences(text, "},\n{") == (expectedCount - 1));
+	TEST_CHECK(gCompatThreadWaitCount == threadWaitCount);
+
+	free(data);
+}
+static VOID VaTestBinaryCaptureRoundTrips(VOID)
+{
+	LPCSTR names[] = { "Present", "Lines", "Shapes" };
+
+	TEST_CHECK(VaArmTrace(sFilePath, TRACE_FORMAT_BINARY));
+
+	UINT64 base = VaQueryTraceTime();
+
+	for (UINT32 i = 0; i < 300; i++)
+	{
+		VaWriteTraceEvent(names[i % 3], base + (i * 1000), base + (i * 1000) + i);
+	}
+
+	// Events that started before the capture was armed are left out
+	VaWriteTraceEvent(names[0], 0, base);
+
+	VaDisarmTrace();
+
+	TEST_CHECK(VaWaitForFinalizedTrace());
+
+	UINT64 size = 0;
+	PBYTE data = VaReadTraceFile(&size);
+
+	UINT32 header[2];
+
+	memcpy(header, data, sizeof(header));
+
+	TEST_CHECK(header[0] == TRACE_BINARY_MAGIC);
+	TEST_CHECK(header[1] == 1);
+
+	CHAR decodedNames[3][16] = { 0 };
+
+	UINT32 nameCount = 0;
+	UINT32 eventCount = 0;
+	UINT32 mismatchCount = 0;
+
+	UINT64 position = sizeof(header);
+
+	UINT64 firstStart = 0;
+
+	while (position < size)
+	{
+		BYTE type = data[position];
+
+		position += 1;
+
+		if (type == 0)
+		{
+			UINT16 length;
+
+			memcpy(&length, data + position, sizeof(length));
+
+			position += sizeof(length);
+
+			if ((nameCount < 3) && (length < 16))
+			{
+				memcpy(decodedNames[nameCount], data + position, length);
+			}
+
+			position += length;
+
+			nameCount += 1;
+		}
+		else
+		{
+			BYTE index = data[position];
+			UINT32 threadId;
+			UINT64 start;
+			UINT32 duration;
+
+			memcpy(&threadId, data + position + 1, sizeof(threadId));
+			memcpy(&start, data + position + 5, sizeof(start));
+			memcpy(&duration, data + position + 13, sizeof(duration));
+
+			position += 17;
+
+			if (eventCount == 0)
+			{
+				firstStart = start;
+			}
+
+			// Events keep their order, so the i-th one has to carry the i-th name, offset and duration
+			if ((index >= 3) || (strcmp(decodedNames[index], names[eventCount % 3]) != 0) || (duration != eventCount) || ((start - firstStart) != (UINT64)eventCount * 1000) || (threadId != GetCurrentThreadId()))
+			{
+				mismatchCount += 1;
+			}
+
+			eventCount += 1;
+		}
+	}
+
+	// Names are stored once each, an event costs 18 bytes
+	TEST_CHECK(position == size);
+	TEST_CHECK(nameCount == 3);
+	TEST_CHECK(eventCount == 300);
+	TEST_CHECK(mismatchCount == 0);
+	TEST_CHECK(size == (sizeof(header) + (3 * 3) + strlen("Present") + strlen("Lines") + strlen("Shapes") + (300 * 18)));
+
+	free(data);
+}
+static VOID VaTestFullBuffersDropEvents(VOID)
+{
+	TEST_CHECK(VaArmTrace(sFilePath, TRACE_FORMAT_JSON));
+
+	// A burst larger than one thread buffer between two flushes loses the rest, but never blocks the producer
+	UINT64 base = VaQueryTraceTime();
+
+	for (UINT32 i = 0; i < TRACE_OVERFLOW_COUNT; i++)
+	{
+		VaWriteTraceEvent("Burst", base, base + 1);
+	}
+
+	TRACE_STATISTICS statistics;
+
+	VaGetTraceStatistics(&statistics);
+
+	UINT64 droppedCount = statistics.DroppedCount;
+
+	VaDisarmTrace();
+
+	TEST_CHECK(VaWaitForFinalizedTrace());
+
+	VaGetTraceStatistics(&statistics);
+
+	TEST_CHECK(droppedCount > 0);
+	TEST_CHECK((statistics.EventCount + statistics.DroppedCount) == TRACE_OVERFLOW_COUNT);
+}
+static VOID VaTestRearmWaitsForFinalize(VOID)
+{
+	TEST_CHECK(VaArmTrace(sFilePath, TRACE_FORMAT_JSON));
+
+	VaRecordZones(10);
+
+	VaDisarmTrace();
+
+	// Arming again only succeeds once the previous flusher is done with its file
+	UINT64 start = VaQueryTestTime();
+
+	while (!VaArmTrace(sFilePath, TRACE_FORMAT_JSON))
+	{
+		if ((VaQueryTestTime() - start) > ((UINT64)FINALIZE_TIMEOUT * 1000000))
+		{
+			break;
+		}
+
+		Sleep(1);
+	}
+
+	TRACE_STATISTICS statistics;
+
+	VaGetTraceStatistics(&statistics);
+
+	TEST_CHECK(statistics.Armed);
+	TEST_CHECK(statistics.EventCount == 0);
+
+	VaRecordZones(10);
+
+	// Destroying an armed capture lets the flusher finish on its own and only waits for its done event
+	LONG threadWaitCount = gCompatThreadWaitCount;
+
+	VaDestroyTrace();
+
+	UINT64 size = 0;
+	PBYTE data = VaReadTraceFile(&size);
+
+	TEST_CHECK((size > 4) && (strcmp((LPCSTR)data + size - 4, "\n]}\n") == 0));
+	TEST_CHECK(VaCountOccurrences((LPCSTR)data, "\"ph\":\"X\"") == 20);
+	TEST_CHECK(gCompatThreadWaitCount == threadWaitCount);
+
+	free(data);
+
+	// The flusher thread is gone shortly after its done event
+	start = VaQueryTestTime();
+
+	while ((gCompatThreadCount != 0) && ((VaQueryTestTime() - start) < ((UINT64)FINALIZE_TIMEOUT * 1000000)))
+	{
+		Sleep(1);
+	}
+
+	TEST_CHECK(gCompatThreadCount == 0);
+}
+static VOID VaTestDisarmedZonesCostNothing(VOID)
+{
+	TRACE_STATISTICS before;
+
+	VaGetTraceStatistics(&before);
+
+	UINT64 start = VaQueryTestTime();
+
+	for (UINT32 i = 0; i < DISARMED_ZONE_COUNT; i++)
+	{
+		TRACE_ZONE("Disarmed");
+
+		// Keeps the loop from being folded away around the empty scope
+		__asm__ volatile("" ::: "memory");
+	}
+
+	UINT64 elapsed = VaQueryTestTime() - start;
+
+	TRACE_STATISTICS after;
+
+	VaGetTraceStatistics(&after);
+
+	DOUBLE nanoseconds = (DOUBLE)elapsed / DISARMED_ZONE_COUNT;
+
+	// A disarmed zone is one load and one branch, it never touches the thread buffers
+	TEST_CHECK(after.ThreadCount == before.ThreadCount);
+	TEST_CHECK(nanoseconds < 5.0);
+
+	printf("  %.2f ns per disarmed zone\n", nanoseconds);
+}
+
+static VOID VaRecordZones(UINT32 Count)
+{
+	for (UINT32 i = 0; i < Count; i++)
+	{
+		TRACE_ZONE("Outer");
+
+		{
+			TRACE_ZONE("Inner");
+		}
+	}
+}
+
+static BOOL VaWaitForFinalizedTrace(VOID)
+{
+	UINT64 start = VaQueryTestTime();
+
+	// The flusher is the only thread a capture starts, it returns right after finalizing the file
+	while ((VaQueryTestTime() - start) < ((UINT64)FINALIZE_TIMEOUT * 1000000))
+	{
+		if (gCompatThreadCount == 0)
+		{
+			return TRUE;
+		}
+
+		Sleep(1);
+	}
+
+	return FALSE;
+}
+
+static PBYTE VaReadTraceFile(UINT64* Size)
+{
+	FILE* file = fopen(sFilePath, "rb");
+
+	if (!file)
+	{
+		*Size = 0;
+
+		return (PBYTE)calloc(1, 1);
+	}
+
+	fseek(file, 0, SEEK_END);
+
+	*Size = (UINT64)ftell(file);
+
+	fseek(file, 0, SEEK_SET);
+
+	PBYTE data = (PBYTE)calloc(1, *Size + 1);
+
+	fread(data, 1, *Size, file);
+	fclose(file);
+
+	return data;
+}
+
+static UINT32 VaCountOccurrences(LPCSTR Text, LPCSTR Pattern)
+{
+	UINT32 count = 0;
+
+	for (LPCSTR position = strstr(Text, Pattern); position; position = strstr(position + 1, Pattern))
+	{
+		count += 1;
+	}
+
+	return count;
+}
\ No newline at end of file
@@ -0,0 +1,573 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "testing.h"
+#include "uploadring.h"
+
+/////////////////////////////////////////////////
+// Macros
+/////////////////////////////////////////////////
+
+#define RING_INITIAL_SIZE (4 * 1024 * 1024)
+
+#define RING_FRAME_COUNT (8)
+
+#define SIMULATED_FRAME_COUNT (2000)
+#define SIMULATED_REGION_CAPACITY (4096)
+
+#define IMGUI_VERTEX_STRIDE (20)
+
+/////////////////////////////////////////////////
+// Type Definition
+/////////////////////////////////////////////////
+
+// A region is live from its allocation until the query ended with its frame has completed
+struct LIVE_REGION
+{
+	UINT32 Offset;
+	UINT32 Size;
+	UINT32 Generation;
+	UINT64 Sequence;
+};
+
+/////////////////////////////////////////////////
+// Local Variables
+/////////////////////////////////////////////////
+
+static LIVE_REGION sLiveRegions[SIMULATED_REGION_CAPACITY] = { 0 };
+
+static UINT32 sLiveRegionCount = 0;
+
+static UINT32 sRandomState = 0x12345678;
+
+/////////////////////////////////////////////////
+// Function Definition
+/////////////////////////////////////////////////
+
+static VOID VaTestOnlyFreshBufferIsDiscarded(VOID);
+static VOID VaTestStrideAlignment(VOID);
+static VOID VaTestWrapsWithoutGrowing(VOID);
+static VOID VaTestRetiredFramesAreReclaimed(VOID);
+static VOID VaTestLaggingGpuGrowsRing(VOID);
+static VOID VaTestFullFrameQueueWaitsForOldest(VOID);
+static VOID VaTestLargeRegionGrowsGeometrically(VOID);
+static VOID VaTestCachedRegionSurvivesRetirement(VOID);
+static VOID VaTestHotCachedRegionDoesNotPinRing(VOID);
+static VOID VaTestSimulatedRetireSequence(VOID);
+
+static VOID VaResetRing(VOID);
+
+static BOOL VaCheckRegion(const UPLOAD_REGION* Region, UINT32 Generation);
+
+static UINT32 VaRandom(VOID);
+
+/////////////////////////////////////////////////
+// Function Implementation
+/////////////////////////////////////////////////
+
+INT32 main(VOID)
+{
+	VaCreateTestRenderer();
+
+	TEST_RUN(VaTestOnlyFreshBufferIsDiscarded);
+	TEST_RUN(VaTestStrideAlignment);
+	TEST_RUN(VaTestWrapsWithoutGrowing);
+	TEST_RUN(VaTestRetiredFramesAreReclaimed);
+	TEST_RUN(VaTestLaggingGpuGrowsRing);
+	TEST_RUN(VaTestFullFrameQueueWaitsForOldest);
+	TEST_RUN(VaTestLargeRegionGrowsGeometrically);
+	TEST_RUN(VaTestCachedRegionSurvivesRetirement);
+	TEST_RUN(VaTestHotCachedRegionDoesNotPinRing);
+	TEST_RUN(VaTestSimulatedRetireSequence);
+
+	VaDestroyTestRenderer();
+
+	return VaFinishTests();
+}
+
+static VOID VaTestOnlyFreshBufferIsDiscarded(VOID)
+{
+	VaResetRing();
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	// Only the very first map may rename the buffer, every later one appends behind regions the gpu may still read
+	for (UINT32 frame = 0; frame < 100; frame++)
+	{
+		VaBeginUploadFrame();
+
+		for (UINT32 i = 0; i < 4; i++)
+		{
+			UPLOAD_REGION region;
+
+			TEST_CHECK(VaMapUploadRegion(4096, 16, &region) != NULL);
+
+			VaUnmapUploadRegion();
+		}
+
+		VaEndUploadFrame();
+	}
+
+	TEST_CHECK((gMockContext->Statistics.DiscardMapCount - before.DiscardMapCount) == 1);
+	TEST_CHECK((gMockContext->Statistics.NoOverwriteMapCount - before.NoOverwriteMapCount) == 399);
+	TEST_CHECK((gMockContext->Statistics.CreatedBufferCount - before.CreatedBufferCount) == 0);
+}
+static VOID VaTestStrideAlignment(VOID)
+{
+	VaResetRing();
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	// The ImGui vertices are 20 bytes, the capacity is a power of two and no multiple of it
+	for (UINT32 frame = 0; frame < 64; frame++)
+	{
+		VaBeginUploadFrame();
+
+		UPLOAD_REGION region;
+
+		VaMapUploadRegion(7 + (frame * 13), 4, &region);
+		VaUnmapUploadRegion();
+
+		VaMapUploadRegion(IMGUI_VERTEX_STRIDE * (1000 + (frame * 997)), IMGUI_VERTEX_STRIDE, &region);
+		VaUnmapUploadRegion();
+
+		VaGetUploadRingStatistics(&statistics);
+
+		TEST_CHECK((region.Offset % IMGUI_VERTEX_STRIDE) == 0);
+		TEST_CHECK((region.Offset + region.Size) <= statistics.Capacity);
+
+		VaMapUploadRegion(6 * 1000, 2, &region);
+		VaUnmapUploadRegion();
+
+		TEST_CHECK((region.Offset % 2) == 0);
+
+		VaEndUploadFrame();
+	}
+
+	TEST_CHECK(statistics.GrowCount == 0);
+}
+static VOID VaTestWrapsWithoutGrowing(VOID)
+{
+	VaResetRing();
+
+	UINT32 wrapCount = 0;
+	UINT32 previousOffset = 0;
+
+	// A gpu that keeps up lets a 1 MiB frame cycle through the 4 MiB ring forever
+	for (UINT32 frame = 0; frame < 64; frame++)
+	{
+		VaBeginUploadFrame();
+
+		UPLOAD_REGION region;
+
+		VaMapUploadRegion(1024 * 1024 - 64, 16, &region);
+		VaUnmapUploadRegion();
+
+		if (region.Offset < previousOffset)
+		{
+			wrapCount += 1;
+		}
+
+		previousOffset = region.Offset;
+
+		VaEndUploadFrame();
+	}
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(wrapCount >= 15);
+	TEST_CHECK(statistics.Capacity == RING_INITIAL_SIZE);
+	TEST_CHECK(statistics.GrowCount == 0);
+	TEST_CHECK(statistics.WaitCount == 0);
+}
+static VOID VaTestRetiredFramesAreReclaimed(VOID)
+{
+	VaResetRing();
+
+	gMockContext->HoldQueries = TRUE;
+
+	for (UINT32 frame = 0; frame < 3; frame++)
+	{
+		VaBeginUploadFrame();
+
+		UPLOAD_REGION region;
+
+		VaMapUploadRegion(65536, 16, &region);
+		VaUnmapUploadRegion();
+
+		VaEndUploadFrame();
+	}
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(statistics.InFlightFrameCount == 3);
+	TEST_CHECK(statistics.UsedBytes == 3 * 65536);
+
+	// Two of the three frames finish on the gpu, the next frame start reclaims exactly their bytes
+	gMockContext->CompletedQuerySequence = gMockContext->IssuedQuerySequence - 1;
+
+	VaBeginUploadFrame();
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(statistics.InFlightFrameCount == 1);
+	TEST_CHECK(statistics.UsedBytes == 65536);
+
+	VaEndUploadFrame();
+
+	gMockContext->CompletedQuerySequence = gMockContext->IssuedQuerySequence;
+
+	VaBeginUploadFrame();
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(statistics.InFlightFrameCount == 0);
+	TEST_CHECK(statistics.UsedBytes == 0);
+	TEST_CHECK(statistics.WaitCount == 0);
+
+	VaEndUploadFrame();
+
+	gMockContext->HoldQueries = FALSE;
+}
+static VOID VaTestLaggingGpuGrowsRing(VOID)
+{
+	VaResetRing();
+
+	gMockContext->HoldQueries = TRUE;
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	// Three frames of 1 MiB stay in flight, a fourth 1.5 MiB frame no longer fits and must not wait for them
+	for (UINT32 frame = 0; frame < 4; frame++)
+	{
+		VaBeginUploadFrame();
+
+		UPLOAD_REGION region;
+
+		VaMapUploadRegion((frame < 3) ? (1024 * 1024) : (1536 * 1024), 16, &region);
+		VaUnmapUploadRegion();
+
+		VaEndUploadFrame();
+	}
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(statistics.GrowCount == 1);
+	TEST_CHECK(statistics.Capacity == 2 * RING_INITIAL_SIZE);
+	TEST_CHECK(statistics.WaitCount == 0);
+	TEST_CHECK((gMockContext->Statistics.QueryWaitCount - before.QueryWaitCount) == 0);
+	TEST_CHECK((gMockContext->Statistics.CreatedBufferCount - before.CreatedBufferCount) == 1);
+
+	// The new buffer was never drawn from, so its first map is a discard again
+	TEST_CHECK((gMockContext->Statistics.DiscardMapCount - before.DiscardMapCount) == 2);
+
+	gMockContext->CompletedQuerySequence = gMockContext->IssuedQuerySequence;
+	gMockContext->HoldQueries = FALSE;
+}
+static VOID VaTestFullFrameQueueWaitsForOldest(VOID)
+{
+	VaResetRing();
+
+	gMockContext->HoldQueries = TRUE;
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	for (UINT32 frame = 0; frame < RING_FRAME_COUNT; frame++)
+	{
+		VaBeginUploadFrame();
+		VaEndUploadFrame();
+	}
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(statistics.InFlightFrameCount == RING_FRAME_COUNT);
+	TEST_CHECK(statistics.WaitCount == 0);
+
+	// A ninth frame has no query left, only the oldest one is waited for and everything newer stays in flight
+	VaBeginUploadFrame();
+	VaEndUploadFrame();
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(statistics.InFlightFrameCount == RING_FRAME_COUNT);
+	TEST_CHECK(statistics.WaitCount == 1);
+	TEST_CHECK((gMockContext->Statistics.QueryWaitCount - before.QueryWaitCount) == 1);
+
+	gMockContext->CompletedQuerySequence = gMockContext->IssuedQuerySequence;
+	gMockContext->HoldQueries = FALSE;
+}
+static VOID VaTestLargeRegionGrowsGeometrically(VOID)
+{
+	VaResetRing();
+
+	D3D11_MOCK_STATISTICS before = gMockContext->Statistics;
+
+	VaBeginUploadFrame();
+
+	UPLOAD_REGION region;
+
+	// The old ImGui buffers grew by a few thousand vertices per hitch, the ring jumps straight to twice the request
+	PVOID data = VaMapUploadRegion(20 * 1024 * 1024, 16, &region);
+
+	VaUnmapUploadRegion();
+
+	VaEndUploadFrame();
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(data != NULL);
+	TEST_CHECK(statistics.GrowCount == 1);
+	TEST_CHECK(statistics.Capacity == 64 * 1024 * 1024);
+	TEST_CHECK(region.Buffer->Desc.ByteWidth == statistics.Capacity);
+	TEST_CHECK((gMockContext->Statistics.CreatedBufferCount - before.CreatedBufferCount) == 1);
+}
+static VOID VaTestCachedRegionSurvivesRetirement(VOID)
+{
+	VaResetRing();
+
+	BYTE data[4096];
+
+	for (UINT32 i = 0; i < sizeof(data); i++)
+	{
+		data[i] = (BYTE)(i * 7);
+	}
+
+	UPLOAD_REGION first;
+	UPLOAD_REGION second;
+
+	VaBeginUploadFrame();
+
+	TEST_CHECK(VaUploadCached(data, sizeof(data), 16, &first));
+
+	VaEndUploadFrame();
+
+	// The frame has retired by now, its bytes are still in the ring until the head laps them
+	VaBeginUploadFrame();
+
+	TEST_CHECK(!VaUploadCached(data, sizeof(data), 16, &second));
+
+	VaEndUploadFrame();
+
+	TEST_CHECK((second.Buffer == first.Buffer) && (second.Offset == first.Offset));
+	TEST_CHECK(memcmp(second.Buffer->Data + second.Offset, data, sizeof(data)) == 0);
+
+	// Once four megabytes went through the ring the old region is gone and uploaded anew
+	for (UINT32 frame = 0; frame < 8; frame++)
+	{
+		VaBeginUploadFrame();
+
+		UPLOAD_REGION region;
+
+		VaMapUploadRegion(1024 * 1024, 16, &region);
+		VaUnmapUploadRegion();
+
+		VaEndUploadFrame();
+	}
+
+	VaBeginUploadFrame();
+
+	TEST_CHECK(VaUploadCached(data, sizeof(data), 16, &second));
+
+	VaEndUploadFrame();
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(statistics.HitCount == 1);
+	TEST_CHECK(statistics.MissCount == 2);
+}
+static VOID VaTestHotCachedRegionDoesNotPinRing(VOID)
+{
+	VaResetRing();
+
+	BYTE data[4096];
+
+	memset(data, 0x5A, sizeof(data));
+
+	// Static instances are hit every frame next to streamed geometry, the hot region is copied forward once per half lap instead of holding the tail
+	for (UINT32 frame = 0; frame < 256; frame++)
+	{
+		VaBeginUploadFrame();
+
+		UPLOAD_REGION region;
+
+		VaUploadCached(data, sizeof(data), 16, &region);
+
+		TEST_CHECK(memcmp(region.Buffer->Data + region.Offset, data, sizeof(data)) == 0);
+
+		VaMapUploadRegion(512 * 1024, 16, &region);
+		VaUnmapUploadRegion();
+
+		VaEndUploadFrame();
+	}
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(statistics.GrowCount == 0);
+	TEST_CHECK(statistics.WaitCount == 0);
+	TEST_CHECK(statistics.HitCount > (statistics.MissCount * 2));
+}
+static VOID VaTestSimulatedRetireSequence(VOID)
+{
+	VaResetRing();
+
+	gMockContext->HoldQueries = TRUE;
+
+	BYTE cachedData[4][2048];
+
+	for (UINT32 i = 0; i < 4; i++)
+	{
+		memset(cachedData[i], 0x10 + i, sizeof(cachedData[i]));
+	}
+
+	sLiveRegionCount = 0;
+
+	UINT32 overlapCount = 0;
+	UINT32 corruptCount = 0;
+
+	UPLOAD_RING_STATISTICS statistics;
+
+	// The gpu lags a random number of frames behind, no allocation may ever overlap a region it can still read
+	for (UINT32 frame = 0; frame < SIMULATED_FRAME_COUNT; frame++)
+	{
+		UINT32 lag = VaRandom() % (RING_FRAME_COUNT + 2);
+
+		if (gMockContext->IssuedQuerySequence > lag)
+		{
+			UINT64 completed = gMockContext->IssuedQuerySequence - lag;
+
+			if (completed > gMockContext->CompletedQuerySequence)
+			{
+				gMockContext->CompletedQuerySequence = completed;
+			}
+		}
+
+		VaBeginUploadFrame();
+
+		UINT64 sequence = gMockContext->IssuedQuerySequence + 1;
+
+		UINT32 regionCount = 1 + (VaRandom() % 8);
+
+		for (UINT32 i = 0; i < regionCount; i++)
+		{
+			UPLOAD_REGION region;
+
+			UINT32 kind = VaRandom() % 4;
+
+			if (kind == 0)
+			{
+				UINT32 index = VaRandom() % 4;
+
+				VaUploadCached(cachedData[index], sizeof(cachedData[index]), IMGUI_VERTEX_STRIDE, &region);
+
+				// A hit hands out bytes that were written frames ago, they must still be exactly the cached ones
+				if (memcmp(region.Buffer->Data + region.Offset, cachedData[index], sizeof(cachedData[index])) != 0)
+				{
+					corruptCount += 1;
+				}
+			}
+			else
+			{
+				UINT32 alignment = (kind == 1) ? IMGUI_VERTEX_STRIDE : 16;
+				UINT32 size = alignment * (1 + (VaRandom() % 8192));
+
+				PBYTE data = (PBYTE)VaMapUploadRegion(size, alignment, &region);
+
+				memset(data, 0xEE, size);
+
+				VaUnmapUploadRegion();
+			}
+
+			VaGetUploadRingStatistics(&statistics);
+
+			if (!VaCheckRegion(&region, statistics.GrowCount))
+			{
+				overlapCount += 1;
+			}
+
+			if (sLiveRegionCount < SIMULATED_REGION_CAPACITY)
+			{
+				LIVE_REGION* live = &sLiveRegions[sLiveRegionCount];
+
+				live->Offset = region.Offset;
+				live->Size = region.Size;
+				live->Generation = statistics.GrowCount;
+				live->Sequence = sequence;
+
+				sLiveRegionCount += 1;
+			}
+		}
+
+		VaEndUploadFrame();
+	}
+
+	VaGetUploadRingStatistics(&statistics);
+
+	TEST_CHECK(overlapCount == 0);
+	TEST_CHECK(corruptCount == 0);
+	TEST_CHECK(statistics.HitCount > 0);
+
+	printf("  %u frames, %u waits, %u grows to %.0f MiB, %llu hits\n", SIMULATED_FRAME_COUNT, statistics.WaitCount, statistics.GrowCount, statistics.Capacity / (1024.0 * 1024.0), statistics.HitCount);
+
+	gMockContext->CompletedQuerySequence = gMockContext->IssuedQuerySequence;
+	gMockContext->HoldQueries = FALSE;
+}
+
+static VOID VaResetRing(VOID)
+{
+	VaDestroyUploadRing();
+	VaCreateUploadRing();
+}
+
+static BOOL VaCheckRegion(const UPLOAD_REGION* Region, UINT32 Generation)
+{
+	BOOL valid = TRUE;
+
+	UINT32 count = 0;
+
+	for (UINT32 i = 0; i < sLiveRegionCount; i++)
+	{
+		LIVE_REGION* live = &sLiveRegions[i];
+
+		// Growing abandons the old buffer and completed queries free their regions, neither is tracked further
+		if ((live->Generation != Generation) || (live->Sequence <= gMockContext->CompletedQuerySequence))
+		{
+			continue;
+		}
+
+		BOOL same = (live->Offset == Region->Offset) && (live->Size == Region->Size);
+
+		// Cache hits legitimately hand out the same region again
+		if (!same && (live->Offset < (Region->Offset + Region->Size)) && (Region->Offset < (live->Offset + live->Size)))
+		{
+			valid = FALSE;
+		}
+
+		sLiveRegions[count] = *live;
+		count += 1;
+	}
+
+	sLiveRegionCount = count;
+
+	return valid;
+}
+
+static UINT32 VaRandom(VOID)
+{
+	sRandomState = (sRandomState * 1664525) + 1013904223;
+
+	return sRandomState >> 8;
+}
\ No newline at end of file